@@ -10,7 +10,43 @@
  * @date 13/12/2020
  * @copyright APACHE-2.0
  */
+#include <algorithm>
 #include "Chord.hpp"
+#include "HeapProbe.hpp"
+
+
+// Definitions of the static constexpr members (required before C++17)
+constexpr Chord::Type Chord::allChordTypes[];
+constexpr enum Chord::Iv Chord::majorVect[];
+constexpr enum Chord::Iv Chord::major_6_Vect[];
+constexpr enum Chord::Iv Chord::major_7_Vect[];
+constexpr enum Chord::Iv Chord::major_9_Vect[];
+constexpr enum Chord::Iv Chord::major_7_sharp11_Vect[];
+constexpr enum Chord::Iv Chord::minorVect[];
+constexpr enum Chord::Iv Chord::minor_6_Vect[];
+constexpr enum Chord::Iv Chord::minor_flat6_Vect[];
+constexpr enum Chord::Iv Chord::minor_7_Vect[];
+constexpr enum Chord::Iv Chord::minor_9_Vect[];
+constexpr enum Chord::Iv Chord::minor_major_7_Vect[];
+constexpr enum Chord::Iv Chord::dominant_7_Vect[];
+constexpr enum Chord::Iv Chord::dominant_flat5_Vect[];
+constexpr enum Chord::Iv Chord::dominant_sharp5_Vect[];
+constexpr enum Chord::Iv Chord::dominant_7_sus4[];
+constexpr enum Chord::Iv Chord::dominant_7_flat9[];
+constexpr enum Chord::Iv Chord::dominant_7_sharp9[];
+constexpr enum Chord::Iv Chord::dominant_7_sharp5_flat9[];
+constexpr enum Chord::Iv Chord::dominant_7_sharp11[];
+constexpr enum Chord::Iv Chord::dominant_7_add9_flat5[];
+constexpr enum Chord::Iv Chord::dominant_7_add9_sharp11[];
+constexpr enum Chord::Iv Chord::dominant_7_add13[];
+constexpr enum Chord::Iv Chord::dominant_7_sharp9_flat13[];
+constexpr enum Chord::Iv Chord::dominant_7_sharp11_add13[];
+constexpr enum Chord::Iv Chord::diminished[];
+constexpr enum Chord::Iv Chord::diminished_7[];
+constexpr enum Chord::Iv Chord::minor_7_flat5[];
+constexpr enum Chord::Iv Chord::augmented[];
+constexpr enum Chord::Iv Chord::sus4[];
+constexpr enum Chord::Iv Chord::sus2[];
 
 
 /** Chord constructor
@@ -19,6 +55,7 @@
 Chord::Chord(Chord::Type chordTypeArg,
 			 uint8_t bassnoteArg,
 			 uint8_t rootnoteArg ) noexcept {
+	HEAP_PROBE_SCOPE(CHORD);
 	
 	chordType = chordTypeArg;
 	bassnote = bassnoteArg;
@@ -29,153 +66,153 @@ Chord::Chord(Chord::Type chordTypeArg,
 		case Type::MAJOR:
 			privText = "Major";
 			shortPrivText = "";
-			chordVect = majorVect;
+			SetRecipe(majorVect);
 			break;
 		case Type::MAJOR_6:
 			privText = "Major 6'th";
 			shortPrivText = "6";
-			chordVect = major_6_Vect;
+			SetRecipe(major_6_Vect);
 			break;
 		case Type::MAJOR_7:
 			privText = "Major 7'th";
 			shortPrivText = "maj7";
-			chordVect = major_7_Vect;
+			SetRecipe(major_7_Vect);
 			break;
 		case Type::MAJOR_9:
 			privText = "Major 9'th";
 			shortPrivText = "maj9";
-			chordVect = major_9_Vect;
+			SetRecipe(major_9_Vect);
 			break;
 		case Type::MAJOR_7_SHARP11:
 			privText = "Major 7'th #11";
 			shortPrivText = "maj7#11";
-			chordVect = major_7_sharp11_Vect;
+			SetRecipe(major_7_sharp11_Vect);
 			break;
 		case Type::MINOR:
 			privText = "Minor";
 			shortPrivText = "m";
-			chordVect = minorVect;
+			SetRecipe(minorVect);
 			break;
 		case Type::MINOR_6:
 			privText = "Minor 6'th";
 			shortPrivText = "m6";
-			chordVect = minor_6_Vect;
+			SetRecipe(minor_6_Vect);
 			break;
 		case Type::MINOR_FLAT6:
 			privText = "Minor b6";
 			shortPrivText = "mb6";
-			chordVect = minor_flat6_Vect;
+			SetRecipe(minor_flat6_Vect);
 			break;
 		case Type::MINOR_7:
 			privText = "Minor 7'th";
 			shortPrivText = "m7";
-			chordVect = minor_7_Vect;
+			SetRecipe(minor_7_Vect);
 			break;
 		case Type::MINOR_9:
 			privText = "Minor 9'th";
 			shortPrivText = "m9";
-			chordVect = minor_9_Vect;
+			SetRecipe(minor_9_Vect);
 			break;
 		case Type::MINOR_MAJOR_7:
 			privText = "Minor major 7'th";
 			shortPrivText = "minMaj7";
-			chordVect = minor_major_7_Vect;
+			SetRecipe(minor_major_7_Vect);
 			break;
 		case Type::DOMINANT_7:
 			privText = "Dominant 7'th";
 			shortPrivText = "7";
-			chordVect = dominant_7_Vect;
+			SetRecipe(dominant_7_Vect);
 			break;
 		case Type::DOMINANT_7_FLAT5:
 			privText = "Dominant 7'th b5";
 			shortPrivText = "7b5";
-			chordVect = dominant_flat5_Vect;
+			SetRecipe(dominant_flat5_Vect);
 			break;
 		case Type::DOMINANT_7_SHARP5:
 			privText = "Dominant 7'th #5";
 			shortPrivText = "7#5";
-			chordVect = dominant_sharp5_Vect;
+			SetRecipe(dominant_sharp5_Vect);
 			break;
 		case Type::DOMINANT_7_SUS4:
 			privText = "Dominant 7'th with suspended 4'th";
 			shortPrivText = "7sus4";
-			chordVect = dominant_7_sus4;
+			SetRecipe(dominant_7_sus4);
 			break;
 		case Type::DOMINANT_7_FLAT9:
 			privText = "Dominant 7'th b9";
 			shortPrivText = "7b9";
-			chordVect = dominant_7_flat9;
+			SetRecipe(dominant_7_flat9);
 			break;
 		case Type::DOMINANT_7_SHARP9:
 			privText = "Dominant 7'th #9";
 			shortPrivText = "7#9";
-			chordVect = dominant_7_sharp9;
+			SetRecipe(dominant_7_sharp9);
 			break;
 		case Type::DOMINANT_7_SHARP5_FLAT9:
 			privText = "Dominant 7'th #5 b9";
 			shortPrivText = "7#5b9";
-			chordVect = dominant_7_sharp5_flat9;
+			SetRecipe(dominant_7_sharp5_flat9);
 			break;
 		case Type::DOMINANT_7_SHARP11:
 			privText = "Dominant 7'th #11";
 			shortPrivText = "7#11";
-			chordVect = dominant_7_sharp11;
+			SetRecipe(dominant_7_sharp11);
 			break;
 		case Type::DOMINANT_7_ADD9_FLAT5:
 			privText = "Dominant 7'th add9 b5";
 			shortPrivText = "7add9b5";
-			chordVect = dominant_7_add9_flat5;
+			SetRecipe(dominant_7_add9_flat5);
 			break;
 		case Type::DOMINANT_7_ADD9_SHARP11:
 			privText = "Dominant 7'th add9 #11";
 			shortPrivText = "7add9#11";
-			chordVect = dominant_7_add9_sharp11;
+			SetRecipe(dominant_7_add9_sharp11);
 			break;
 		case Type::DOMINANT_7_ADD13:
 			privText = "Dominant 7'th add13";
 			shortPrivText = "7add13";
-			chordVect = dominant_7_add13;
+			SetRecipe(dominant_7_add13);
 			break;
 		case Type::DOMINANT_7_SHARP9_FLAT13:
 			privText = "Dominant 7'th #9 b13";
 			shortPrivText = "7#9b13";
-			chordVect = dominant_7_sharp9_flat13;
+			SetRecipe(dominant_7_sharp9_flat13);
 			break;
 		case Type::DOMINANT_7_SHARP11_ADD13:
 			privText = "Dominant 7'th #11 add13";
 			shortPrivText = "7#11add13";
-			chordVect = dominant_7_sharp11_add13;
+			SetRecipe(dominant_7_sharp11_add13);
 			break;
 		case Type::DIMINISHED:
 			privText = "Diminished";
 			shortPrivText = "dim";
-			chordVect = diminished;
+			SetRecipe(diminished);
 			break;
 		case Type::DIMINISHED_7:
 			privText = "Diminished 7";
 			shortPrivText = "dim7";
-			chordVect = diminished_7;
+			SetRecipe(diminished_7);
 			break;
 		case Type::MINOR_7_FLAT5:
 			privText = "Minor 7 b5";
 			//shortPrivText = "m7b5";
 			shortPrivText = "0";
-			chordVect = minor_7_flat5;
+			SetRecipe(minor_7_flat5);
 			break;
 		case Type::AUGMENTED:
 			privText = "Augmented";
 			shortPrivText = "+";
-			chordVect = augmented;
+			SetRecipe(augmented);
 			break;
 		case Type::SUS4:
 			privText = "Suspended 4'th";
 			shortPrivText = "sus4";
-			chordVect = sus4;
+			SetRecipe(sus4);
 			break;
 		case Type::SUS2:
 			privText = "Suspended 2'nd";
 			shortPrivText = "sus2";
-			chordVect = sus2;
+			SetRecipe(sus2);
 			break;
 			//default:	//	Does not exist when using enum Classes!
 			// break;
@@ -185,9 +222,9 @@ Chord::Chord(Chord::Type chordTypeArg,
 	Note note(rootnote);
 	notes.push_back(note);
 	uint8_t previousnote = rootnote;
-	for (auto vect: chordVect) {
+	for (unsigned int i = 0; i < numOfIntervals; i++) {
 		// c style cast required on the Enum
-		previousnote = previousnote + (uint8_t)vect;
+		previousnote = previousnote + (uint8_t)chordVect[i];
 		Note noteU(previousnote);
 		notes.push_back(noteU);
 	}
@@ -226,8 +263,14 @@ void Chord::setVoicing(VoicingType voicingTypeArg,
 			if (voicing.back().number >= 12 ) {
 				voicing.back().number = voicing.back().number - 12;
 			}
-			// Not exactly in the right order anymore but that's ok.
 			voicing.push_back(tmpNote);
 			break;
 	}
+	
+	// Dropping notes leaves the voicing out of order, sort it so
+	// the voicing is always low to high (the bass first).
+	std::sort(voicing.begin(), voicing.end(),
+			  [](const Note &a, const Note &b) {
+		return a.number < b.number;
+	});
 };
@@ -14,8 +14,10 @@
 #define Chords_hpp
 
 #include <vector>
+#include "FixedVector.hpp"
 //#include "Harmony.hpp"
 #include "Note.hpp"
+#include "NoteSet.hpp"
 
 
 
@@ -34,7 +36,7 @@ class Chord {
 public:
 	uint8_t rootnote;
 	uint8_t bassnote;
-	enum class Type {
+	enum class Type: uint8_t {
 		MAJOR,
 		MAJOR_6,
 		MAJOR_7,
@@ -69,7 +71,7 @@ public:
 	};
 	Chord::Type chordType;
 	
-	const std::vector<Chord::Type> allChordTypes =  {
+	static constexpr Chord::Type allChordTypes[] = {
 		Type::MAJOR,
 		Type::MAJOR_6,
 		Type::MAJOR_7,
@@ -112,7 +114,8 @@ public:
 public:
 	// Vector of notes of the chord.
 	// when constructed it's in the root position.
-	std::vector<Note> notes;
+	static const unsigned int maxNotes = 8;
+	HarmonyVector<Note, maxNotes> notes;
 	
 public:
 	/*
@@ -166,77 +169,77 @@ public:
 		OCTAAF           =  12
 	};
 	
-	// Constrants
-	const std::vector<enum Iv> majorVect =
+	// Constrants (static so every Chord doesn't carry its own copy)
+	static constexpr enum Iv majorVect[] =
 	//{Iv::WW, Iv::WH};
 	{Iv::MAJOR_THIRD, Iv::MINOR_THIRD};
-	const std::vector<enum Iv> major_6_Vect =
+	static constexpr enum Iv major_6_Vect[] =
 	{Iv::WW, Iv::WH, Iv::W};
-	const std::vector<enum Iv> major_7_Vect =
+	static constexpr enum Iv major_7_Vect[] =
 	//{Iv::WW, Iv::WH, Iv::WW};
 	{Iv::MAJOR_THIRD, Iv::MINOR_THIRD, Iv::MAJOR_THIRD};
-	const std::vector<enum Iv> major_9_Vect =
+	static constexpr enum Iv major_9_Vect[] =
 	{Iv::WW, Iv::WH, Iv::WW ,Iv::WH};
-	const std::vector<enum Iv> major_7_sharp11_Vect =
+	static constexpr enum Iv major_7_sharp11_Vect[] =
 	{Iv::WW, Iv::WH, Iv::WW ,Iv::WH, Iv::WW};
-	const std::vector<enum Iv> minorVect =
+	static constexpr enum Iv minorVect[] =
 	//{Iv::WH, Iv::WW};
 	{Iv::MINOR_THIRD, Iv::MAJOR_THIRD};
-	const std::vector<enum Iv> minor_6_Vect =
+	static constexpr enum Iv minor_6_Vect[] =
 	{Iv::WH, Iv::WW, Iv::W};
-	const std::vector<enum Iv> minor_flat6_Vect =
+	static constexpr enum Iv minor_flat6_Vect[] =
 	{Iv::WH, Iv::WW, Iv::H};
-	const std::vector<enum Iv> minor_7_Vect =
+	static constexpr enum Iv minor_7_Vect[] =
 	//{Iv::WH, Iv::WW, Iv::WH};
 	{Iv::MINOR_THIRD, Iv::MAJOR_THIRD, Iv::MINOR_THIRD};
-	const std::vector<enum Iv> minor_9_Vect =
+	static constexpr enum Iv minor_9_Vect[] =
 	{Iv::WH, Iv::WW, Iv::WH, Iv::WW};
-	const std::vector<enum Iv> minor_major_7_Vect =
+	static constexpr enum Iv minor_major_7_Vect[] =
 	{Iv::WH, Iv::WW, Iv::WW};
-	const std::vector<enum Iv> dominant_7_Vect =
+	static constexpr enum Iv dominant_7_Vect[] =
 	//{Iv::WW, Iv::WH, Iv::WH};
 	{Iv::MAJOR_THIRD, Iv::MINOR_THIRD, Iv::MINOR_THIRD};
-	const std::vector<enum Iv> dominant_flat5_Vect =
+	static constexpr enum Iv dominant_flat5_Vect[] =
 	{Iv::WW, Iv::W, Iv::WW};
-	const std::vector<enum Iv> dominant_sharp5_Vect =
+	static constexpr enum Iv dominant_sharp5_Vect[] =
 	{Iv::WW, Iv::WW, Iv::W};
-	const std::vector<enum Iv> dominant_7_sus4 =
+	static constexpr enum Iv dominant_7_sus4[] =
 	{Iv::WWH, Iv::W, Iv::WH};
-	const std::vector<enum Iv> dominant_7_flat9 =
+	static constexpr enum Iv dominant_7_flat9[] =
 	{Iv::WW, Iv::WH, Iv::WH, Iv::WH};
-	const std::vector<enum Iv> dominant_7_sharp9 = \
+	static constexpr enum Iv dominant_7_sharp9[] =
 	{Iv::WW, Iv::WH, Iv::WH, Iv::WWH};
 	// As the intervals are getting larger using the Dutch intervals for
 	// the definitions instead of wholes and halfs.
-	const std::vector<enum Iv> dominant_7_sharp5_flat9 =
+	static constexpr enum Iv dominant_7_sharp5_flat9[] =
 	{Iv::GROTE_TERTS, Iv::GROTE_TERTS, Iv::GROTE_SECUNDE, Iv::KLEINE_TERTS};
-	const std::vector<enum Iv> dominant_7_sharp11 =
+	static constexpr enum Iv dominant_7_sharp11[] =
 	{Iv::GROTE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_SEXT};
-	const std::vector<enum Iv> dominant_7_add9_flat5 =
+	static constexpr enum Iv dominant_7_add9_flat5[] =
 	{Iv::GROTE_TERTS, Iv::GROTE_SECUNDE, Iv::GROTE_TERTS, Iv::GROTE_TERTS};
-	const std::vector<enum Iv> dominant_7_add9_sharp11 =
+	static constexpr enum Iv dominant_7_add9_sharp11[] =
 	{Iv::GROTE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS,
 		Iv::GROTE_TERTS, Iv::GROTE_TERTS};
-	const std::vector<enum Iv> dominant_7_add13 =
+	static constexpr enum Iv dominant_7_add13[] =
 	{Iv::GROTE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS,
 		Iv::GROTE_SEPTIEM};
-	const std::vector<enum Iv> dominant_7_sharp9_flat13 =
+	static constexpr enum Iv dominant_7_sharp9_flat13[] =
 	{Iv::GROTE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS,
 		Iv::REINE_KWART, Iv::REINE_KWART};
-	const std::vector<enum Iv> dominant_7_sharp11_add13 =
+	static constexpr enum Iv dominant_7_sharp11_add13[] =
 	{Iv::GROTE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS,
 		Iv::KLEINE_SEXT, Iv::KLEINE_TERTS};
-	const std::vector<enum Iv> diminished =
+	static constexpr enum Iv diminished[] =
 	{Iv::KLEINE_TERTS, Iv::KLEINE_TERTS};
-	const std::vector<enum Iv> diminished_7 =
+	static constexpr enum Iv diminished_7[] =
 	{Iv::KLEINE_TERTS, Iv::KLEINE_TERTS, Iv::KLEINE_TERTS};
-	const std::vector<enum Iv> minor_7_flat5 =
+	static constexpr enum Iv minor_7_flat5[] =
 	{Iv::KLEINE_TERTS, Iv::KLEINE_TERTS, Iv::GROTE_TERTS};
-	const std::vector<enum Iv> augmented =
+	static constexpr enum Iv augmented[] =
 	{Iv::GROTE_TERTS, Iv::GROTE_TERTS};
-	const std::vector<enum Iv> sus4 =
+	static constexpr enum Iv sus4[] =
 	{Iv::REINE_KWART, Iv::GROTE_SECUNDE};
-	const std::vector<enum Iv> sus2 =
+	static constexpr enum Iv sus2[] =
 	{Iv::GROTE_SECUNDE, Iv::REINE_KWART};
 	// TODO: Finish the rest of the chords.
 	
@@ -249,21 +252,51 @@ public: enum class VoicingType {
 public:
 	void setVoicing(Chord::VoicingType voicingTypeArg,
 					bool dropRootDown);
-public: std::vector<Note> voicing;
+public: HarmonyVector<Note, maxNotes> voicing;
+	
+	// The notes as bit sets, e.g. to check if a chord fits in a mode
+	// mode.PitchClasses().Contains(chord.PitchClasses())
+public: PitchClassSet PitchClasses() {
+	PitchClassSet set;
+	for (auto note: notes) {
+		set.Add(note.number);
+	}
+	return set;
+};
+public: NoteSet Set() {
+	NoteSet set;
+	for (auto note: notes) {
+		set.Add(note.number);
+	}
+	return set;
+};
+public: NoteSet VoicingSet() {
+	NoteSet set;
+	for (auto note: voicing) {
+		set.Add(note.number);
+	}
+	return set;
+};
 	
 	// Text representation of the Chords.
-private: std::string privText;
+private: const char *privText;
 public: std::string Text() {
 	return Note::ToText(rootnote, false, false) + " " + privText;
 };
 	
-private: std::string shortPrivText;
+private: const char *shortPrivText;
 public: std::string ShortText() {
 	return Note::ToText(rootnote, false, false) + shortPrivText;
 };
-	// Vector describing the Chord Recipe.
+	// Array describing the Chord Recipe.
 	// assigned in constructor.
-private: std::vector<enum Iv> chordVect;
+private: const enum Iv *chordVect;
+	unsigned int numOfIntervals;
+	template<std::size_t N>
+	void SetRecipe(const enum Iv (&recipe)[N]) {
+		chordVect = recipe;
+		numOfIntervals = N;
+	};
 };
 
 
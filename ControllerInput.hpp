@@ -0,0 +1,57 @@
+/** @file ControllerInput.hpp
+ *
+ * A potmeter, ribbon or breath sensor read by an ADC as a MIDI
+ * controller: the 16 bit readings are smoothed with a OneEuroFilter,
+ * scaled to 7 bits and an event is made when the value changes.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef ControllerInput_hpp
+#define ControllerInput_hpp
+
+#include <cstdint>
+#include "Ump.hpp"
+#include "OneEuroFilter.hpp"
+
+
+class ControllerInput {
+public:
+	ControllerInput(uint8_t statusArg, uint8_t controllerArg,
+					const OneEuroFilter::Parameters &parameters) noexcept
+		: filter(parameters), status(statusArg), controller(controllerArg),
+		  value(0), sent(noValue) {};
+
+	/** A reading taken dt us after the previous one.  Returns true
+	 * with the control change in 'event' when the value changed.
+	 */
+	bool Update(uint16_t raw, uint32_t dt, UmpEvent &event) {
+		// MIDI only uses 7 bits (16-9 = 7)
+		value = (uint8_t)((uint32_t)filter.Filter(raw, dt) >> 9) & 0x7F;
+		if (value == sent) {
+			return false;
+		}
+		sent = value;
+		event = UmpEvent::Midi1(status, controller, value);
+		return true;
+	};
+	uint8_t Value() const {
+		return value;
+	};
+	OneEuroFilter &Filter() {
+		return filter;
+	};
+
+private:
+	static const uint8_t noValue = 0xFF;
+
+	OneEuroFilter filter;
+	uint8_t status;
+	uint8_t controller;
+	uint8_t value;
+	uint8_t sent;
+};
+
+
+#endif /* ControllerInput_hpp */
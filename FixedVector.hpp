@@ -0,0 +1,132 @@
+/** @file FixedVector.hpp
+ *
+ * Harmony implements Notes, Scales, Modes, Chords
+ * the intent is to keep this library as clean
+ * as possible to allow implementation on hardware
+ * platforms such as ARM MBED OS.
+ *
+ * On an RTOS with a small heap std::vector fragments the heap and
+ * gives non deterministic latency in the MIDI handlers.  When
+ * HARMONY_HEAP_FREE is set (the default) the library uses FixedVector,
+ * a vector with a fixed capacity that lives inside the object, and
+ * never touches the heap.  Set HARMONY_HEAP_FREE to 0 to use
+ * std::vector (e.g. on a desktop).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef FixedVector_hpp
+#define FixedVector_hpp
+
+#include <cstddef>
+#include <new>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+#ifndef HARMONY_HEAP_FREE
+#define HARMONY_HEAP_FREE 1
+#endif
+
+
+/** Vector with storage for N elements inside the object.
+ * Only the subset of std::vector used by the library is implemented.
+ * No exceptions are used: push_back() on a full vector drops the
+ * element, check Full() when that matters.
+ */
+template<class T, std::size_t N>
+class FixedVector {
+public:
+	typedef T value_type;
+	typedef T *iterator;
+	typedef const T *const_iterator;
+	typedef std::size_t size_type;
+	
+	FixedVector() noexcept : count(0) {};
+	FixedVector(std::initializer_list<T> list) noexcept : count(0) {
+		for (const T &item: list) {
+			push_back(item);
+		}
+	};
+	FixedVector(const FixedVector &other) noexcept : count(0) {
+		for (const T &item: other) {
+			push_back(item);
+		}
+	};
+	FixedVector &operator=(const FixedVector &other) noexcept {
+		if (this != &other) {
+			clear();
+			for (const T &item: other) {
+				push_back(item);
+			}
+		}
+		return *this;
+	};
+	~FixedVector() {
+		clear();
+	};
+	
+	void push_back(const T &item) {
+		if (count < N) {
+			new (&data()[count]) T(item);
+			count++;
+		}
+	};
+	void pop_back() {
+		if (count > 0) {
+			count--;
+			data()[count].~T();
+		}
+	};
+	void clear() {
+		while (count > 0) {
+			pop_back();
+		}
+	};
+	/** Nothing to reserve, keeps the std::vector interface.
+	 */
+	void reserve(size_type) {};
+	
+	size_type size() const { return count; };
+	size_type capacity() const { return N; };
+	bool empty() const { return count == 0; };
+	bool Full() const { return count == N; };
+	
+	T &operator[](size_type i) { return data()[i]; };
+	const T &operator[](size_type i) const { return data()[i]; };
+	T &front() { return data()[0]; };
+	const T &front() const { return data()[0]; };
+	T &back() { return data()[count - 1]; };
+	const T &back() const { return data()[count - 1]; };
+	
+	iterator begin() { return data(); };
+	iterator end() { return data() + count; };
+	const_iterator begin() const { return data(); };
+	const_iterator end() const { return data() + count; };
+	
+private:
+	T *data() {
+		return reinterpret_cast<T *>(storage);
+	};
+	const T *data() const {
+		return reinterpret_cast<const T *>(storage);
+	};
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[N];
+	size_type count;
+};
+
+
+/** Container used by the Harmony classes, N is the most elements
+ * that will ever be stored.
+ */
+#if HARMONY_HEAP_FREE
+template<class T, std::size_t N>
+using HarmonyVector = FixedVector<T, N>;
+#else
+template<class T, std::size_t N>
+using HarmonyVector = std::vector<T>;
+#endif
+
+
+#endif /* FixedVector_hpp */
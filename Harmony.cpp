@@ -13,6 +13,7 @@
  * @date 13/12/2020
  * @copyright APACHE-2.0
  */
+#include <atomic>
 #include "Harmony.hpp"
 #include "Mode.hpp"
 
@@ -23,90 +24,236 @@
 // First select the mode
 // then iterate over the notes.
 
+/*
+ * Cache of the diatonic chords, indexed by type of scale and mode.
+ * Chromatic and larger scales don't have thirds so at most
+ * 8 degrees are stored.
+ */
+static const unsigned int numOfScaleTypes =
+	(unsigned int)Scale::TypeOfScale::MINOR_PENTATONIC + 1;
+static const unsigned int maxModes = 7;
+static const unsigned int maxDegrees = 8;
+static ChordProgression::DiatonicChord
+	diatonicCache[numOfScaleTypes][maxModes][maxDegrees];
+/*
+ * An entry is filled by the thread that moves it from EMPTY to FILLING
+ * and published with READY, readers only use READY entries.
+ */
+enum DiatonicState: uint8_t {
+	EMPTY,
+	FILLING,
+	READY
+};
+static std::atomic<uint8_t> diatonicState[numOfScaleTypes][maxModes];
+
+
+/*
+ * Semitones between the root of the mode and degree 'j' counting
+ * beyond the octave (j can be larger than the number of notes).
+ */
+static int DegreeOffset(Mode &mode, unsigned int j) {
+	unsigned long n = mode.notes.size();
+	return mode.notes[j % n].number - mode.notes[0].number
+		+ 12 * (int)(j / n);
+}
+
+
+/*
+ * Root note of a degree, folded down an octave at a time when it is
+ * above the MIDI range (high roots in modes with a wide span).
+ */
+static uint8_t RootOf(unsigned int note) {
+	while (note > 127) {
+		note -= 12;
+	}
+	return (uint8_t)note;
+}
+
+
+/*
+ * Chord quality from the stacked thirds (intervals above the root).
+ */
+static Chord::Type TriadType(int third, int fifth) {
+	if (third == 4 && fifth == 8) return Chord::Type::AUGMENTED;
+	if (third == 3 && fifth == 6) return Chord::Type::DIMINISHED;
+	if (third == 4) return Chord::Type::MAJOR;
+	if (third == 3) return Chord::Type::MINOR;
+	if (third == 5) return Chord::Type::SUS4;
+	return Chord::Type::SUS2;
+}
+
+static Chord::Type SeventhType(int third, int fifth, int seventh) {
+	if (third == 4 && fifth == 7 && seventh == 11) return Chord::Type::MAJOR_7;
+	if (third == 4 && fifth == 7 && seventh == 10) return Chord::Type::DOMINANT_7;
+	if (third == 4 && fifth == 7 && seventh == 9) return Chord::Type::MAJOR_6;
+	if (third == 4 && fifth == 8 && seventh == 10) return Chord::Type::DOMINANT_7_SHARP5;
+	if (third == 4 && fifth == 6 && seventh == 10) return Chord::Type::DOMINANT_7_FLAT5;
+	if (third == 3 && fifth == 7 && seventh == 10) return Chord::Type::MINOR_7;
+	if (third == 3 && fifth == 7 && seventh == 11) return Chord::Type::MINOR_MAJOR_7;
+	if (third == 3 && fifth == 7 && seventh == 9) return Chord::Type::MINOR_6;
+	if (third == 3 && fifth == 7 && seventh == 8) return Chord::Type::MINOR_FLAT6;
+	if (third == 3 && fifth == 6 && seventh == 10) return Chord::Type::MINOR_7_FLAT5;
+	if (third == 3 && fifth == 6 && seventh == 9) return Chord::Type::DIMINISHED_7;
+	if (third == 5 && fifth == 7 && seventh == 10) return Chord::Type::DOMINANT_7_SUS4;
+	// No seventh chord for this combination (e.g. augmented major 7)
+	return TriadType(third, fifth);
+}
+
+
+const ChordProgression::DiatonicChord *ChordProgression::DiatonicChords
+ (
+	Scale &scl,
+	unsigned int modenum )
+{
+	unsigned int scaleIndex = (unsigned int)scl.typeOfScale;
+	
+	if (scaleIndex >= numOfScaleTypes ||
+		modenum >= maxModes ||
+		modenum >= scl.modes.size()) {
+		return nullptr;
+	}
+	Mode &mode = scl.modes[modenum];
+	unsigned long n = mode.notes.size();
+	if (n < 5 || n > maxDegrees) {
+		return nullptr;
+	}
+	
+	DiatonicChord *table = diatonicCache[scaleIndex][modenum];
+	std::atomic<uint8_t> &state = diatonicState[scaleIndex][modenum];
+	uint8_t expected = EMPTY;
+	if (state.load(std::memory_order_acquire) != READY) {
+		if (!state.compare_exchange_strong(expected, FILLING,
+										   std::memory_order_acquire)) {
+			// READY by now, or another thread is filling it and
+			// waiting for a lower priority thread could block forever.
+			return expected == READY ? table : nullptr;
+		}
+		for (unsigned int i = 0; i < n; i++) {
+			int root = DegreeOffset(mode, i);
+			int third = DegreeOffset(mode, i + 2) - root;
+			int fifth = DegreeOffset(mode, i + 4) - root;
+			int seventh = DegreeOffset(mode, i + 6) - root;
+			table[i].offset = (uint8_t)root;
+			table[i].triad = TriadType(third, fifth);
+			table[i].seventh = SeventhType(third, fifth, seventh);
+		}
+		state.store(READY, std::memory_order_release);
+	}
+	return table;
+}
+
+
+void ChordProgression::Precompute(Scale &scl) {
+	for (unsigned int i = 0; i < scl.modes.size(); i++) {
+		DiatonicChords(scl, i);
+	}
+}
+
+
+void ChordProgression::Precompute() {
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		Scale scl(typeOfScale, 0);
+		Precompute(scl);
+	}
+}
+
+
+/*
+ * Degrees of every type of progression.
+ * V_of_V is the secondary dominant (V of V) on the second degree
+ * resolving to V and I.
+ */
+static const uint8_t progII_V_I[] = {
+	ChordProgression::II, ChordProgression::V, ChordProgression::I
+};
+static const uint8_t progI_VI_II_V[] = {
+	ChordProgression::I, ChordProgression::VI,
+	ChordProgression::II, ChordProgression::V
+};
+static const uint8_t progIII_VI_II_V[] = {
+	ChordProgression::III, ChordProgression::VI,
+	ChordProgression::II, ChordProgression::V
+};
+static const uint8_t progI_II_III_IV[] = {
+	ChordProgression::I, ChordProgression::II,
+	ChordProgression::III, ChordProgression::IV
+};
+
 
 ChordProgression::ChordProgression
  (
 	Scale &scl,
 	unsigned int modenum,
-	Type progType )
-: scale(scl), fullrangemode(scl.modes[modenum])
+	Type progType,
+	bool sevenths )
+: scale(scl)
 {
-	 Mode mode = scale.modes[modenum];
-	 std::vector<Note> secondoctave;
-	 
-	 std::cout << "ChordProgression::"
-				<< scale.Text()
-				<< "|" << mode.Name() << "|"
-				<< std::endl;
-
-	
+	const uint8_t *degrees = progII_V_I;
+	bool secondaryDominant = false;
 	
+	numOfSteps = 0;
 	
-	 // We need to add another octave to the modes of this scale
-	 for(Note note: mode.notes) {
-		 Note note2{note.number + 12};	//	octave is 12 semi-tones.
-		 secondoctave.push_back(note2);
-	 }
-	 // append the vector we just created to the existing mode.
-	 mode.notes.insert(mode.notes.end(),
-					   secondoctave.begin(),
-					   secondoctave.end());
+	// What progression to choose?
+	switch(progType) {
+		case Type::II_V_I:
+			degrees = progII_V_I;
+			numOfSteps = sizeof(progII_V_I);
+			break;
+		case Type::V_of_V:
+			degrees = progII_V_I;
+			numOfSteps = sizeof(progII_V_I);
+			secondaryDominant = true;
+			break;
+		case Type::I_VI_II_V:
+			degrees = progI_VI_II_V;
+			numOfSteps = sizeof(progI_VI_II_V);
+			break;
+		case Type::III_VI_II_V:
+			degrees = progIII_VI_II_V;
+			numOfSteps = sizeof(progIII_VI_II_V);
+			break;
+		case Type::I_II_III_IV:
+			degrees = progI_II_III_IV;
+			numOfSteps = sizeof(progI_II_III_IV);
+			break;
+	};
 	
-	 // What mode to choose?  
-	 switch(progType) {
-		 case Type::II_V_I:
-			 std::cout << "II V I progression" << std::endl;
-			 std::cout << "|"
-			 << mode.notes[Offset::II + 0].Name() << "|"
-			 << mode.notes[Offset::II + 2].Name() << "|"
-			 << mode.notes[Offset::II + 4].Name() << "|"
-			 << mode.notes[Offset::II + 6].Name() << std::endl;
-			 
-			 // In order to do these progressions we need
-			 // to have two octaves at least in the scale.
-			 std::cout << "|"
-			 << mode.notes[Offset::V + 0].Name() << "|"
-			 << mode.notes[Offset::V + 2].Name() << "|"
-			 << mode.notes[Offset::V + 4].Name() << "|"
-			 << mode.notes[Offset::V + 6].Name() << std::endl;
-			 
-			 std::cout << "|"
-			 << mode.notes[Offset::I + 0].Name() << "|"
-			 << mode.notes[Offset::I + 2].Name() << "|"
-			 << mode.notes[Offset::I + 4].Name() << "|"
-			 << mode.notes[Offset::I + 6].Name() << std::endl;
-			 break;
-		 case Type::V_of_V:
-			 break;
-		 case Type::I_VI_II_V:
-			 break;
-		 case Type::III_VI_II_V:
-			 break;
-		 case Type::I_II_III_IV:
-			 break;
-		 default:
-			 break;
-	 };
-	 
-	// Find the lowest note number in the scale mode used
-	// e.g. for a D major scale C# is the lowest note in the octave.
-	// This can be found by substracting 12 (an octave) from
-	// every note in the scale mode and making sure it's higher than 0.
-	for(Note note: mode.notes) {
-	//	int j = (unsigned int)note.number % 12;
-	//	std::cout << "[" << j << "](" << (unsigned int) note.number;
-		note.number = (unsigned int)note.number % 12;
-	//	std::cout << "[" << j << "]"<< note.Name() << ".";
+	const DiatonicChord *table = DiatonicChords(scale, modenum);
+	if (table == nullptr) {
+		numOfSteps = 0;
+		return;
 	}
+	uint8_t rootNote = scale.modes[modenum].notes.front().number;
+	unsigned long numOfDegrees = scale.modes[modenum].notes.size();
 	
-	mode.Order(Mode::NoteOrder::HIGH_TO_LOW);
-	for(Note note: mode.notes) {
-		std::cout << note.Text()
-		<< "(" << (unsigned int) note.number  << ")";
+	for (unsigned int i = 0; i < numOfSteps; i++) {
+		const DiatonicChord &degree = table[degrees[i] % numOfDegrees];
+		steps[i].rootnote = RootOf(rootNote + degree.offset);
+		steps[i].chordType = sevenths ? degree.seventh : degree.triad;
+		
+		// The secondary dominant is always a dominant chord (major
+		// in case of triads) a whole step above the root whatever
+		// the mode says.
+		if (secondaryDominant && i == 0) {
+			steps[i].rootnote = RootOf(rootNote + 2);
+			steps[i].chordType = sevenths ?
+				Chord::Type::DOMINANT_7 : Chord::Type::MAJOR;
+		}
 	}
-	std::cout << std::endl;
-	
- };
+};
+
+
+const HarmonyVector<Chord, ChordProgression::maxChords> &
+ChordProgression::Chords() {
+	if (chords.empty()) {
+		for (unsigned int i = 0; i < numOfSteps; i++) {
+			chords.push_back(Chord(steps[i].chordType,
+								   steps[i].rootnote,
+								   steps[i].rootnote));
+		}
+	}
+	return chords;
+}
 
 	
 /* EOF */
@@ -14,13 +14,14 @@
 #define Harmony_hpp
 
 //#include <stdio.h>
-#include <iostream>
 
 // This is the top level include file for the following Class implementations
 #include "Chord.hpp"
 #include "Note.hpp"
+#include "NoteSet.hpp"
 #include "Mode.hpp"
 #include "Scale.hpp"
+#include "VoiceLeading.hpp"
 
 
 /*
@@ -29,6 +30,14 @@
  * Otherwise we need to expand way to much down here
  * to find all the chord qualities based on the progression
  * mode and scale used.
+ *
+ * The chord qualities of every degree are found by stacking thirds
+ * within the mode.  They only depend on the type of scale and the mode
+ * (not on the root note) so they are calculated once and cached in a
+ * table.  Call Precompute() at boot, before the threads start, after
+ * that the table is only read.  Constructing a progression fills
+ * Steps() and does not allocate, the Chord objects are only built
+ * when Chords() is asked for.
  */
 class ChordProgression {
 public:
@@ -50,12 +59,64 @@ public:
 		III_VI_II_V,
 		I_II_III_IV
 	};
+	
+	/** Diatonic chord on one degree of a mode
+	 * offset is in semitones above the root of the mode.
+	 */
+	struct DiatonicChord {
+		uint8_t offset;
+		Chord::Type triad;
+		Chord::Type seventh;
+	};
+	
+	/** Every progression has at most this many chords.
+	 */
+	static const unsigned int maxChords = 4;
+	
+	/** One chord of the progression without constructing a Chord.
+	 */
+	struct Step {
+		uint8_t rootnote;
+		Chord::Type chordType;
+	};
+	
 	ChordProgression(Scale &scl,
 					 unsigned int modenum, 
-					 Type progType);
-	Mode fullrangemode;
+					 Type progType,
+					 bool sevenths = true);
+	
+	/** The chords of this progression in the order they are played,
+	 * built on the first call.
+	 */
+	const HarmonyVector<Chord, maxChords> &Chords();
+	const Step &Steps(unsigned int i) {
+		return steps[i];
+	};
+	unsigned int NumOfChords() {
+		return numOfSteps;
+	};
+	
+	/** Cached table with the diatonic triads and sevenths of every
+	 * degree of the mode (mode.NumOfNotes() entries).  Returns nullptr
+	 * when the scale does not have stacked thirds (chromatic), and
+	 * while another thread is filling the entry (Precompute() was not
+	 * called at boot).
+	 */
+	static const DiatonicChord *DiatonicChords(Scale &scl,
+											   unsigned int modenum);
+	
+	/** Fill the cache for all modes of the scale.
+	 */
+	static void Precompute(Scale &scl);
+	/** Fill the cache for every type of scale, call this at boot before
+	 * the threads start so no MIDI handler fills it.
+	 */
+	static void Precompute();
+	
 private:
-	std::vector<Chord> chords;
+	HarmonyVector<Chord, maxChords> chords;	// Empty until Chords().
+	Step steps[maxChords];
+	unsigned int numOfSteps;
 	Scale &scale;
 };
 
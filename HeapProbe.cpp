@@ -0,0 +1,109 @@
+/** @file HeapProbe.cpp
+ *
+ * Heap use per MIDI handler and per Harmony constructor.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include "HeapProbe.hpp"
+
+
+HeapProbe::SiteStats HeapProbe::stats[HeapProbe::numOfSites];
+
+
+const char *HeapProbe::Name(Site site) {
+	static const char *const names[numOfSites] = {
+		"note on",
+		"note off",
+		"control",
+		"pitchwheel",
+		"realtime",
+		"other",
+		"Scale",
+		"Mode",
+		"Chord"
+	};
+	return site < numOfSites ? names[site] : "?";
+}
+
+
+HeapProbe::Site HeapProbe::SiteOf(uint8_t status) {
+	if (status >= 0xF8) {
+		return REALTIME;
+	}
+	switch (status & 0xF0) {
+		case 0x80:
+			return NOTE_OFF;
+		case 0x90:
+			return NOTE_ON;
+		case 0xB0:
+			return CONTROL_CHANGE;
+		case 0xE0:
+			return PITCHWHEEL;
+		default:
+			return OTHER;
+	}
+}
+
+
+void HeapProbe::Charge(Site site, const HeapCounters &start,
+					   const HeapCounters &end) {
+	SiteStats &s = stats[site];
+	uint32_t allocs = end.allocs - start.allocs;
+
+	s.calls++;
+	if (allocs == 0) {
+		return;
+	}
+	s.allocating++;
+	s.allocs += allocs;
+	s.bytes += end.bytes - start.bytes;
+	// Exact when the call set a new high water mark, otherwise what
+	// it left allocated is all that is known.
+	uint32_t peak = 0;
+	if (end.peak > start.peak) {
+		peak = end.peak - start.current;
+	}
+	else if (end.current > start.current) {
+		peak = end.current - start.current;
+	}
+	if (peak > s.peak) {
+		s.peak = peak;
+	}
+}
+
+
+uint32_t HeapProbe::Allocs() {
+	uint32_t allocs = 0;
+	for (unsigned int i = 0; i < numOfSites; i++) {
+		allocs += stats[i].allocs;
+	}
+	return allocs;
+}
+
+
+void HeapProbe::Print() {
+	for (unsigned int i = 0; i < numOfSites; i++) {
+		const SiteStats &s = stats[i];
+		if (s.calls == 0) {
+			continue;
+		}
+		printf("heap %-10s %8lu calls %6lu allocating %7lu allocs "
+			   "%8lu bytes peak %6lu\n",
+			   Name((Site)i), (unsigned long)s.calls,
+			   (unsigned long)s.allocating, (unsigned long)s.allocs,
+			   (unsigned long)s.bytes, (unsigned long)s.peak);
+	}
+}
+
+
+void HeapProbe::Clear() {
+	for (unsigned int i = 0; i < numOfSites; i++) {
+		stats[i] = SiteStats();
+	}
+}
+
+
+/* EOF */
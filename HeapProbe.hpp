@@ -0,0 +1,120 @@
+/** @file HeapProbe.hpp
+ *
+ * Heap use per MIDI handler and per Harmony constructor: how often
+ * they ran, how many allocations and bytes they made and how far
+ * they pushed the heap up.  A HEAP_PROBE_SCOPE(site) at the top of a
+ * function charges everything allocated until it returns to that
+ * site, nested scopes are charged to both.
+ *
+ * The counters come from heap_counters(), which the platform
+ * provides: mbed's heap statistics on the board (main.cpp), counting
+ * operator new and delete on a host (sim/HostHeap.cpp).  Allocations
+ * by other threads while a scope is open are charged to it as well.
+ *
+ * Set HEAP_PROBE to 1 to build the probes in, it follows
+ * MBED_HEAP_STATS_ENABLED when not set.  Without it the scopes are
+ * empty and nothing is counted.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef HeapProbe_hpp
+#define HeapProbe_hpp
+
+#include <cstdint>
+
+#ifndef HEAP_PROBE
+#if defined(MBED_HEAP_STATS_ENABLED) && MBED_HEAP_STATS_ENABLED
+#define HEAP_PROBE 1
+#else
+#define HEAP_PROBE 0
+#endif
+#endif
+
+
+/** Totals since boot, the platform fills them in.
+ */
+struct HeapCounters {
+	uint32_t allocs;	// Allocations made.
+	uint32_t bytes;		// Bytes allocated.
+	uint32_t current;	// Bytes in use.
+	uint32_t peak;		// Most bytes ever in use.
+};
+
+void heap_counters(HeapCounters &counters);
+
+
+class HeapProbe {
+public:
+	enum Site {
+		NOTE_ON,
+		NOTE_OFF,
+		CONTROL_CHANGE,
+		PITCHWHEEL,
+		REALTIME,
+		OTHER,			// Other channel and system messages.
+		SCALE,
+		MODE,
+		CHORD,
+		numOfSites
+	};
+
+	struct SiteStats {
+		uint32_t calls;
+		uint32_t allocating;	// Calls that allocated.
+		uint32_t allocs;
+		uint32_t bytes;
+		uint32_t peak;			// Most a call raised the heap by.
+	};
+
+	/** Charges the heap use until it goes out of scope to 'site'.
+	 */
+	class Scope {
+	public:
+		Scope(Site siteArg) : site(siteArg) {
+			heap_counters(start);
+		};
+		~Scope() {
+			HeapCounters end;
+			heap_counters(end);
+			Charge(site, start, end);
+		};
+
+	private:
+		Site site;
+		HeapCounters start;
+	};
+
+	static const SiteStats &Stats(Site site) {
+		return stats[site];
+	};
+	static const char *Name(Site site);
+	/** The handler site of a MIDI status byte.
+	 */
+	static Site SiteOf(uint8_t status);
+	/** Allocations of all sites together.
+	 */
+	static uint32_t Allocs();
+
+	/** One line per site that ran, on the console.
+	 */
+	static void Print();
+	static void Clear();
+
+private:
+	static void Charge(Site site, const HeapCounters &start,
+					   const HeapCounters &end);
+
+	static SiteStats stats[numOfSites];
+};
+
+
+#if HEAP_PROBE
+#define HEAP_PROBE_SCOPE(site) HeapProbe::Scope heapProbeScope(HeapProbe::site)
+#else
+#define HEAP_PROBE_SCOPE(site)
+#endif
+
+
+#endif /* HeapProbe_hpp */
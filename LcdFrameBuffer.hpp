@@ -0,0 +1,150 @@
+/** @file LcdFrameBuffer.hpp
+ *
+ * RAM copy of a character LCD.  Writers only change the buffer, which
+ * is cheap and safe from any thread; a renderer calls Flush() now and
+ * then to send the cells that changed to the display.  Every I2C
+ * transaction to a PCF8574 backpack blocks for a while, so only
+ * characters that differ from what the display shows are sent and the
+ * address is only set when the cursor is not already there.
+ *
+ * Flush() takes any LCD class with write(command) and putchar(c),
+ * like I2cLcd.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef LcdFrameBuffer_hpp
+#define LcdFrameBuffer_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+
+class LcdFrameBuffer {
+public:
+	static const unsigned int columns = 16;
+	static const unsigned int rows = 2;
+	static const unsigned int cells = columns * rows;
+
+	/** Counters to see what the diffing saves: a full redraw costs
+	 * cells + rows transactions.
+	 */
+	struct Statistics {
+		uint32_t flushes;
+		uint32_t characters;	// putchar transactions.
+		uint32_t addresses;		// Set DDRAM address transactions.
+		uint32_t unchanged;		// Dirty cells that showed the same already.
+	};
+
+	LcdFrameBuffer() noexcept {
+		for (unsigned int i = 0; i < cells; i++) {
+			text[i] = ' ';
+			shown[i] = 0;	// Unknown, the first flush draws everything.
+		}
+		dirty.store(allCells);
+		stats = Statistics();
+	};
+
+	/** Put a character, O(1).
+	 */
+	void Put(unsigned int row, unsigned int column, char c) {
+		if (row >= rows || column >= columns) {
+			return;
+		}
+		unsigned int cell = row * columns + column;
+		if (text[cell] != c) {
+			text[cell] = c;
+			dirty.fetch_or(1ul << cell);
+		}
+	};
+
+	/** Text from 'column' on, the rest of the row is cleared when
+	 * fill is set.
+	 */
+	void Print(unsigned int row, unsigned int column, const char *str,
+			   bool fill = true) {
+		while (column < columns && *str) {
+			Put(row, column++, *str++);
+		}
+		while (fill && column < columns) {
+			Put(row, column++, ' ');
+		}
+	};
+
+	/** Send at most maxChars changed cells to the LCD, returns the
+	 * number of transactions.  Cells left over stay dirty.
+	 */
+	template<class Lcd>
+	unsigned int Flush(Lcd &lcd, unsigned int maxChars = cells) {
+		uint32_t todo = dirty.exchange(0);
+		unsigned int transactions = 0;
+		unsigned int chars = 0;
+		int cursor = -1;	// Unknown
+
+		stats.flushes++;
+		while (todo) {
+			unsigned int cell = __builtin_ctz(todo);
+			todo &= todo - 1;
+			char c = text[cell];
+			if (c == shown[cell]) {
+				stats.unchanged++;
+				continue;
+			}
+			if (chars == maxChars) {
+				dirty.fetch_or(todo | (1ul << cell));
+				break;
+			}
+			if (cursor != (int)cell) {
+				lcd.write(setAddress | Address(cell));
+				stats.addresses++;
+				transactions++;
+			}
+			lcd.putchar(c);
+			shown[cell] = c;
+			stats.characters++;
+			transactions++;
+			chars++;
+			// The LCD moves the cursor on, but not from the end of one
+			// row to the start of the next.
+			cursor = ((cell + 1) % columns) ? (int)cell + 1 : -1;
+		}
+		return transactions;
+	};
+
+	/** Make the next Flush() redraw everything, e.g. after the LCD
+	 * was cleared or reset.
+	 */
+	void Invalidate() {
+		for (unsigned int i = 0; i < cells; i++) {
+			shown[i] = 0;
+		}
+		dirty.store(allCells);
+	};
+
+	const Statistics &Stats() const {
+		return stats;
+	};
+
+private:
+	static_assert(cells <= 32, "dirty bits are one word");
+	static const uint32_t allCells = (uint32_t)((1ull << cells) - 1);
+	static const uint8_t setAddress = 0x80;		// HD44780 set DDRAM address
+
+	/** HD44780 DDRAM address: rows 0 and 1 start at 0x00 and 0x40,
+	 * rows 2 and 3 of a 4 line display follow on after those.
+	 */
+	static uint8_t Address(unsigned int cell) {
+		static const uint8_t rowStart[4] = { 0x00, 0x40, 0x14, 0x54 };
+		return rowStart[cell / columns] + cell % columns;
+	};
+
+	char text[cells];
+	char shown[cells];		// What the LCD shows, only used by Flush().
+	std::atomic<uint32_t> dirty;
+	Statistics stats;
+};
+
+
+#endif /* LcdFrameBuffer_hpp */
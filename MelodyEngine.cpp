@@ -0,0 +1,205 @@
+/** @file MelodyEngine.cpp
+ *
+ * Generative melodies in a scale.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MelodyEngine.hpp"
+#include "StaticScale.hpp"
+
+
+// Mostly steps, now and then a leap, C2 to C5.
+const MelodyEngine::Parameters MelodyEngine::defaults = {
+	48, 84,
+	{2, 16, 10, 5, 3, 2, 1, 1},
+	60, 2, 1, 90, 20
+};
+
+
+MelodyEngine::MelodyEngine(Sink sinkArg, uint8_t channelArg,
+						   uint32_t seedArg) noexcept
+: random(seedArg)
+{
+	sink = sinkArg;
+	channel = channelArg & 0x0F;
+	seed = seedArg ? seedArg : 1;
+	scale = StaticScale<Scale::TypeOfScale::MAJOR, 0>::PitchClasses(0);
+	playing = none;
+	onStep = 0;
+	lastNote = none;
+	SetParameters(defaults);
+	Restart();
+}
+
+
+void MelodyEngine::SetParameters(const Parameters &parametersArg) {
+	parameters = parametersArg;
+	if (parameters.high > 127) {
+		parameters.high = 127;
+	}
+	if (parameters.low > parameters.high) {
+		parameters.low = parameters.high;
+	}
+	if (parameters.density > 100) {
+		parameters.density = 100;
+	}
+	if (parameters.bars == 0) {
+		parameters.bars = 1;
+	}
+	if (parameters.gate == 0) {
+		parameters.gate = 1;
+	}
+	uint16_t sum = 0;
+	for (unsigned int i = 0; i <= maxLeap; i++) {
+		sum += parameters.leapWeights[i];
+		cumulative[i] = sum;
+	}
+	BuildNotes();
+}
+
+
+void MelodyEngine::SetScale(PitchClassSet pcs) {
+	scale = pcs;
+	BuildNotes();
+}
+
+
+/** Notes of the scale in the range, the walk goes on from the one
+ * nearest to the last note.
+ */
+void MelodyEngine::BuildNotes() {
+	numOfNotes = 0;
+	for (unsigned int note = parameters.low; note <= parameters.high; note++) {
+		if (scale.Contains(note)) {
+			notes[numOfNotes++] = note;
+		}
+	}
+	degree = numOfNotes / 2;
+	if (lastNote == none) {
+		return;
+	}
+	for (unsigned int i = 0; i < numOfNotes; i++) {
+		if (notes[i] >= lastNote) {
+			bool below = i > 0 && lastNote - notes[i - 1] < notes[i] - lastNote;
+			degree = below ? i - 1 : i;
+			return;
+		}
+	}
+	if (numOfNotes) {
+		degree = numOfNotes - 1;
+	}
+}
+
+
+void MelodyEngine::Seed(uint32_t seedArg) {
+	seed = seedArg ? seedArg : 1;
+	Stop();
+	Restart();
+}
+
+
+void MelodyEngine::Restart() {
+	random.Seed(seed);
+	lastNote = none;
+	degree = numOfNotes / 2;
+	pattern = 0;
+	patternValid = false;
+}
+
+
+void MelodyEngine::NewPattern() {
+	// The first step of the bar always plays.
+	pattern = 1;
+	for (unsigned int i = 1; i < patternSteps; i++) {
+		if (random.Chance(parameters.density)) {
+			pattern |= 1 << i;
+		}
+	}
+	patternValid = true;
+}
+
+
+/** Distance to the next note in scale degrees, by weight.
+ */
+unsigned int MelodyEngine::Leap() {
+	uint16_t total = cumulative[maxLeap];
+	if (total == 0) {
+		return 1;
+	}
+	uint16_t pick = random.Below(total);
+	unsigned int leap = 0;
+	while (pick >= cumulative[leap]) {
+		leap++;
+	}
+	return leap;
+}
+
+
+void MelodyEngine::Send(uint8_t status, uint8_t note, uint8_t velocity) {
+	if (sink) {
+		sink(UmpEvent::Midi1(status | channel, note, velocity));
+	}
+}
+
+
+void MelodyEngine::Step(uint32_t step) {
+	// Unsigned, a step before onStep (song restarted) also ends it.
+	if (playing != none && step - onStep >= parameters.gate) {
+		Stop();
+	}
+
+	unsigned int position = step % patternSteps;
+	if (!patternValid
+		|| (position == 0 && (step / patternSteps) % parameters.bars == 0)) {
+		NewPattern();
+	}
+	if (!(pattern & (1 << position)) || numOfNotes == 0) {
+		return;
+	}
+
+	// Up or down, turn around at the ends of the range.
+	int leap = Leap();
+	if (random.Below(2)) {
+		leap = -leap;
+	}
+	int next = (int)degree + leap;
+	if (next < 0 || next >= (int)numOfNotes) {
+		next = (int)degree - leap;
+	}
+	if (next < 0) {
+		next = 0;
+	}
+	if (next >= (int)numOfNotes) {
+		next = numOfNotes - 1;
+	}
+	degree = next;
+	lastNote = notes[degree];
+
+	unsigned int velocity = parameters.velocity;
+	if (position % 4 == 0) {
+		velocity += parameters.accent;
+	}
+	if (velocity > 127) {
+		velocity = 127;
+	}
+	if (velocity == 0) {
+		velocity = 1;
+	}
+	Stop();
+	Send(0x90, lastNote, velocity);
+	playing = lastNote;
+	onStep = step;
+}
+
+
+void MelodyEngine::Stop() {
+	if (playing != none) {
+		Send(0x80, playing, 0);
+		playing = none;
+	}
+}
+
+
+/* EOF */
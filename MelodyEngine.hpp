@@ -0,0 +1,126 @@
+/** @file MelodyEngine.hpp
+ *
+ * Generative melodies in a scale, played on the 16th note steps of
+ * the MIDI clock.
+ *
+ * The melody is a random walk over the notes of the scale within a
+ * range: every note moves 0..maxLeap scale degrees up or down, how
+ * often each distance is picked is set by weights (small steps with
+ * the odd leap sound like a tune, equal weights like a dice roll).
+ * A walk that would leave the range turns around.  The rhythm is a
+ * pattern of 16 steps, every step plays with 'density' percent
+ * chance and the first always does; a new pattern is drawn every
+ * 'bars' bars so the rhythm repeats long enough to be heard.
+ *
+ * Everything comes from one seeded Random: the same seed, scale and
+ * parameters give the same notes on the same steps, every time.
+ * Seed() starts the melody over.
+ *
+ * Like MidiClock it does not know about threads or UARTs, Step() is
+ * called for every 16th note (MidiClock's StepHandler or counted
+ * clocks) and the notes go to a sink.  A note costs two random
+ * numbers and a few table reads, a new rhythm 15 random numbers, no
+ * heap is used.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MelodyEngine_hpp
+#define MelodyEngine_hpp
+
+#include <cstdint>
+#include "NoteSet.hpp"
+#include "Random.hpp"
+#include "Scale.hpp"
+#include "Ump.hpp"
+
+
+class MelodyEngine {
+public:
+	/** Receives the note on and note off messages.
+	 */
+	typedef void (*Sink)(const UmpEvent &event);
+
+	static const unsigned int maxLeap = 7;		// Scale degrees.
+	static const unsigned int patternSteps = 16;
+	static const uint8_t none = 0xFF;
+
+	struct Parameters {
+		uint8_t low;						// Range of notes.
+		uint8_t high;
+		uint8_t leapWeights[maxLeap + 1];	// Of moving 0..maxLeap degrees.
+		uint8_t density;					// % of the steps that play.
+		uint8_t bars;						// Before a new rhythm.
+		uint8_t gate;						// Steps a note is held.
+		uint8_t velocity;
+		uint8_t accent;						// Added on the beat.
+	};
+	static const Parameters defaults;
+
+	MelodyEngine(Sink sinkArg, uint8_t channelArg = 0,
+				 uint32_t seedArg = 1) noexcept;
+
+	/** Takes effect on the next note, the walk goes on from the scale
+	 * note nearest to where it was.
+	 */
+	void SetScale(PitchClassSet pcs);
+	void SetScale(Scale &scl, unsigned int modenum) {
+		SetScale(scl.PitchClasses(modenum));
+	};
+	void SetParameters(const Parameters &parametersArg);
+	const Parameters &GetParameters() const {
+		return parameters;
+	};
+
+	/** Start the melody over from this seed (0 is taken as 1).
+	 */
+	void Seed(uint32_t seedArg);
+	uint32_t GetSeed() const {
+		return seed;
+	};
+
+	/** One 16th note, 'step' counts from the song start.
+	 */
+	void Step(uint32_t step);
+	/** Note off for the note that is sounding (transport stop).
+	 */
+	void Stop();
+
+	/** Note that is sounding or none.
+	 */
+	uint8_t Playing() const {
+		return playing;
+	};
+	uint16_t Pattern() const {
+		return pattern;
+	};
+
+private:
+	void Restart();
+	void BuildNotes();
+	void NewPattern();
+	unsigned int Leap();
+	void Send(uint8_t status, uint8_t note, uint8_t velocity);
+
+	Sink sink;
+	uint8_t channel;
+	uint32_t seed;
+	Random random;
+	Parameters parameters;
+	uint16_t cumulative[maxLeap + 1];	// Running sum of leapWeights.
+	PitchClassSet scale;
+
+	uint8_t notes[128];		// Of the scale in the range, low to high.
+	unsigned int numOfNotes;
+	unsigned int degree;	// Index in notes of the last note.
+	uint8_t lastNote;
+
+	uint16_t pattern;		// Bit n: step n of the bar plays.
+	bool patternValid;
+	uint8_t playing;
+	uint32_t onStep;		// Of the note that is playing.
+};
+
+
+#endif /* MelodyEngine_hpp */
@@ -0,0 +1,179 @@
+/** @file MidiClock.cpp
+ *
+ * MIDI clock master.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MidiClock.hpp"
+
+// One clock at 1/1000 BPM lasts this / milliBpm us:
+// 60 s * 10^6 us * 1000 / 24 clocks.
+static const uint32_t clockMicrosMilliBpm = 2500000000u;
+
+
+MidiClock::MidiClock(Sink sinkArg, StepHandler stepArg) noexcept {
+	sink = sinkArg;
+	step = stepArg;
+	running = false;
+	position = 0;
+	nextMilliBpm = 0;
+	swing = 50;
+	clockTime = 0;
+	swingPending = false;
+	swingTime = 0;
+	stats = Statistics();
+	ApplyTempo(120000);
+}
+
+
+void MidiClock::ApplyTempo(uint32_t milliBpmArg) {
+	milliBpm = milliBpmArg;
+	period = clockMicrosMilliBpm / milliBpm;
+	periodFraction = clockMicrosMilliBpm % milliBpm;
+	phase = 0;
+}
+
+
+void MidiClock::SetTempo(uint32_t milliBpmArg) {
+	if (milliBpmArg < 10000) {
+		milliBpmArg = 10000;
+	}
+	if (milliBpmArg > 999000) {
+		milliBpmArg = 999000;
+	}
+	if (running) {
+		nextMilliBpm = milliBpmArg;
+	}
+	else {
+		ApplyTempo(milliBpmArg);
+	}
+}
+
+
+void MidiClock::SetSwing(uint8_t percent) {
+	swing = percent < 50 ? 50 : (percent > 75 ? 75 : percent);
+}
+
+
+void MidiClock::Send(uint8_t status, uint8_t data1, uint8_t data2) {
+	if (sink) {
+		sink(UmpEvent::Midi1(status, data1, data2));
+	}
+}
+
+
+void MidiClock::Advance() {
+	clockTime += period;
+	phase += periodFraction;
+	if (phase >= milliBpm) {
+		phase -= milliBpm;
+		clockTime++;
+	}
+}
+
+
+void MidiClock::Start(uint64_t now) {
+	if (running) {
+		Stop();
+	}
+	position = 0;
+	Send(0xFA);
+	Continue(now);
+}
+
+
+void MidiClock::Stop() {
+	if (!running) {
+		return;
+	}
+	running = false;
+	swingPending = false;
+	Send(0xFC);
+}
+
+
+void MidiClock::Continue(uint64_t now) {
+	if (running) {
+		return;
+	}
+	if (position != 0) {
+		Send(0xFB);
+	}
+	if (nextMilliBpm) {
+		ApplyTempo(nextMilliBpm);
+		nextMilliBpm = 0;
+	}
+	running = true;
+	clockTime = now;
+	phase = 0;
+	// Picked up halfway a pair of 16ths: the swung one is next.
+	swingPending = (position % (2 * clocksPerStep)) == clocksPerStep;
+	swingTime = now;
+}
+
+
+void MidiClock::SetPosition(uint32_t stepArg) {
+	if (running) {
+		return;
+	}
+	stepArg &= 0x3FFF;
+	position = stepArg * clocksPerStep;
+	Send(0xF2, stepArg & 0x7F, (stepArg >> 7) & 0x7F);
+}
+
+
+void MidiClock::Run(uint64_t now) {
+	while (running) {
+		if (swingPending && swingTime <= clockTime) {
+			if (swingTime > now) {
+				break;
+			}
+			swingPending = false;
+			if (step) {
+				step(position / clocksPerStep);
+			}
+			continue;
+		}
+		if (clockTime > now) {
+			break;
+		}
+
+		uint32_t late = (uint32_t)(now - clockTime);
+		if (late > stats.maxLate) {
+			stats.maxLate = late;
+		}
+		stats.totalLate += late;
+		stats.clocks++;
+
+		if (position % clocksPerBeat == 0 && nextMilliBpm) {
+			ApplyTempo(nextMilliBpm);
+			nextMilliBpm = 0;
+		}
+		Send(0xF8);
+		if (position % (2 * clocksPerStep) == 0) {
+			// First 16th of a pair on the clock, the second one
+			// 'swing' percent into the pair.
+			if (step) {
+				step(position / clocksPerStep);
+			}
+			swingTime = clockTime + (uint64_t)clockMicrosMilliBpm *
+				2 * clocksPerStep * swing / (100ull * milliBpm);
+			swingPending = true;
+		}
+		position++;
+		Advance();
+	}
+}
+
+
+uint64_t MidiClock::NextEventTime() const {
+	if (swingPending && swingTime < clockTime) {
+		return swingTime;
+	}
+	return clockTime;
+}
+
+
+/* EOF */
@@ -0,0 +1,116 @@
+/** @file MidiClock.hpp
+ *
+ * MIDI clock master: 24 clocks per quarter note with the transport
+ * messages (start, stop, continue, song position).
+ *
+ * The time of every clock is kept as an integer number of us plus a
+ * fraction (Bresenham style), the fraction carries over from clock to
+ * clock so the tempo is exact however long it runs: at 123.456 BPM
+ * clock n is never more than 1 us off n * 60 / (123.456 * 24) s.
+ *
+ * Tempo changes take effect on the next beat.  Internal sequencing
+ * gets 16th note steps with swing: the second 16th of every pair is
+ * moved later, the clock itself stays straight.
+ *
+ * The clock does not know about timers: Run() is given the current
+ * time, sends what is due to the sink and NextEventTime() tells when
+ * to call it again (e.g. from a hardware Timeout).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiClock_hpp
+#define MidiClock_hpp
+
+#include <cstdint>
+#include "Ump.hpp"
+
+
+class MidiClock {
+public:
+	/** Receives the clock and transport messages.
+	 */
+	typedef void (*Sink)(const UmpEvent &event);
+	/** Called for every 16th note, 'step' counts from the song start.
+	 */
+	typedef void (*StepHandler)(uint32_t step);
+
+	static const uint32_t clocksPerBeat = 24;
+	static const uint32_t clocksPerStep = 6;
+
+	struct Statistics {
+		uint32_t clocks;
+		uint32_t maxLate;		// us, Run() after the clock was due.
+		uint64_t totalLate;
+	};
+
+	MidiClock(Sink sinkArg, StepHandler stepArg = nullptr) noexcept;
+
+	/** Tempo in 1/1000 BPM (120000 is 120 BPM).  While running it
+	 * takes effect on the next beat.
+	 */
+	void SetTempo(uint32_t milliBpm);
+	uint32_t Tempo() const {
+		return milliBpm;
+	};
+	/** 50 is straight, 66 is triplet feel, at most 75.
+	 */
+	void SetSwing(uint8_t percent);
+
+	/** Start from the beginning of the song.
+	 */
+	void Start(uint64_t now);
+	void Stop();
+	/** Start from the current position.
+	 */
+	void Continue(uint64_t now);
+	/** Song position in 16th notes, only while stopped.
+	 */
+	void SetPosition(uint32_t step);
+
+	/** Send what is due at 'now' (us).
+	 */
+	void Run(uint64_t now);
+	/** When Run() has to be called next, only valid while running.
+	 */
+	uint64_t NextEventTime() const;
+
+	bool Running() const {
+		return running;
+	};
+	/** Clocks since the song start.
+	 */
+	uint32_t Position() const {
+		return position;
+	};
+	const Statistics &Stats() const {
+		return stats;
+	};
+
+private:
+	void ApplyTempo(uint32_t milliBpmArg);
+	void Advance();
+	void Send(uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0);
+
+	Sink sink;
+	StepHandler step;
+	bool running;
+	uint32_t position;
+	uint32_t milliBpm;
+	uint32_t nextMilliBpm;	// 0 when no tempo change is pending.
+	uint8_t swing;
+
+	// Clock period in us is period + periodFraction / milliBpm.
+	uint64_t clockTime;		// Due time of the next clock.
+	uint32_t period;
+	uint32_t periodFraction;
+	uint32_t phase;			// Fraction of clockTime, in 1/milliBpm us.
+
+	bool swingPending;
+	uint64_t swingTime;		// Due time of the swung 16th.
+	Statistics stats;
+};
+
+
+#endif /* MidiClock_hpp */
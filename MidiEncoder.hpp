@@ -0,0 +1,49 @@
+/** @file MidiEncoder.hpp
+ *
+ * Puts a UmpEvent on a serial MIDI port as MIDI 1.0 bytes (MIDI 2.0
+ * values are scaled down).  Every message goes out whole, status byte
+ * included, through the port's write(buf, len): the firmware sends
+ * nothing through SerialMidi's NoteON()/ControlChange() any more, so
+ * whatever running status SerialMidi keeps for those can not drop the
+ * status of a channel message that follows a system common one.
+ *
+ * write(buf, len) is the one SerialMidi call assumed here that the
+ * original main.cpp did not use; the SerialMidi sources (serialmidi.lib,
+ * f57e2aa) are not part of this tree, a build against a revision
+ * without it fails to compile in Send() rather than sending wrong bytes.
+ *
+ * The port is a template parameter so the simulator can put the same
+ * bytes on its model of the wire (sim/SimWire.hpp).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiEncoder_hpp
+#define MidiEncoder_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "Ump.hpp"
+
+
+class MidiEncoder {
+public:
+	/** Send 'event' to 'port', false when it has no MIDI 1.0 form
+	 * (e.g. MIDI 2.0 per note controllers) and nothing was sent.
+	 */
+	template<class Port>
+	static bool Send(Port &port, const UmpEvent &event) {
+		uint8_t msg[3];
+		size_t len = event.ToBytes(msg);
+
+		if (len == 0) {
+			return false;
+		}
+		port.write(msg, len);
+		return true;
+	};
+};
+
+
+#endif /* MidiEncoder_hpp */
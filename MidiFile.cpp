@@ -0,0 +1,285 @@
+/** @file MidiFile.cpp
+ *
+ * Streaming Standard MIDI File (type 0 and 1) player.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstring>
+#include "MidiFile.hpp"
+#include "MidiParser.hpp"
+
+
+static uint32_t Read32(const uint8_t *p) {
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+		(uint32_t)p[2] << 8 | p[3];
+}
+
+static uint16_t Read16(const uint8_t *p) {
+	return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/*
+ * Variable length quantity, at most 4 bytes.  Returns false when it
+ * runs past 'end'.
+ */
+static bool ReadVlq(const uint8_t *&p, const uint8_t *end, uint32_t &value) {
+	value = 0;
+	for (int i = 0; i < 4; i++) {
+		if (p >= end) {
+			return false;
+		}
+		uint8_t byte = *p++;
+		value = (value << 7) | (byte & 0x7F);
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+SmfPlayer::SmfPlayer(Sink sinkArg) noexcept {
+	sink = sinkArg;
+	file = nullptr;
+	len = 0;
+	numOfTracks = 0;
+	format = 0;
+	heapSize = 0;
+	division = 96;
+	usPerTick = 0;
+}
+
+
+bool SmfPlayer::Open(const uint8_t *fileArg, size_t lenArg) {
+	file = fileArg;
+	len = lenArg;
+	numOfTracks = 0;
+	heapSize = 0;
+	
+	if (len < 14 || memcmp(file, "MThd", 4) != 0 || Read32(file + 4) < 6) {
+		return false;
+	}
+	format = Read16(file + 8);
+	unsigned int ntrks = Read16(file + 10);
+	uint16_t div = Read16(file + 12);
+	if (format > 1 || ntrks > maxTracks) {
+		return false;
+	}
+	if (div & 0x8000) {
+		// SMPTE: -frames per second and ticks per frame.
+		int fps = -(int8_t)(div >> 8);
+		int tpf = div & 0xFF;
+		if (fps == 29) {
+			fps = 30;	// 30 drop frame is close enough.
+		}
+		division = 0;
+		usPerTick = (fps > 0 && tpf > 0) ? 1000000 / (fps * tpf) : 1000;
+	}
+	else {
+		division = div ? div : 96;
+		usPerTick = 0;
+	}
+	
+	// Walk the chunks, skip the ones that are not tracks.
+	const uint8_t *p = file + 8 + Read32(file + 4);
+	const uint8_t *end = file + len;
+	while (p + 8 <= end && numOfTracks < ntrks) {
+		uint32_t chunkLen = Read32(p + 4);
+		const uint8_t *data = p + 8;
+		if (chunkLen > (size_t)(end - data)) {
+			chunkLen = end - data;	// Truncated file, play what's there.
+		}
+		if (memcmp(p, "MTrk", 4) == 0) {
+			trackStart[numOfTracks] = data;
+			trackEnd[numOfTracks] = data + chunkLen;
+			numOfTracks++;
+		}
+		p = data + chunkLen;
+	}
+	Rewind();
+	return numOfTracks > 0;
+}
+
+
+void SmfPlayer::Rewind() {
+	tempo = 500000;		// 120 BPM until the file says otherwise.
+	tempoTick = 0;
+	tempoTime = 0;
+	timing = Timing();
+	heapSize = 0;
+	
+	for (unsigned int i = 0; i < numOfTracks; i++) {
+		tracks[i].pos = trackStart[i];
+		tracks[i].end = trackEnd[i];
+		tracks[i].tick = 0;
+		tracks[i].status = 0;
+		if (ReadDelta(tracks[i])) {
+			heap[heapSize++] = i;
+		}
+	}
+	for (unsigned int i = heapSize / 2; i-- > 0; ) {
+		HeapDown(i);
+	}
+}
+
+
+uint64_t SmfPlayer::TickToTime(uint32_t tick) const {
+	if (division == 0) {
+		return (uint64_t)tick * usPerTick;
+	}
+	return tempoTime + (uint64_t)(tick - tempoTick) * tempo / division;
+}
+
+
+/*
+ * Read the delta time of the next event, false at the end of the track.
+ */
+bool SmfPlayer::ReadDelta(Track &track) {
+	uint32_t delta;
+	if (!ReadVlq(track.pos, track.end, delta)) {
+		return false;
+	}
+	track.tick += delta;
+	return true;
+}
+
+
+void SmfPlayer::HeapDown(unsigned int i) {
+	for (;;) {
+		unsigned int smallest = i;
+		unsigned int left = 2 * i + 1;
+		unsigned int right = left + 1;
+		if (left < heapSize && Before(heap[left], heap[smallest])) {
+			smallest = left;
+		}
+		if (right < heapSize && Before(heap[right], heap[smallest])) {
+			smallest = right;
+		}
+		if (smallest == i) {
+			return;
+		}
+		uint8_t tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+
+void SmfPlayer::HeapPop() {
+	heap[0] = heap[--heapSize];
+	HeapDown(0);
+}
+
+
+unsigned int SmfPlayer::Play(uint64_t now) {
+	unsigned int sent = 0;
+	
+	while (heapSize > 0) {
+		Track &track = tracks[heap[0]];
+		uint64_t time = TickToTime(track.tick);
+		if (time > now) {
+			break;
+		}
+		uint32_t events = timing.events;
+		Event(track);
+		if (timing.events != events) {
+			uint32_t late = (uint32_t)(now - time);
+			timing.totalLate += late;
+			if (late > timing.maxLate) {
+				timing.maxLate = late;
+			}
+			sent++;
+		}
+		// Next event of this track, it only moves later in time
+		// so sifting down the root is enough.
+		if (track.pos < track.end && ReadDelta(track)) {
+			HeapDown(0);
+		}
+		else {
+			HeapPop();
+		}
+	}
+	return sent;
+}
+
+
+/*
+ * Handle the event at the cursor of the track (the delta time has
+ * been read already).
+ */
+void SmfPlayer::Event(Track &track) {
+	const uint8_t *p = track.pos;
+	uint8_t msg[3];
+	
+	if (p >= track.end) {
+		return;
+	}
+	uint8_t status = *p;
+	if (status & 0x80) {
+		p++;
+	}
+	else {
+		status = track.status;	// Running status
+	}
+	
+	if (status == 0xFF) {
+		// Meta event: type, length, data.
+		uint32_t metaLen;
+		if (p >= track.end) {
+			track.pos = track.end;
+			return;
+		}
+		uint8_t type = *p++;
+		if (!ReadVlq(p, track.end, metaLen) ||
+			metaLen > (size_t)(track.end - p)) {
+			track.pos = track.end;
+			return;
+		}
+		if (type == 0x51 && metaLen == 3) {
+			// Tempo change, continue the tempo map from here.
+			tempoTime = TickToTime(track.tick);
+			tempoTick = track.tick;
+			tempo = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+		}
+		track.pos = (type == 0x2F) ? track.end : p + metaLen;
+		return;
+	}
+	if (status == 0xF0 || status == 0xF7) {
+		// SysEx is skipped, the sinks only take short messages.
+		uint32_t sysexLen;
+		if (!ReadVlq(p, track.end, sysexLen) ||
+			sysexLen > (size_t)(track.end - p)) {
+			track.pos = track.end;
+			return;
+		}
+		track.pos = p + sysexLen;
+		timing.skipped++;
+		return;
+	}
+	if (!(status & 0x80) || status > 0xEF) {
+		// No running status to use, the track is corrupt.
+		track.pos = track.end;
+		return;
+	}
+	
+	track.status = status;
+	unsigned int n = MidiParser::DataBytes(status);
+	if ((size_t)(track.end - p) < n) {
+		track.pos = track.end;
+		return;
+	}
+	msg[0] = status;
+	memcpy(msg + 1, p, n);
+	track.pos = p + n;
+	timing.events++;
+	UmpEvent event;
+	if (sink && UmpEvent::FromBytes(msg, n + 1, event)) {
+		sink(event);
+	}
+}
+
+
+/* EOF */
@@ -0,0 +1,121 @@
+/** @file MidiFile.hpp
+ *
+ * Streaming Standard MIDI File (type 0 and 1) player.
+ * The file is read in place (e.g. a const array in flash) and is
+ * never copied to RAM, every track only has a small cursor.  The
+ * tracks are merged on the fly with a heap of track cursors ordered
+ * by the time of their next event and the tempo map is followed while
+ * playing.
+ *
+ * The player does not know about time sources or UARTs: Play() is
+ * given the current time and sends everything that is due to the
+ * sink, NextEventTime() tells when to call it again.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiFile_hpp
+#define MidiFile_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "Ump.hpp"
+
+
+class SmfPlayer {
+public:
+	/** Receives every channel message as a MIDI 1.0 UMP event.
+	 */
+	typedef void (*Sink)(const UmpEvent &event);
+	
+	static const unsigned int maxTracks = 16;
+	static const uint64_t never = ~0ull;
+	
+	SmfPlayer(Sink sinkArg) noexcept;
+	
+	/** Check the header and find the tracks, returns false when this
+	 * is not a type 0 or 1 SMF (or there are too many tracks).
+	 */
+	bool Open(const uint8_t *fileArg, size_t lenArg);
+	
+	/** Back to the start of the song.
+	 */
+	void Rewind();
+	
+	/** Time of the next event in us since the start of the song,
+	 * never when the song has finished.
+	 */
+	uint64_t NextEventTime() const {
+		if (heapSize == 0) {
+			return never;
+		}
+		return TickToTime(tracks[heap[0]].tick);
+	};
+	bool Finished() const {
+		return heapSize == 0;
+	};
+	
+	/** Send all events that are due at 'now' (us since the start of
+	 * the song), returns the number of messages sent.
+	 */
+	unsigned int Play(uint64_t now);
+	
+	/** How late the events were sent compared to the time in the
+	 * file (in us).
+	 */
+	struct Timing {
+		uint32_t events;
+		uint32_t skipped;	// SysEx and unknown events.
+		uint32_t maxLate;
+		uint64_t totalLate;
+	};
+	const Timing &Stats() {
+		return timing;
+	};
+	
+	unsigned int numOfTracks;
+	uint16_t format;
+	
+private:
+	struct Track {
+		const uint8_t *pos;
+		const uint8_t *end;
+		uint32_t tick;		// Absolute tick of the next event.
+		uint8_t status;		// Running status.
+	};
+	
+	bool ReadDelta(Track &track);
+	void Event(Track &track);
+	uint64_t TickToTime(uint32_t tick) const;
+	
+	// Min-heap of track numbers ordered by the tick of the next event,
+	// ties go to the lowest track number so type 1 files keep the
+	// order of the tracks.
+	bool Before(uint8_t a, uint8_t b) const {
+		return tracks[a].tick < tracks[b].tick ||
+			(tracks[a].tick == tracks[b].tick && a < b);
+	};
+	void HeapDown(unsigned int i);
+	void HeapPop();
+	
+	Sink sink;
+	const uint8_t *file;
+	size_t len;
+	Track tracks[maxTracks];
+	const uint8_t *trackStart[maxTracks];
+	const uint8_t *trackEnd[maxTracks];
+	uint8_t heap[maxTracks];
+	unsigned int heapSize;
+	
+	// Tempo map, followed while playing.
+	uint16_t division;		// Ticks per quarter note.
+	uint32_t usPerTick;		// Only for SMPTE time division.
+	uint32_t tempo;			// us per quarter note.
+	uint32_t tempoTick;		// Tick of the last tempo change.
+	uint64_t tempoTime;		// Time (us) of the last tempo change.
+	Timing timing;
+};
+
+
+#endif /* MidiFile_hpp */
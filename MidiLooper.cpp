@@ -0,0 +1,617 @@
+/** @file MidiLooper.cpp
+ *
+ * Compact MIDI recorder and looper.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MidiLooper.hpp"
+#include "MidiParser.hpp"
+
+
+/*
+ * Encode one event, running status is used when the status is the
+ * same as 'running'.  Deltas longer than 4 bytes are clamped.
+ */
+static size_t Encode(uint8_t *out, uint32_t delta, uint8_t running,
+					 const uint8_t *msg, size_t len) {
+	uint8_t vlq[4];
+	size_t n = 0;
+	size_t i = 0;
+
+	if (delta > 0x0FFFFFFF) {
+		delta = 0x0FFFFFFF;
+	}
+	do {
+		vlq[i++] = delta & 0x7F;
+		delta >>= 7;
+	} while (delta);
+	while (i > 1) {
+		out[n++] = vlq[--i] | 0x80;
+	}
+	out[n++] = vlq[0];
+	if (msg[0] != running) {
+		out[n++] = msg[0];
+	}
+	for (i = 1; i < len; i++) {
+		out[n++] = msg[i];
+	}
+	return n;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// EventRing
+/////////////////////////////////////////////////////////////////
+EventRing::EventRing(uint8_t *storageArg, size_t sizeArg) noexcept {
+	buf = storageArg;
+	mask = sizeArg - 1;
+	Clear();
+}
+
+
+void EventRing::Clear(uint32_t tick) {
+	head = 0;
+	tail = 0;
+	headTick = tick;
+	headStatus = 0;
+	tailTick = tick;
+	tailStatus = 0;
+	events = 0;
+	dropped = 0;
+}
+
+
+bool EventRing::Append(uint32_t tick, const uint8_t *msg, size_t len) {
+	uint8_t enc[maxEncoded];
+
+	if (msg[0] < 0x80 || msg[0] > 0xEF ||
+		len != 1u + MidiParser::DataBytes(msg[0])) {
+		return false;
+	}
+	for (size_t i = 1; i < len; i++) {
+		if (msg[i] & 0x80) {
+			return false;
+		}
+	}
+	// Out of order events are put at the time of the previous one.
+	uint32_t delta = (int32_t)(tick - headTick) > 0 ? tick - headTick : 0;
+	size_t n = Encode(enc, delta, headStatus, msg, len);
+	if (n > Size()) {
+		return false;
+	}
+	while (Size() - Bytes() < n) {
+		DropOldest();
+	}
+	for (size_t i = 0; i < n; i++) {
+		buf[head++ & mask] = enc[i];
+	}
+	headTick += delta > 0x0FFFFFFF ? 0x0FFFFFFF : delta;
+	headStatus = msg[0];
+	events++;
+	return true;
+}
+
+
+/*
+ * Skip the event at the tail, keeping the tick and running status
+ * so the next one can still be decoded.
+ */
+void EventRing::DropOldest() {
+	uint32_t delta = 0;
+	uint8_t byte;
+
+	do {
+		byte = buf[tail++ & mask];
+		delta = (delta << 7) | (byte & 0x7F);
+	} while (byte & 0x80);
+	byte = buf[tail & mask];
+	if (byte & 0x80) {
+		tailStatus = byte;
+		tail++;
+	}
+	tail += MidiParser::DataBytes(tailStatus);
+	tailTick += delta;
+	events--;
+	dropped++;
+}
+
+
+EventRing::Reader EventRing::Read() const {
+	Reader reader;
+	reader.ring = this;
+	reader.pos = tail;
+	reader.end = head;
+	reader.tick = tailTick;
+	reader.status = tailStatus;
+	return reader;
+}
+
+
+EventRing::Reader EventRing::Mark() const {
+	Reader reader;
+	reader.ring = this;
+	reader.pos = head;
+	reader.end = head;
+	reader.tick = headTick;
+	reader.status = headStatus;
+	return reader;
+}
+
+
+EventRing::Reader EventRing::Until(const Reader &from) const {
+	Reader reader = from;
+	reader.end = head;
+	return reader;
+}
+
+
+size_t EventRing::Reader::Next(uint32_t &tickArg, uint8_t *msg) {
+	const uint8_t *buf = ring->buf;
+	size_t mask = ring->mask;
+	uint32_t delta = 0;
+	uint8_t byte;
+
+	if (pos == end) {
+		return 0;
+	}
+	do {
+		byte = buf[pos++ & mask];
+		delta = (delta << 7) | (byte & 0x7F);
+	} while (byte & 0x80);
+	byte = buf[pos & mask];
+	if (byte & 0x80) {
+		status = byte;
+		pos++;
+	}
+	size_t n = MidiParser::DataBytes(status);
+	msg[0] = status;
+	for (size_t i = 1; i <= n; i++) {
+		msg[i] = buf[pos++ & mask];
+	}
+	tick += delta;
+	tickArg = tick;
+	return n + 1;
+}
+
+
+size_t EventRing::WriteSmf(Output out, uint16_t division, uint32_t tempo) const {
+	uint8_t first[maxEncoded];
+	size_t firstLen = 0;
+	uint8_t msg[3];
+	uint32_t tick;
+
+	// The ring is already an SMF track, only the first event needs its
+	// status written out as the running status before it is gone.
+	Reader reader = Read();
+	size_t len = reader.Next(tick, msg);
+	if (len) {
+		firstLen = Encode(first, tick - tailTick, 0, msg, len);
+	}
+	size_t rest = head - reader.pos;
+	uint32_t trackLen = 7 + firstLen + rest + 4;
+
+	const uint8_t header[] = {
+		'M', 'T', 'h', 'd', 0, 0, 0, 6,
+		0, 0,					// Format 0
+		0, 1,					// One track
+		(uint8_t)(division >> 8), (uint8_t)division,
+		'M', 'T', 'r', 'k',
+		(uint8_t)(trackLen >> 24), (uint8_t)(trackLen >> 16),
+		(uint8_t)(trackLen >> 8), (uint8_t)trackLen,
+		0, 0xFF, 0x51, 3,		// Tempo
+		(uint8_t)(tempo >> 16), (uint8_t)(tempo >> 8), (uint8_t)tempo
+	};
+	const uint8_t endOfTrack[] = { 0, 0xFF, 0x2F, 0 };
+
+	out(header, sizeof(header));
+	out(first, firstLen);
+	if (rest) {
+		size_t from = reader.pos & mask;
+		size_t chunk = Size() - from;
+		if (chunk >= rest) {
+			out(buf + from, rest);
+		}
+		else {
+			out(buf + from, chunk);
+			out(buf, rest - chunk);
+		}
+	}
+	out(endOfTrack, sizeof(endOfTrack));
+	return sizeof(header) + firstLen + rest + sizeof(endOfTrack);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// MidiLooper
+/////////////////////////////////////////////////////////////////
+MidiLooper::MidiLooper(uint8_t *storage, size_t size, Sink sinkArg) noexcept
+: ring(storage, size)
+{
+	sink = sinkArg;
+	state = EMPTY;
+	firstLayer = 0;
+	numOfLayers = 0;
+	loopStart = 0;
+	length = 0;
+	dropped = 0;
+	running = false;
+	firstClock = true;
+	clocks = 0;
+	lastClock = 0;
+	clockPeriod = 0;
+	position = 0;
+}
+
+
+/*
+ * Position in ticks, between two clocks it is interpolated with the
+ * time between the last two.
+ */
+uint32_t MidiLooper::Position(uint64_t now) {
+	if (!running) {
+		return position;
+	}
+	uint32_t frac = 0;
+	if (clockPeriod && lastClock && !firstClock) {
+		uint64_t since = (now - lastClock) * ticksPerClock / clockPeriod;
+		frac = since < ticksPerClock ? (uint32_t)since : ticksPerClock - 1;
+	}
+	uint32_t tick = clocks * ticksPerClock + frac;
+	if ((int32_t)(tick - position) > 0) {
+		position = tick;
+	}
+	return position;
+}
+
+
+void MidiLooper::Realtime(uint8_t msg, uint64_t now) {
+	switch (msg) {
+		case 0xF8:		// Clock
+			if (!running) {
+				break;
+			}
+			if (lastClock) {
+				clockPeriod = (uint32_t)(now - lastClock);
+			}
+			if (firstClock) {
+				firstClock = false;
+			}
+			else {
+				clocks++;
+			}
+			lastClock = now;
+			break;
+		case 0xFA:		// Start, the loop starts again from its beginning.
+			AllNotesOff();
+			if (state == RECORDING) {
+				Clear();
+			}
+			else if (state == OVERDUBBING) {
+				CloseLayer(Position(now));
+			}
+			running = true;
+			firstClock = true;
+			lastClock = 0;
+			clocks = 0;
+			position = 0;
+			loopStart = 0;
+			for (unsigned int i = 0; i < numOfLayers; i++) {
+				Seek(LayerAt(i), 0);
+			}
+			if (state == OVERDUBBING) {
+				OpenLayer(0, false);
+			}
+			break;
+		case 0xFB:		// Continue, the time since the stop is no clock period.
+			running = true;
+			lastClock = 0;
+			break;
+		case 0xFC:		// Stop
+			Position(now);
+			running = false;
+			AllNotesOff();
+			break;
+		default:
+			break;
+	}
+}
+
+
+void MidiLooper::Record(uint64_t now) {
+	uint32_t tick = Position(now);
+
+	switch (state) {
+		case EMPTY:
+			ring.Clear();
+			loopStart = tick;
+			OpenLayer(tick, false);
+			state = RECORDING;
+			break;
+		case RECORDING:
+			// The loop is a whole number of beats.
+			length = ((tick - loopStart + ticksPerBeat / 2) / ticksPerBeat) *
+				ticksPerBeat;
+			if (length == 0) {
+				length = ticksPerBeat;
+			}
+			CloseLayer(tick);
+			state = numOfLayers ? PLAYING : EMPTY;
+			break;
+		case PLAYING:
+			OpenLayer(tick, false);
+			state = OVERDUBBING;
+			break;
+		case OVERDUBBING:
+			Split(tick);
+			CloseLayer(tick);
+			state = PLAYING;
+			break;
+	}
+}
+
+
+void MidiLooper::Undo() {
+	if (numOfLayers == 0) {
+		return;
+	}
+	if (state == RECORDING || numOfLayers == 1) {
+		Clear();
+		return;
+	}
+	numOfLayers--;
+	for (unsigned int c = 0; c < 16; c++) {
+		held[c] = NoteSet();
+	}
+	state = PLAYING;
+	AllNotesOff();
+}
+
+
+void MidiLooper::Clear() {
+	AllNotesOff();
+	ring.Clear();
+	numOfLayers = 0;
+	firstLayer = 0;
+	length = 0;
+	state = EMPTY;
+	for (unsigned int c = 0; c < 16; c++) {
+		held[c] = NoteSet();
+	}
+}
+
+
+void MidiLooper::Input(const UmpEvent &event, uint64_t now) {
+	if (state != RECORDING && state != OVERDUBBING) {
+		return;
+	}
+	uint8_t msg[3];
+	size_t len = event.ToBytes(msg);
+	if (len == 0) {
+		return;
+	}
+	uint32_t tick = Position(now);
+	if (state == OVERDUBBING) {
+		Split(tick);
+	}
+	Layer &layer = Last();
+	Append(layer, tick - layer.start, msg, len);
+
+	uint8_t type = msg[0] & 0xF0;
+	if (len == 3 && (type == 0x90 || type == 0x80)) {
+		if (type == 0x90 && msg[2]) {
+			held[msg[0] & 0x0F].Add(msg[1]);
+		}
+		else {
+			held[msg[0] & 0x0F].Remove(msg[1]);
+		}
+	}
+}
+
+
+unsigned int MidiLooper::Play(uint64_t now) {
+	unsigned int sent = 0;
+	uint32_t tick = Position(now);
+
+	if (state == OVERDUBBING) {
+		Split(tick);
+	}
+	if (!running) {
+		return 0;
+	}
+	// The layer being recorded is heard live, not from the loop.
+	unsigned int closed = numOfLayers;
+	if (state == RECORDING || state == OVERDUBBING) {
+		closed--;
+	}
+	for (unsigned int i = 0; i < closed; i++) {
+		Layer &layer = LayerAt(i);
+		while (layer.len && (int32_t)(layer.due - tick) <= 0) {
+			Send(layer.msg, layer.len);
+			sent++;
+			Load(layer);
+		}
+	}
+	return sent;
+}
+
+
+void MidiLooper::OpenLayer(uint32_t tick, bool carry) {
+	if (numOfLayers == maxLayers) {
+		// Merge is not possible, the oldest overdub goes.
+		firstLayer = (firstLayer + 1) % maxLayers;
+		numOfLayers--;
+	}
+	numOfLayers++;
+	Layer &layer = Last();
+	layer.begin = ring.Mark();
+	layer.base = layer.begin.Tick();
+	layer.start = tick;
+	layer.offset = length ? (tick - loopStart) % length : 0;
+	layer.len = 0;
+
+	// Notes held over from the previous pass start again.
+	for (uint8_t c = 0; carry && c < 16; c++) {
+		for (uint8_t note = 0; note < 128; note++) {
+			if (held[c].Contains(note)) {
+				const uint8_t msg[3] = { (uint8_t)(0x90 | c), note, 100 };
+				Append(layer, 0, msg, 3);
+			}
+		}
+	}
+}
+
+
+/*
+ * Notes still held end with the layer, then the layer is played
+ * from where the loop is now.
+ */
+void MidiLooper::CloseLayer(uint32_t tick) {
+	Layer &layer = Last();
+	uint32_t rel = tick - layer.start;
+
+	if (rel >= length) {
+		rel = length - 1;
+	}
+	for (uint8_t c = 0; c < 16; c++) {
+		for (uint8_t note = 0; note < 128; note++) {
+			if (held[c].Contains(note)) {
+				const uint8_t msg[3] = { (uint8_t)(0x80 | c), note, 0 };
+				Append(layer, rel, msg, 3);
+			}
+		}
+	}
+	for (unsigned int c = 0; c < 16; c++) {
+		held[c] = NoteSet();
+	}
+	if (numOfLayers == 0) {
+		return;		// Did not fit.
+	}
+	Layer &closed = Last();
+	closed.begin = ring.Until(closed.begin);
+	Seek(closed, tick);
+}
+
+
+/*
+ * An overdub records one pass of the loop per layer, so it can be
+ * undone a pass at a time.
+ */
+void MidiLooper::Split(uint32_t tick) {
+	while (state == OVERDUBBING && tick - Last().start >= length) {
+		uint32_t end = Last().start + length;
+		NoteSet carried[16];
+		for (unsigned int c = 0; c < 16; c++) {
+			carried[c] = held[c];
+		}
+		CloseLayer(end);
+		for (unsigned int c = 0; c < 16; c++) {
+			held[c] = carried[c];
+		}
+		OpenLayer(end, true);
+	}
+}
+
+
+void MidiLooper::Append(Layer &layer, uint32_t rel, const uint8_t *msg,
+						size_t len) {
+	if (!ring.Append(layer.base + rel, msg, len)) {
+		dropped++;
+		return;
+	}
+	DropInvalid();
+}
+
+
+/*
+ * Layers that were (partly) overwritten by newer events are gone,
+ * when that is the layer being recorded the ring is too small.
+ */
+void MidiLooper::DropInvalid() {
+	while (numOfLayers && !ring.Valid(LayerAt(0).begin)) {
+		firstLayer = (firstLayer + 1) % maxLayers;
+		numOfLayers--;
+		dropped++;
+	}
+	if (numOfLayers == 0 && state != EMPTY) {
+		state = length ? PLAYING : EMPTY;
+		for (unsigned int c = 0; c < 16; c++) {
+			held[c] = NoteSet();
+		}
+	}
+}
+
+
+/*
+ * Position the layer at the first event at or after 'tick'.
+ */
+void MidiLooper::Seek(Layer &layer, uint32_t tick) {
+	int64_t into = ((int64_t)tick - loopStart - layer.offset) % length;
+	if (into < 0) {
+		into += length;
+	}
+	layer.cycle = tick - (uint32_t)into;
+	layer.cursor = layer.begin;
+	layer.len = 1;
+	Load(layer);
+	// At most one pass is skipped.
+	uint32_t limit = layer.cycle + length;
+	while (layer.len && (int32_t)(layer.due - tick) < 0 &&
+		   (int32_t)(layer.due - limit) < 0) {
+		Load(layer);
+	}
+}
+
+
+/*
+ * Read the next event of the layer, at the end it wraps around to the
+ * next pass of the loop.
+ */
+void MidiLooper::Load(Layer &layer) {
+	uint32_t tick;
+	size_t len = layer.cursor.Next(tick, layer.msg);
+
+	if (len == 0) {
+		layer.cursor = layer.begin;
+		layer.cycle += length;
+		len = layer.cursor.Next(tick, layer.msg);
+	}
+	layer.len = (uint8_t)len;
+	uint32_t rel = tick - layer.base;
+	layer.due = layer.cycle + (rel < length ? rel : length - 1);
+}
+
+
+void MidiLooper::Send(const uint8_t *msg, size_t len) {
+	uint8_t type = msg[0] & 0xF0;
+	if (len == 3 && (type == 0x90 || type == 0x80)) {
+		if (type == 0x90 && msg[2]) {
+			sounding[msg[0] & 0x0F].Add(msg[1]);
+		}
+		else {
+			sounding[msg[0] & 0x0F].Remove(msg[1]);
+		}
+	}
+	UmpEvent event;
+	if (sink && UmpEvent::FromBytes(msg, len, event)) {
+		sink(event);
+	}
+}
+
+
+void MidiLooper::AllNotesOff() {
+	for (uint8_t c = 0; c < 16; c++) {
+		for (uint8_t note = 0; note < 128 && !sounding[c].Empty(); note++) {
+			if (sounding[c].Contains(note)) {
+				sounding[c].Remove(note);
+				if (sink) {
+					sink(UmpEvent::Midi1(0x80 | c, note, 0));
+				}
+			}
+		}
+	}
+}
+
+
+/* EOF */
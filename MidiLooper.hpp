@@ -0,0 +1,244 @@
+/** @file MidiLooper.hpp
+ *
+ * Compact MIDI recorder and looper.
+ *
+ * EventRing keeps channel messages in a byte ring with the encoding
+ * of a Standard MIDI File track: a variable length delta time
+ * followed by the message with running status.  A note is mostly
+ * 2 or 3 bytes so minutes of playing fit in a few kB.  When the ring
+ * is full the oldest events are dropped.  The contents can be written
+ * out as a type 0 SMF, which is nearly a straight copy of the ring.
+ *
+ * MidiLooper records layers into an EventRing in sync with the MIDI
+ * clock.  The first layer sets the length of the loop (whole beats),
+ * every overdub is a new layer of one loop length that can be undone.
+ * Like SmfPlayer it does not know about time sources or UARTs, it is
+ * given the time and sends what is due to a sink.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiLooper_hpp
+#define MidiLooper_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include "NoteSet.hpp"
+#include "Ump.hpp"
+
+
+class EventRing {
+public:
+	/** Receives the bytes of an exported SMF.
+	 */
+	typedef void (*Output)(const uint8_t *data, size_t len);
+
+	/** Longest encoding: 4 byte delta, status and 2 data bytes.
+	 */
+	static const size_t maxEncoded = 7;
+
+	/** sizeArg has to be a power of two.
+	 */
+	EventRing(uint8_t *storageArg, size_t sizeArg) noexcept;
+
+	/** Throw everything away, the next event's delta is from 'tick'.
+	 */
+	void Clear(uint32_t tick = 0);
+
+	/** Add a channel message (0x80..0xEF with its data bytes) at
+	 * 'tick', which should not be before the previous event.  Returns
+	 * false for anything else (realtime, SysEx, incomplete messages).
+	 */
+	bool Append(uint32_t tick, const uint8_t *msg, size_t len);
+
+	/** Walks events from a position in the ring.
+	 */
+	class Reader {
+	public:
+		/** Copy the next message to msg (3 bytes) and its tick,
+		 * returns its length or 0 at the end.
+		 */
+		size_t Next(uint32_t &tickArg, uint8_t *msg);
+		uint32_t Tick() const {
+			return tick;
+		};
+
+	private:
+		friend class EventRing;
+		const EventRing *ring;
+		size_t pos;
+		size_t end;
+		uint32_t tick;		// Tick of the last event read.
+		uint8_t status;		// Running status.
+	};
+	/** All events, oldest first.
+	 */
+	Reader Read() const;
+	/** Empty reader at the end of the ring, the start of whatever is
+	 * appended next.
+	 */
+	Reader Mark() const;
+	/** Events from 'from' up to the current end of the ring.
+	 */
+	Reader Until(const Reader &from) const;
+	/** False when events of 'reader' have been dropped.
+	 */
+	bool Valid(const Reader &reader) const {
+		return head - reader.pos <= head - tail;
+	};
+
+	size_t Size() const {
+		return mask + 1;
+	};
+	size_t Bytes() const {
+		return head - tail;
+	};
+	uint32_t Events() const {
+		return events;
+	};
+	uint32_t Dropped() const {
+		return dropped;
+	};
+
+	/** Write everything as a type 0 SMF with the given division
+	 * (ticks per quarter note) and tempo (us per quarter note),
+	 * returns the number of bytes written.
+	 */
+	size_t WriteSmf(Output out, uint16_t division, uint32_t tempo) const;
+
+private:
+	void DropOldest();
+
+	uint8_t *buf;
+	size_t mask;
+	size_t head;		// Free running byte counters, used = head - tail.
+	size_t tail;
+	uint32_t headTick;	// Tick and running status after the last event.
+	uint8_t headStatus;
+	uint32_t tailTick;	// Tick and running status before the oldest event.
+	uint8_t tailStatus;
+	uint32_t events;
+	uint32_t dropped;
+};
+
+
+class MidiLooper {
+public:
+	/** Receives the events played back.
+	 */
+	typedef void (*Sink)(const UmpEvent &event);
+
+	static const unsigned int maxLayers = 8;
+	/** Position resolution, the time between MIDI clocks is
+	 * interpolated to 96 PPQN.
+	 */
+	static const uint32_t ticksPerClock = 4;
+	static const uint32_t ticksPerBeat = 24 * ticksPerClock;
+
+	enum State {
+		EMPTY,			// Nothing recorded.
+		RECORDING,		// First layer, the loop length is not known yet.
+		PLAYING,
+		OVERDUBBING
+	};
+
+	MidiLooper(uint8_t *storage, size_t size, Sink sinkArg) noexcept;
+
+	/** MIDI clock, start, continue and stop.  'now' is in us from any
+	 * free running clock, the same one for all calls.
+	 */
+	void Realtime(uint8_t msg, uint64_t now);
+	/** Record button: start recording, close the loop, start or
+	 * stop an overdub.
+	 */
+	void Record(uint64_t now);
+	/** Drop the last layer (or the overdub in progress).
+	 */
+	void Undo();
+	void Clear();
+	/** Events played in, only kept while recording.  The loop is
+	 * stored as MIDI 1.0 so MIDI 2.0 values are scaled down.
+	 */
+	void Input(const UmpEvent &event, uint64_t now);
+	/** Send the recorded events that are due, returns the number of
+	 * messages sent.
+	 */
+	unsigned int Play(uint64_t now);
+
+	State GetState() const {
+		return state;
+	};
+	/** Loop length in ticks, 0 until the first layer is closed.
+	 */
+	uint32_t Length() const {
+		return length;
+	};
+	unsigned int NumOfLayers() const {
+		return numOfLayers;
+	};
+	size_t Bytes() const {
+		return ring.Bytes();
+	};
+	/** Events that did not fit.
+	 */
+	uint32_t Dropped() const {
+		return dropped;
+	};
+
+private:
+	struct Layer {
+		EventRing::Reader begin;	// First event of the layer.
+		EventRing::Reader cursor;	// Next event to play.
+		uint32_t base;		// Ring tick the layer starts at.
+		uint32_t start;		// Position the layer was recorded at.
+		uint32_t offset;	// Start within the loop.
+		uint32_t cycle;		// Position of the current pass of the layer.
+		uint32_t due;		// Position of the pending event.
+		uint8_t msg[3];		// Pending event.
+		uint8_t len;		// 0 when the layer has no events.
+	};
+
+	Layer &LayerAt(unsigned int i) {
+		return layers[(firstLayer + i) % maxLayers];
+	};
+	Layer &Last() {
+		return LayerAt(numOfLayers - 1);
+	};
+	uint32_t Position(uint64_t now);
+	void OpenLayer(uint32_t tick, bool carry);
+	void CloseLayer(uint32_t tick);
+	void Split(uint32_t tick);
+	void Seek(Layer &layer, uint32_t tick);
+	void Load(Layer &layer);
+	void DropInvalid();
+	void Append(Layer &layer, uint32_t rel, const uint8_t *msg, size_t len);
+	void Send(const uint8_t *msg, size_t len);
+	void AllNotesOff();
+
+	EventRing ring;
+	Sink sink;
+	State state;
+	Layer layers[maxLayers];
+	unsigned int firstLayer;
+	unsigned int numOfLayers;
+	uint32_t loopStart;		// Position of the start of the loop.
+	uint32_t length;
+	uint32_t dropped;
+
+	// Transport, positions are in ticks since MIDI start.
+	bool running;
+	bool firstClock;		// No clock since start yet.
+	uint32_t clocks;
+	uint64_t lastClock;		// Time of the last clock.
+	uint32_t clockPeriod;	// Between the last two clocks (us).
+	uint32_t position;		// Never goes backwards until a start.
+
+	// Notes held while recording and sounding from the loop per
+	// channel, so a layer and the playback never leave notes hanging.
+	NoteSet held[16];
+	NoteSet sounding[16];
+};
+
+
+#endif /* MidiLooper_hpp */
@@ -0,0 +1,414 @@
+/** @file MidiParser.cpp
+ *
+ * MIDI 1.0 byte stream parser
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MidiParser.hpp"
+
+
+MidiParser::MidiParser(NoteHandler noteOnArg,
+					   RealtimeHandler realtimeArg,
+					   NoteHandler noteOffArg,
+					   ControlChangeHandler controlChangeArg,
+					   PitchwheelHandler pitchwheelArg) noexcept {
+	noteOn = noteOnArg;
+	realtime = realtimeArg;
+	noteOff = noteOffArg;
+	controlChange = controlChangeArg;
+	pitchwheel = pitchwheelArg;
+	sysex = nullptr;
+	sysexFlags = 0;
+	state = 0;
+	Reset();
+	ClearStats();
+}
+
+
+void MidiParser::ClearStats() {
+	stats = Statistics();
+}
+
+
+uint8_t MidiParser::DataBytes(uint8_t status) {
+	switch (status & 0xF0) {
+		case 0x80:	// Note off
+		case 0x90:	// Note on
+		case 0xA0:	// Polyphonic aftertouch
+		case 0xB0:	// Control change
+		case 0xE0:	// Pitch wheel
+			return 2;
+		case 0xC0:	// Program change
+		case 0xD0:	// Channel aftertouch
+			return 1;
+		default:
+			break;
+	}
+	switch (status) {
+		case 0xF1:	// MTC quarter frame
+		case 0xF3:	// Song select
+			return 1;
+		case 0xF2:	// Song position pointer
+			return 2;
+		default:	// F4, F5 undefined, F6 tune request, F0/F7 SysEx
+			return 0;
+	}
+}
+
+
+/*
+ * Byte classes
+ */
+enum ByteClass: uint8_t {
+	DATA,		// 00..7F
+	CH1,		// C0..DF channel message with 1 data byte
+	CH2,		// 80..BF, E0..EF channel message with 2 data bytes
+	SX,			// F0 SysEx start
+	SXE,		// F7 SysEx end
+	C0,			// F4, F5, F6 system common without data
+	C1,			// F1, F3 system common with 1 data byte
+	C2,			// F2 system common with 2 data bytes
+	RT			// F8..FF realtime
+};
+
+#define X16(c) c,c,c,c,c,c,c,c,c,c,c,c,c,c,c,c
+const uint8_t MidiParser::byteClass[256] = {
+	X16(DATA), X16(DATA), X16(DATA), X16(DATA),
+	X16(DATA), X16(DATA), X16(DATA), X16(DATA),
+	X16(CH2), X16(CH2), X16(CH2), X16(CH2),		// 8x 9x Ax Bx
+	X16(CH1), X16(CH1), X16(CH2),				// Cx Dx Ex
+	SX, C1, C2, C1, C0, C0, C0, SXE,			// F0..F7
+	RT, RT, RT, RT, RT, RT, RT, RT				// F8..FF
+};
+#undef X16
+
+/*
+ * States
+ */
+enum State: uint8_t {
+	IDLE,		// No running status
+	SYSEX,		// Between F0 and F7
+	RUN1,		// Channel message, waiting for the data byte
+	RUN2A,		// Channel message, waiting for the first data byte
+	RUN2B,		// Channel message, waiting for the second data byte
+	COM1,		// System common, waiting for the data byte
+	COM2A,		// System common, waiting for the first data byte
+	COM2B		// System common, waiting for the second data byte
+};
+
+#define T(next, action) (uint8_t)((action) << 4 | (next))
+const uint8_t MidiParser::transition[8][9] = {
+	// DATA, CH1, CH2, SX, SXE, C0, C1, C2, RT
+	{	// IDLE
+		T(IDLE, A_STRAY), T(RUN1, A_STATUS), T(RUN2A, A_STATUS),
+		T(SYSEX, A_SYSEX_START), T(IDLE, A_STRAY), T(IDLE, A_COMMON0),
+		T(COM1, A_STATUS), T(COM2A, A_STATUS), T(IDLE, A_REALTIME)
+	},
+	{	// SYSEX, the byte that ends it is handled again from IDLE
+		T(SYSEX, A_SYSEX), T(IDLE, A_SYSEX_EXIT), T(IDLE, A_SYSEX_EXIT),
+		T(IDLE, A_SYSEX_EXIT), T(IDLE, A_SYSEX_EXIT), T(IDLE, A_SYSEX_EXIT),
+		T(IDLE, A_SYSEX_EXIT), T(IDLE, A_SYSEX_EXIT), T(SYSEX, A_REALTIME)
+	},
+	{	// RUN1
+		T(RUN1, A_DISPATCH1), T(RUN1, A_STATUS), T(RUN2A, A_STATUS),
+		T(SYSEX, A_SYSEX_START), T(IDLE, A_STRAY), T(IDLE, A_COMMON0),
+		T(COM1, A_STATUS), T(COM2A, A_STATUS), T(RUN1, A_REALTIME)
+	},
+	{	// RUN2A
+		T(RUN2B, A_STORE), T(RUN1, A_STATUS), T(RUN2A, A_STATUS),
+		T(SYSEX, A_SYSEX_START), T(IDLE, A_STRAY), T(IDLE, A_COMMON0),
+		T(COM1, A_STATUS), T(COM2A, A_STATUS), T(RUN2A, A_REALTIME)
+	},
+	{	// RUN2B
+		T(RUN2A, A_DISPATCH2), T(RUN1, A_STATUS_TRUNC),
+		T(RUN2A, A_STATUS_TRUNC), T(SYSEX, A_SYSEX_START_TRUNC),
+		T(IDLE, A_STRAY_TRUNC), T(IDLE, A_COMMON0_TRUNC),
+		T(COM1, A_STATUS_TRUNC), T(COM2A, A_STATUS_TRUNC),
+		T(RUN2B, A_REALTIME)
+	},
+	{	// COM1
+		T(IDLE, A_DISPATCH1), T(RUN1, A_STATUS), T(RUN2A, A_STATUS),
+		T(SYSEX, A_SYSEX_START), T(IDLE, A_STRAY), T(IDLE, A_COMMON0),
+		T(COM1, A_STATUS), T(COM2A, A_STATUS), T(COM1, A_REALTIME)
+	},
+	{	// COM2A
+		T(COM2B, A_STORE), T(RUN1, A_STATUS), T(RUN2A, A_STATUS),
+		T(SYSEX, A_SYSEX_START), T(IDLE, A_STRAY), T(IDLE, A_COMMON0),
+		T(COM1, A_STATUS), T(COM2A, A_STATUS), T(COM2A, A_REALTIME)
+	},
+	{	// COM2B
+		T(IDLE, A_DISPATCH2), T(RUN1, A_STATUS_TRUNC),
+		T(RUN2A, A_STATUS_TRUNC), T(SYSEX, A_SYSEX_START_TRUNC),
+		T(IDLE, A_STRAY_TRUNC), T(IDLE, A_COMMON0_TRUNC),
+		T(COM1, A_STATUS_TRUNC), T(COM2A, A_STATUS_TRUNC),
+		T(COM2B, A_REALTIME)
+	}
+};
+#undef T
+
+void MidiParser::Reset() {
+	if (state == SYSEX) {
+		SysexChunk(nullptr, 0, SYSEX_END | SYSEX_ABORTED);
+	}
+	state = IDLE;
+	status = 0;
+}
+
+
+void MidiParser::Action(uint8_t action, uint8_t byte) {
+	switch (action) {
+		case A_NONE:
+		case A_STORE:
+			break;
+		case A_DISPATCH1:
+			data[0] = byte;
+			Dispatch();
+			break;
+		case A_DISPATCH2:
+			data[1] = byte;
+			Dispatch();
+			break;
+		case A_STATUS_TRUNC:
+			stats.truncated++;
+			status = byte;
+			break;
+		case A_STATUS:
+			status = byte;
+			break;
+		case A_REALTIME:
+			stats.realtime++;
+			if (realtime) {
+				realtime(byte);
+			}
+			break;
+		case A_STRAY_TRUNC:
+			stats.truncated++;
+			stats.stray++;
+			break;
+		case A_STRAY:
+			stats.stray++;
+			break;
+		case A_SYSEX:
+			stats.sysexBytes++;
+			SysexChunk(&byte, 1, 0);
+			break;
+		case A_SYSEX_START_TRUNC:
+			stats.truncated++;
+			sysexFlags = SYSEX_START;
+			break;
+		case A_SYSEX_START:
+			sysexFlags = SYSEX_START;
+			break;
+		case A_SYSEX_EXIT:
+			if (byte == 0xF7) {
+				SysexChunk(nullptr, 0, SYSEX_END);
+			}
+			else {
+				// From IDLE a status byte other than F7 can only start
+				// a message, a SysEx or be a system common without data.
+				SysexChunk(nullptr, 0, SYSEX_END | SYSEX_ABORTED);
+				uint8_t entry = transition[IDLE][byteClass[byte]];
+				state = entry & stateMask;
+				switch (entry >> actionShift) {
+					case A_SYSEX_START:
+						sysexFlags = SYSEX_START;
+						break;
+					case A_COMMON0:
+						stats.messages++;
+						break;
+					default:
+						status = byte;
+						break;
+				}
+			}
+			break;
+		case A_COMMON0_TRUNC:
+			stats.truncated++;
+			stats.messages++;
+			break;
+		case A_COMMON0:
+			stats.messages++;
+			break;
+	}
+}
+
+
+void MidiParser::Parse(const uint8_t *buf, size_t len) {
+	uint8_t s = state;
+	stats.bytes += len;
+	for (size_t i = 0; i < len; i++) {
+		if (s == SYSEX) {
+			// Hand over the whole run of data bytes at once, when the
+			// run ends with F7 it is the last chunk.
+			size_t run = i;
+			while (run < len && buf[run] < 0x80) {
+				run++;
+			}
+			size_t n = run - i;
+			stats.sysexBytes += n;
+			if (run < len && buf[run] == 0xF7) {
+				SysexChunk(buf + i, n, SYSEX_END);
+				s = IDLE;
+				i = run;
+				continue;
+			}
+			if (n) {
+				SysexChunk(buf + i, n, 0);
+			}
+			i = run;
+			if (i == len) {
+				break;
+			}
+		}
+		uint8_t entry = transition[s][byteClass[buf[i]]];
+		uint8_t action = entry >> actionShift;
+		s = entry & stateMask;
+		// Nearly every byte of a busy stream is a data byte.
+		if (action == A_STORE) {
+			data[0] = buf[i];
+		}
+		else if (action == A_DISPATCH2) {
+			data[1] = buf[i];
+			Dispatch();
+		}
+		else {
+			state = s;
+			Action(action, buf[i]);
+			s = state;
+		}
+	}
+	state = s;
+}
+
+
+#if MIDI_PARSER_SELFTEST
+MidiReferenceParser::MidiReferenceParser
+ (
+	MidiParser::NoteHandler noteOnArg,
+	MidiParser::RealtimeHandler realtimeArg,
+	MidiParser::NoteHandler noteOffArg,
+	MidiParser::ControlChangeHandler controlChangeArg,
+	MidiParser::PitchwheelHandler pitchwheelArg ) noexcept
+{
+	noteOn = noteOnArg;
+	realtime = realtimeArg;
+	noteOff = noteOffArg;
+	controlChange = controlChangeArg;
+	pitchwheel = pitchwheelArg;
+	Reset();
+	ClearStats();
+}
+
+
+void MidiReferenceParser::Reset() {
+	status = 0;
+	needed = 0;
+	count = 0;
+	inSysex = false;
+}
+
+
+/*
+ * One byte at the time, realtime bytes can come anywhere (also in
+ * the middle of a message or SysEx) and don't change the state.
+ */
+void MidiReferenceParser::Parse(uint8_t byte) {
+	stats.bytes++;
+	
+	// Realtime
+	if (byte >= 0xF8) {
+		stats.realtime++;
+		if (realtime) {
+			realtime(byte);
+		}
+		return;
+	}
+	
+	// Status
+	if (byte & 0x80) {
+		if (count != 0) {
+			stats.truncated++;
+		}
+		count = 0;
+		if (byte == 0xF7) {
+			if (!inSysex) {
+				stats.stray++;
+			}
+			inSysex = false;
+			status = 0;
+			return;
+		}
+		// Any other status byte ends a SysEx as well.
+		inSysex = (byte == 0xF0);
+		status = inSysex ? 0 : byte;
+		needed = MidiParser::DataBytes(byte);
+		if (byte > 0xF0 && needed == 0) {
+			// Tune request and the undefined ones have no data.
+			Dispatch();
+			status = 0;
+		}
+		return;
+	}
+	
+	// Data
+	if (inSysex) {
+		stats.sysexBytes++;
+		return;
+	}
+	if (status == 0) {
+		stats.stray++;
+		return;
+	}
+	data[count++] = byte;
+	if (count == needed) {
+		Dispatch();
+		count = 0;
+		// System common messages cancel running status.
+		if (status >= 0xF0) {
+			status = 0;
+		}
+	}
+}
+
+
+void MidiReferenceParser::Dispatch() {
+	stats.messages++;
+	switch (status & 0xF0) {
+		case 0x80:
+			if (noteOff) {
+				noteOff(data[0], data[1]);
+			}
+			break;
+		case 0x90:
+			// Note on with velocity 0 is a note off.
+			if (data[1] == 0) {
+				if (noteOff) {
+					noteOff(data[0], 0);
+				}
+			}
+			else if (noteOn) {
+				noteOn(data[0], data[1]);
+			}
+			break;
+		case 0xB0:
+			if (controlChange) {
+				controlChange(data[0], data[1]);
+			}
+			break;
+		case 0xE0:
+			if (pitchwheel) {
+				pitchwheel(data[0], data[1]);
+			}
+			break;
+		default:
+			// No handlers for these (yet).
+			break;
+	}
+}
+
+#endif // MIDI_PARSER_SELFTEST
+
+
+/* EOF */
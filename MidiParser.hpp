@@ -0,0 +1,241 @@
+/** @file MidiParser.hpp
+ *
+ * MIDI 1.0 byte stream parser that can be fed from any source
+ * (UART, a buffer in RAM, a file) and dispatches to the same kind of
+ * handlers as SerialMidi.  It does not touch the hardware so it can
+ * be fed arbitrary byte streams to check its behaviour on running
+ * status, interleaved realtime bytes, truncated messages, SysEx and
+ * garbage.
+ *
+ * The state machine is table driven: every byte is looked up in a
+ * byte class table and then in a (state, byte class) transition table
+ * which gives the next state and the action to take.  The actions of
+ * data bytes in a message, nearly every byte of a busy stream, are
+ * handled inline, the rest in Action().
+ *
+ * SysEx is not buffered, the data is handed to the SysEx handler in
+ * chunks.  When a whole buffer is parsed the chunks point straight
+ * into that buffer, so dumps of any size pass without being copied.
+ *
+ * The firmware does not use it yet: main.cpp's RX thread still parses
+ * with SerialMidi::ReceiveParser(), which has no SysEx handler, so
+ * SysEx on the DIN input is still dropped on the board.  The
+ * simulator tools in sim/ parse with this one.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiParser_hpp
+#define MidiParser_hpp
+
+#include <cstdint>
+#include <cstddef>
+
+
+class MidiParser {
+public:
+	typedef void (*NoteHandler)(uint8_t note, uint8_t velocity);
+	typedef void (*RealtimeHandler)(uint8_t msg);
+	typedef void (*ControlChangeHandler)(uint8_t controller, uint8_t value);
+	typedef void (*PitchwheelHandler)(uint8_t valueLSB, uint8_t valueMSB);
+	/** A piece of SysEx data (without F0 and F7), only valid during
+	 * the call.
+	 */
+	typedef void (*SysexHandler)(const uint8_t *data, size_t len, uint8_t flags);
+	
+	/** Flags of a SysEx chunk, a chunk without START or END is a
+	 * continuation.  The END chunk can be empty.
+	 */
+	enum SysexFlags: uint8_t {
+		SYSEX_START = 1,
+		SYSEX_END = 2,
+		SYSEX_ABORTED = 4	// Ended by a status byte other than F7.
+	};
+	
+	/** Handlers in the same order as SerialMidi, nullptr is allowed
+	 * for messages we are not interested in.
+	 */
+	MidiParser(NoteHandler noteOnArg,
+			   RealtimeHandler realtimeArg,
+			   NoteHandler noteOffArg,
+			   ControlChangeHandler controlChangeArg,
+			   PitchwheelHandler pitchwheelArg) noexcept;
+	
+	void SetSysexHandler(SysexHandler sysexArg) {
+		sysex = sysexArg;
+	};
+	
+	void Parse(uint8_t byte) {
+		uint8_t entry = transition[state][byteClass[byte]];
+		uint8_t action = entry >> actionShift;
+		state = entry & stateMask;
+		stats.bytes++;
+		if (action == A_STORE) {
+			data[0] = byte;
+		}
+		else if (action == A_DISPATCH2) {
+			data[1] = byte;
+			Dispatch();
+		}
+		else {
+			Action(action, byte);
+		}
+	};
+	/** Parse a whole buffer at once, SysEx data is passed on in
+	 * chunks that point into buf.
+	 */
+	void Parse(const uint8_t *buf, size_t len);
+	/** Forget running status and any message in progress, a SysEx
+	 * in progress ends with SYSEX_ABORTED.
+	 */
+	void Reset();
+	
+	/** Counters, e.g. to calculate throughput or to find out
+	 * what was thrown away.
+	 */
+	struct Statistics {
+		uint32_t bytes;
+		uint32_t messages;		// Channel and system common messages.
+		uint32_t realtime;
+		uint32_t sysexBytes;	// Data bytes between F0 and F7.
+		uint32_t truncated;		// Messages cut short by a status byte.
+		uint32_t stray;			// Data bytes without status, lone F7.
+	};
+	const Statistics &Stats() {
+		return stats;
+	};
+	void ClearStats();
+	
+	/** Number of data bytes that follow a status byte.
+	 */
+	static uint8_t DataBytes(uint8_t status);
+	
+private:
+	enum ParserAction: uint8_t {
+		A_NONE,
+		A_STORE,			// First of two data bytes
+		A_DISPATCH1,		// Only data byte, dispatch
+		A_DISPATCH2,		// Second data byte, dispatch
+		A_STATUS,			// New status
+		A_STATUS_TRUNC,		// New status, message in progress lost
+		A_REALTIME,
+		A_STRAY,			// Data without status or F7 without F0
+		A_STRAY_TRUNC,
+		A_SYSEX,			// SysEx data byte
+		A_SYSEX_START,
+		A_SYSEX_START_TRUNC,	// SysEx start, message in progress lost
+		A_SYSEX_EXIT,		// F7 or another status byte ends the SysEx
+		A_COMMON0,			// System common without data
+		A_COMMON0_TRUNC
+	};
+
+	/** Everything but A_STORE and A_DISPATCH2, 'byte' is counted.
+	 */
+	void Action(uint8_t action, uint8_t byte);
+	void Dispatch() {
+		stats.messages++;
+		switch (status & 0xF0) {
+			case 0x80:
+				if (noteOff) {
+					noteOff(data[0], data[1]);
+				}
+				break;
+			case 0x90:
+				// Note on with velocity 0 is a note off.
+				if (data[1] == 0) {
+					if (noteOff) {
+						noteOff(data[0], 0);
+					}
+				}
+				else if (noteOn) {
+					noteOn(data[0], data[1]);
+				}
+				break;
+			case 0xB0:
+				if (controlChange) {
+					controlChange(data[0], data[1]);
+				}
+				break;
+			case 0xE0:
+				if (pitchwheel) {
+					pitchwheel(data[0], data[1]);
+				}
+				break;
+			default:
+				// Aftertouch, program change and system common.
+				break;
+		}
+	};
+	void SysexChunk(const uint8_t *chunk, size_t len, uint8_t flags) {
+		if (sysex) {
+			sysex(chunk, len, sysexFlags | flags);
+		}
+		sysexFlags = 0;
+	};
+	
+	static const uint8_t stateMask = 0x0F;
+	static const uint8_t actionShift = 4;
+	static const uint8_t byteClass[256];
+	static const uint8_t transition[8][9];
+	
+	NoteHandler noteOn;
+	RealtimeHandler realtime;
+	NoteHandler noteOff;
+	ControlChangeHandler controlChange;
+	PitchwheelHandler pitchwheel;
+	SysexHandler sysex;
+	
+	uint8_t state;
+	uint8_t status;		// Running status (or system common status).
+	uint8_t data[2];
+	uint8_t sysexFlags;	// START until the first chunk is out.
+	Statistics stats;
+};
+
+
+#if MIDI_PARSER_SELFTEST
+/** The straightforward byte at a time parser that MidiParser
+ * replaced, only kept to compare MidiParser against.
+ */
+class MidiReferenceParser {
+public:
+	MidiReferenceParser(MidiParser::NoteHandler noteOnArg,
+						MidiParser::RealtimeHandler realtimeArg,
+						MidiParser::NoteHandler noteOffArg,
+						MidiParser::ControlChangeHandler controlChangeArg,
+						MidiParser::PitchwheelHandler pitchwheelArg) noexcept;
+	void Parse(uint8_t byte);
+	void Parse(const uint8_t *buf, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			Parse(buf[i]);
+		}
+	};
+	void Reset();
+	const MidiParser::Statistics &Stats() {
+		return stats;
+	};
+	void ClearStats() {
+		stats = MidiParser::Statistics();
+	};
+	
+private:
+	void Dispatch();
+	
+	MidiParser::NoteHandler noteOn;
+	MidiParser::RealtimeHandler realtime;
+	MidiParser::NoteHandler noteOff;
+	MidiParser::ControlChangeHandler controlChange;
+	MidiParser::PitchwheelHandler pitchwheel;
+	
+	uint8_t status;		// Running status, 0 when there is none.
+	uint8_t needed;
+	uint8_t count;
+	uint8_t data[2];
+	bool inSysex;
+	MidiParser::Statistics stats;
+};
+#endif // MIDI_PARSER_SELFTEST
+
+
+#endif /* MidiParser_hpp */
@@ -0,0 +1,60 @@
+/** @file MidiSetup.hpp
+ *
+ * How main.cpp sets up the MIDI path: the voicing range, the scale it
+ * starts in, the controller smoothing, the analog inputs and the
+ * output wire.  The simulator (sim/SimPath.cpp) includes this as well,
+ * so a change here is what the soak tests run with before it is
+ * flashed.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiSetup_hpp
+#define MidiSetup_hpp
+
+#include <cstdint>
+#include "TransformMIDI.h"
+#include "StaticScale.hpp"
+#include "OneEuroFilter.hpp"
+
+
+/** Chords are voiced within these notes.
+ */
+const uint8_t voiceLowest = 36;
+const uint8_t voiceHighest = 84;
+
+/** Scale the quantizer, the harmonizer and the melody engine start in,
+ * and the intervals the harmonizer adds.
+ */
+typedef StaticScale<Scale::TypeOfScale::HARMONIC_MINOR, 0> StartScale;
+const uint8_t harmonyIntervals = Harmonizer::THIRD | Harmonizer::FIFTH;
+
+/** Adaptive smoothing of the analog inputs:
+ * {min cutoff mHz, beta mHz per count/s Q16, speed cutoff mHz}
+ */
+const OneEuroFilter::Parameters adcFilterParameters = {1000, 3000, 1000};
+
+/** The analog inputs are read every controlPeriod us and sent as
+ * control changes on channel 3, in this order: b2in, b3in, ribbon.
+ */
+const uint32_t controlPeriod = 30000;
+struct AnalogControl {
+	uint8_t status;
+	uint8_t controller;
+};
+const unsigned int numOfAnalogControls = 3;
+const AnalogControl analogControls[numOfAnalogControls] = {
+	{0xB2, 2},		// Breath
+	{0xB2, 11},		// Expression
+	{0xB2, 1}		// Modulation
+};
+
+/** The DIN output: 31250 baud is 3125 bytes/s, and the UART FIFO
+ * takes this many back to back.
+ */
+const uint32_t wireBytesPerSecond = 3125;
+const uint32_t wireBurstBytes = 16;
+
+
+#endif /* MidiSetup_hpp */
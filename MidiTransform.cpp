@@ -0,0 +1,129 @@
+/** @file MidiTransform.cpp
+ *
+ * The transform stage: scale quantize, chords and harmonies.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MidiTransform.hpp"
+
+
+MidiTransform::MidiTransform(Sink sinkArg, ScaleQuantize &quantizeArg,
+							 Harmonizer &harmonizerArg,
+							 VoiceLeader &voiceLeaderArg,
+							 Mode modeArg, uint32_t gateArg) noexcept
+: quantize(quantizeArg), harmonizer(harmonizerArg),
+  voiceLeader(voiceLeaderArg)
+{
+	sink = sinkArg;
+	chordHandler = nullptr;
+	mode = modeArg;
+	gate = gateArg;
+	chordType = Chord::Type::MAJOR;
+	firstPending = 0;
+	numOfPending = 0;
+	stats = Statistics();
+}
+
+
+Chord::Type MidiTransform::ChordTypeOf(uint8_t value) {
+	static const Chord::Type types[8] = {
+		Chord::Type::MAJOR,
+		Chord::Type::MINOR,
+		Chord::Type::AUGMENTED,
+		Chord::Type::DIMINISHED_7,
+		Chord::Type::MINOR_7_FLAT5,
+		Chord::Type::DOMINANT_7_ADD9_SHARP11,
+		Chord::Type::DOMINANT_7_ADD9_FLAT5,
+		Chord::Type::SUS4
+	};
+	return types[(value & 0x7F) >> 4];
+}
+
+
+void MidiTransform::Process(const UmpEvent &event, uint32_t now) {
+	stats.events++;
+	switch (event.Opcode()) {
+		case 0x90:
+			if (event.Data2() != 0) {
+				NoteOn(event.Index(), event.Data2(), now);
+				break;
+			}
+			// Velocity 0 is a note off.
+			// fall through
+		case 0x80:
+			quantize.NoteOff(event.Index());
+			break;
+		case 0xB0:
+			chordType = ChordTypeOf(event.Data2());
+			break;
+		default:
+			break;
+	}
+}
+
+
+void MidiTransform::NoteOn(uint8_t note, uint8_t velocity, uint32_t now) {
+	// Velocity decides on the chord quality.
+	chordType = ChordTypeOf(velocity);
+	note = quantize.NoteOn(note);
+
+	if (mode == HARMONIES) {
+		// Diatonic intervals from the table above the note.
+		uint8_t voices[Harmonizer::maxVoices];
+		unsigned int numOfVoices = harmonizer.Harmonize(note, voices);
+		Play(note, velocity, now);
+		for (unsigned int i = 0; i < numOfVoices; i++) {
+			Play(voices[i], velocity, now);
+		}
+		return;
+	}
+	Chord chrd(chordType, note, note);
+	voiceLeader.Voice(chrd);
+	if (chordHandler) {
+		chordHandler(chrd);
+	}
+	for (auto &voice: chrd.voicing) {
+		Play(voice.number, velocity, now);
+	}
+}
+
+
+void MidiTransform::Play(uint8_t note, uint8_t velocity, uint32_t now) {
+	if (numOfPending == maxPending) {
+		// No room: the oldest note ends early.
+		Send(0x80, pending[firstPending].note, 100);
+		firstPending = (firstPending + 1) % maxPending;
+		numOfPending--;
+		stats.early++;
+	}
+	PendingNote &p = pending[(firstPending + numOfPending) % maxPending];
+	p.due = now + gate;
+	p.note = note;
+	numOfPending++;
+	stats.voices++;
+	Send(0x90, note, velocity);
+}
+
+
+unsigned int MidiTransform::Release(uint32_t now) {
+	unsigned int n = 0;
+	while (numOfPending && (int32_t)(now - pending[firstPending].due) >= 0) {
+		Send(0x80, pending[firstPending].note, 100);
+		firstPending = (firstPending + 1) % maxPending;
+		numOfPending--;
+		n++;
+	}
+	return n;
+}
+
+
+void MidiTransform::Send(uint8_t status, uint8_t note, uint8_t velocity) {
+	if (sink) {
+		sink(UmpEvent::Midi1(status, note, velocity));
+	}
+}
+
+
+/* EOF */
@@ -0,0 +1,108 @@
+/** @file MidiTransform.hpp
+ *
+ * The transform stage of the firmware: incoming notes are snapped to
+ * the scale and played as a voice led chord (or with diatonic
+ * harmonies), controllers and velocity pick the chord quality.  Every
+ * generated note is released again after the gate time.
+ *
+ * The stage only deals in UMP events and us time stamps, it is driven
+ * by the transform thread on the board and by the simulator (sim/) on
+ * a host, so both run the same logic.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiTransform_hpp
+#define MidiTransform_hpp
+
+#include <cstdint>
+#include "Ump.hpp"
+#include "Harmony.hpp"
+#include "TransformMIDI.h"
+
+
+class MidiTransform {
+public:
+	/** Receives the generated notes, on channel 0.
+	 */
+	typedef void (*Sink)(const UmpEvent &event);
+	/** Called with every chord that is played (e.g. for the display).
+	 */
+	typedef void (*ChordHandler)(Chord &chord);
+
+	enum Mode {
+		CHORDS,
+		HARMONIES
+	};
+	static const unsigned int maxPending = 64;
+
+	struct Statistics {
+		uint32_t events;		// Processed.
+		uint32_t voices;		// Notes generated.
+		uint32_t early;			// Released before the gate ended (no room).
+	};
+
+	MidiTransform(Sink sinkArg, ScaleQuantize &quantizeArg,
+				  Harmonizer &harmonizerArg, VoiceLeader &voiceLeaderArg,
+				  Mode modeArg = CHORDS, uint32_t gateArg = 400000) noexcept;
+
+	/** One incoming channel message, 'now' in us.
+	 */
+	void Process(const UmpEvent &event, uint32_t now);
+
+	/** Release the notes whose gate has ended, returns how many.
+	 */
+	unsigned int Release(uint32_t now);
+	bool Pending() const {
+		return numOfPending != 0;
+	};
+	/** When the next note has to be released, only valid when
+	 * Pending().
+	 */
+	uint32_t NextReleaseTime() const {
+		return pending[firstPending].due;
+	};
+
+	void SetChordHandler(ChordHandler handler) {
+		chordHandler = handler;
+	};
+	Chord::Type GetChordType() const {
+		return chordType;
+	};
+	const Statistics &Stats() const {
+		return stats;
+	};
+
+	/** Chord quality picked by a 7 bit value (velocity, controller).
+	 */
+	static Chord::Type ChordTypeOf(uint8_t value);
+
+private:
+	struct PendingNote {
+		uint32_t due;
+		uint8_t note;
+	};
+
+	void NoteOn(uint8_t note, uint8_t velocity, uint32_t now);
+	void Play(uint8_t note, uint8_t velocity, uint32_t now);
+	void Send(uint8_t status, uint8_t note, uint8_t velocity);
+
+	Sink sink;
+	ChordHandler chordHandler;
+	ScaleQuantize &quantize;
+	Harmonizer &harmonizer;
+	VoiceLeader &voiceLeader;
+	Mode mode;
+	uint32_t gate;
+	Chord::Type chordType;
+
+	// Due times only go up (one gate for all), so a FIFO will do.
+	PendingNote pending[maxPending];
+	unsigned int firstPending;
+	unsigned int numOfPending;
+	Statistics stats;
+};
+
+
+#endif /* MidiTransform_hpp */
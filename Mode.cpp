@@ -14,9 +14,36 @@
  * @copyright APACHE-2.0
  */
 #include <algorithm>
-#include <random>
 #include "Harmony.hpp"
 #include "Mode.hpp"
+#include "HeapProbe.hpp"
+
+
+// Definitions of the static constexpr members (required before C++17)
+constexpr uint8_t Mode::chromatic[12];
+constexpr uint8_t Mode::octatonic[2][8];
+constexpr uint8_t Mode::dominant_diminished[8];
+constexpr uint8_t Mode::diminished[8];
+constexpr uint8_t Mode::major_s[7][7];
+constexpr uint8_t Mode::minor_s[7][7];
+constexpr uint8_t Mode::melodic_minor[7][7];
+constexpr uint8_t Mode::harmonic_minor[7][7];
+constexpr uint8_t Mode::gypsy[7];
+constexpr uint8_t Mode::symetrical[7];
+constexpr uint8_t Mode::enigmatic[7];
+constexpr uint8_t Mode::arabian[7];
+constexpr uint8_t Mode::hungarian[7];
+constexpr uint8_t Mode::whole_tone[6];
+constexpr uint8_t Mode::augmented[2][6];
+constexpr uint8_t Mode::blues_major[6];
+constexpr uint8_t Mode::blues_minor[6][6];
+constexpr uint8_t Mode::pentatonic[5];
+constexpr uint8_t Mode::minor_pentatonic[5];
+constexpr uint8_t Mode::in_scale[5];
+constexpr uint8_t Mode::insen[5];
+constexpr uint8_t Mode::hirajoshi[5];
+constexpr uint8_t Mode::iwato[5];
+constexpr uint8_t Mode::yo[5];
 
 /*
  * Constructor of 'Mode'
@@ -27,7 +54,8 @@
 Mode::Mode(Scale *scaleParent,
 		   unsigned int modeNumArg,
 		   unsigned long numOfNotesArg,
-		   std::string modeNameArg) noexcept {
+		   const char *modeNameArg) noexcept {
+	HEAP_PROBE_SCOPE(MODE);
 	modeNum = modeNumArg;
 	//privName = modeNumArg;
 	numOfNotes = numOfNotesArg;
@@ -51,88 +79,8 @@ Mode::Mode(Scale *scaleParent,
 							 // We need to substract j - 1 otherwise
 							 // we will be missing the first offset
 							 // ( j == 0 is covered above)
-			switch(scaleParent->typeOfScale) {
-				case Scale::TypeOfScale::CHROMATIC:
-					note.number = 	note.number + chromatic[j-1];
-					//note.number += 	scaleParent->chromatic[j-1];
-					break;
-				case Scale::TypeOfScale::OCTATONIC:
-					note.number = 	note.number +
-					octatonic[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::DOMINANT_DIMINISHED:
-					note.number = 	note.number +
-					dominant_diminished[j-1];
-					break;
-				case Scale::TypeOfScale::DIMINISHED:
-					note.number = 	note.number +
-					diminished[j-1];
-					break;
-				case Scale::TypeOfScale::MAJOR:
-					note.number = 	note.number +
-					major_s[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::MINOR:
-					note.number = 	note.number +
-					minor_s[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::MELODIC_MINOR:
-					note.number = 	note.number +
-					melodic_minor[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::HARMONIC_MINOR:
-					note.number = 	note.number +
-					harmonic_minor[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::GYPSY:
-					note.number = 	note.number +
-					gypsy[j-1];
-					break;
-				case Scale::TypeOfScale::SYMETRICAL:
-					note.number =	note.number +
-					symetrical[j-1];
-					break;
-				case Scale::TypeOfScale::ENIGMATIC:
-					note.number =	note.number +
-					enigmatic[j-1];
-					break;
-				case Scale::TypeOfScale::ARABIAN:
-					note.number =	note.number +
-					arabian[j-1];
-					break;
-				case Scale::TypeOfScale::HUNGARIAN:
-					note.number =	note.number +
-					hungarian[j-1];
-					break;
-				case Scale::TypeOfScale::WHOLE_TONE:
-					note.number =	note.number +
-					whole_tone[j-1];
-					break;
-				case Scale::TypeOfScale::AUGMENTED:
-					note.number =	note.number +
-					augmented[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::BLUES_MAJOR:
-					note.number =	note.number +
-					blues_major[j-1];
-					break;
-				case Scale::TypeOfScale::BLUES_MINOR:
-					note.number =	note.number +
-					blues_minor[this->modeNum][j-1];
-					break;
-				case Scale::TypeOfScale::PENTATONIC:
-					note.number =	note.number +
-					pentatonic[j-1];
-					break;
-				case Scale::TypeOfScale::MINOR_PENTATONIC:
-					note.number =	note.number +
-					minor_pentatonic[j-1];
-					break;
-					// TODO: IMPLEMENT
-				default:
-					// Don't to anything.
-					break;
-			}
+			note.number = note.number +
+				Scale::Step(scaleParent->typeOfScale, this->modeNum, j-1);
 			k = note.number; 	// Save just calculated note number in 'k'
 		}
 		// 'notes' is a vector containing our 'note' objects itself
@@ -145,16 +93,23 @@ Mode::Mode(Scale *scaleParent,
 /** This function reorders the notes in the mode
  */
 void Mode::Order(NoteOrder noteOrderArg) {
-	std::random_device rd;
+	// Seeded once, a std::random_device per call was slow and made the
+	// order impossible to repeat.
+	static Random random;
+	Order(noteOrderArg, random);
+}
+
+
+void Mode::Order(NoteOrder noteOrderArg, Random &random) {
 	switch(noteOrderArg) {
 		case NoteOrder::LOW_TO_HIGH:
-			sort(notes.begin(), notes.end(), Mode::privLowToHigh);
+			std::sort(notes.begin(), notes.end(), Mode::privLowToHigh);
 			break;
 		case NoteOrder::HIGH_TO_LOW:
-			sort(notes.begin(), notes.end(), Mode::privHighToLow);
+			std::sort(notes.begin(), notes.end(), Mode::privHighToLow);
 			break;
 		case NoteOrder::RANDOM:
-			std::shuffle(notes.begin(), notes.end(), rd);
+			std::shuffle(notes.begin(), notes.end(), random);
 			break;
 		default:
 			break;
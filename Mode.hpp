@@ -20,6 +20,9 @@
 #include <array>
 
 #include "Note.hpp"
+#include "FixedVector.hpp"
+#include "NoteSet.hpp"
+#include "Random.hpp"
 //#include "Harmony.hpp"
 
 
@@ -28,7 +31,7 @@ public:
 	Mode(class Scale *scaleParent,
 		 unsigned int modeNumArg,
 		 unsigned long numOfNotesArg,
-		 std::string modeNameArg) noexcept;
+		 const char *modeNameArg) noexcept;
 	unsigned int modeNum;
 	unsigned long numOfNotes;
 	
@@ -38,20 +41,45 @@ public:
 		RANDOM
 	};
 	void Order(NoteOrder noteOrderArg);
+	/** RANDOM shuffles with 'random', the same seed gives the same
+	 * order.
+	 */
+	void Order(NoteOrder noteOrderArg, Random &random);
 	
 	const std::string Name(){
-		return privName;
+		return privName + std::to_string(modeNum + 1);
 	}
 	const std::string Text() {
-		return "Mode::" + privName;
+		return "Mode::" + Name();
 	}
 	
-	std::vector<Note> notes;
+	static const unsigned int maxNotes = 12;
+	HarmonyVector<Note, maxNotes> notes;
 	unsigned long NumOfNotes() {
 		return notes.size();
 	};
+	
+	// The notes as bit sets (see NoteSet.hpp)
+	PitchClassSet PitchClasses() {
+		PitchClassSet set;
+		for (auto note: notes) {
+			set.Add(note.number);
+		}
+		return set;
+	};
+	NoteSet Set() {
+		NoteSet set;
+		for (auto note: notes) {
+			set.Add(note.number);
+		}
+		return set;
+	};
 private:
-	std::string privName;
+	// Scale::Step() reads the interval tables below.
+	friend class Scale;
+	
+	// The name is built when asked for, not for every Mode constructed.
+	const char *privName;
 	
 	// Used to sort notes e.g.
 	// sort(notes.begin(), notes.end(), Mode::CompareInterval);
@@ -63,7 +91,7 @@ private:
 	};
 private:
 	/*
-	 * Scales are listed below as arrays of
+	 * Scales are listed below as (static) arrays of
 	 * uint8_t indicating the either a 1/2 step as 1
 	 * or a whole step as 2.
 	 * minor 3'rd as 3
@@ -82,14 +110,14 @@ private:
 	/*
 	 * CHROMATIC Scale 12 note
 	 */
-	const uint8_t  chromatic[12]  = {
+	static constexpr uint8_t chromatic[12] = {
 		H,H,H,H,H,H,H,H,H,H,H,H,
 	};
 	
 	/*
 	 * OCTATONIC 8 notes (of course)
 	 */
-	const uint8_t  octatonic[2][8]  = {
+	static constexpr uint8_t octatonic[2][8] = {
 		{H,W,H,W,H,W,H,W},
 		{W,H,W,H,W,H,W,H}
 	};
@@ -98,7 +126,7 @@ private:
 	 * Dominant Diminished (Dom13, b9,#9, b5)   8 note scale
 	 * same as "first mode of OCTATONIC" see above
 	 */
-	const uint8_t  dominant_diminished[8]  = {
+	static constexpr uint8_t dominant_diminished[8] = {
 		H,W,H,W,H,W,H,W
 	};
 	
@@ -106,7 +134,7 @@ private:
 	 * Diminished (Dim7, Maj/b9)  8 note scale
 	 * same as "second mode of OCTATONIC" see above
 	 */
-	const uint8_t  diminished[8]  = {
+	static constexpr uint8_t diminished[8] = {
 		W,H,W,H,W,H,W,H
 	};
 	
@@ -125,7 +153,7 @@ private:
 	 * we need a MACRO to access them e.g. like below
 	 * uint8_t (*scale)[7] = pgm_read_ptr(&major[0]);
 	 */
-	const uint8_t major_s[7][7]  = {
+	static constexpr uint8_t major_s[7][7] = {
 		{W,W,H,W,W,W,H}, // IONIAN   	: Happy
 		{W,H,W,W,W,H,W}, // DORIAN		: Jazzy,
 		{H,W,W,W,H,W,W}, // PHRYGIAN	: Exotic, latin
@@ -138,7 +166,7 @@ private:
 	/*
 	 * MINOR Scale modes  7 notes
 	 */
-	const uint8_t  minor_s[7][7]  = {
+	static constexpr uint8_t minor_s[7][7] = {
 		{W,H,W,W,H,W,W}, // AEOLIAN		: Sad
 		{H,W,W,H,W,W,W}, // LOCRIAN
 		{W,W,H,W,W,W,H}, // IONIAN		: Happy
@@ -151,7 +179,7 @@ private:
 	/*
 	 * MELODIC MINOR Scale modes  7 notes
 	 */
-	const uint8_t  melodic_minor[7][7]  = {
+	static constexpr uint8_t melodic_minor[7][7] = {
 		{W,H,W,W,W,W,H}, // Melodic minor     (minor major7)
 		{H,W,W,W,W,H,W}, // DORIAN bW         (minor7 sus4 b9)
 		{W,W,W,W,H,W,H}, // LYDIAN augmented  (major7 #4 #5)
@@ -164,7 +192,7 @@ private:
 	/*
 	 * HARMONIC MINOR Scale modes  7 notes
 	 */
-	const uint8_t  harmonic_minor[7][7]  = {
+	static constexpr uint8_t harmonic_minor[7][7] = {
 		{W,H,W,W,H,WH,H}, // Harmonic minor    (minor major7)
 		{H,W,W,H,WH,H,W}, // LOCRIAN Nat.6     (minor7 b5)
 		{W,W,H,WH,H,W,H}, // IONIAN Augmented  (major7 sus4, #5)
@@ -177,7 +205,7 @@ private:
 	/*
 	 * Gypsy scale
 	 */
-	const uint8_t  gypsy[7]   = 	{
+	static constexpr uint8_t gypsy[7] = 	{
 		W,H,WH,H,H,WH,H
 	};
 	
@@ -185,35 +213,35 @@ private:
 	/*
 	 * Symetrical scale
 	 */
-	const uint8_t  symetrical[7]  = {
+	static constexpr uint8_t symetrical[7] = {
 		H,W,W,WH,H,H,W
 	};
 	
 	/*
 	 * Enigmatic scale
 	 */
-	const uint8_t  enigmatic[7]  = {
+	static constexpr uint8_t enigmatic[7] = {
 		H,WH,W,W,W,H,H
 	};
 	
 	/*
 	 * Arabian scale
 	 */
-	const uint8_t  arabian[7]  = {
+	static constexpr uint8_t arabian[7] = {
 		W,W,H,H,W,W,W
 	};
 	
 	/*
 	 * Hungarian scale
 	 */
-	const uint8_t  hungarian[7]  = {
+	static constexpr uint8_t hungarian[7] = {
 		WH,H,W,H,W,H,W
 	};
 	
 	/*
 	 * Whole tone (Dom7 #5, b6)   6 note scale
 	 */
-	const uint8_t  whole_tone[6]  = {
+	static constexpr uint8_t whole_tone[6] = {
 		W,W,W,W,W,W
 	};
 	//  uint8_t *hexatonic  = whole_tone;
@@ -223,7 +251,7 @@ private:
 	 * Augmented (Aug)   6 note scale
 	 * (two modes? how does one call this second one then)
 	 */
-	const uint8_t  augmented[2][6]  = {
+	static constexpr uint8_t augmented[2][6] = {
 		{WH,H,WH,H,WH,H},
 		{H,WH,H,WH,H,WH}	//	 Augmented inverse ?
 	};
@@ -231,7 +259,7 @@ private:
 	/*
 	 * Blues major  6 note scale
 	 */
-	const uint8_t  blues_major[6]  = {
+	static constexpr uint8_t blues_major[6] = {
 		W,H,H,WH,W,WH
 	};
 	
@@ -239,7 +267,7 @@ private:
 	 * Blues minor  6 note scale
 	 * not sure if these are called "modes"
 	 */
-	const uint8_t  blues_minor[6][6]  = {
+	static constexpr uint8_t blues_minor[6][6] = {
 		{WH,W,H,H,WH,W},
 		{W,H,H,WH,W,WH},      // Same as blues major scale
 		{H,H,WH,W,WH,W},
@@ -251,14 +279,14 @@ private:
 	/*
 	 * Major Pentatonic  5 note scale
 	 */
-	const uint8_t  pentatonic[5]  = {
+	static constexpr uint8_t pentatonic[5] = {
 		W,W,WH,W,WH
 	};
 	
 	/*
 	 * Minor Pentatonic  5 note scale
 	 */
-	const uint8_t  minor_pentatonic[5]  = {
+	static constexpr uint8_t minor_pentatonic[5] = {
 		WH,W,W,WH,W
 	};
 	
@@ -266,35 +294,35 @@ private:
 	/*
 	 * "In scale" scale
 	 */
-	const uint8_t in_scale[5] = {
+	static constexpr uint8_t in_scale[5] = {
 		H,I2W,W,H,I2W
 	};
 	
 	/*
 	 * "Insen" scale
 	 */
-	const uint8_t insen[5] = {
+	static constexpr uint8_t insen[5] = {
 		H,I2W,W,I2W,W
 	};
 	
 	/*
 	 * Hirajoshi scale
 	 */
-	const uint8_t hirajoshi[5] = {
+	static constexpr uint8_t hirajoshi[5] = {
 		I2W,W,H,I2W,H
 	};
 	
 	/*
 	 * Iwato scale
 	 */
-	const uint8_t iwato[5] = {
+	static constexpr uint8_t iwato[5] = {
 		H,I2W,H,I2W,W
 	};
 	
 	/*
 	 * Yo scale
 	 */
-	const uint8_t yo[5] = {
+	static constexpr uint8_t yo[5] = {
 		I3H,W,W,I3H,W
 	};
 	
@@ -317,7 +345,7 @@ private:
 	/*
 	 * MAJOR Scale modes  7 notes
 	 */
-	const std::vector<std::array<enum Iv, 7>> majorScaleVect = { {
+	static constexpr std::array<std::array<enum Iv, 7>, 7> majorScaleVect = { {
 		{Iv::W, Iv::W, Iv::H, Iv::W, Iv::W, Iv::W, Iv::H}, // IONIAN
 		{Iv::W, Iv::H, Iv::W, Iv::W, Iv::W, Iv::H, Iv::W}, // DORIAN
 		{Iv::H, Iv::W, Iv::W, Iv::W, Iv::H, Iv::W, Iv::W}, // PHRYGIAN
@@ -330,7 +358,7 @@ private:
 	/*
 	 * MINOR Scale modes  7 notes
 	 */
-	const std::vector<std::array<enum Iv, 7>> minorScaleVect  = { {
+	static constexpr std::array<std::array<enum Iv, 7>, 7> minorScaleVect = { {
 		{Iv::W, Iv::H, Iv::W, Iv::W, Iv::H, Iv::W, Iv::W}, 	// AEOLIAN
 		{Iv::H, Iv::W, Iv::W, Iv::H, Iv::W, Iv::W, Iv::W}, 	// LOCRIAN
 		{Iv::W, Iv::W, Iv::H, Iv::W, Iv::W, Iv::W, Iv::H}, 	// IONIAN
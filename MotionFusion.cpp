@@ -0,0 +1,176 @@
+/** @file MotionFusion.cpp
+ *
+ * Fixed point orientation from accelerometer and magnetometer.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MotionFusion.hpp"
+
+
+MotionFusion::MotionFusion(uint8_t shiftArg) noexcept {
+	shift = shiftArg;
+	primed = false;
+	for (int i = 0; i < 3; i++) {
+		gravity[i] = 0;
+		field[i] = 0;
+	}
+	orientation = Orientation();
+}
+
+
+/*
+ * atan(2^-i) in binary angle units.
+ */
+static const uint16_t atanTable[] = {
+	8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1, 1
+};
+// 1/K of the CORDIC in Q16.
+static const uint32_t cordicGain = 39797;
+
+
+/*
+ * CORDIC in vectoring mode, the vector is rotated onto the x axis and
+ * the rotations add up to its angle.  |x| and |y| must stay below
+ * 2^28 for the growth of the vector.
+ */
+int16_t MotionFusion::Atan2(int32_t y, int32_t x, uint32_t *magnitude) {
+	int32_t angle = 0;
+
+	if (x < 0) {
+		x = -x;
+		y = -y;
+		angle = 32768;
+	}
+	for (int i = 0; i < (int)(sizeof(atanTable) / sizeof(atanTable[0])); i++) {
+		int32_t dx = x >> i;
+		int32_t dy = y >> i;
+		if (y > 0) {
+			x += dy;
+			y -= dx;
+			angle += atanTable[i];
+		}
+		else {
+			x -= dy;
+			y += dx;
+			angle -= atanTable[i];
+		}
+	}
+	if (magnitude) {
+		*magnitude = (uint32_t)(((uint64_t)x * cordicGain) >> 16);
+	}
+	return (int16_t)angle;
+}
+
+
+static int64_t Abs(int64_t v) {
+	return v < 0 ? -v : v;
+}
+
+
+const MotionFusion::Orientation &MotionFusion::Update(const int16_t *accel,
+													   const int16_t *magnet) {
+	for (int i = 0; i < 3; i++) {
+		int32_t a = (int32_t)accel[i] << fraction;
+		int32_t m = (int32_t)magnet[i] << fraction;
+		if (primed) {
+			gravity[i] += (a - gravity[i]) >> shift;
+			field[i] += (m - field[i]) >> shift;
+		}
+		else {
+			gravity[i] = a;
+			field[i] = m;
+		}
+	}
+	primed = true;
+
+	// Tilt, as in NXP AN4248: roll around x, then pitch.
+	uint32_t yz;
+	uint32_t g;
+	orientation.roll = Atan2(gravity[1], gravity[2], &yz);
+	orientation.pitch = Atan2(-gravity[0], (int32_t)yz, &g);
+
+	// Heading: the field rotated back into the horizontal plane,
+	// atan2(Bz sin(roll) - By cos(roll),
+	//       Bx cos(pitch) + (By sin(roll) + Bz cos(roll)) sin(pitch))
+	// with sin and cos taken from the gravity vector and both sides
+	// multiplied by |g| * |yz| so that no division is needed.
+	const int drop = fraction - 4;	// Q4 keeps the products in 64 bit.
+	int64_t ax = gravity[0] >> drop;
+	int64_t ay = gravity[1] >> drop;
+	int64_t az = gravity[2] >> drop;
+	int64_t mx = field[0] >> drop;
+	int64_t my = field[1] >> drop;
+	int64_t mz = field[2] >> drop;
+	int64_t r = (int64_t)(yz >> drop);
+	int64_t num = (mz * ay - my * az) * (int64_t)(g >> drop);
+	int64_t den = mx * r * r - ax * (my * ay + mz * az);
+
+	// Scale both down into the range of the CORDIC.
+	uint64_t largest = (uint64_t)(Abs(num) | Abs(den));
+	int bits = largest ? 64 - __builtin_clzll(largest) : 0;
+	int scale = bits > 28 ? bits - 28 : 0;
+	orientation.heading = (uint16_t)Atan2((int32_t)(num >> scale),
+										  (int32_t)(den >> scale));
+	return orientation;
+}
+
+
+MotionCurve::MotionCurve(int16_t fromArg, int16_t toArg, Curve curveArg) noexcept {
+	from = fromArg;
+	to = toArg;
+	curve = curveArg;
+}
+
+
+uint16_t MotionCurve::Map(int16_t angle) const {
+	// The angles wrap, so the span is taken the short way round
+	// (across north works for the heading) and a half turn is +-32768,
+	// its sign says which way.  The angle is taken within half a turn
+	// of the middle of the range, beyond the ends it clamps to the
+	// nearest one.
+	int32_t span = (int32_t)to - from;
+	if (span > 32768) {
+		span -= 65536;
+	}
+	if (span < -32768) {
+		span += 65536;
+	}
+	int32_t middle = from + span / 2;
+	int32_t offset = ((int32_t)angle - middle) & 0xFFFF;
+	if (offset >= 32768) {
+		offset -= 65536;
+	}
+	offset += span / 2;
+
+	if (span == 0) {
+		return 0;
+	}
+	int32_t x = offset * 16384 / span;		// Q14
+	if (x < 0) {
+		x = 0;
+	}
+	if (x > 16384) {
+		x = 16384;
+	}
+	// Each rounded once, so the curves never go back a step.
+	switch (curve) {
+		case SOFT:
+			x = (x * x) >> 14;
+			break;
+		case HARD:
+			x = (x * (2 * 16384 - x)) >> 14;
+			break;
+		case S_CURVE:
+			x = (int32_t)(((int64_t)x * x * (3 * 16384 - 2 * x)) >> 28);
+			break;
+		case LINEAR:
+		default:
+			break;
+	}
+	return x > maxValue ? maxValue : (uint16_t)x;
+}
+
+
+/* EOF */
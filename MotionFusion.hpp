@@ -0,0 +1,91 @@
+/** @file MotionFusion.hpp
+ *
+ * Orientation from an accelerometer and a magnetometer in fixed point:
+ * pitch and roll from gravity and a tilt compensated heading from the
+ * magnetic field.  Both vectors are low pass filtered before the
+ * angles are taken so there is no wrap around to deal with, the
+ * angles come out of an integer CORDIC atan2.  There is no floating
+ * point anywhere, at 200 Hz it is a few us per sample on the M4.
+ *
+ * Angles are binary angles: 65536 is a full circle, so an int16_t
+ * wraps around exactly like the angle does.
+ *
+ * MotionCurve maps an angle range onto a 14 bit value (pitch bend,
+ * or a CC as the upper 7 bits) through a response curve.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MotionFusion_hpp
+#define MotionFusion_hpp
+
+#include <cstdint>
+
+
+class MotionFusion {
+public:
+	struct Orientation {
+		int16_t pitch;		// Nose up positive, +-90 degrees.
+		int16_t roll;		// Right side down positive, +-180 degrees.
+		uint16_t heading;	// 0 is magnetic north, clockwise.
+	};
+
+	/** Filter time constant as a shift: every sample moves the
+	 * filtered vectors 1/2^shift of the way, 3 is ~40 ms at 200 Hz.
+	 */
+	MotionFusion(uint8_t shiftArg = 3) noexcept;
+
+	/** One sample of both sensors (any scale, the same every time),
+	 * returns the new orientation.
+	 */
+	const Orientation &Update(const int16_t *accel, const int16_t *magnet);
+	const Orientation &Get() const {
+		return orientation;
+	};
+	/** The next sample is taken as is, without filtering.
+	 */
+	void Reset() {
+		primed = false;
+	};
+
+	/** Angle of (x, y) in binary units, optionally its length.
+	 */
+	static int16_t Atan2(int32_t y, int32_t x, uint32_t *magnitude = nullptr);
+	static const int16_t degrees90 = 16384;
+
+private:
+	static const uint8_t fraction = 8;	// Filtered vectors are Q8.
+
+	uint8_t shift;
+	bool primed;
+	int32_t gravity[3];
+	int32_t field[3];
+	Orientation orientation;
+};
+
+
+class MotionCurve {
+public:
+	enum Curve: uint8_t {
+		LINEAR,
+		SOFT,		// Slow start, x^2
+		HARD,		// Fast start, 2x - x^2
+		S_CURVE		// Smoothstep, 3x^2 - 2x^3
+	};
+	static const uint16_t maxValue = 16383;
+
+	/** Angles from 'from' to 'to' map onto 0..16383, 'to' can be below
+	 * 'from' to invert.  Outside the range the value is clamped.
+	 */
+	MotionCurve(int16_t fromArg, int16_t toArg, Curve curveArg = LINEAR) noexcept;
+
+	uint16_t Map(int16_t angle) const;
+
+	int16_t from;
+	int16_t to;
+	Curve curve;
+};
+
+
+#endif /* MotionFusion_hpp */
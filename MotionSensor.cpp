@@ -0,0 +1,158 @@
+/** @file MotionSensor.cpp
+ *
+ * FXOS8700CQ accelerometer and magnetometer, interrupt driven.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MotionSensor.hpp"
+
+
+/*
+ * Registers
+ */
+enum Fxos8700Register: uint8_t {
+	STATUS = 0x00,			// Followed by OUT_X_MSB .. OUT_Z_LSB
+	WHO_AM_I = 0x0D,
+	XYZ_DATA_CFG = 0x0E,
+	CTRL_REG1 = 0x2A,
+	CTRL_REG2 = 0x2B,
+	CTRL_REG3 = 0x2C,
+	CTRL_REG4 = 0x2D,
+	CTRL_REG5 = 0x2E,
+	M_CTRL_REG1 = 0x5B,
+	M_CTRL_REG2 = 0x5C
+};
+
+static const uint8_t whoAmI = 0xC7;
+static const uint8_t flagDataReady = 1;
+static const uint8_t statusDataReady = 0x08;	// ZYXDR
+
+// STATUS, 3 x accelerometer and with hyb_autoinc_mode the burst
+// continues with the 3 x magnetometer registers.
+static const int burstLength = 13;
+
+
+MotionSensor::MotionSensor(PinName sda, PinName scl, PinName int1Pin,
+						   uint8_t addressArg) noexcept
+: i2c(sda, scl), int1(int1Pin), thread(osPriorityAboveNormal, 1536)
+{
+	address = addressArg;
+	irqTime = 0;
+	timeout = 20ms;
+	stats = Statistics();
+	i2c.frequency(400000);
+}
+
+
+bool MotionSensor::WriteRegister(uint8_t reg, uint8_t value) {
+	const char buf[2] = { (char)reg, (char)value };
+	if (i2c.write(address, buf, 2) != 0) {
+		stats.busErrors++;
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Register address write with a repeated start, then one read of
+ * 'len' bytes, the part increments the register address itself.
+ */
+bool MotionSensor::ReadRegisters(uint8_t reg, uint8_t *buf, int len) {
+	const char r = (char)reg;
+	if (i2c.write(address, &r, 1, true) != 0 ||
+		i2c.read(address, (char *)buf, len) != 0) {
+		stats.busErrors++;
+		return false;
+	}
+	return true;
+}
+
+
+bool MotionSensor::Start(Rate rate) {
+	uint8_t id = 0;
+
+	if (!ReadRegisters(WHO_AM_I, &id, 1) || id != whoAmI) {
+		return false;
+	}
+	// Standby while configuring.
+	WriteRegister(CTRL_REG1, 0x00);
+	// Hybrid mode, oversampling ratio 16 for the magnetometer.
+	WriteRegister(M_CTRL_REG1, 0x1F);
+	// hyb_autoinc_mode: the burst from STATUS runs on into the
+	// magnetometer data.
+	WriteRegister(M_CTRL_REG2, 0x20);
+	// +-2 g
+	WriteRegister(XYZ_DATA_CFG, 0x00);
+	// High resolution oversampling.
+	WriteRegister(CTRL_REG2, 0x02);
+	// Push-pull, active low.
+	WriteRegister(CTRL_REG3, 0x00);
+	// Data ready interrupt on INT1.
+	WriteRegister(CTRL_REG4, 0x01);
+	WriteRegister(CTRL_REG5, 0x01);
+	// Data rate, low noise, active.
+	if (!WriteRegister(CTRL_REG1, (uint8_t)(rate << 3) | 0x04 | 0x01)) {
+		return false;
+	}
+
+	// Hybrid mode: 400 Hz for DR 0, halving with every step.
+	timeout = Kernel::Clock::duration_u32(2 * 1000 / (400 >> rate) + 1);
+	clock.start();
+	int1.fall(callback(this, &MotionSensor::DataReady));
+	thread.start(callback(this, &MotionSensor::Run));
+	return true;
+}
+
+
+/*
+ * Interrupt: only note the time and wake up the thread.
+ */
+void MotionSensor::DataReady() {
+	irqTime = duration_cast<microseconds>(clock.elapsed_time()).count();
+	flags.set(flagDataReady);
+}
+
+
+void MotionSensor::Run() {
+	uint8_t buf[burstLength];
+
+	while (true) {
+		uint32_t result = flags.wait_any_for(flagDataReady, timeout);
+		bool timedOut = result & osFlagsError;
+		uint32_t time = irqTime;
+		if (timedOut) {
+			time = duration_cast<microseconds>(clock.elapsed_time()).count();
+		}
+		if (!ReadRegisters(STATUS, buf, burstLength)) {
+			continue;
+		}
+		if ((buf[0] & statusDataReady) == 0) {
+			// Timeout without a new sample, the part is not running.
+			continue;
+		}
+		if (timedOut) {
+			// The edge was missed or never came, INT1 only goes
+			// high again once the data has been read.
+			stats.missed++;
+		}
+		MotionSample *sample = mail.try_alloc();
+		if (sample == nullptr) {
+			stats.dropped++;
+			continue;
+		}
+		sample->time = time;
+		for (int i = 0; i < 3; i++) {
+			// Accelerometer is 14 bit left aligned.
+			sample->accel[i] = (int16_t)(buf[1 + 2 * i] << 8 | buf[2 + 2 * i]) >> 2;
+			sample->magnet[i] = (int16_t)(buf[7 + 2 * i] << 8 | buf[8 + 2 * i]);
+		}
+		mail.put(sample);
+		stats.samples++;
+	}
+}
+
+
+/* EOF */
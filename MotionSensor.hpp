@@ -0,0 +1,93 @@
+/** @file MotionSensor.hpp
+ *
+ * FXOS8700CQ accelerometer and magnetometer on the FRDM-K64F, driven
+ * from its data ready interrupt.  A thread of its own waits for INT1,
+ * reads the status, accelerometer and magnetometer registers in one
+ * 13 byte I2C burst and puts the timestamped sample in a Mail queue
+ * for whoever turns them into MIDI.
+ *
+ * The FIFO of the part only holds accelerometer samples in hybrid
+ * (accelerometer + magnetometer) mode, so every sample is read on its
+ * own data ready interrupt instead.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MotionSensor_hpp
+#define MotionSensor_hpp
+
+#include "mbed.h"
+#include <cstdint>
+
+
+struct MotionSample {
+	uint32_t time;		// us, when the data ready interrupt came (wraps).
+	int16_t accel[3];	// 14 bit, 0.244 mg per LSB at +-2 g.
+	int16_t magnet[3];	// 0.1 uT per LSB.
+};
+
+
+class MotionSensor {
+public:
+	/** I2C address on the FRDM-K64F (SA0 and SA1 high).
+	 */
+	static const uint8_t defaultAddress = 0x1D << 1;
+	static const unsigned int queueLength = 16;
+
+	/** Output data rate of the accelerometer and magnetometer each,
+	 * the value is the DR field of CTRL_REG1 in hybrid mode.
+	 */
+	enum Rate: uint8_t {
+		HZ_400 = 0,
+		HZ_200 = 1,
+		HZ_100 = 2,
+		HZ_50 = 3,
+		HZ_25 = 4
+	};
+
+	struct Statistics {
+		uint32_t samples;
+		uint32_t dropped;		// Queue full.
+		uint32_t missed;		// No interrupt, read on the timeout.
+		uint32_t busErrors;
+	};
+
+	/** INT1 of the FXOS8700CQ is PTC6 on the FRDM-K64F.
+	 */
+	MotionSensor(PinName sda, PinName scl, PinName int1Pin,
+				 uint8_t addressArg = defaultAddress) noexcept;
+
+	/** Check the part, configure it and start the thread.  Returns
+	 * false when there is no FXOS8700CQ on the bus.
+	 */
+	bool Start(Rate rate);
+
+	/** Samples for the consumer, free() every one that is taken.
+	 */
+	Mail<MotionSample, queueLength> mail;
+
+	const Statistics &Stats() const {
+		return stats;
+	};
+
+private:
+	void Run();
+	void DataReady();
+	bool WriteRegister(uint8_t reg, uint8_t value);
+	bool ReadRegisters(uint8_t reg, uint8_t *buf, int len);
+
+	I2C i2c;
+	InterruptIn int1;
+	Thread thread;
+	EventFlags flags;
+	Timer clock;
+	uint8_t address;
+	// Written in the interrupt, 32 bit so the thread reads it whole.
+	volatile uint32_t irqTime;
+	Kernel::Clock::duration_u32 timeout;	// Two sample periods.
+	Statistics stats;
+};
+
+
+#endif /* MotionSensor_hpp */
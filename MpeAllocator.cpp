@@ -0,0 +1,119 @@
+/** @file MpeAllocator.cpp
+ *
+ * Channel allocation for MPE output.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "MpeAllocator.hpp"
+
+
+MpeAllocator::MpeAllocator(uint8_t numOfMembersArg) noexcept {
+	numOfMembers = numOfMembersArg;
+	if (numOfMembers < 1) {
+		numOfMembers = 1;
+	}
+	if (numOfMembers > maxMembers) {
+		numOfMembers = maxMembers;
+	}
+	Reset();
+}
+
+
+void MpeAllocator::Reset() {
+	next[freeList] = prev[freeList] = freeList;
+	next[busyList] = prev[busyList] = busyList;
+	for (uint8_t node = 0; node < numOfMembers; node++) {
+		noteOfNode[node] = none;
+		Append(freeList, node);
+	}
+	for (unsigned int note = 0; note < 128; note++) {
+		channelOfNote[note] = none;
+	}
+	stats = Statistics();
+}
+
+
+void MpeAllocator::Unlink(uint8_t node) {
+	next[prev[node]] = next[node];
+	prev[next[node]] = prev[node];
+}
+
+
+void MpeAllocator::Append(uint8_t list, uint8_t node) {
+	prev[node] = prev[list];
+	next[node] = list;
+	next[prev[list]] = node;
+	prev[list] = node;
+}
+
+
+uint8_t MpeAllocator::NoteOn(uint8_t note, uint8_t &stolen) {
+	uint8_t node;
+
+	stolen = none;
+	if (note >= 128) {
+		return none;
+	}
+	if (channelOfNote[note] != none) {
+		// Same note again: it takes over its own channel.
+		node = channelOfNote[note] - 1;
+		stolen = note;
+		Unlink(node);
+	}
+	else if (next[freeList] != freeList) {
+		// The channel that has been free the longest, so the release
+		// of its last note has had the most time to ring out.
+		node = next[freeList];
+		Unlink(node);
+	}
+	else {
+		// None free: steal the channel of the oldest note.
+		node = next[busyList];
+		Unlink(node);
+		stolen = noteOfNode[node];
+		channelOfNote[stolen] = none;
+		stats.steals++;
+	}
+	Append(busyList, node);
+	noteOfNode[node] = note;
+	channelOfNote[note] = node + 1;
+	stats.allocations++;
+	return node + 1;
+}
+
+
+uint8_t MpeAllocator::NoteOff(uint8_t note) {
+	uint8_t channel = Channel(note);
+
+	if (channel == none) {
+		return none;
+	}
+	uint8_t node = channel - 1;
+	Unlink(node);
+	Append(freeList, node);
+	noteOfNode[node] = none;
+	channelOfNote[note] = none;
+	return channel;
+}
+
+
+unsigned int MpeAllocator::ActiveChannels(uint8_t *channels) const {
+	unsigned int n = 0;
+	for (uint8_t node = next[busyList]; node != busyList; node = next[node]) {
+		channels[n++] = node + 1;
+	}
+	return n;
+}
+
+
+void MpeAllocator::ConfigurationMessage(UmpEvent msg[3]) const {
+	const uint8_t status = 0xB0 | masterChannel;
+	msg[0] = UmpEvent::Midi1(status, 101, 0);				// RPN MSB
+	msg[1] = UmpEvent::Midi1(status, 100, 6);				// RPN LSB: MPE configuration
+	msg[2] = UmpEvent::Midi1(status, 6, numOfMembers);		// Data entry: member channels
+}
+
+
+/* EOF */
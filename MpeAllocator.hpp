@@ -0,0 +1,92 @@
+/** @file MpeAllocator.hpp
+ *
+ * Channel allocation for MPE (MIDI Polyphonic Expression) output in
+ * the lower zone: channel 1 is the master channel and every note gets
+ * a member channel (2..16) of its own, so pitch bend, pressure and
+ * CC74 can be sent per note.
+ *
+ * A new note gets the member channel that has been free the longest,
+ * so the release of the previous note on it can ring out.  When all
+ * of them are in use the oldest note is stolen.  Free and busy
+ * channels are kept in two linked lists so every call is O(1).
+ *
+ * Channels are 0 based as in the status byte (0 = MIDI channel 1).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MpeAllocator_hpp
+#define MpeAllocator_hpp
+
+#include <cstdint>
+#include "Ump.hpp"
+
+
+class MpeAllocator {
+public:
+	static const unsigned int maxMembers = 15;
+	static const uint8_t masterChannel = 0;
+	static const uint8_t none = 0xFF;
+
+	struct Statistics {
+		uint32_t allocations;
+		uint32_t steals;
+	};
+
+	MpeAllocator(uint8_t numOfMembersArg = maxMembers) noexcept;
+
+	/** Channel for a new note.  When a note had to make room for it
+	 * 'stolen' is that note (on the same channel) and it has to be
+	 * turned off first, otherwise it is none.
+	 */
+	uint8_t NoteOn(uint8_t note, uint8_t &stolen);
+
+	/** Channel the note was playing on (none when it was not), the
+	 * channel is free afterwards.
+	 */
+	uint8_t NoteOff(uint8_t note);
+
+	uint8_t Channel(uint8_t note) const {
+		return note < 128 ? channelOfNote[note] : none;
+	};
+
+	/** Channels of the sounding notes, oldest first, returns how many.
+	 */
+	unsigned int ActiveChannels(uint8_t *channels) const;
+
+	/** Everything off, e.g. after all notes off was sent.
+	 */
+	void Reset();
+
+	/** The MPE Configuration Message (RPN 6 on the master channel)
+	 * for this zone, 3 control changes.
+	 */
+	void ConfigurationMessage(UmpEvent msg[3]) const;
+
+	uint8_t NumOfMembers() const {
+		return numOfMembers;
+	};
+	const Statistics &Stats() const {
+		return stats;
+	};
+
+private:
+	// Nodes 0..maxMembers-1 are member channels 1..maxMembers, the two
+	// after those are the heads of the free and busy lists.
+	static const uint8_t freeList = maxMembers;
+	static const uint8_t busyList = maxMembers + 1;
+
+	void Unlink(uint8_t node);
+	void Append(uint8_t list, uint8_t node);
+
+	uint8_t numOfMembers;
+	uint8_t next[maxMembers + 2];
+	uint8_t prev[maxMembers + 2];
+	uint8_t noteOfNode[maxMembers];
+	uint8_t channelOfNote[128];
+	Statistics stats;
+};
+
+
+#endif /* MpeAllocator_hpp */
@@ -20,7 +20,7 @@
  * e.g. F#, G# Gb A
  * C3 C-2 Ab5 etc...
  */
-const uint8_t Note::ToNote(std::string str) {
+uint8_t Note::ToNote(std::string str) {
 	uint8_t basenote = 60;  // If no basenote is given use 60 (middle C3)
 	
 	// TODO: find the last numeral in the string add 2
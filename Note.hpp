@@ -59,7 +59,7 @@ public:
 									bool showoctave);
 	/** Convert string to MIDI note number
 	 */
-	static const uint8_t ToNote(std::string str);
+	static uint8_t ToNote(std::string str);
 private:
 };
 
@@ -0,0 +1,168 @@
+/** @file NoteSet.hpp
+ *
+ * Harmony implements Notes, Scales, Modes, Chords
+ * the intent is to keep this library as clean
+ * as possible to allow implementation on hardware
+ * platforms such as ARM MBED OS.
+ *
+ * Compact sets of notes as bits so questions like "does this chord
+ * fit in this mode" or "transpose by N" are a couple of word
+ * operations instead of loops over std::vector<Note>.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef NoteSet_hpp
+#define NoteSet_hpp
+
+#include <cstdint>
+
+
+/** Set of pitch classes (C = bit 0 ... B = bit 11)
+ */
+class PitchClassSet {
+public:
+	constexpr PitchClassSet() noexcept : bits(0) {};
+	constexpr explicit PitchClassSet(uint16_t bitsArg) noexcept
+	: bits(bitsArg & mask) {};
+	
+	static const uint16_t mask = 0x0FFF;
+	uint16_t bits;
+	
+	void Add(uint8_t note) {
+		bits |= 1 << (note % 12);
+	};
+	bool Contains(uint8_t note) const {
+		return bits & (1 << (note % 12));
+	};
+	/** True when every pitch class of 'other' is in this set.
+	 */
+	bool Contains(PitchClassSet other) const {
+		return (other.bits & ~bits) == 0;
+	};
+	bool Empty() const {
+		return bits == 0;
+	};
+	unsigned int Count() const {
+		return __builtin_popcount(bits);
+	};
+	/** Transposing pitch classes is a rotate within 12 bits.
+	 */
+	PitchClassSet Transpose(int semitones) const {
+		unsigned int n = ((semitones % 12) + 12) % 12;
+		return PitchClassSet((uint16_t)((bits << n) | (bits >> (12 - n))));
+	};
+	PitchClassSet operator|(PitchClassSet other) const {
+		return PitchClassSet(bits | other.bits);
+	};
+	PitchClassSet operator&(PitchClassSet other) const {
+		return PitchClassSet(bits & other.bits);
+	};
+	bool operator==(PitchClassSet other) const {
+		return bits == other.bits;
+	};
+};
+
+
+/** Set of absolute MIDI notes 0..127 in four 32 bit words
+ */
+class NoteSet {
+public:
+	NoteSet() noexcept : words{0, 0, 0, 0} {};
+	
+	static const unsigned int numOfWords = 4;
+	uint32_t words[numOfWords];
+	
+	void Add(uint8_t note) {
+		words[(note >> 5) & 3] |= 1ul << (note & 31);
+	};
+	void Remove(uint8_t note) {
+		words[(note >> 5) & 3] &= ~(1ul << (note & 31));
+	};
+	bool Contains(uint8_t note) const {
+		return words[(note >> 5) & 3] & (1ul << (note & 31));
+	};
+	/** True when every note of 'other' is in this set.
+	 */
+	bool Contains(const NoteSet &other) const {
+		return ((other.words[0] & ~words[0]) |
+				(other.words[1] & ~words[1]) |
+				(other.words[2] & ~words[2]) |
+				(other.words[3] & ~words[3])) == 0;
+	};
+	bool Empty() const {
+		return (words[0] | words[1] | words[2] | words[3]) == 0;
+	};
+	unsigned int Count() const {
+		return __builtin_popcount(words[0]) + __builtin_popcount(words[1]) +
+			__builtin_popcount(words[2]) + __builtin_popcount(words[3]);
+	};
+	NoteSet operator|(const NoteSet &other) const {
+		NoteSet result;
+		for (unsigned int i = 0; i < numOfWords; i++) {
+			result.words[i] = words[i] | other.words[i];
+		}
+		return result;
+	};
+	NoteSet operator&(const NoteSet &other) const {
+		NoteSet result;
+		for (unsigned int i = 0; i < numOfWords; i++) {
+			result.words[i] = words[i] & other.words[i];
+		}
+		return result;
+	};
+	bool operator==(const NoteSet &other) const {
+		return words[0] == other.words[0] && words[1] == other.words[1] &&
+			words[2] == other.words[2] && words[3] == other.words[3];
+	};
+	
+	/** Transposing is a shift of the 128 bits, notes that end up
+	 * outside 0..127 are dropped.
+	 */
+	NoteSet Transpose(int semitones) const {
+		NoteSet result;
+		if (semitones <= -128 || semitones >= 128) {
+			return result;
+		}
+		if (semitones >= 0) {
+			unsigned int w = semitones >> 5;
+			unsigned int b = semitones & 31;
+			for (unsigned int i = numOfWords; i-- > w; ) {
+				uint32_t lo = (i - w >= 1 && b) ?
+					words[i - w - 1] >> (32 - b) : 0;
+				result.words[i] = (words[i - w] << b) | lo;
+			}
+		}
+		else {
+			unsigned int w = (-semitones) >> 5;
+			unsigned int b = (-semitones) & 31;
+			for (unsigned int i = 0; i + w < numOfWords; i++) {
+				uint32_t hi = (i + w + 1 < numOfWords && b) ?
+					words[i + w + 1] << (32 - b) : 0;
+				result.words[i] = (words[i + w] >> b) | hi;
+			}
+		}
+		return result;
+	};
+	
+	/** Fold all octaves on top of each other.
+	 */
+	PitchClassSet PitchClasses() const {
+		PitchClassSet result;
+		for (unsigned int note = 0; note < 128; note += 12) {
+			// 12 bits starting at 'note', can straddle two words.
+			unsigned int w = note >> 5;
+			unsigned int b = note & 31;
+			uint32_t bits = words[w] >> b;
+			if (b > 20 && w + 1 < numOfWords) {
+				bits |= words[w + 1] << (32 - b);
+			}
+			result.bits |= bits & PitchClassSet::mask;
+		}
+		return result;
+	};
+};
+
+
+#endif /* NoteSet_hpp */
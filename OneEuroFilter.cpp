@@ -0,0 +1,87 @@
+/** @file OneEuroFilter.cpp
+ *
+ * Adaptive low pass filter for continuous controllers in fixed point.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "OneEuroFilter.hpp"
+
+
+OneEuroFilter::OneEuroFilter(const Parameters &parametersArg) noexcept {
+	parameters = parametersArg;
+	primed = false;
+	value = 0;
+	speed = 0;
+	cutoff = parameters.minCutoff;
+	previousValue = 0;
+	previousSpeed = 0;
+	previousDt = 0;
+}
+
+
+/*
+ * alpha = r / (1 + r) with r = 2 pi fc dt, fc in mHz and dt in us.
+ * Scale() is r per mHz in Q32 (2 pi 65536 / 10^9 is 1768561 / 2^32
+ * in Q16), so r in Q16 is one multiply and alpha = 1 - 1 / (1 + r)
+ * one 32 bit division: 2^32 / d is (2^32 - d) / d + 1.
+ */
+uint32_t OneEuroFilter::Alpha(uint32_t cutoff, uint32_t scale) {
+	uint64_t r = (uint64_t)cutoff * scale >> 16;
+	if (r > 0xFFFFFFFF - 65536) {
+		r = 0xFFFFFFFF - 65536;
+	}
+	uint32_t d = 65536 + (uint32_t)r;
+	return 65536 - ((0u - d) / d + 1);
+}
+
+
+int32_t OneEuroFilter::Filter(int32_t x, uint32_t dt) {
+	int64_t input = (int64_t)x << fraction;
+
+	if (!primed) {
+		value = input;
+		speed = 0;
+		previousDt = 0;
+		primed = true;
+		return Value();
+	}
+	if (dt == 0) {
+		// Same time as the previous sample, do its update again with
+		// this one instead.
+		if (previousDt == 0) {
+			value = input;
+			return Value();
+		}
+		value = previousValue;
+		speed = previousSpeed;
+		dt = previousDt;
+	}
+	previousValue = value;
+	previousSpeed = speed;
+	previousDt = dt;
+	if (dt > maxDt) {
+		dt = maxDt;
+	}
+	uint32_t scale = Scale(dt);
+
+	// Speed from the previous filtered value, smoothed by itself.
+	// 10^6 / dt in Q12 still fits in 32 bits.
+	int64_t rate = (input - value) * (4096000000u / dt) >> 12;
+	speed += (rate - speed) * Alpha(parameters.derivativeCutoff, scale) >> 16;
+
+	// The faster the input moves the higher the cutoff.
+	uint64_t absSpeed = (uint64_t)(speed < 0 ? -speed : speed) >> fraction;
+	if (absSpeed > 0x7FFFFFFF) {
+		absSpeed = 0x7FFFFFFF;
+	}
+	uint64_t fc = parameters.minCutoff + ((absSpeed * parameters.beta) >> 16);
+	cutoff = fc > maxCutoff ? maxCutoff : (uint32_t)fc;
+
+	value += (input - value) * Alpha(cutoff, scale) >> 16;
+	return Value();
+}
+
+
+/* EOF */
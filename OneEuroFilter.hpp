@@ -0,0 +1,86 @@
+/** @file OneEuroFilter.hpp
+ *
+ * Adaptive low pass filter for continuous controllers in fixed point,
+ * after Casiez, Roussel and Vogel, "1 Euro Filter" (CHI 2012).  The
+ * cutoff frequency goes up with the speed of the input: a controller
+ * at rest is smoothed heavily (no jitter), a controller that is moved
+ * quickly is followed closely (no lag).
+ *
+ * One filter per controller, a filter is a few words of state and an
+ * update is three 32 bit divisions (UDIV on the M4, no library call)
+ * and a handful of multiplies.  Parameters can be changed at any time.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef OneEuroFilter_hpp
+#define OneEuroFilter_hpp
+
+#include <cstdint>
+
+
+class OneEuroFilter {
+public:
+	/** Values are in counts of whatever is filtered (e.g. 0..65535
+	 * for an ADC, 0..16383 for pitch bend).
+	 */
+	struct Parameters {
+		uint32_t minCutoff;			// mHz, the cutoff at rest.
+		uint32_t beta;				// mHz per count/s in Q16.
+		uint32_t derivativeCutoff;	// mHz, smoothing of the speed.
+	};
+
+	OneEuroFilter(const Parameters &parametersArg) noexcept;
+
+	/** Filter one sample taken dt us after the previous one.  With dt
+	 * 0 it was taken at the same time and replaces the previous one.
+	 */
+	int32_t Filter(int32_t x, uint32_t dt);
+
+	/** The next sample is taken as is.
+	 */
+	void Reset() {
+		primed = false;
+	};
+	void SetParameters(const Parameters &parametersArg) {
+		parameters = parametersArg;
+	};
+	const Parameters &GetParameters() const {
+		return parameters;
+	};
+	int32_t Value() const {
+		return (int32_t)((value + (1 << (fraction - 1))) >> fraction);
+	};
+	/** Current cutoff in mHz.
+	 */
+	uint32_t Cutoff() const {
+		return cutoff;
+	};
+
+private:
+	static const int fraction = 8;		// The filtered value is Q8.
+	static const uint32_t maxCutoff = 1000000;	// 1 kHz
+	static const uint32_t maxDt = 1 << 24;		// us, longer is the same.
+
+	/** Smoothing factor of a first order low pass with the given
+	 * cutoff in Q16, 'scale' is Scale() of the sample interval.
+	 */
+	static uint32_t Alpha(uint32_t cutoff, uint32_t scale);
+	static uint32_t Scale(uint32_t dt) {
+		return (uint32_t)((uint64_t)dt * 1768561 >> 16);
+	};
+
+	Parameters parameters;
+	bool primed;
+	int64_t value;
+	int64_t speed;		// Filtered, in counts/s Q8.
+	uint32_t cutoff;
+	// Before the last update, for a sample at the same time.
+	int64_t previousValue;
+	int64_t previousSpeed;
+	uint32_t previousDt;
+};
+
+
+#endif /* OneEuroFilter_hpp */
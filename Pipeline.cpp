@@ -0,0 +1,29 @@
+/** @file Pipeline.cpp
+ *
+ * Measurements for the stages of the MIDI pipeline.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include "Pipeline.hpp"
+
+
+void StageStats::Print() {
+	uint32_t count = latencyCount;
+	printf("%-9s %8lu events %4lu dropped depth %2lu max %2lu "
+		   "late avg %5lu max %6lu us\n",
+		   name, (unsigned long)(count ? count : posted.load()),
+		   (unsigned long)dropped.load(), (unsigned long)Depth(),
+		   (unsigned long)maxDepth,
+		   (unsigned long)(count ? latencySum / count : 0),
+		   (unsigned long)latencyMax);
+	maxDepth = Depth();
+	latencyMax = 0;
+	latencySum = 0;
+	latencyCount = 0;
+}
+
+
+/* EOF */
@@ -0,0 +1,99 @@
+/** @file Pipeline.hpp
+ *
+ * Events and measurements for the stages of the MIDI pipeline:
+ * RX -> transform -> TX, with realtime messages going to the clock.
+ * Stages hand each other PipelineEvents through queues, every stage
+ * keeps a StageStats with the depth of its queue and how late it got
+ * to its work (latency for queued events, wake-up jitter for periodic
+ * stages).
+ *
+ * Nothing in here depends on the RTOS: the queues and threads are the
+ * firmware's business, so the same stages can run in a simulation.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef Pipeline_hpp
+#define Pipeline_hpp
+
+#include <atomic>
+#include <cstdint>
+#include "Ump.hpp"
+
+
+/** An event on its way through the pipeline.
+ */
+struct PipelineEvent {
+	UmpEvent event;
+	uint32_t stamp;		// us, when it entered the pipeline.
+};
+
+
+/**
+ * Counters of one stage.  The producer side calls Posted() or
+ * Dropped(), the consumer Taken() or Woke().  The queue counters are
+ * atomic as a stage can have more than one producer (e.g. a thread
+ * and an interrupt).
+ */
+class StageStats {
+public:
+	StageStats(const char *nameArg) noexcept
+		: name(nameArg), posted(0), taken(0), dropped(0), maxDepth(0),
+		  latencyMax(0), latencySum(0), latencyCount(0) {};
+
+	/** An event was queued for this stage.
+	 */
+	void Posted() {
+		uint32_t depth = ++posted - taken;
+		if (depth > maxDepth) {
+			maxDepth = depth;
+		}
+	};
+	/** The queue was full.
+	 */
+	void Dropped() {
+		dropped++;
+	};
+	/** An event was taken off the queue 'latency' us after it was
+	 * posted.
+	 */
+	void Taken(uint32_t latency) {
+		taken++;
+		Latency(latency);
+	};
+	/** A periodic stage woke up 'late' us after it was due.
+	 */
+	void Woke(int32_t late) {
+		Latency(late > 0 ? (uint32_t)late : 0);
+	};
+
+	uint32_t Depth() const {
+		return posted - taken;
+	};
+
+	/** One line on the console, the peaks start over afterwards.
+	 */
+	void Print();
+
+private:
+	void Latency(uint32_t us) {
+		if (us > latencyMax) {
+			latencyMax = us;
+		}
+		latencySum += us;
+		latencyCount++;
+	};
+
+	const char *name;
+	std::atomic<uint32_t> posted;
+	std::atomic<uint32_t> taken;
+	std::atomic<uint32_t> dropped;
+	uint32_t maxDepth;
+	uint32_t latencyMax;
+	uint32_t latencySum;
+	uint32_t latencyCount;
+};
+
+
+#endif /* Pipeline_hpp */
@@ -0,0 +1,66 @@
+/** @file Random.hpp
+ *
+ * Small and fast pseudo random numbers with an explicit seed:
+ * xorshift32 (Marsaglia, "Xorshift RNGs", 2003).  One word of state,
+ * three shifts and three exclusive ors a number, the same seed always
+ * gives the same numbers so generated music can be played again and
+ * tested.  Good enough for music and test streams, not for anything
+ * that has to be unpredictable.
+ *
+ * It is a UniformRandomBitGenerator, so std::shuffle() and the
+ * <random> distributions take it as well.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef Random_hpp
+#define Random_hpp
+
+#include <cstdint>
+
+
+class Random {
+public:
+	typedef uint32_t result_type;
+
+	/** Seed 0 would only ever give 0, it is taken as 1.
+	 */
+	explicit Random(uint32_t seed = 1) noexcept : state(seed ? seed : 1) {};
+
+	void Seed(uint32_t seed) {
+		state = seed ? seed : 1;
+	};
+	uint32_t Next() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+	/** 0 .. n - 1, n not 0.  The modulo bias is below n / 2^32.
+	 */
+	uint32_t Below(uint32_t n) {
+		return Next() % n;
+	};
+	/** True 'percent' times out of 100.
+	 */
+	bool Chance(uint32_t percent) {
+		return Below(100) < percent;
+	};
+
+	result_type operator()() {
+		return Next();
+	};
+	static constexpr result_type min() {
+		return 1;
+	};
+	static constexpr result_type max() {
+		return UINT32_MAX;
+	};
+
+private:
+	uint32_t state;
+};
+
+
+#endif /* Random_hpp */
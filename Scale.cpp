@@ -11,6 +11,11 @@
  * @copyright APACHE-2.0
  */
 #include "Scale.hpp"
+#include "HeapProbe.hpp"
+
+
+// Definition of the static constexpr member (required before C++17)
+constexpr Scale::TypeOfScale Scale::allScaleKinds[];
 
 
 /*
@@ -19,8 +24,10 @@
  * middle C (rootNote=60)
  */
 Scale::Scale() noexcept{
+	HEAP_PROBE_SCOPE(SCALE);
 	kindOfScale = Scale::KindOfScale::HEPTATONIC;
 	typeOfScale = Scale::TypeOfScale::MAJOR;
+	scaleText = "MAJOR";
 	numOfModes = 7; // 7 modes in this scale
 	numOfNotes = 7; // Heptatonic = 7 notes.
 	rootNote = 60;
@@ -42,6 +49,7 @@ Scale::Scale() noexcept{
  */
 Scale::Scale(TypeOfScale typeOfScaleArg,
 			 uint8_t rootNoteArg) noexcept{
+	HEAP_PROBE_SCOPE(SCALE);
 	// MIDI notes cannot be higher than 128
 	// instead of throwing an exception we just truncate it to the
 	// higest value.
@@ -55,133 +63,96 @@ Scale::Scale(TypeOfScale typeOfScaleArg,
 		case Scale::TypeOfScale::CHROMATIC:
 			scaleText = "CHROMATIC";
 			kindOfScale = Scale::KindOfScale::CHROMATIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 12;
 			break;
 			// ---==== 8 NOTE scale's ====----
 		case Scale::TypeOfScale::OCTATONIC:
 			scaleText ="OCTATONIC";
 			kindOfScale = Scale::KindOfScale::OCTATONIC;
-			numOfModes = 2; // only 2 modes in this scale
-			numOfNotes = 8;
 			break;
 		case Scale::TypeOfScale::DOMINANT_DIMINISHED:
 			scaleText ="DOMINANT_DIMINISHED";
 			kindOfScale = Scale::KindOfScale::OCTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 8;
 			break;
 		case Scale::TypeOfScale::DIMINISHED:
 			scaleText ="DIMINISHED";
 			kindOfScale = Scale::KindOfScale::OCTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 8;
 			break;
 			// ---==== 7 NOTE scale's ====----
 		case Scale::TypeOfScale::MAJOR:
 			scaleText ="MAJOR";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 7; // 7 modes in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::MINOR:
 			scaleText ="MINOR";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 7; // 7 modes in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::MELODIC_MINOR:
 			scaleText ="MELODIC_MINOR";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 7; // 7 modes in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::HARMONIC_MINOR:
 			scaleText ="HARMONIC_MINOR";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 7; // 7 modes in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::GYPSY:
 			scaleText ="GYPSY";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::SYMETRICAL:
 			scaleText ="SYMETRICAL";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::ENIGMATIC:
 			scaleText ="ENIGMATIC";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::ARABIAN:
 			scaleText ="ARABIAN";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 		case Scale::TypeOfScale::HUNGARIAN:
 			scaleText ="HUNGARIAN";
 			kindOfScale = Scale::KindOfScale::HEPTATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 7; // Heptatonic = 7 notes.
 			break;
 			// ---==== 6 NOTE scale's ====----
 		case Scale::TypeOfScale::WHOLE_TONE:
 			scaleText ="WHOLE_TONE";
 			kindOfScale = Scale::KindOfScale::HEXATONIC;
-			numOfModes = 1; // only 1 mode in this scale
-			numOfNotes = 6; // Hexatonic 6 notes.
 			break;
 		case Scale::TypeOfScale::AUGMENTED:
 			scaleText ="AUGMENTED";
 			kindOfScale = Scale::KindOfScale::HEXATONIC;
-			numOfModes = 2;
-			numOfNotes = 6; // Hexatonic 6 notes.
 			break;
 		case Scale::TypeOfScale::BLUES_MAJOR:
 			scaleText ="BLUES MAJOR";
 			kindOfScale = Scale::KindOfScale::HEXATONIC;
-			numOfModes = 1;
-			numOfNotes = 6; // Hexatonic 6 notes.
 			break;
 		case Scale::TypeOfScale::BLUES_MINOR:
 			scaleText ="BLUES_MINOR";
 			kindOfScale = Scale::KindOfScale::HEXATONIC;
-			numOfModes = 6;
-			numOfNotes = 6; // Hexatonic 6 notes.
 			break;
 			// ---==== 5 NOTE scale's ====----
 		case Scale::TypeOfScale::PENTATONIC:
 			scaleText ="PENTATONIC";
 			kindOfScale = Scale::KindOfScale::PENTATONIC;
-			numOfModes = 1;
-			numOfNotes = 5; // Hexatonic 6 notes.
 			break;
 		case Scale::TypeOfScale::MINOR_PENTATONIC:
 			scaleText ="MINOR_PENTATONIC";
 			kindOfScale = Scale::KindOfScale::PENTATONIC;
-			numOfModes = 1;
-			numOfNotes = 5; // Hexatonic 6 notes.
 			break;
 			// TODO: implement other type of scales.
 		default:
-			numOfModes = 0;
-			numOfNotes = 0;
+			scaleText = "UNKNOWN";
 			break;
 	}
+	numOfModes = NumOfModes(typeOfScaleArg);
+	numOfNotes = NumOfNotes(typeOfScaleArg);
 	
 	//	 Create (i) modes object in the vector
 	//	 We give a pointer to ourselves 'this' as the mode
 	//	 must know what kind of scale it is a mode of.
 	for(unsigned int i = 0; i < numOfModes; i++) {
-		Mode mode(this, i, numOfNotes, "mode" + std::to_string(i + 1));
+		Mode mode(this, i, numOfNotes, "mode");
 		modes.push_back(mode);
 	}
 	
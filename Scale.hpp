@@ -19,6 +19,7 @@
 
 
 #include "Mode.hpp"
+#include "FixedVector.hpp"
 //#include "Harmony.hpp"
 
 
@@ -58,7 +59,7 @@ public:
 	enum TypeOfScale typeOfScale;
 	
 	// This is just to facilitate some iterations
-	const std::vector<TypeOfScale> allScaleKinds = {
+	static constexpr TypeOfScale allScaleKinds[] = {
 		TypeOfScale::CHROMATIC,
 		TypeOfScale::OCTATONIC,
 		TypeOfScale::DOMINANT_DIMINISHED,
@@ -86,13 +87,120 @@ public:
 	Scale(TypeOfScale typeOfScaleArg,
 		  uint8_t rootNoteArg) noexcept;
 	
+	/** Size of a type of scale, 0 for types that are not
+	 * implemented.  Usable at compile time (see StaticScale.hpp).
+	 */
+	static constexpr unsigned int NumOfNotes(TypeOfScale type) {
+		switch (type) {
+			case TypeOfScale::CHROMATIC:
+				return 12;
+			case TypeOfScale::OCTATONIC:
+			case TypeOfScale::DOMINANT_DIMINISHED:
+			case TypeOfScale::DIMINISHED:
+				return 8;
+			case TypeOfScale::MAJOR:
+			case TypeOfScale::MINOR:
+			case TypeOfScale::MELODIC_MINOR:
+			case TypeOfScale::HARMONIC_MINOR:
+			case TypeOfScale::GYPSY:
+			case TypeOfScale::SYMETRICAL:
+			case TypeOfScale::ENIGMATIC:
+			case TypeOfScale::ARABIAN:
+			case TypeOfScale::HUNGARIAN:
+				return 7;
+			case TypeOfScale::WHOLE_TONE:
+			case TypeOfScale::AUGMENTED:
+			case TypeOfScale::BLUES_MAJOR:
+			case TypeOfScale::BLUES_MINOR:
+				return 6;
+			case TypeOfScale::PENTATONIC:
+			case TypeOfScale::MINOR_PENTATONIC:
+				return 5;
+		}
+		return 0;
+	}
+	static constexpr unsigned int NumOfModes(TypeOfScale type) {
+		switch (type) {
+			case TypeOfScale::MAJOR:
+			case TypeOfScale::MINOR:
+			case TypeOfScale::MELODIC_MINOR:
+			case TypeOfScale::HARMONIC_MINOR:
+				return 7;
+			case TypeOfScale::BLUES_MINOR:
+				return 6;
+			case TypeOfScale::OCTATONIC:
+			case TypeOfScale::AUGMENTED:
+				return 2;
+			default:
+				return NumOfNotes(type) ? 1 : 0;
+		}
+	}
+	/** Semitones from note 'j' to note 'j + 1' of a mode.
+	 */
+	static constexpr uint8_t Step(TypeOfScale type,
+								  unsigned int modeNum,
+								  unsigned int j) {
+		switch (type) {
+			case TypeOfScale::CHROMATIC:
+				return Mode::chromatic[j];
+			case TypeOfScale::OCTATONIC:
+				return Mode::octatonic[modeNum][j];
+			case TypeOfScale::DOMINANT_DIMINISHED:
+				return Mode::dominant_diminished[j];
+			case TypeOfScale::DIMINISHED:
+				return Mode::diminished[j];
+			case TypeOfScale::MAJOR:
+				return Mode::major_s[modeNum][j];
+			case TypeOfScale::MINOR:
+				return Mode::minor_s[modeNum][j];
+			case TypeOfScale::MELODIC_MINOR:
+				return Mode::melodic_minor[modeNum][j];
+			case TypeOfScale::HARMONIC_MINOR:
+				return Mode::harmonic_minor[modeNum][j];
+			case TypeOfScale::GYPSY:
+				return Mode::gypsy[j];
+			case TypeOfScale::SYMETRICAL:
+				return Mode::symetrical[j];
+			case TypeOfScale::ENIGMATIC:
+				return Mode::enigmatic[j];
+			case TypeOfScale::ARABIAN:
+				return Mode::arabian[j];
+			case TypeOfScale::HUNGARIAN:
+				return Mode::hungarian[j];
+			case TypeOfScale::WHOLE_TONE:
+				return Mode::whole_tone[j];
+			case TypeOfScale::AUGMENTED:
+				return Mode::augmented[modeNum][j];
+			case TypeOfScale::BLUES_MAJOR:
+				return Mode::blues_major[j];
+			case TypeOfScale::BLUES_MINOR:
+				return Mode::blues_minor[modeNum][j];
+			case TypeOfScale::PENTATONIC:
+				return Mode::pentatonic[j];
+			case TypeOfScale::MINOR_PENTATONIC:
+				return Mode::minor_pentatonic[j];
+		}
+		return 0;
+	}
+	
 	unsigned int rootNote;
 	unsigned int numOfNotes;
-	std::vector<Mode> modes;
+	static const unsigned int maxModes = 7;
+	HarmonyVector<Mode, maxModes> modes;
 	unsigned int numOfModes;
 	
 	const std::string Text() {
-		return "Scale::TypeOfScale::" + scaleText;
+		return std::string("Scale::TypeOfScale::") + scaleText;
+	}
+	
+	/** Pitch classes of one of the modes, empty when there is
+	 * no such mode.
+	 */
+	PitchClassSet PitchClasses(unsigned int modenum) {
+		if (modenum >= modes.size()) {
+			return PitchClassSet();
+		}
+		return modes[modenum].PitchClasses();
 	}
 	enum class Iv { // Interval
 		H  = 1,     // Half step
@@ -107,7 +215,7 @@ private:
 	Scale& operator=(const Scale&);
 	
 	//
-	std::string scaleText;
+	const char *scaleText;
 };
 
 
@@ -0,0 +1,101 @@
+/** @file StaticScale.hpp
+ *
+ * Harmony implements Notes, Scales, Modes, Chords
+ * the intent is to keep this library as clean
+ * as possible to allow implementation on hardware
+ * platforms such as ARM MBED OS.
+ *
+ * A Scale whose type and root are known when compiling.  The notes of
+ * every mode are worked out by the compiler from the same interval
+ * tables as the runtime Scale (Scale::Step()) and end up as constant
+ * std::arrays in flash: no constructor, no heap and no stack for
+ * fixed scales.  Use the runtime Scale when the scale is picked while
+ * running.
+ *
+ *   typedef StaticScale<Scale::TypeOfScale::GYPSY, 60> Gypsy;
+ *   for (auto note: Gypsy::modes[0]) ...
+ *   quantizer.SetScale(Gypsy::PitchClasses(0));
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef StaticScale_hpp
+#define StaticScale_hpp
+
+#include <cstdint>
+#include <array>
+#include <utility>
+
+#include "Scale.hpp"
+#include "NoteSet.hpp"
+
+
+template<Scale::TypeOfScale typeOfScale, uint8_t rootNote>
+class StaticScale {
+public:
+	static_assert(rootNote < 128, "root note is not a MIDI note");
+	static_assert(Scale::NumOfNotes(typeOfScale) != 0,
+				  "type of scale is not implemented");
+
+	static constexpr unsigned int numOfNotes = Scale::NumOfNotes(typeOfScale);
+	static constexpr unsigned int numOfModes = Scale::NumOfModes(typeOfScale);
+
+	typedef std::array<uint8_t, numOfNotes> Notes;
+
+	/** Note 'j' of mode 'modeNum', as Mode::Mode() calculates it.
+	 */
+	static constexpr uint8_t NoteOf(unsigned int modeNum, unsigned int j) {
+		return j == 0 ? rootNote
+			: (uint8_t)(NoteOf(modeNum, j - 1)
+						+ Scale::Step(typeOfScale, modeNum, j - 1));
+	};
+	static constexpr Notes ModeNotes(unsigned int modeNum) {
+		return ModeNotes(modeNum, std::make_index_sequence<numOfNotes>());
+	};
+	static constexpr PitchClassSet PitchClasses(unsigned int modeNum) {
+		return PitchClasses(modeNum, std::make_index_sequence<numOfNotes>());
+	};
+
+private:
+	template<size_t... j>
+	static constexpr Notes ModeNotes(unsigned int modeNum,
+									 std::index_sequence<j...>) {
+		return Notes{ {NoteOf(modeNum, j)...} };
+	};
+	template<size_t... j>
+	static constexpr PitchClassSet PitchClasses(unsigned int modeNum,
+												std::index_sequence<j...>) {
+		return PitchClassSet(BitsOf(NoteOf(modeNum, j)...));
+	};
+	template<size_t... m>
+	static constexpr std::array<Notes, numOfModes> Modes(
+		std::index_sequence<m...>) {
+		return std::array<Notes, numOfModes>{ {ModeNotes(m)...} };
+	};
+
+	static constexpr uint16_t BitsOf() {
+		return 0;
+	};
+	template<typename... Rest>
+	static constexpr uint16_t BitsOf(uint8_t note, Rest... rest) {
+		return (uint16_t)(1 << (note % 12)) | BitsOf(rest...);
+	};
+
+public:
+	/** All modes, built by the compiler.  Declared after the
+	 * functions it is built with, they must be defined by then.
+	 */
+	static constexpr std::array<Notes, numOfModes> modes =
+		Modes(std::make_index_sequence<numOfModes>());
+};
+
+// Before C++17 a constexpr static member used by reference (range for)
+// needs a definition.
+template<Scale::TypeOfScale typeOfScale, uint8_t rootNote>
+constexpr std::array<typename StaticScale<typeOfScale, rootNote>::Notes,
+					 StaticScale<typeOfScale, rootNote>::numOfModes>
+StaticScale<typeOfScale, rootNote>::modes;
+
+
+#endif /* StaticScale_hpp */
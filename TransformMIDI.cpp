@@ -1,2 +1,153 @@
+/** This MIDI class implements various transforms for MIDI messages 
+ * @date: 24 Oct 2020 
+ * @author: Jan-Willem Smaal <usenet@gispen.org>  
+ * @license: APACHE-2.0 
+ */
+#include "TransformMIDI.h"
 
 
+/** ScaleQuantize constructor
+ * until a scale is set notes pass unchanged (chromatic).
+ */
+ScaleQuantize::ScaleQuantize(SerialMidi *ptr,
+							 Direction directionArg)
+: TransformMIDI(ptr)
+{
+	direction = directionArg;
+	pitchClasses = 0x0FFF;
+	for (unsigned int i = 0; i < 128; i++) {
+		held[i] = notHeld;
+	}
+	Rebuild();
+}
+
+
+/** Take the pitch classes of the mode and rebuild the table.
+ */
+void ScaleQuantize::SetScale(Scale &scl, unsigned int modenum) {
+	SetScale(scl.PitchClasses(modenum));
+}
+
+
+void ScaleQuantize::SetScale(PitchClassSet pcs) {
+	// An empty scale would map everything to nothing.
+	pitchClasses = pcs.Empty() ? PitchClassSet::mask : pcs.bits;
+	Rebuild();
+}
+
+
+void ScaleQuantize::SetDirection(Direction directionArg) {
+	direction = directionArg;
+	Rebuild();
+}
+
+
+/** Fill the table that is not in use and swap it in.
+ */
+void ScaleQuantize::Rebuild() {
+	uint8_t *spare = luts.Spare();
+	
+	for (int i = 0; i < 128; i++) {
+		int down = i;
+		int up = i;
+		
+		// Pitch class sets are never empty so one of the two ends
+		// within an octave.  Outside 0..127 take the other direction.
+		while (down >= 0 && !(pitchClasses & (1 << (down % 12)))) {
+			down--;
+		}
+		while (up <= 127 && !(pitchClasses & (1 << (up % 12)))) {
+			up++;
+		}
+		if (down < 0) {
+			down = up;
+		}
+		if (up > 127) {
+			up = down;
+		}
+		
+		switch (direction) {
+			case Direction::UP:
+				spare[i] = up;
+				break;
+			case Direction::DOWN:
+				spare[i] = down;
+				break;
+			case Direction::NEAREST:
+				spare[i] = (up - i < i - down) ? up : down;
+				break;
+		}
+	}
+	luts.Publish(spare);
+}
+
+
+/** Harmonizer constructor
+ * until a scale is set the intervals are those of C major.
+ */
+Harmonizer::Harmonizer(SerialMidi *ptr,
+					   uint8_t intervalsArg,
+					   bool aboveArg,
+					   bool belowArg)
+: TransformMIDI(ptr)
+{
+	SetIntervals(intervalsArg, aboveArg, belowArg);
+	SetScale(StaticScale<Scale::TypeOfScale::MAJOR, 0>::PitchClasses(0));
+}
+
+
+void Harmonizer::SetScale(Scale &scl, unsigned int modenum) {
+	SetScale(scl.PitchClasses(modenum));
+}
+
+
+/** Build the interval table of the mode in the spare buffer.
+ */
+void Harmonizer::SetScale(PitchClassSet pcset) {
+	// Steps in the scale for THIRD, FIFTH, SIXTH, (OCTAVE is numOfPcs)
+	static const int steps[numOfIntervals - 1] = {2, 4, 5};
+	uint8_t pcs[12];
+	int numOfPcs = 0;
+	
+	// Sorted pitch classes of the mode.
+	for (int pc = 0; pc < 12; pc++) {
+		if (pcset.Contains(pc)) {
+			pcs[numOfPcs++] = pc;
+		}
+	}
+	if (numOfPcs == 0) {
+		return;
+	}
+	
+	uint8_t *spare = tables.Spare();
+	
+	for (int note = 0; note < 128; note++) {
+		// Degree of the scale note at or below 'note' counted from
+		// pitch class pcs[0] of octave 0, can be -1.
+		int octave = note / 12;
+		int pc = note % 12;
+		int k = numOfPcs - 1;
+		while (k >= 0 && pcs[k] > pc) {
+			k--;
+		}
+		if (k < 0) {
+			k = numOfPcs - 1;
+			octave--;
+		}
+		int degree = octave * numOfPcs + k;
+		int chromatic = note - (octave * 12 + pcs[k]);
+		
+		for (unsigned int i = 0; i < numOfIntervals; i++) {
+			int step = (i < numOfIntervals - 1) ? steps[i] : numOfPcs;
+			for (int direction = 0; direction < 2; direction++) {
+				int d = direction ? degree - step : degree + step;
+				// Floor division, d can be negative.
+				int o = (d >= 0) ? d / numOfPcs : -((numOfPcs - 1 - d) / numOfPcs);
+				int out = o * 12 + pcs[d - o * numOfPcs] + chromatic;
+				spare[note * maxVoices + direction * numOfIntervals + i] =
+					(out >= 0 && out < 128) ? out : noNote;
+			}
+		}
+	}
+	tables.Publish(spare);
+}
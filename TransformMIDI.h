@@ -3,8 +3,18 @@
  * @author: Jan-Willem Smaal <usenet@gispen.org>  
  * @license: APACHE-2.0 
  */
- #include "mbed.h"
- #include "serial-midi.h"
+#ifndef TransformMIDI_h
+#define TransformMIDI_h
+
+ #include <cstdint>
+ #include <cstddef>
+ #include <atomic>
+ #include "Harmony.hpp"
+ #include "StaticScale.hpp"
+
+// Only a pointer is kept, the transforms do not depend on the 
+// hardware so they also build on a host (see sim/). 
+class SerialMidi;
 
 /** TransformMIDI class  
  * protoype 
@@ -29,3 +39,193 @@ class SuperARP: public TransformMIDI {
 };
 
 
+/** Lookup tables rebuilt by one thread while another reads them.
+ *
+ * The writer fills Spare() and swaps it in with Publish().  The
+ * reader brackets every lookup with Acquire() and Release(), which
+ * tells the writer which table is in use (a hazard pointer).  With
+ * three tables there is always one that is neither published nor in
+ * use so the writer never waits and never writes a table that is
+ * being read, however often it rebuilds.  Only one writer thread.
+ */
+template<size_t size>
+class SwapTables {
+public:
+	SwapTables() noexcept : reading(nullptr) {
+		active.store(tables[0]);
+	};
+	
+	uint8_t *Spare() {
+		const uint8_t *current = active.load();
+		const uint8_t *used = reading.load();
+		unsigned int i = 0;
+		while (tables[i] == current || tables[i] == used) {
+			i++;
+		}
+		return tables[i];
+	};
+	void Publish(const uint8_t *table) {
+		active.store(table);
+	};
+	/** The current table, valid until Release().
+	 */
+	const uint8_t *Acquire() {
+		const uint8_t *table = active.load();
+		while (true) {
+			reading.store(table);
+			// Published again before the store was seen, try that one.
+			const uint8_t *now = active.load();
+			if (now == table) {
+				return table;
+			}
+			table = now;
+		}
+	};
+	void Release() {
+		reading.store(nullptr, std::memory_order_release);
+	};
+	
+private:
+	static const unsigned int numOfTables = 3;
+	uint8_t tables[numOfTables][size];
+	std::atomic<const uint8_t *> active;
+	std::atomic<const uint8_t *> reading;
+};
+
+
+
+/** ScaleQuantize snaps incoming notes to the current Scale/Mode.
+ *
+ * Every time the scale changes a 128 entry note -> note lookup table
+ * is rebuilt in a spare buffer and swapped in (SwapTables), after that
+ * every note costs one table read.  Call SetScale() and SetDirection()
+ * from one thread that is not handling notes.
+ *
+ * The note each note-on was mapped to is remembered so the note-off
+ * always matches, even when the scale changed while the note was held.
+ */
+class ScaleQuantize: public TransformMIDI {
+public:
+	enum class Direction {
+		NEAREST,	// Ties go down.
+		UP,
+		DOWN
+	};
+	ScaleQuantize(SerialMidi *ptr,
+				  Direction directionArg = Direction::NEAREST);
+	
+	void SetScale(Scale &scl, unsigned int modenum);
+	/** Pitch classes of a scale, from a StaticScale for example.
+	 */
+	void SetScale(PitchClassSet pcs);
+	void SetDirection(Direction directionArg);
+	
+	/** Quantized note for a note-on, remembered until the note-off.
+	 */
+	uint8_t NoteOn(uint8_t note) {
+		uint8_t out = Lookup(note);
+		held[note & 0x7F] = out;
+		return out;
+	};
+	/** Note that was sent for the note-on of this note.
+	 */
+	uint8_t NoteOff(uint8_t note) {
+		uint8_t out = held[note & 0x7F];
+		held[note & 0x7F] = notHeld;
+		if (out == notHeld) {
+			out = Lookup(note);
+		}
+		return out;
+	};
+	
+private:
+	void Rebuild();
+	uint8_t Lookup(uint8_t note) {
+		uint8_t out = luts.Acquire()[note & 0x7F];
+		luts.Release();
+		return out;
+	};
+	
+	static const uint8_t notHeld = 0xFF;
+	SwapTables<128> luts;
+	uint8_t held[128];
+	uint16_t pitchClasses;	// bit n set means pitch class n is in the scale
+	Direction direction;
+};
+
+
+/** Harmonizer adds diatonic intervals above and/or below every note.
+ *
+ * The intervals follow the mode so a third is major or minor depending
+ * on where the note is in the scale.  Notes that are not in the scale
+ * keep their chromatic distance to the scale note below them.
+ *
+ * All intervals of all 128 notes are calculated once per scale into a
+ * table (swapped in like ScaleQuantize's) so harmonizing a note costs
+ * a few table reads whatever the scale is.  The intervals and
+ * directions are one atomic byte so a note never sees half of a
+ * SetIntervals() from another thread.
+ */
+class Harmonizer: public TransformMIDI {
+public:
+	enum Interval: uint8_t {	// Can be combined.
+		THIRD  = 0x01,
+		FIFTH  = 0x02,
+		SIXTH  = 0x04,
+		OCTAVE = 0x08
+	};
+	static const unsigned int numOfIntervals = 4;
+	static const unsigned int maxVoices = 2 * numOfIntervals;
+	
+	Harmonizer(SerialMidi *ptr,
+			   uint8_t intervalsArg = THIRD | FIFTH,
+			   bool aboveArg = true,
+			   bool belowArg = false);
+	
+	void SetScale(Scale &scl, unsigned int modenum);
+	void SetScale(PitchClassSet pcs);
+	void SetIntervals(uint8_t intervalsArg,
+					  bool aboveArg,
+					  bool belowArg) {
+		settings.store((intervalsArg & intervalMask)
+					   | (aboveArg ? above : 0)
+					   | (belowArg ? below : 0),
+					   std::memory_order_relaxed);
+	};
+	
+	/** Writes the harmony notes (not the note itself) to 'out' which
+	 * must hold maxVoices notes, returns the number of notes.
+	 */
+	unsigned int Harmonize(uint8_t note, uint8_t *out) {
+		uint8_t set = settings.load(std::memory_order_relaxed);
+		const uint8_t *row = tables.Acquire() + (note & 0x7F) * maxVoices;
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < numOfIntervals; i++) {
+			if (!(set & (1 << i))) {
+				continue;
+			}
+			if ((set & above) && row[i] != noNote) {
+				out[n++] = row[i];
+			}
+			if ((set & below) && row[numOfIntervals + i] != noNote) {
+				out[n++] = row[numOfIntervals + i];
+			}
+		}
+		tables.Release();
+		return n;
+	};
+	
+private:
+	static const uint8_t noNote = 0xFF;
+	// Bits of 'settings', the intervals are the low bits.
+	static const uint8_t intervalMask = 0x0F;
+	static const uint8_t above = 0x10;
+	static const uint8_t below = 0x20;
+	
+	// [note][above intervals, below intervals]
+	SwapTables<128 * maxVoices> tables;
+	std::atomic<uint8_t> settings;
+};
+
+
+#endif /* TransformMIDI_h */
@@ -0,0 +1,201 @@
+/** @file TxScheduler.cpp
+ *
+ * Transmit scheduler for a MIDI link of limited bandwidth.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "TxScheduler.hpp"
+
+
+TxScheduler::TxScheduler(uint32_t bytesPerSecond, uint32_t burstBytes) noexcept {
+	byteTime = 1000000 / (bytesPerSecond ? bytesPerSecond : 1);
+	burst = (burstBytes ? burstBytes : 1) * byteTime;
+	credit = burst;
+	lastRefill = 0;
+	stats = Statistics();
+}
+
+
+unsigned int TxScheduler::WireBytes(const UmpEvent &event) {
+	uint8_t msg[3];
+	return event.ToBytes(msg);
+}
+
+
+TxScheduler::Class TxScheduler::ClassOf(const UmpEvent &event) {
+	uint8_t status = event.Status();
+
+	if (event.MessageType() == UmpEvent::SYSTEM) {
+		// Song position belongs with the continue after it.
+		return (status >= 0xF8 || status == 0xF2) ? REALTIME : URGENT;
+	}
+	switch (event.Opcode()) {
+		case 0xA0:
+		case 0xD0:
+		case 0xE0:
+			return CONTINUOUS;
+		case 0xB0:
+			switch (event.Index()) {
+				case 0:			// Bank select
+				case 6:			// Data entry
+				case 32:
+				case 38:
+				case 64:		// Sustain, portamento, sostenuto,
+				case 65:		// soft, legato and hold 2: a pedal
+				case 66:		// coalesced away or sent after the
+				case 67:		// notes it should hold is heard.
+				case 68:
+				case 69:
+				case 96:		// Data increment, decrement
+				case 97:
+				case 98:		// NRPN, RPN
+				case 99:
+				case 100:
+				case 101:
+					return URGENT;
+				default:
+					// Channel mode messages (all notes off...)
+					return event.Index() >= 120 ? URGENT : CONTINUOUS;
+			}
+		default:
+			return URGENT;
+	}
+}
+
+
+uint16_t TxScheduler::Key(const UmpEvent &event) {
+	uint8_t opcode = event.Opcode();
+	uint8_t index = (opcode == 0xA0 || opcode == 0xB0) ? event.Index() : 0;
+	return (uint16_t)(event.Status() << 8 | index);
+}
+
+
+bool TxScheduler::Post(const UmpEvent &event, uint32_t now) {
+	switch (ClassOf(event)) {
+		case REALTIME:
+			if (realtime.Full()) {
+				break;
+			}
+			realtime.Push(event, now);
+			return true;
+		case URGENT:
+			if (urgent.Full()) {
+				break;
+			}
+			urgent.Push(event, now);
+			return true;
+		case CONTINUOUS: {
+			// The newest value takes the place of the pending one.
+			uint16_t key = Key(event);
+			for (unsigned int i = 0; i < continuous.count; i++) {
+				Entry &entry = continuous.At(i);
+				if (Key(entry.event) == key) {
+					entry.event = event;
+					stats.coalesced++;
+					return true;
+				}
+			}
+			if (continuous.Full()) {
+				break;
+			}
+			continuous.Push(event, now);
+			return true;
+		}
+	}
+	stats.dropped++;
+	return false;
+}
+
+
+void TxScheduler::Refill(uint32_t now) {
+	uint32_t elapsed = now - lastRefill;
+	lastRefill = now;
+	credit = (elapsed >= burst - credit) ? burst : credit + elapsed;
+}
+
+
+TxScheduler::Entry *TxScheduler::Front(Class &cls) {
+	if (!realtime.Empty()) {
+		cls = REALTIME;
+		return &realtime.Front();
+	}
+	if (!urgent.Empty()) {
+		cls = URGENT;
+		return &urgent.Front();
+	}
+	if (!continuous.Empty()) {
+		cls = CONTINUOUS;
+		return &continuous.Front();
+	}
+	return nullptr;
+}
+
+
+bool TxScheduler::Next(uint32_t now, UmpEvent &event) {
+	uint32_t stamp;
+	return Next(now, event, stamp);
+}
+
+
+bool TxScheduler::Next(uint32_t now, UmpEvent &event, uint32_t &stamp) {
+	Class cls;
+	Entry *entry;
+
+	Refill(now);
+	while ((entry = Front(cls)) != nullptr) {
+		uint32_t cost = WireBytes(entry->event) * byteTime;
+		if (cost == 0) {
+			// Nothing MIDI 1.0 can carry.
+			stats.dropped++;
+		}
+		else if (cost > credit) {
+			return false;
+		}
+		else {
+			credit -= cost;
+			event = entry->event;
+			stamp = entry->stamp;
+			uint32_t latency = now - entry->stamp;
+			uint32_t &latencyMax = (cls == CONTINUOUS) ?
+				stats.continuousLatencyMax : stats.urgentLatencyMax;
+			if (latency > latencyMax) {
+				latencyMax = latency;
+			}
+			stats.sent++;
+			stats.bytes += cost / byteTime;
+		}
+		switch (cls) {
+			case REALTIME:
+				realtime.Pop();
+				break;
+			case URGENT:
+				urgent.Pop();
+				break;
+			case CONTINUOUS:
+				continuous.Pop();
+				break;
+		}
+		if (cost != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+uint32_t TxScheduler::Wait(uint32_t now) {
+	Class cls;
+	Entry *entry = Front(cls);
+
+	if (entry == nullptr) {
+		return forever;
+	}
+	Refill(now);
+	uint32_t cost = WireBytes(entry->event) * byteTime;
+	return cost > credit ? cost - credit : 0;
+}
+
+
+/* EOF */
@@ -0,0 +1,150 @@
+/** @file TxScheduler.hpp
+ *
+ * Transmit scheduler for a MIDI link of limited bandwidth (a DIN port
+ * carries 3125 bytes/s).  Events are put on the wire in three classes:
+ *
+ *   realtime	clock, start, stop and song position: always first.
+ *   urgent		notes, program changes, system messages, the pedals
+ *				(CC 64..69) and the controllers that only work in
+ *				sequence (bank select, (N)RPN, data entry, channel
+ *				mode): in order.
+ *   continuous	other controllers, pitch bend and pressure: only the
+ *				last value per channel and controller is kept, an
+ *				update that has not been sent yet is replaced.
+ *
+ * A token bucket keeps the bytes sent within the wire rate, so the
+ * queue lives here and not in a UART buffer where a note would wait
+ * behind a stream of controllers.
+ *
+ * Times are in us from any free running clock (wrap around is fine).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef TxScheduler_hpp
+#define TxScheduler_hpp
+
+#include <cstdint>
+#include "Ump.hpp"
+
+
+class TxScheduler {
+public:
+	static const uint32_t forever = 0xFFFFFFFF;
+	static const unsigned int maxRealtime = 16;
+	static const unsigned int maxUrgent = 64;
+	static const unsigned int maxContinuous = 32;
+
+	struct Statistics {
+		uint32_t sent;
+		uint32_t bytes;
+		uint32_t coalesced;		// Updates replaced before they were sent.
+		uint32_t dropped;		// Did not fit.
+		uint32_t urgentLatencyMax;		// us from Post() to Next().
+		uint32_t continuousLatencyMax;
+	};
+
+	/** 'burstBytes' may be sent back to back after the link was idle
+	 * (e.g. the UART FIFO), after that 'bytesPerSecond'.
+	 */
+	TxScheduler(uint32_t bytesPerSecond = 3125, uint32_t burstBytes = 16) noexcept;
+
+	/** Queue an event, false when it had to be dropped.
+	 */
+	bool Post(const UmpEvent &event, uint32_t now);
+
+	/** The next event to send at 'now', false when nothing is queued
+	 * or the budget does not allow it yet.
+	 */
+	bool Next(uint32_t now, UmpEvent &event);
+	/** Same, 'stamp' is the time it was posted.
+	 */
+	bool Next(uint32_t now, UmpEvent &event, uint32_t &stamp);
+
+	/** us until Next() has something to send, forever when nothing is
+	 * queued.
+	 */
+	uint32_t Wait(uint32_t now);
+
+	bool Empty() const {
+		return realtime.Empty() && urgent.Empty() && continuous.Empty();
+	};
+	const Statistics &Stats() const {
+		return stats;
+	};
+	/** Peaks start over.
+	 */
+	void ClearPeaks() {
+		stats.urgentLatencyMax = 0;
+		stats.continuousLatencyMax = 0;
+	};
+
+	/** Bytes on a MIDI 1.0 wire, 0 for events it cannot carry.
+	 */
+	static unsigned int WireBytes(const UmpEvent &event);
+
+private:
+	struct Entry {
+		UmpEvent event;
+		uint32_t stamp;
+	};
+
+	/** FIFO of entries, 'size' is a power of two.
+	 */
+	template<unsigned int size>
+	struct Ring {
+		Entry entry[size];
+		unsigned int head = 0;
+		unsigned int count = 0;
+
+		bool Empty() const {
+			return count == 0;
+		};
+		bool Full() const {
+			return count == size;
+		};
+		Entry &At(unsigned int i) {
+			return entry[(head + i) & (size - 1)];
+		};
+		Entry &Front() {
+			return entry[head];
+		};
+		void Push(const UmpEvent &event, uint32_t stamp) {
+			Entry &e = At(count++);
+			e.event = event;
+			e.stamp = stamp;
+		};
+		void Pop() {
+			head = (head + 1) & (size - 1);
+			count--;
+		};
+	};
+
+	enum Class {
+		REALTIME,
+		URGENT,
+		CONTINUOUS
+	};
+	static Class ClassOf(const UmpEvent &event);
+	/** Messages the continuous class coalesces on: status and
+	 * controller (or note for poly pressure).
+	 */
+	static uint16_t Key(const UmpEvent &event);
+	void Refill(uint32_t now);
+	/** Highest class with something queued, nullptr when empty.
+	 */
+	Entry *Front(Class &cls);
+
+	Ring<maxRealtime> realtime;
+	Ring<maxUrgent> urgent;
+	Ring<maxContinuous> continuous;
+	uint32_t byteTime;		// us per byte
+	uint32_t burst;			// us of wire time
+	uint32_t credit;		// us of wire time that may be used
+	uint32_t lastRefill;
+	Statistics stats;
+};
+
+
+#endif /* TxScheduler_hpp */
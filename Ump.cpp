@@ -0,0 +1,169 @@
+/** @file Ump.cpp
+ *
+ * Universal MIDI Packet translation from and to MIDI 1.0 bytes.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include "Ump.hpp"
+
+
+/** Number of data bytes after a MIDI 1.0 status byte, -1 for SysEx
+ * and bytes that are not a status.
+ */
+static int DataBytes(uint8_t status) {
+	if (status < 0x80) {
+		return -1;
+	}
+	if (status < 0xF0) {
+		uint8_t opcode = status & 0xF0;
+		return (opcode == 0xC0 || opcode == 0xD0) ? 1 : 2;
+	}
+	switch (status) {
+		case 0xF1:		// MTC quarter frame
+		case 0xF3:		// Song select
+			return 1;
+		case 0xF2:		// Song position
+			return 2;
+		case 0xF0:
+		case 0xF7:
+			return -1;
+		default:
+			return 0;
+	}
+}
+
+
+uint32_t UmpEvent::ScaleUp(uint32_t value, unsigned int srcBits, unsigned int dstBits) {
+	unsigned int scaleBits = dstBits - srcBits;
+	uint32_t shifted = value << scaleBits;
+	uint32_t center = 1u << (srcBits - 1);
+
+	if (value <= center) {
+		return shifted;
+	}
+	// Above the centre the bits below the top one are repeated to
+	// fill the extra resolution.
+	unsigned int repeatBits = srcBits - 1;
+	uint32_t repeat = value & ((1u << repeatBits) - 1);
+	if (scaleBits > repeatBits) {
+		repeat <<= scaleBits - repeatBits;
+	}
+	else {
+		repeat >>= repeatBits - scaleBits;
+	}
+	while (repeat != 0) {
+		shifted |= repeat;
+		repeat >>= repeatBits;
+	}
+	return shifted;
+}
+
+
+bool UmpEvent::FromBytes(const uint8_t *msg, size_t len, UmpEvent &event,
+						 uint8_t group) {
+	if (len == 0) {
+		return false;
+	}
+	int n = DataBytes(msg[0]);
+	if (n < 0 || len < (size_t)n + 1) {
+		return false;
+	}
+	event = Midi1(msg[0], n > 0 ? msg[1] : 0, n > 1 ? msg[2] : 0, group);
+	return true;
+}
+
+
+size_t UmpEvent::ToBytes(uint8_t *msg) const {
+	uint8_t status = Status();
+
+	switch (MessageType()) {
+		case SYSTEM:
+		case MIDI1: {
+			int n = DataBytes(status);
+			if (n < 0) {
+				return 0;
+			}
+			msg[0] = status;
+			msg[1] = Index() & 0x7F;
+			msg[2] = Data2() & 0x7F;
+			return (size_t)n + 1;
+		}
+		case MIDI2:
+			break;
+		default:
+			return 0;
+	}
+
+	msg[0] = status;
+	msg[1] = Index() & 0x7F;
+	switch (Opcode()) {
+		case 0x80:
+			msg[2] = (uint8_t)ScaleDown(word[1] >> 16, 16, 7);
+			return 3;
+		case 0x90:
+			// A MIDI 1.0 velocity of 0 would be a note off.
+			msg[2] = (uint8_t)ScaleDown(word[1] >> 16, 16, 7);
+			if (msg[2] == 0) {
+				msg[2] = 1;
+			}
+			return 3;
+		case 0xA0:
+		case 0xB0:
+			msg[2] = (uint8_t)ScaleDown(word[1], 32, 7);
+			return 3;
+		case 0xC0:
+			msg[1] = (word[1] >> 24) & 0x7F;
+			return 2;
+		case 0xD0:
+			msg[1] = (uint8_t)ScaleDown(word[1], 32, 7);
+			return 2;
+		case 0xE0: {
+			uint32_t bend = ScaleDown(word[1], 32, 14);
+			msg[1] = bend & 0x7F;
+			msg[2] = (bend >> 7) & 0x7F;
+			return 3;
+		}
+		default:
+			// Per note and registered controllers have no MIDI 1.0
+			// counterpart of one message.
+			return 0;
+	}
+}
+
+
+UmpEvent UmpEvent::ToMidi2() const {
+	if (MessageType() != MIDI1) {
+		return *this;
+	}
+	uint8_t channel = Channel();
+	uint8_t group = Group();
+	uint8_t data1 = Index();
+	uint8_t data2 = Data2();
+
+	switch (Opcode()) {
+		case 0x80:
+			return NoteOff(channel, data1, (uint16_t)ScaleUp(data2, 7, 16), group);
+		case 0x90:
+			if (data2 == 0) {
+				return NoteOff(channel, data1, 0, group);
+			}
+			return NoteOn(channel, data1, (uint16_t)ScaleUp(data2, 7, 16), group);
+		case 0xA0:
+			return Midi2(Status(), data1, 0, ScaleUp(data2, 7, 32), group);
+		case 0xB0:
+			return ControlChange(channel, data1, ScaleUp(data2, 7, 32), group);
+		case 0xC0:
+			return Midi2(Status(), 0, 0, (uint32_t)data1 << 24, group);
+		case 0xD0:
+			return ChannelPressure(channel, ScaleUp(data1, 7, 32), group);
+		case 0xE0:
+			return PitchBend(channel, ScaleUp((uint32_t)data2 << 7 | data1, 14, 32), group);
+		default:
+			return *this;
+	}
+}
+
+
+/* EOF */
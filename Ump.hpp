@@ -0,0 +1,152 @@
+/** @file Ump.hpp
+ *
+ * MIDI 2.0 Universal MIDI Packet as the one event type inside the
+ * firmware.  An event is one or two 32 bit words, always 8 bytes and
+ * word aligned, so it is copied, queued and compared as plain data.
+ *
+ * Supported are the packet types the MIDI 1.0 wire can carry:
+ * system messages (type 1), MIDI 1.0 channel voice (type 2) and
+ * MIDI 2.0 channel voice (type 4) with 16 bit velocities and 32 bit
+ * controllers.  FromBytes() and ToBytes() translate from and to a
+ * MIDI 1.0 byte stream, scaling MIDI 2.0 values as the UMP spec says.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef Ump_hpp
+#define Ump_hpp
+
+#include <cstdint>
+#include <cstddef>
+
+
+struct UmpEvent {
+	enum Type: uint8_t {
+		UTILITY = 0x0,
+		SYSTEM = 0x1,		// 32 bit, realtime and system common
+		MIDI1 = 0x2,		// 32 bit, MIDI 1.0 channel voice
+		MIDI2 = 0x4			// 64 bit, MIDI 2.0 channel voice
+	};
+
+	uint32_t word[2];
+
+	UmpEvent() noexcept : word{0, 0} {};
+
+	Type MessageType() const {
+		return (Type)(word[0] >> 28);
+	};
+	uint8_t Group() const {
+		return (word[0] >> 24) & 0x0F;
+	};
+	/** Status byte, with the channel for channel voice messages.
+	 */
+	uint8_t Status() const {
+		return (uint8_t)(word[0] >> 16);
+	};
+	uint8_t Opcode() const {
+		return Status() & 0xF0;
+	};
+	uint8_t Channel() const {
+		return Status() & 0x0F;
+	};
+	/** Note or controller number (the first data byte).
+	 */
+	uint8_t Index() const {
+		return (uint8_t)(word[0] >> 8);
+	};
+	/** Second data byte of a MIDI 1.0 message.
+	 */
+	uint8_t Data2() const {
+		return (uint8_t)word[0];
+	};
+	unsigned int Words() const {
+		return MessageType() >= 0x3 ? 2 : 1;
+	};
+	bool operator==(const UmpEvent &other) const {
+		return word[0] == other.word[0] && word[1] == other.word[1];
+	};
+
+	/** Same message on another channel.
+	 */
+	UmpEvent WithChannel(uint8_t channel) const {
+		UmpEvent event = *this;
+		event.word[0] = (word[0] & ~0x000F0000u) | (uint32_t)(channel & 0x0F) << 16;
+		return event;
+	};
+
+	/** MIDI 1.0 message (channel voice or system) as a 32 bit packet.
+	 */
+	static UmpEvent Midi1(uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0,
+						  uint8_t group = 0) {
+		UmpEvent event;
+		uint32_t type = status >= 0xF0 ? SYSTEM : MIDI1;
+		event.word[0] = type << 28 | (uint32_t)(group & 0x0F) << 24 |
+			(uint32_t)status << 16 | (uint32_t)(data1 & 0x7F) << 8 | (data2 & 0x7F);
+		return event;
+	};
+
+	/** MIDI 2.0 channel voice messages, full resolution values.
+	 */
+	static UmpEvent NoteOn(uint8_t channel, uint8_t note, uint16_t velocity,
+						   uint8_t group = 0) {
+		return Midi2(0x90 | (channel & 0x0F), note, 0, (uint32_t)velocity << 16, group);
+	};
+	static UmpEvent NoteOff(uint8_t channel, uint8_t note, uint16_t velocity,
+							uint8_t group = 0) {
+		return Midi2(0x80 | (channel & 0x0F), note, 0, (uint32_t)velocity << 16, group);
+	};
+	static UmpEvent ControlChange(uint8_t channel, uint8_t controller,
+								  uint32_t value, uint8_t group = 0) {
+		return Midi2(0xB0 | (channel & 0x0F), controller, 0, value, group);
+	};
+	static UmpEvent ChannelPressure(uint8_t channel, uint32_t value,
+									uint8_t group = 0) {
+		return Midi2(0xD0 | (channel & 0x0F), 0, 0, value, group);
+	};
+	/** 0x80000000 is the centre.
+	 */
+	static UmpEvent PitchBend(uint8_t channel, uint32_t value, uint8_t group = 0) {
+		return Midi2(0xE0 | (channel & 0x0F), 0, 0, value, group);
+	};
+
+	/** Event for a complete MIDI 1.0 message (status and data
+	 * bytes).  False for SysEx and messages that are cut short.
+	 */
+	static bool FromBytes(const uint8_t *msg, size_t len, UmpEvent &event,
+						  uint8_t group = 0);
+
+	/** The MIDI 1.0 bytes for this event, MIDI 2.0 values are scaled
+	 * down.  Returns the length, 0 when MIDI 1.0 has no such message
+	 * (e.g. per note controllers).
+	 */
+	size_t ToBytes(uint8_t *msg) const;
+
+	/** A MIDI 1.0 channel voice event as MIDI 2.0, values scaled up.
+	 * Other events are returned as they are.
+	 */
+	UmpEvent ToMidi2() const;
+
+	/** Min-center-max scaling from the UMP spec: 0 stays 0, the
+	 * centre stays the centre and the maximum becomes the maximum.
+	 */
+	static uint32_t ScaleUp(uint32_t value, unsigned int srcBits, unsigned int dstBits);
+	static uint32_t ScaleDown(uint32_t value, unsigned int srcBits, unsigned int dstBits) {
+		return value >> (srcBits - dstBits);
+	};
+
+private:
+	static UmpEvent Midi2(uint8_t status, uint8_t index, uint8_t attribute,
+						  uint32_t data, uint8_t group) {
+		UmpEvent event;
+		event.word[0] = (uint32_t)MIDI2 << 28 | (uint32_t)(group & 0x0F) << 24 |
+			(uint32_t)status << 16 | (uint32_t)(index & 0x7F) << 8 | attribute;
+		event.word[1] = data;
+		return event;
+	};
+};
+
+static_assert(sizeof(UmpEvent) == 8, "UMP events are two words");
+
+
+#endif /* Ump_hpp */
@@ -0,0 +1,158 @@
+/** @file VoiceLeading.cpp
+ *
+ * Harmony implements Notes, Scales, Modes, Chords
+ * the intent is to keep this library as clean
+ * as possible to allow implementation on hardware
+ * platforms such as ARM MBED OS.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <algorithm>
+#include <cstdlib>
+#include "VoiceLeading.hpp"
+
+
+/** VoiceLeader constructor
+ * the register must at least span an octave otherwise
+ * no inversion will fit.
+ */
+VoiceLeader::VoiceLeader(uint8_t lowNoteArg,
+						 uint8_t highNoteArg) noexcept {
+	if (highNoteArg > 127) {
+		highNoteArg = 127;
+	}
+	if (lowNoteArg + 12 > highNoteArg) {
+		lowNoteArg = highNoteArg >= 12 ? highNoteArg - 12 : 0;
+	}
+	lowNote = lowNoteArg;
+	highNote = highNoteArg;
+	numOfPrevious = 0;
+};
+
+
+/** Distance between a candidate and the previous voicing in semitones.
+ * Both are sorted low to high.  When the number of voices is the same
+ * every voice moves to the voice in the same position, otherwise every
+ * note is matched with the nearest note of the other chord.
+ */
+unsigned int VoiceLeader::Cost(const int *candidate,
+							   unsigned int numOfNotes) {
+	unsigned int cost = 0;
+	
+	if (numOfPrevious == 0) {
+		// Nothing to lead from, stay in the middle of the register.
+		int middle = (lowNote + highNote) / 2;
+		int sum = 0;
+		for (unsigned int i = 0; i < numOfNotes; i++) {
+			sum += candidate[i];
+		}
+		return std::abs(sum - middle * (int)numOfNotes);
+	}
+	
+	if (numOfNotes == numOfPrevious) {
+		for (unsigned int i = 0; i < numOfNotes; i++) {
+			cost += std::abs(candidate[i] - previous[i]);
+		}
+		return cost;
+	}
+	
+	for (unsigned int i = 0; i < numOfNotes; i++) {
+		int nearest = 127;
+		for (unsigned int j = 0; j < numOfPrevious; j++) {
+			nearest = std::min(nearest, std::abs(candidate[i] - previous[j]));
+		}
+		cost += nearest;
+	}
+	for (unsigned int j = 0; j < numOfPrevious; j++) {
+		int nearest = 127;
+		for (unsigned int i = 0; i < numOfNotes; i++) {
+			nearest = std::min(nearest, std::abs(candidate[i] - previous[j]));
+		}
+		cost += nearest;
+	}
+	return cost;
+}
+
+
+/**
+ * Search inversions, drop voicings and octave placements.
+ */
+void VoiceLeader::Voice(Chord &chord) {
+	int root[maxVoices];
+	int candidate[maxVoices];
+	int best[maxVoices];
+	unsigned int numOfNotes = 0;
+	unsigned int bestCost = ~0u;
+	
+	for (auto note: chord.notes) {
+		if (numOfNotes == maxVoices) {
+			break;
+		}
+		root[numOfNotes++] = note.number;
+	}
+	if (numOfNotes == 0) {
+		return;
+	}
+	
+	for (unsigned int inversion = 0; inversion < numOfNotes; inversion++) {
+		// drop == 0 is closed position, 2 is drop 2, 3 is drop 3
+		for (unsigned int drop = 0; drop <= 3; drop++) {
+			if (drop == 1 || (drop != 0 && drop >= numOfNotes)) {
+				continue;
+			}
+			
+			// Closed position of this inversion, notes below the
+			// inversion note are moved up an octave.
+			for (unsigned int i = 0; i < numOfNotes; i++) {
+				unsigned int k = (inversion + i) % numOfNotes;
+				candidate[i] = root[k] + (k < inversion ? 12 : 0);
+			}
+			std::sort(candidate, candidate + numOfNotes);
+			if (drop) {
+				candidate[numOfNotes - drop] -= 12;
+				std::sort(candidate, candidate + numOfNotes);
+			}
+			
+			// Move the lowest note to the bottom of the register
+			// and try every octave that still fits.
+			int shift = lowNote - candidate[0];
+			if (shift >= 0) {
+				shift = ((shift + 11) / 12) * 12;
+			}
+			else {
+				shift = -((-shift) / 12) * 12;
+			}
+			for (; candidate[numOfNotes - 1] + shift <= highNote; shift += 12) {
+				for (unsigned int i = 0; i < numOfNotes; i++) {
+					candidate[i] += shift;
+				}
+				unsigned int cost = Cost(candidate, numOfNotes);
+				if (cost < bestCost) {
+					bestCost = cost;
+					std::copy(candidate, candidate + numOfNotes, best);
+				}
+				for (unsigned int i = 0; i < numOfNotes; i++) {
+					candidate[i] -= shift;
+				}
+			}
+		}
+	}
+	
+	// The chord spans more than the register, keep what we have.
+	if (bestCost == ~0u) {
+		return;
+	}
+	
+	chord.voicing.clear();
+	for (unsigned int i = 0; i < numOfNotes; i++) {
+		Note note(best[i]);
+		chord.voicing.push_back(note);
+		previous[i] = (uint8_t)best[i];
+	}
+	numOfPrevious = numOfNotes;
+}
+
+
+/* EOF */
@@ -0,0 +1,60 @@
+/** @file VoiceLeading.hpp
+ *
+ * Harmony implements Notes, Scales, Modes, Chords
+ * the intent is to keep this library as clean
+ * as possible to allow implementation on hardware
+ * platforms such as ARM MBED OS.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef VoiceLeading_hpp
+#define VoiceLeading_hpp
+
+#include "Chord.hpp"
+
+
+/** Voice leading for successive chords.
+ *
+ * Remembers the previous voicing that was played and voices the next
+ * chord so that it moves the least.  Candidates are all inversions of
+ * the chord in closed, drop 2 and drop 3 position, placed in every
+ * octave that fits inside the register [lowNote, highNote].
+ *
+ * The search is bounded by the number of chord notes (at most
+ * maxVoices inversions * 3 drops * ~10 octaves) and does not allocate
+ * so it is cheap enough to run in a note-on handler.
+ */
+class VoiceLeader {
+public:
+	VoiceLeader(uint8_t lowNoteArg = 36,
+				uint8_t highNoteArg = 84) noexcept;
+	
+	/** Replace chord.voicing with the candidate that has the smallest
+	 * movement from the previous voicing and remember it.
+	 * When there is no previous voicing the candidate closest to the
+	 * middle of the register is chosen.
+	 */
+	void Voice(Chord &chord);
+	
+	/** Forget the previous voicing (e.g. after all notes off)
+	 */
+	void Reset() {
+		numOfPrevious = 0;
+	};
+	
+	uint8_t lowNote;
+	uint8_t highNote;
+	static const unsigned int maxVoices = 8;
+	
+private:
+	uint8_t previous[maxVoices];
+	unsigned int numOfPrevious;
+	
+	unsigned int Cost(const int *candidate,
+					  unsigned int numOfNotes);
+};
+
+
+#endif /* VoiceLeading_hpp */
@@ -15,10 +15,26 @@
 // MIDI transforms 
 #include "TransformMIDI.h"
 
+// Universal MIDI Packet, the event type between the modules 
+#include "Ump.hpp"
+
+// Standard MIDI File player 
+#include "MidiFile.hpp"
+
+// Recorder and looper 
+#include "MidiLooper.hpp"
+
+// Analog inputs as MIDI controllers 
+#include "ControllerInput.hpp"
+
 // Musical scale implementation by Jan-Willem Smaal <usenet@gispen.org> 
 //#include "midi-scales.h"
 #include "Harmony.hpp"
 
+// Voicing range, scale, smoothing, analog inputs and wire rate, shared 
+// with the simulator in sim/ 
+#include "MidiSetup.hpp"
+
 // Serial USART MIDI implementation by Jan-Willem Smaal <usenet@gispen.org> 
 #include "serial-midi.h"
 /*  
@@ -35,116 +51,504 @@ SerialMidi serialMidiGlob(
 		&midi_pitchwheel_handler
 ); 
 
-Chord::Type chordTypeGlob = Chord::Type::MAJOR;  
+/** Chords are voiced relative to the previous chord played 
+ * so successive chords move as little as possible. 
+ */
+VoiceLeader voiceLeaderGlob(voiceLowest, voiceHighest); 
+
+/** Incoming notes are snapped to the scale before they are 
+ * turned into chords.  The scale is set from control_thread. 
+ */
+ScaleQuantize scaleQuantizeGlob(&serialMidiGlob); 
+
+/** Define HARMONIZER to play diatonic thirds and fifths instead of 
+ * chords, the scale is set from control_thread as well. 
+ */
+Harmonizer harmonizerGlob(&serialMidiGlob, harmonyIntervals); 
 
 // Driver for the Magneto and Gyro 
 #include "FXOS8700CQ.h"
 
+#if MAGNETO_SENSOR 
+/** Built in accelerometer and magnetometer of the NXP FRDM board, 
+ * sampled on its data ready interrupt (INT1 = PTC6) by a thread of 
+ * its own, control_thread takes the samples from the mail queue. 
+ */
+#include "MotionSensor.hpp"
+MotionSensor motionSensorGlob(PTE25, PTE24, PTC6); 
+
+/** Tilt and heading from the sensor in fixed point, tilting forward 
+ * and back +-45 degrees bends the pitch, rolling +-90 degrees is the 
+ * modulation wheel. 
+ */
+#include "MotionFusion.hpp"
+MotionFusion motionFusionGlob; 
+MotionCurve pitchBendCurveGlob(-MotionFusion::degrees90 / 2, 
+		MotionFusion::degrees90 / 2, MotionCurve::S_CURVE); 
+MotionCurve modulationCurveGlob(-MotionFusion::degrees90, 
+		MotionFusion::degrees90, MotionCurve::LINEAR); 
+#endif 
+
 /** Minimal LCD lib by Jan-Willem Smaal <usenet@gispen.org>
- * need to do something about it being accessable from 
- * all threads. 
+ * only lcd_thread talks to the LCD, everybody else writes into 
+ * lcdGlob which is flushed by that thread. 
  */ 
 #include "i2c-lcd.h"
+#include "LcdFrameBuffer.hpp"
+LcdFrameBuffer lcdGlob; 
 
 /** Musical Harmony lib by Jan-Willem Smaal <usenet@gispen.org> 
  *
  */
  #include "Harmony.hpp" 
 
+#include "HeapProbe.hpp"
+#if HEAP_PROBE 
+#include "mbed_stats.h"
+/** 
+ * The Harmony library is heap free (HARMONY_HEAP_FREE) so after boot 
+ * the MIDI handlers must not allocate.  HeapProbe charges whatever 
+ * they do allocate to the handler (and Harmony constructor) that 
+ * did it, CC 87 prints the table on the console. 
+ */
+const uint8_t heapCtlReport = 87; 
+
+void heap_counters(HeapCounters &counters) 
+{
+	mbed_stats_heap_t stats; 
+	mbed_stats_heap_get(&stats); 
+	counters.allocs = stats.alloc_cnt; 
+	counters.bytes = stats.total_size; 
+	counters.current = stats.current_size; 
+	counters.peak = stats.max_size; 
+}
+#endif // HEAP_PROBE 
+
+#if MIDI_LOOPER 
+void looper_input(const UmpEvent &event); 
+bool looper_control(uint8_t controller, uint8_t value); 
+void looper_realtime(uint8_t msg); 
+#endif 
+
+/** 
+ * Adaptive smoothing for the continuous controllers: still 
+ * controllers do not jitter, moving ones do not lag.  The 
+ * parameters are in MidiSetup.hpp and can be changed at any time 
+ * with SetParameters(). 
+ */
+#include "OneEuroFilter.hpp"
+
+#if MPE_OUTPUT 
+/** MPE output: every generated note is played on a member channel 
+ * of its own (lower zone, master channel 1) so the sensors can bend 
+ * and shape each voice separately. 
+ */
+#include "MpeAllocator.hpp"
+MpeAllocator mpeGlob; 
+Mutex mpeMutexGlob; 
+#endif 
+
+/////////////////////////////////////////////////////////////////
+//  Pipeline 
+//  RX thread (SerialMidi) -> transform thread -> TX thread, realtime 
+//  messages go from RX straight to the clock thread.  The stages 
+//  pass time stamped UMP events through Mail queues, every stage has 
+//  a StageStats that main() prints on the console. 
+/////////////////////////////////////////////////////////////////
+#include "Pipeline.hpp"
+#include "TxScheduler.hpp"
+#include "MidiEncoder.hpp"
+
+/** A producer waits at most this long for room in a queue, after 
+ * that the event is dropped (and counted). 
+ */
+const Kernel::Clock::duration_u32 pipelinePostTimeout = 10ms; 
+const Kernel::Clock::duration_u32 pipelineStatsInterval = 5000ms; 
+
+Mail<PipelineEvent, 16> clockMailGlob; 
+Mail<PipelineEvent, 32> transformMailGlob; 
+Mail<PipelineEvent, 64> txMailGlob; 
+StageStats clockStatsGlob("clock"); 
+StageStats transformStatsGlob("transform"); 
+StageStats txStatsGlob("tx"); 
+StageStats controlStatsGlob("control"); 
+Timer pipelineTimeGlob; 
+uint32_t rxEventsGlob; 
+
+uint32_t pipeline_now() 
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			pipelineTimeGlob.elapsed_time()).count(); 
+}
+
+template<uint32_t N> 
+bool pipeline_post(Mail<PipelineEvent, N> &mail, StageStats &stats, 
+		const UmpEvent &event) 
+{
+	PipelineEvent *item = mail.try_alloc_for(pipelinePostTimeout); 
+	if (item == nullptr) {
+		stats.Dropped(); 
+		return false; 
+	}
+	item->event = event; 
+	item->stamp = pipeline_now(); 
+	stats.Posted(); 
+	mail.put(item); 
+	return true; 
+}
+
+/** 
+ * Waits at most 'timeout' for an event for the stage. 
+ */
+template<uint32_t N> 
+bool pipeline_take(Mail<PipelineEvent, N> &mail, StageStats &stats, 
+		PipelineEvent &event, 
+		Kernel::Clock::duration_u32 timeout = Kernel::wait_for_u32_forever) 
+{
+	PipelineEvent *item = mail.try_get_for(timeout); 
+	if (item == nullptr) {
+		return false; 
+	}
+	event = *item; 
+	mail.free(item); 
+	stats.Taken(pipeline_now() - event.stamp); 
+	return true; 
+}
+
+/** 
+ * Everything that goes out is queued for the TX thread, it is the 
+ * only thread that writes to SerialMidi. 
+ */
+void midi_send(const UmpEvent &event) 
+{
+	pipeline_post(txMailGlob, txStatsGlob, event); 
+}
+
+
+#if MELODY_ENGINE 
+/////////////////////////////////////////////////////////////////
+//  Generative melody on CH2 in the scale control_thread sets, on 
+//  the 16th notes of the MIDI clock: the master's (swung) steps 
+//  with CLOCK_MASTER, otherwise counted from the incoming clock. 
+//  Every start plays the same melody again.  CC 88 picks the seed 
+//  (1..127), 0 mutes it.  Define MELODY_ENGINE to enable. 
+/////////////////////////////////////////////////////////////////
+#include "MelodyEngine.hpp"
+
+const uint8_t melodyCtlSeed = 88; 
+const uint32_t melodyClocksPerStep = 6; 
+
+MelodyEngine melodyGlob(&midi_send, 1); 
+Mutex melodyMutexGlob; 
+bool melodyMutedGlob; 
+uint32_t melodyClocksGlob; 
+
+void melody_step(uint32_t step) 
+{
+	melodyMutexGlob.lock(); 
+	if (!melodyMutedGlob) {
+		melodyGlob.Step(step); 
+	}
+	melodyMutexGlob.unlock(); 
+}
+
+/** 
+ * Transport and (without CLOCK_MASTER) clock, in the clock thread. 
+ */
+void melody_realtime(uint8_t msg) 
+{
+	switch (msg) {
+		case 0xFA: 
+			melodyClocksGlob = 0; 
+			melodyMutexGlob.lock(); 
+			melodyGlob.Seed(melodyGlob.GetSeed()); 
+			melodyMutexGlob.unlock(); 
+			break; 
+		case 0xFC: 
+			melodyMutexGlob.lock(); 
+			melodyGlob.Stop(); 
+			melodyMutexGlob.unlock(); 
+			break; 
+#if !CLOCK_MASTER 
+		case 0xF8: 
+			if (melodyClocksGlob % melodyClocksPerStep == 0) {
+				melody_step(melodyClocksGlob / melodyClocksPerStep); 
+			}
+			melodyClocksGlob++; 
+			break; 
+#endif 
+	}
+}
+
+bool melody_control(uint8_t controller, uint8_t value) 
+{
+	if (controller != melodyCtlSeed) {
+		return false; 
+	}
+	melodyMutexGlob.lock(); 
+	melodyMutedGlob = (value == 0); 
+	if (melodyMutedGlob) {
+		melodyGlob.Stop(); 
+	}
+	else {
+		melodyGlob.Seed(value); 
+	}
+	melodyMutexGlob.unlock(); 
+	char text[LcdFrameBuffer::columns + 1]; 
+	snprintf(text, sizeof(text), "SEED%3d", value); 
+	lcdGlob.Print(1, 8, text); 
+	return true; 
+}
+#endif // MELODY_ENGINE 
+
+
+#if CLOCK_MASTER 
+/////////////////////////////////////////////////////////////////
+//  MIDI clock master. 
+//  A hardware Timeout wakes up the clock thread when the next 
+//  clock is due, the clock goes out and to the looper.  Incoming 
+//  clock is ignored.  Define CLOCK_MASTER to enable, the controls 
+//  are on CC 84..86: start/stop, tempo (40 + value BPM) and swing 
+//  (50..75%). 
+/////////////////////////////////////////////////////////////////
+#include "MidiClock.hpp"
+
+const uint8_t clockCtlStartStop = 84; 
+const uint8_t clockCtlTempo = 85; 
+const uint8_t clockCtlSwing = 86; 
+
+void clock_master_out(const UmpEvent &event) 
+{
+	midi_send(event); 
+#if MIDI_LOOPER 
+	looper_realtime(event.Status()); 
+#endif 
+#if MELODY_ENGINE 
+	melody_realtime(event.Status()); 
+#endif 
+}
+
+#if MELODY_ENGINE 
+MidiClock clockMasterGlob(&clock_master_out, &melody_step); 
+#else 
+MidiClock clockMasterGlob(&clock_master_out); 
+#endif 
+Mutex clockMasterMutexGlob; 
+Timeout clockTimeoutGlob; 
+
+uint64_t clock_now() 
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			pipelineTimeGlob.elapsed_time()).count(); 
+}
+
+/** 
+ * Wakes up the clock thread, called from the Timeout interrupt 
+ * and after the transport or tempo was changed. 
+ */
+void clock_wake() 
+{
+	PipelineEvent *item = clockMailGlob.try_alloc(); 
+	if (item == nullptr) {
+		clockStatsGlob.Dropped(); 
+		return; 
+	}
+	item->event = UmpEvent(); 
+	item->stamp = pipeline_now(); 
+	clockStatsGlob.Posted(); 
+	clockMailGlob.put(item); 
+}
+
+/** 
+ * Buttons send 127 when pressed, returns true when the 
+ * controller belongs to the clock. 
+ */
+bool clock_control(uint8_t controller, uint8_t value) 
+{
+	if (controller < clockCtlStartStop || controller > clockCtlSwing) {
+		return false; 
+	}
+	clockMasterMutexGlob.lock(); 
+	switch (controller) {
+		case clockCtlStartStop: 
+			if (value < 64) {
+				break; 
+			}
+			if (clockMasterGlob.Running()) {
+				clockMasterGlob.Stop(); 
+			}
+			else {
+				clockMasterGlob.Start(clock_now()); 
+			}
+			break; 
+		case clockCtlTempo: 
+			clockMasterGlob.SetTempo((40 + value) * 1000); 
+			break; 
+		case clockCtlSwing: 
+			clockMasterGlob.SetSwing(50 + value * 25 / 127); 
+			break; 
+	}
+	char text[LcdFrameBuffer::columns + 1]; 
+	snprintf(text, sizeof(text), "%3luBPM", 
+			(unsigned long)(clockMasterGlob.Tempo() / 1000)); 
+	clockMasterMutexGlob.unlock(); 
+	lcdGlob.Print(1, 0, text, false); 
+	clock_wake(); 
+	return true; 
+}
+#endif // CLOCK_MASTER 
+
+/** 
+ * Generated notes (chords, harmonies) are played through these, on 
+ * CH1 or with MPE_OUTPUT each on its own member channel. 
+ */
+void voice_note_on(uint8_t note, uint8_t velocity) 
+{
+#if MPE_OUTPUT 
+	uint8_t stolen; 
+	mpeMutexGlob.lock(); 
+	uint8_t channel = mpeGlob.NoteOn(note, stolen); 
+	mpeMutexGlob.unlock(); 
+	if (channel == MpeAllocator::none) {
+		return; 
+	}
+	if (stolen != MpeAllocator::none) {
+		midi_send(UmpEvent::Midi1(0x80 | channel, stolen, 0)); 
+	}
+	midi_send(UmpEvent::Midi1(0x90 | channel, note, velocity)); 
+#else 
+	midi_send(UmpEvent::Midi1(0x90, note, velocity)); 
+#endif 
+}
+
+void voice_note_off(uint8_t note, uint8_t velocity) 
+{
+#if MPE_OUTPUT 
+	mpeMutexGlob.lock(); 
+	uint8_t channel = mpeGlob.NoteOff(note); 
+	mpeMutexGlob.unlock(); 
+	if (channel != MpeAllocator::none) {
+		midi_send(UmpEvent::Midi1(0x80 | channel, note, velocity)); 
+	}
+#else 
+	midi_send(UmpEvent::Midi1(0x80, note, velocity)); 
+#endif 
+}
+
 /////////////////////////////////////////////////////////////////
 //  MIDI callback functions  
 //  TODO: need to find a more C++ way of doing this with 
 //        delegates. 
+//  SerialMidi calls these in the RX thread, they only queue the 
+//  message for the transform (or clock) thread. 
 /////////////////////////////////////////////////////////////////
 void midi_note_on_handler(uint8_t note, uint8_t velocity) {
-	printf("midi_note_on_handler(%d, %d)\n", note, velocity);
+	rxEventsGlob++; 
+	pipeline_post(transformMailGlob, transformStatsGlob, 
+			UmpEvent::Midi1(0x90, note, velocity)); 
+}
 
-	Scale scl(Scale::TypeOfScale::HARMONIC_MINOR, note); 
-	uint8_t i, j; 
-	uint8_t midi_note = note; 
-
-	// Velocity decided on the chord quality. 
-	if (velocity > 127 ) return; 
- 	if (velocity >= 0 && velocity < 16 ) 	chordTypeGlob = Chord::Type::MAJOR;	
-	if (velocity >= 16 && velocity < 32)	chordTypeGlob = Chord::Type::MINOR;
-	if (velocity >= 32 && velocity < 48) 	chordTypeGlob = Chord::Type::AUGMENTED;
-	if (velocity >= 48 && velocity < 64) 	chordTypeGlob = Chord::Type::DIMINISHED_7;
-	if (velocity>= 64 && velocity < 80) 	chordTypeGlob = Chord::Type::MINOR_7_FLAT5;
-	if (velocity >= 80 && velocity < 96) 	chordTypeGlob = Chord::Type::DOMINANT_7_ADD9_SHARP11;
-	if (velocity >= 96 && velocity < 112) 	chordTypeGlob = Chord::Type::DOMINANT_7_ADD9_FLAT5;
-	if (velocity >= 112 && velocity < 128) 	chordTypeGlob = Chord::Type::SUS4;
-	
+void midi_note_off_handler(uint8_t note, uint8_t velocity) {
+	rxEventsGlob++; 
+	pipeline_post(transformMailGlob, transformStatsGlob, 
+			UmpEvent::Midi1(0x80, note, velocity)); 
+}
 
-#if 0	// Go through all the modes and notes of this scale 
-	for(auto mode: scl.modes) {
-		std::cout << mode.Name() << "\t"; 
-		for (auto note: mode.notes) {
-			std::cout << "\t"<< note.Name();
-			serialMidiGlob.NoteON(SerialMidi::CH1, note.number, velocity);
-			ThisThread::sleep_for(80ms);
-			serialMidiGlob.NoteOFF(SerialMidi::CH1, note.number, 100);
-			ThisThread::sleep_for(80ms);
-		}
-		std::cout << std::endl;
+void midi_control_change_handler(uint8_t controller, uint8_t value) {
+	rxEventsGlob++; 
+	pipeline_post(transformMailGlob, transformStatsGlob, 
+			UmpEvent::Midi1(0xB0, controller, value)); 
+}
+
+void midi_pitchwheel_handler(uint8_t valueLSB, uint8_t valueMSB)  {
+	rxEventsGlob++; 
+	pipeline_post(transformMailGlob, transformStatsGlob, 
+			UmpEvent::Midi1(0xE0, valueLSB, valueMSB)); 
+}
+
+void realtime_handler(uint8_t msg)
+{
+	rxEventsGlob++; 
+#if !CLOCK_MASTER 
+	// Active sensing is not passed on. 
+	if (msg == 0xfe) {
+		return; 
 	}
+	pipeline_post(clockMailGlob, clockStatsGlob, UmpEvent::Midi1(msg)); 
 #endif 
+}
+/////////////////////////////////////////////////////////////////
+
 
+/////////////////////////////////////////////////////////////////
+//  Transform stage, runs in thread_transform.  
+//  Scale quantize, chords and harmonies are in MidiTransform so 
+//  the same logic runs in the host simulator (sim/midisim.cpp). 
+/////////////////////////////////////////////////////////////////
+#include "MidiTransform.hpp"
 
-#if 1	// Play a Chord based on the root note given.  
-	//Chord chrd(Chord::Type::DIMINISHED_7, note, note);
-	// Chord played is based on the Modulation wheel. 
-	Chord chrd(chordTypeGlob, note, note);
-	for(auto note: chrd.voicing) {
-		serialMidiGlob.NoteON(SerialMidi::CH1, note.number, velocity);
+/** 
+ * The generated notes come out on channel 0 and go to the voices. 
+ */
+void voice_send(const UmpEvent &event) 
+{
+	if (event.Opcode() == 0x90) {
+		voice_note_on(event.Index(), event.Data2()); 
 	}
-	ThisThread::sleep_for(400ms);
-	// Make sure we also send a note off.... 
-	for(auto note: chrd.voicing) {
-		serialMidiGlob.NoteOFF(SerialMidi::CH1, note.number, 100);
+	else {
+		voice_note_off(event.Index(), event.Data2()); 
 	}
-#endif 
-
+}
 
-	return; 
+void chord_display(Chord &chrd) 
+{
+	lcdGlob.Print(0, 0, chrd.ShortText().c_str()); 
 }
 
-/*
- * Timer is declared global. 
- * as it needs be accessed from the MIDI thread. 
- */
+#if HARMONIZER	// Add diatonic intervals from the table above the note.  
+MidiTransform transformGlob(&voice_send, scaleQuantizeGlob, harmonizerGlob, 
+		voiceLeaderGlob, MidiTransform::HARMONIES); 
+#else	// Play a Chord based on the root note given.  
+MidiTransform transformGlob(&voice_send, scaleQuantizeGlob, harmonizerGlob, 
+		voiceLeaderGlob, MidiTransform::CHORDS); 
+#endif 
+
 using namespace std::chrono;
-Timer t;
+
+/** Tempo of the incoming clock in 1/1000 BPM and the last start, 
+ * stop or continue, main() prints them with the stage statistics. 
+ */
+volatile uint32_t clockInMilliBpmGlob; 
+volatile uint8_t clockInTransportGlob; 
 
 /** 
- * Called with realtime messages
+ * Called with realtime messages in the clock thread, 'stamp' is when 
+ * the RX thread took it (pipeline_now()) so the time it waited in the 
+ * queue does not show as tempo. 
  * do not use blocking calls!  
  */ 
-void realtime_handler(uint8_t msg)
+void clock_realtime(uint8_t msg, uint32_t stamp)
 {
+	HEAP_PROBE_SCOPE(REALTIME); 
 	static uint8_t midi_f8_counter; 
-	//static uint8_t midi_beat; 
-	uint16_t ppm24; 
-	long long bpm; 
+	static uint32_t beat_stamp; 
 	
+#if MIDI_LOOPER 
+	looper_realtime(msg); 
+#endif 
+#if MELODY_ENGINE 
+	melody_realtime(msg); 
+#endif 
 	if (msg == 0xf8) { 
 		if(midi_f8_counter == 23) {
-			//stat1 = true; 
-			t.stop(); 
-	 		bpm = 60000000 /  duration_cast<milliseconds>(t.elapsed_time()).count();
-			//sem_led.acquire(); 
-			 printf("%llu %llu\n", 
-			 		duration_cast<milliseconds>(t.elapsed_time()).count(),
-				//	duration_cast<microseconds>(t.elapsed_time()).count(),
-					bpm
-				 );
-			//sem_led.release(); 
+			uint32_t beat = stamp - beat_stamp; 
+			uint32_t bpm = beat ? (uint32_t)(60000000000ull / beat) : 0; 
+			clockInMilliBpmGlob = bpm; 
+			char text[LcdFrameBuffer::columns + 1]; 
+			snprintf(text, sizeof(text), "%3luBPM", (unsigned long)(bpm / 1000)); 
+			lcdGlob.Print(1, 0, text, false); 
 			midi_f8_counter = 0;
-			t.reset(); 
-			t.start();
-		}
-		else if(midi_f8_counter == 11 ) {
-			//stat1 = false; 
-			midi_f8_counter++; 
+			beat_stamp = stamp; 
 		}
 		else {
 			midi_f8_counter++;
@@ -155,8 +559,9 @@ void realtime_handler(uint8_t msg)
 		return; 
 	}
 	else {
-			printf("RT msg:%x\n", msg);
-			midi_f8_counter =0; 
+		clockInTransportGlob = msg; 
+		midi_f8_counter = 0; 
+		beat_stamp = stamp; 
 	}
 	return;
 }
@@ -164,87 +569,432 @@ void realtime_handler(uint8_t msg)
 
 
 
-void midi_note_off_handler(uint8_t note, uint8_t velocity) {
-	printf("midi_note_off_handler(%d, %d)\n", note, velocity);
-	return; 
+/** 
+ * One incoming channel message: the controllers for the clock and 
+ * the looper are taken out here, the rest goes to transformGlob. 
+ */
+void transform_event(const PipelineEvent &item) 
+{
+	const UmpEvent &event = item.event; 
+
+#if HEAP_PROBE 
+	if (event.Opcode() == 0xB0 && event.Index() == heapCtlReport) {
+		HeapProbe::Print(); 
+		return; 
+	}
+	HeapProbe::Scope heapProbeScope(HeapProbe::SiteOf(event.Status())); 
+#endif 
+	if (event.Opcode() == 0xB0) {
+#if CLOCK_MASTER 
+		if (clock_control(event.Index(), event.Data2())) {
+			return; 
+		}
+#endif 
+#if MIDI_LOOPER 
+		if (looper_control(event.Index(), event.Data2())) {
+			return; 
+		}
+#endif 
+#if MELODY_ENGINE 
+		if (melody_control(event.Index(), event.Data2())) {
+			return; 
+		}
+#endif 
+		char text[LcdFrameBuffer::columns + 1]; 
+		snprintf(text, sizeof(text), "CC%02X=%3d", event.Index(), event.Data2()); 
+		lcdGlob.Print(1, 8, text); 
+	}
+#if MIDI_LOOPER 
+	looper_input(event); 
+#endif 
+	transformGlob.Process(event, item.stamp); 
 }
+/////////////////////////////////////////////////////////////////
 
 
-void midi_control_change_handler(uint8_t controller, uint8_t value) {
-	printf("midi_control_change_handler(%2X, %2X)\n", controller, value);
-
-	if (value > 127 ) return; 
- 	if (value >= 0 && value < 16 ) 	chordTypeGlob = Chord::Type::MAJOR;	
-	if (value >= 16 && value < 32)	chordTypeGlob = Chord::Type::MINOR;
-	if (value >= 32 && value < 48) 	chordTypeGlob = Chord::Type::AUGMENTED;
-	if (value >= 48 && value < 64) 	chordTypeGlob = Chord::Type::DIMINISHED_7;
-	if (value >= 64 && value < 80) 	chordTypeGlob = Chord::Type::MINOR_7_FLAT5;
-	if (value >= 80 && value < 96) 	chordTypeGlob = Chord::Type::DOMINANT_7_ADD9_SHARP11;
-	if (value >= 96 && value < 112) chordTypeGlob = Chord::Type::DOMINANT_7_ADD9_FLAT5;
-	if (value >= 112 && value < 128) chordTypeGlob = Chord::Type::SUS4;
-	
-	return; 
+
+
+/////////////////////////////////////////////////////////////////
+//  MIDI output 
+/////////////////////////////////////////////////////////////////
+uint32_t midiSendDroppedGlob; 
+
+/** 
+ * Send one event through SerialMidi, this is where UMP events become 
+ * MIDI 1.0 bytes (MidiEncoder.hpp).  Only the TX thread calls this, 
+ * everybody else uses midi_send().  Events without a MIDI 1.0 form 
+ * are counted in midiSendDroppedGlob. 
+ */
+void midi_tx_encode(const UmpEvent &event) 
+{
+	if (!MidiEncoder::Send(serialMidiGlob, event)) {
+		midiSendDroppedGlob++; 
+	}
 }
 
 
-/**
- * Not all MIDI controllers use the LSB on the pitch bend. 
- * mid position == 0x2000 because this is a 14 bit value.  
- * we use a signed int16_t and simply substract to be 
- * able to present a human readable value  
+#if MPE_OUTPUT 
+/** 
+ * Send a channel message to every sounding MPE voice, the channel 
+ * of 'event' is replaced by the member channel of the voice. 
  */
-void midi_pitchwheel_handler(uint8_t valueLSB, uint8_t valueMSB)  {
-	int16_t pitch = (valueLSB + (valueMSB<<7)) - 0x2000; 
-	printf("midi_pitch_wheel_handler%2X %2X (%d)\n", valueLSB, valueMSB, pitch);
-	return; 
+void mpe_send_voices(const UmpEvent &event) 
+{
+	uint8_t channels[MpeAllocator::maxMembers]; 
+
+	mpeMutexGlob.lock(); 
+	unsigned int n = mpeGlob.ActiveChannels(channels); 
+	mpeMutexGlob.unlock(); 
+	for (unsigned int i = 0; i < n; i++) {
+		midi_send(event.WithChannel(channels[i])); 
+	}
 }
+#endif // MPE_OUTPUT 
+
+
+#if SMF_PLAYBACK 
+/////////////////////////////////////////////////////////////////
+//  Standard MIDI File playback straight from flash. 
+//  The player tells when the next event is due, a Timeout 
+//  (hardware timer) wakes up the thread at that time. 
+//  Define SMF_PLAYBACK to play the demo file at startup. 
 /////////////////////////////////////////////////////////////////
 
+// Type 1 file, tempo track (120 BPM, 150 BPM after 4 beats) and 
+// the GYPSY scale up and down from C3. 
+const uint8_t demoSmfGlob[] = {
+	0x4D, 0x54, 0x68, 0x64, 0x00, 0x00, 0x00, 0x06, 0x00, 0x01, 0x00, 0x02, 
+	0x00, 0x60, 0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00, 0x13, 0x00, 0xFF, 
+	0x51, 0x03, 0x07, 0xA1, 0x20, 0x83, 0x00, 0xFF, 0x51, 0x03, 0x06, 0x1A, 
+	0x80, 0x00, 0xFF, 0x2F, 0x00, 0x4D, 0x54, 0x72, 0x6B, 0x00, 0x00, 0x00, 
+	0x5F, 0x00, 0x90, 0x3C, 0x64, 0x30, 0x3C, 0x00, 0x00, 0x3E, 0x64, 0x30, 
+	0x3E, 0x00, 0x00, 0x3F, 0x64, 0x30, 0x3F, 0x00, 0x00, 0x42, 0x64, 0x30, 
+	0x42, 0x00, 0x00, 0x43, 0x64, 0x30, 0x43, 0x00, 0x00, 0x44, 0x64, 0x30, 
+	0x44, 0x00, 0x00, 0x47, 0x64, 0x30, 0x47, 0x00, 0x00, 0x48, 0x64, 0x30, 
+	0x48, 0x00, 0x00, 0x47, 0x64, 0x30, 0x47, 0x00, 0x00, 0x44, 0x64, 0x30, 
+	0x44, 0x00, 0x00, 0x43, 0x64, 0x30, 0x43, 0x00, 0x00, 0x42, 0x64, 0x30, 
+	0x42, 0x00, 0x00, 0x3F, 0x64, 0x30, 0x3F, 0x00, 0x00, 0x3E, 0x64, 0x30, 
+	0x3E, 0x00, 0x00, 0x3C, 0x64, 0x30, 0x3C, 0x00, 0x00, 0xFF, 0x2F, 0x00
+}; 
+
+SmfPlayer smfPlayerGlob(&midi_send); 
+EventFlags smfFlagsGlob; 
+Timeout smfTimeoutGlob; 
+Thread thread_smf(osPriorityAboveNormal, 2048); 
+
+void smf_timeout_isr() 
+{
+	smfFlagsGlob.set(1); 
+}
 
+void smf_thread() 
+{
+	if (!smfPlayerGlob.Open(demoSmfGlob, sizeof(demoSmfGlob))) {
+		printf("SMF: not a type 0/1 MIDI file\n"); 
+		return; 
+	}
+	Timer clock; 
+	clock.start(); 
+	while (!smfPlayerGlob.Finished()) {
+		uint64_t next = smfPlayerGlob.NextEventTime(); 
+		uint64_t now = duration_cast<microseconds>(clock.elapsed_time()).count(); 
+		if (next > now) {
+			smfTimeoutGlob.attach(&smf_timeout_isr, 
+					microseconds(next - now)); 
+			smfFlagsGlob.wait_any(1); 
+			now = duration_cast<microseconds>(clock.elapsed_time()).count(); 
+		}
+		smfPlayerGlob.Play(now); 
+	}
+	const SmfPlayer::Timing &timing = smfPlayerGlob.Stats(); 
+	printf("SMF: %lu events, %lu skipped, late max %lu us avg %lu us\n", 
+			(unsigned long)timing.events, (unsigned long)timing.skipped, 
+			(unsigned long)timing.maxLate, 
+			(unsigned long)(timing.events ? 
+				timing.totalLate / timing.events : 0)); 
+}
+#endif // SMF_PLAYBACK 
 
 
+#if MIDI_LOOPER 
 /////////////////////////////////////////////////////////////////
-// Threads 
+//  Recorder and looper. 
+//  Everything played in is kept in recorderGlob (1 tick = 1 ms), 
+//  the looper records layers in sync with the incoming MIDI clock. 
+//  Define MIDI_LOOPER to enable, the controls are on CC 80..83: 
+//  record/overdub, undo, clear and export of the recorder as a 
+//  Standard MIDI File (hex dump on the console). 
 /////////////////////////////////////////////////////////////////
-Thread thread_midi_tx;
+const uint8_t looperCtlRecord = 80; 
+const uint8_t looperCtlUndo = 81; 
+const uint8_t looperCtlClear = 82; 
+const uint8_t looperCtlExport = 83; 
+const uint32_t looperFlagExport = 1; 
+
+uint8_t recorderStorageGlob[32 * 1024]; 
+EventRing recorderGlob(recorderStorageGlob, sizeof(recorderStorageGlob)); 
+uint8_t looperStorageGlob[16 * 1024]; 
+MidiLooper looperGlob(looperStorageGlob, sizeof(looperStorageGlob), 
+		&midi_send); 
+Mutex looperMutexGlob; 
+EventFlags looperFlagsGlob; 
+Timer looperTimeGlob; 
+bool recorderPausedGlob; 
+Thread thread_looper(osPriorityAboveNormal, 4096); 
+
+static uint64_t looper_now() 
+{
+	return duration_cast<microseconds>(looperTimeGlob.elapsed_time()).count(); 
+}
 
+void looper_input(const UmpEvent &event) 
+{
+	uint8_t msg[3]; 
+	size_t len = event.ToBytes(msg); 
+	uint64_t now = looper_now(); 
+	looperMutexGlob.lock(); 
+	if (!recorderPausedGlob && len > 0) {
+		recorderGlob.Append((uint32_t)(now / 1000), msg, len); 
+	}
+	looperGlob.Input(event, now); 
+	looperMutexGlob.unlock(); 
+}
 
-void led1_thread()
+void looper_realtime(uint8_t msg) 
 {
-    while (true) {
-       	ThisThread::sleep_for(1ms);
-    }
+	looperMutexGlob.lock(); 
+	looperGlob.Realtime(msg, looper_now()); 
+	looperMutexGlob.unlock(); 
+}
+
+/** 
+ * Buttons send 127 when pressed, returns true when the 
+ * controller belongs to the looper. 
+ */
+bool looper_control(uint8_t controller, uint8_t value) 
+{
+	if (controller < looperCtlRecord || controller > looperCtlExport) {
+		return false; 
+	}
+	if (value < 64) {
+		return true; 
+	}
+	looperMutexGlob.lock(); 
+	switch (controller) {
+		case looperCtlRecord: 
+			looperGlob.Record(looper_now()); 
+			break; 
+		case looperCtlUndo: 
+			looperGlob.Undo(); 
+			break; 
+		case looperCtlClear: 
+			looperGlob.Clear(); 
+			break; 
+		case looperCtlExport: 
+			looperFlagsGlob.set(looperFlagExport); 
+			break; 
+	}
+	printf("looper: state %d, %u layers, %u ticks, %u bytes\n", 
+			looperGlob.GetState(), looperGlob.NumOfLayers(), 
+			(unsigned int)looperGlob.Length(), 
+			(unsigned int)looperGlob.Bytes()); 
+	looperMutexGlob.unlock(); 
+	return true; 
 }
 
-void led2_thread()
+/** 
+ * The console is a text stream, the file is sent as hex 
+ * 32 bytes per line (xxd -r -p turns it back into a file). 
+ */
+void smf_hex_out(const uint8_t *data, size_t len) 
 {
-	DigitalOut led2(LED2);
-	led2 =1; 
-	
-    while (true) {
-		//sem_led.acquire();
-        printf("2");
-		//pc.write("2",1);
-		//sem_led.release();
-        ThisThread::sleep_for(10ms);
-    }
+	static unsigned int column; 
+	for (size_t i = 0; i < len; i++) {
+		printf("%02X", data[i]); 
+		if (++column == 32) {
+			printf("\n"); 
+			column = 0; 
+		}
+	}
+}
+
+void looper_thread() 
+{
+	looperTimeGlob.start(); 
+	while (true) {
+		looperMutexGlob.lock(); 
+		looperGlob.Play(looper_now()); 
+		looperMutexGlob.unlock(); 
+
+		if (looperFlagsGlob.get() & looperFlagExport) {
+			looperFlagsGlob.clear(looperFlagExport); 
+			// Printing takes seconds, the recorder pauses meanwhile 
+			// so the rest of the firmware is not held up. 
+			looperMutexGlob.lock(); 
+			recorderPausedGlob = true; 
+			looperMutexGlob.unlock(); 
+			printf("SMF begin, %u events\n", 
+					(unsigned int)recorderGlob.Events()); 
+			size_t bytes = recorderGlob.WriteSmf(&smf_hex_out, 500, 500000); 
+			printf("\nSMF end, %u bytes\n", (unsigned int)bytes); 
+			looperMutexGlob.lock(); 
+			recorderPausedGlob = false; 
+			looperMutexGlob.unlock(); 
+		}
+		ThisThread::sleep_for(1ms); 
+	}
+}
+#endif // MIDI_LOOPER 
+
+
+/////////////////////////////////////////////////////////////////
+// Threads 
+// From high to low priority: 
+//   clock      realtime messages, must never wait for the others 
+//   midi_rx    SerialMidi receive parser, queues what comes in 
+//   midi_tx    the only writer to SerialMidi 
+//   transform  chords, harmonies, looper input 
+//   control    ADCs and sensors 
+//   lcd        display refresh 
+// Stack budgets are sized for printf plus the stage's own work. 
+/////////////////////////////////////////////////////////////////
+Thread thread_clock(osPriorityRealtime, 2048);
+Thread thread_midi_rx(osPriorityHigh, 2048);
+Thread thread_midi_tx(osPriorityAboveNormal1, 2048);
+Thread thread_transform(osPriorityAboveNormal, 6144);
+Thread thread_control(osPriorityNormal, 4096);
+Thread thread_lcd(osPriorityLow, 2048);
+
+/** 
+ * Follows the incoming clock, or with CLOCK_MASTER generates it: 
+ * every wake up sends what is due and sets the Timeout for the 
+ * next clock.  The stage latency is the Timeout to thread delay. 
+ */
+void clock_thread() 
+{
+	PipelineEvent item; 
+
+#if CLOCK_MASTER 
+	clockMasterMutexGlob.lock(); 
+	clockMasterGlob.Start(clock_now()); 
+	clockMasterMutexGlob.unlock(); 
+	clock_wake(); 
+#endif 
+	while (true) {
+		if (!pipeline_take(clockMailGlob, clockStatsGlob, item)) {
+			continue; 
+		}
+#if CLOCK_MASTER 
+		clockMasterMutexGlob.lock(); 
+		clockMasterGlob.Run(clock_now()); 
+		if (clockMasterGlob.Running()) {
+			uint64_t now = clock_now(); 
+			uint64_t next = clockMasterGlob.NextEventTime(); 
+			clockTimeoutGlob.attach(&clock_wake, 
+					std::chrono::microseconds(next > now ? next - now : 0)); 
+		}
+		clockMasterMutexGlob.unlock(); 
+#else 
+		clock_realtime(item.event.Status(), item.stamp); 
+#endif 
+	}
 }
 
+/** 
+ * BufferedSerial receives in its interrupt, ReceiveParser() takes 
+ * the bytes from there.  When a pass produced nothing the thread 
+ * sleeps a tick so the lower priorities get to run. 
+ */
+void midi_rx_thread() 
+{
+    // Green stat2 LED toggles with every pass. 
+    DigitalOut stat2(PTC2);
 
+	while (true) {
+		uint32_t events = rxEventsGlob; 
+		stat2 = !stat2; 
+		serialMidiGlob.ReceiveParser();
+		if (events == rxEventsGlob) {
+			ThisThread::sleep_for(1ms); 
+		}
+	}
+}
 
+/** 
+ * Notes go out before controllers and controller updates that are 
+ * still waiting are replaced by newer ones, at no more than the 
+ * DIN wire rate (31250 baud = 3125 bytes/s). 
+ */
+TxScheduler txSchedulerGlob(wireBytesPerSecond, wireBurstBytes); 
 
 void midi_tx_thread() 
 {
-	uint16_t b2in_value; 
-	uint8_t	prev_b2in_value;
-	
-	uint16_t b3in_value;
-	uint8_t  prev_b3in_value; 
+	PipelineEvent item; 
+	UmpEvent event; 
+
+	while (true) {
+		// Wait for more only while there is nothing the wire can 
+		// take, then move everything queued into the scheduler. 
+		uint32_t wait = txSchedulerGlob.Wait(pipeline_now()); 
+		Kernel::Clock::duration_u32 timeout = (wait == TxScheduler::forever) ? 
+			Kernel::wait_for_u32_forever : 
+			Kernel::Clock::duration_u32((wait + 999) / 1000); 
+		while (pipeline_take(txMailGlob, txStatsGlob, item, timeout)) {
+			txSchedulerGlob.Post(item.event, item.stamp); 
+			timeout = 0ms; 
+		}
+		while (txSchedulerGlob.Next(pipeline_now(), event)) {
+			midi_tx_encode(event); 
+		}
+	}
+}
 
-	uint16_t ribbon_value;
-	uint8_t prev_ribbon_value;
-	
+/** 
+ * Waits for the next event, or until the next generated note has 
+ * to be released. 
+ */
+void transform_thread() 
+{
+	PipelineEvent item; 
+
+	transformGlob.SetChordHandler(&chord_display); 
+	while (true) {
+		Kernel::Clock::duration_u32 timeout = Kernel::wait_for_u32_forever; 
+		if (transformGlob.Pending()) {
+			int32_t wait = (int32_t)(transformGlob.NextReleaseTime() - pipeline_now()); 
+			timeout = Kernel::Clock::duration_u32(wait > 0 ? (wait + 999) / 1000 : 0); 
+		}
+		if (pipeline_take(transformMailGlob, transformStatsGlob, item, timeout)) {
+			transform_event(item); 
+		}
+		transformGlob.Release(pipeline_now()); 
+	}
+}
+
+/** 
+ * Every LCD character is a blocking I2C transaction, this thread 
+ * sends what changed in lcdGlob at most 20 times a second and at 
+ * most lcdMaxChars characters at a time. 
+ */
+const unsigned int lcdMaxChars = 8; 
+
+void lcd_thread()
+{
+	I2cLcd i2clcd;
+
+	i2clcd.move_cursor_line1();
+	i2clcd.write(RETURN_HOME);
+	while (true) {
+		lcdGlob.Flush(i2clcd, lcdMaxChars); 
+		ThisThread::sleep_for(50ms);
+	}
+}
+
+
+void control_thread() 
+{
 	uint16_t prev_tmp; 
+	uint16_t prev_bend = 0x2000; 
 	uint16_t tmp; 
 	int16_t tmpsig; 
 	uint8_t tmp8_t;
@@ -268,29 +1018,44 @@ void midi_tx_thread()
 	pc.set_baud(115200);
 
 	// Built in magneto and gyro chip of the NXP FRDM board 
-	//FXOS8700CQ magneto(PTE25, PTE24, FXOS8700CQ_SLAVE_ADDR1);
-	//magneto.enable();
+#if MAGNETO_SENSOR 
+	if (!motionSensorGlob.Start(MotionSensor::HZ_200)) {
+		printf("FXOS8700CQ not found\n"); 
+	}
+#endif 
 
 
-	//Scale scl(Scale::ScaleKinds::HARMONIC_MINOR, 0); 
-	Scale  scl(Scale::TypeOfScale::HARMONIC_MINOR, 0); 
+	// Fixed scales are worked out by the compiler (StaticScale.hpp). 
+	scaleQuantizeGlob.SetScale(StartScale::PitchClasses(0)); 
+	harmonizerGlob.SetScale(StartScale::PitchClasses(0)); 
+#if MELODY_ENGINE 
+	melodyMutexGlob.lock(); 
+	melodyGlob.SetScale(StartScale::PitchClasses(0)); 
+	melodyMutexGlob.unlock(); 
+#endif 
 
 	uint8_t i, j; 
 	uint8_t midi_note = 60; 
+
+#if MPE_OUTPUT 
+	// Tell the receiver which channels are the MPE zone. 
+	UmpEvent mcm[3]; 
+	mpeGlob.ConfigurationMessage(mcm); 
+	for (i = 0; i < 3; i++) {
+		midi_send(mcm[i]); 
+	}
+#endif 
 	
 	// Trying out the new type of scale. 
-	//Scale scl2(Scale2::TypeOfScale::GYPSY, 60);
-	Scale scl2(Scale::TypeOfScale::GYPSY, 60);
+	typedef StaticScale<Scale::TypeOfScale::GYPSY, 60> Gypsy; 
 
-	for(auto mode: scl2.modes) {
-		for (auto note: mode.notes) {
-			//std::cout << "\t"<< note.Name();
-			serialMidiGlob.NoteON(SerialMidi::CH1, note.number, 100);
+	for(auto &mode: Gypsy::modes) {
+		for (auto note: mode) {
+			midi_send(UmpEvent::Midi1(0x90, note, 100)); 
 			ThisThread::sleep_for(200ms);
-			serialMidiGlob.NoteOFF(SerialMidi::CH1, note.number, 100);
+			midi_send(UmpEvent::Midi1(0x80, note, 100)); 
 			ThisThread::sleep_for(100ms);
 		}
-		//std::cout << std::endl;
 	}
 
 #if 0 
@@ -312,82 +1077,88 @@ void midi_tx_thread()
 #endif 
 
 
+	// Every analog input has its own filter, dt is the time between 
+	// two passes of the loop. 
+	ControllerInput b2inControl(analogControls[0].status, 
+			analogControls[0].controller, adcFilterParameters); 
+	ControllerInput b3inControl(analogControls[1].status, 
+			analogControls[1].controller, adcFilterParameters); 
+	ControllerInput ribbonControl(analogControls[2].status, 
+			analogControls[2].controller, adcFilterParameters); 
+	UmpEvent event; 
+	Timer loopTimer; 
+	loopTimer.start(); 
+
 	/** Tx thread should never end. 
 	 */
 	while(true ) {
+		uint32_t dt = duration_cast<microseconds>(loopTimer.elapsed_time()).count(); 
+		loopTimer.reset(); 
 		/*
 		* MIDI TX processing 
 		* run in a seperate thread (transmission) as MIDI is full duplex.  
 		*/
 
 		// A0 potmeter on MIDI shield 
-		tmp = b2in.read_u16(); 
-		// We shift right 9 because MIDI only uses 7 bits (16-9 = 7)
-		tmp = (uint8_t)(MIDI_DATA & (tmp >>9)); 
-		if (prev_b2in_value != tmp) {
-			serialMidiGlob.ControlChange(SerialMidi::CH3, 
-									SerialMidi::CTL_MSB_BREATH, 
-									(uint8_t)tmp);
-			prev_b2in_value = tmp; 
+		if (b2inControl.Update(b2in.read_u16(), dt, event)) {
+			midi_send(event); 
 		}
-
+#if MPE_OUTPUT 
+		// Breath is the pressure of every sounding voice. 
+		mpe_send_voices(UmpEvent::Midi1(0xD0, b2inControl.Value())); 
+#endif 
 
 		// A1 potmeter on MIDI shield 
-		tmp = b3in.read_u16(); 
-		// We shift right 9 because MIDI only uses 7 bits (16-9 = 7)
-		tmp = (uint8_t)(MIDI_DATA & (tmp >>9)); 
-		if (prev_b3in_value != tmp) {
-			serialMidiGlob.ControlChange(SerialMidi::CH3, 
-									SerialMidi::CTL_MSB_EXPRESSION, 
-									(uint8_t)tmp);
-			prev_b3in_value = tmp; 
+		if (b3inControl.Update(b3in.read_u16(), dt, event)) {
+			midi_send(event); 
 		}
 
 		// Ribbon 
-		tmp = ribbon.read_u16(); 
-		// We shift right 9 because MIDI only uses 7 bits (16-9 = 7)
-		tmp = (uint8_t)(MIDI_DATA & (tmp >>9)); 
-		if (prev_ribbon_value != tmp) {
-			serialMidiGlob.ControlChange(SerialMidi::CH3, 
-									SerialMidi::CTL_MSB_MODWHEEL, 
-									(uint8_t)tmp);
-			prev_ribbon_value = tmp; 
+		if (ribbonControl.Update(ribbon.read_u16(), dt, event)) {
+			midi_send(event); 
 		}
 
 
 		// Magneto sensor   
 #if MAGNETO_SENSOR 
-		magneto.get_data();
-		// 16 bit signed
-		//printf("32768 -32768 "); 
-#if 0 
-		printf("%04d %04d %04d ", 
-			magneto.getMagnetX(),  
-			magneto.getMagnetY(), 
-			magneto.getMagnetZ());
-		// 14 bit signed
-#endif 
-#if 0 	
-		printf("%04d %04d %04d \r\n", 
-			magneto.getAccelX(),
-			magneto.getAccelY(),
-			magneto.getAccelZ());
+		// Every queued sample goes through the fusion, pitch is 
+		// sent as pitch bend and roll as modulation on channel 2. 
+		bool haveSample = false; 
+		while (MotionSample *sample = motionSensorGlob.mail.try_get()) {
+			motionFusionGlob.Update(sample->accel, sample->magnet); 
+			haveSample = true; 
+			motionSensorGlob.mail.free(sample); 
+		}
+		if (haveSample) {
+			const MotionFusion::Orientation &orientation = motionFusionGlob.Get(); 
+			uint16_t bend = pitchBendCurveGlob.Map(orientation.pitch); 
+			tmp = modulationCurveGlob.Map(orientation.roll) >> 7; 
+#if MPE_OUTPUT 
+			// Per voice: pitch bend and timbre (CC74) on every 
+			// sounding member channel. 
+			mpe_send_voices(UmpEvent::PitchBend(0, 
+						UmpEvent::ScaleUp(bend, 14, 32))); 
+			mpe_send_voices(UmpEvent::Midi1(0xB0, 74, (uint8_t)tmp)); 
+#else 
+			if (prev_bend != bend) {
+				midi_send(UmpEvent::PitchBend(1, UmpEvent::ScaleUp(bend, 14, 32))); 
+				prev_bend = bend; 
+			}
+			// Only send out if there is a change in value 
+			if (prev_tmp != tmp ) {
+				midi_send(UmpEvent::Midi1(0xB0 | SerialMidi::CH2, 
+										SerialMidi::CTL_MSB_MODWHEEL, tmp)); 
+				prev_tmp = tmp; 
+			} 
 #endif 
-		tmpsig = magneto.getMagnetZ(); 
-		tmp = MIDI_DATA & ((tmpsig + 8192) >>4); 
-
-		// Only send out if there is a change in value 
-		if (prev_tmp != tmp ) {
-			serialMidiGlob.ControlChange(SerialMidi::CH2, 
-									SerialMidi::CTL_MSB_MODWHEEL, 
-									tmp);
-			prev_tmp = tmp; 
-		} 
+		}
 #endif // MAGNETO_SENSOR 
 
 		// Limit the amount of MIDI messages to something 
 		// a human will not notice the intervals. 
-		ThisThread::sleep_for(30ms); 
+		uint32_t due = pipeline_now() + controlPeriod; 
+		ThisThread::sleep_for(microseconds(controlPeriod)); 
+		controlStatsGlob.Woke((int32_t)(pipeline_now() - due)); 
 	}	
 }
 
@@ -405,14 +1176,9 @@ int main()
 	uint16_t b2in_value; 
 	uint16_t b3in_value; 
 	uint16_t tmp; 
- 	I2cLcd i2clcd;
 
-	i2clcd.move_cursor_line1();
-	i2clcd.write(RETURN_HOME);
-	i2clcd.putchar('J');
-	i2clcd.putchar('-');
-	i2clcd.putchar('W');
-	//i2clcd.printf("Hello\n"); 
+	lcdGlob.Print(0, 0, "J-W");
+	thread_lcd.start(lcd_thread);
 
 
 	// I prefer the USB console port of the mbed to be 115200
@@ -423,23 +1189,44 @@ int main()
 	std::cout << "MIDImon K64 by Jan-Willem Smaal <usenet@gispen.org>";
 	std::cout << std::endl;
 
-    // Initialise the digital pin STAT2 as an output
-    DigitalOut stat2(PTC2);
-
-	// All tests complete start the threads. 
-//	thread_led1.start(led1_thread);
-	//thread_midi_tx.start(midi_tx_thread);
-	thread_midi_tx.start(midi_tx_thread);
+	// The diatonic chord tables are only read by the threads. 
+	ChordProgression::Precompute(); 
+
+	// All tests complete start the threads, consumers first. 
+	pipelineTimeGlob.start(); 
+	thread_clock.start(clock_thread); 
+	thread_midi_tx.start(midi_tx_thread); 
+	thread_transform.start(transform_thread); 
+	thread_control.start(control_thread); 
+	thread_midi_rx.start(midi_rx_thread); 
+#if SMF_PLAYBACK 
+	thread_smf.start(smf_thread); 
+#endif 
+#if MIDI_LOOPER 
+	thread_looper.start(looper_thread); 
+#endif 
 
+	// Queue depth and latency of the pipeline stages. 
     while (true) {
-		// Toggle green stat2 LED.  
-		stat2 = !stat2; 
-			
-		/* 
-		 * MIDI RX processing 
-		 */
-		serialMidiGlob.ReceiveParser();
-
+		ThisThread::sleep_for(pipelineStatsInterval); 
+		clockStatsGlob.Print(); 
+		transformStatsGlob.Print(); 
+		txStatsGlob.Print(); 
+		controlStatsGlob.Print(); 
+		const TxScheduler::Statistics &tx = txSchedulerGlob.Stats(); 
+		printf("wire      %8lu sent %6lu bytes %6lu coalesced %4lu dropped "
+				"late notes %5lu cc %6lu us\n", 
+				(unsigned long)tx.sent, (unsigned long)tx.bytes, 
+				(unsigned long)tx.coalesced, (unsigned long)tx.dropped, 
+				(unsigned long)tx.urgentLatencyMax, 
+				(unsigned long)tx.continuousLatencyMax); 
+		txSchedulerGlob.ClearPeaks(); 
+#if !CLOCK_MASTER 
+		printf("clock in  %4lu.%03lu BPM last transport %02X\n", 
+				(unsigned long)(clockInMilliBpmGlob / 1000), 
+				(unsigned long)(clockInMilliBpmGlob % 1000), 
+				clockInTransportGlob); 
+#endif 
 	}  // End of while(1) loop 
 	
 	return 0;
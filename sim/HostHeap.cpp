@@ -0,0 +1,61 @@
+/** @file HostHeap.cpp
+ *
+ * heap_counters() on a host: operator new and delete are replaced by
+ * ones that count, every block has its size in a header in front of
+ * it.  Link this into a simulator to use HeapProbe (HEAP_PROBE=1).
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "HeapProbe.hpp"
+
+
+static const size_t header = alignof(std::max_align_t);
+static HeapCounters countersGlob;
+
+
+void *operator new(size_t size)
+{
+	uint8_t *block = (uint8_t *)malloc(size + header);
+	if (block == nullptr) {
+		abort();
+	}
+	*(size_t *)block = size;
+	countersGlob.allocs++;
+	countersGlob.bytes += size;
+	countersGlob.current += size;
+	if (countersGlob.current > countersGlob.peak) {
+		countersGlob.peak = countersGlob.current;
+	}
+	return block + header;
+}
+
+
+void operator delete(void *p) noexcept
+{
+	if (p == nullptr) {
+		return;
+	}
+	uint8_t *block = (uint8_t *)p - header;
+	countersGlob.current -= *(size_t *)block;
+	free(block);
+}
+
+
+void operator delete(void *p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+
+void heap_counters(HeapCounters &counters)
+{
+	counters = countersGlob;
+}
+
+
+/* EOF */
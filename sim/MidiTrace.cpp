@@ -0,0 +1,133 @@
+/** @file MidiTrace.cpp
+ *
+ * A recorded MIDI session.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstring>
+#include "MidiTrace.hpp"
+
+
+static const char magic[4] = {'M', 'T', 'R', 'C'};
+
+
+void MidiTrace::Number(uint64_t value) {
+	uint8_t buf[10];
+	unsigned int n = 0;
+
+	do {
+		buf[n++] = value & 0x7F;
+		value >>= 7;
+	} while (value);
+	while (n > 1) {
+		records.push_back(buf[--n] | 0x80);
+	}
+	records.push_back(buf[0]);
+}
+
+
+void MidiTrace::Add(uint64_t now, const uint8_t *data, size_t len) {
+	if (len == 0) {
+		return;
+	}
+	Number(now > time ? now - time : 0);
+	Number(len);
+	records.insert(records.end(), data, data + len);
+	if (now > time) {
+		time = now;
+	}
+}
+
+
+bool MidiTrace::Save(const char *path) const {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	bool ok = fwrite(magic, sizeof(magic), 1, file) == 1
+		&& fputc(version, file) != EOF
+		&& fwrite(records.data(), 1, records.size(), file) == records.size();
+	return fclose(file) == 0 && ok;
+}
+
+
+bool MidiTrace::Load(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	char header[sizeof(magic) + 1];
+	bool ok = fread(header, sizeof(header), 1, file) == 1
+		&& memcmp(header, magic, sizeof(magic)) == 0
+		&& header[sizeof(magic)] == version;
+	records.clear();
+	uint8_t buf[4096];
+	size_t n;
+	while (ok && (n = fread(buf, 1, sizeof(buf), file)) > 0) {
+		records.insert(records.end(), buf, buf + n);
+	}
+	fclose(file);
+
+	// Add() goes on after the last chunk.
+	Reader reader(*this);
+	const uint8_t *data;
+	size_t len;
+	time = 0;
+	while (reader.Next(time, data, len)) {
+	}
+	return ok;
+}
+
+
+uint64_t MidiTrace::Duration() const {
+	Reader reader(*this);
+	uint64_t now, end = 0;
+	const uint8_t *data;
+	size_t len;
+
+	while (reader.Next(now, data, len)) {
+		end = now + len * byteTime;
+	}
+	return end;
+}
+
+
+bool MidiTrace::Reader::Number(uint64_t &value) {
+	value = 0;
+	for (unsigned int n = 0; n < 10; n++) {
+		if (position == trace.records.size()) {
+			return false;
+		}
+		uint8_t byte = trace.records[position++];
+		value = value << 7 | (byte & 0x7F);
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool MidiTrace::Reader::Next(uint64_t &now, const uint8_t *&data, size_t &len) {
+	uint64_t delta, length;
+	size_t start = position;
+
+	if (!Number(delta) || !Number(length)
+		|| length > trace.records.size() - position) {
+		// A truncated last record is left out.
+		position = start;
+		return false;
+	}
+	time += delta;
+	now = time;
+	data = trace.records.data() + position;
+	len = length;
+	position += length;
+	return true;
+}
+
+
+/* EOF */
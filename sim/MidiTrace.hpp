@@ -0,0 +1,82 @@
+/** @file MidiTrace.hpp
+ *
+ * A recorded MIDI session: the bytes as they came in with the time
+ * they came in.  The file is "MTRC", a version byte and then one
+ * record per chunk of input:
+ *
+ *   <us since the previous chunk> <length> <length bytes>
+ *
+ * with both numbers as variable length quantities (7 bits a byte,
+ * high bit set on all but the last, as in a Standard MIDI File).  A
+ * chunk is bytes that came in back to back at the wire rate (320 us
+ * a byte), its time is that of the first byte.  A busy stream is a
+ * few long chunks, sparse playing costs about two bytes a message.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef MidiTrace_hpp
+#define MidiTrace_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+class MidiTrace {
+public:
+	static const uint8_t version = 1;
+	static const uint32_t byteTime = 320;	// us, 31250 baud
+
+	MidiTrace() noexcept : time(0) {};
+
+	/** Bytes that came in back to back from 'now' on (us, from any
+	 * starting point, not going back).
+	 */
+	void Add(uint64_t now, const uint8_t *data, size_t len);
+
+	bool Save(const char *path) const;
+	/** Replaces what was recorded, false when it is not a trace.
+	 */
+	bool Load(const char *path);
+
+	/** Walks through the chunks of a trace.
+	 */
+	class Reader {
+	public:
+		Reader(const MidiTrace &traceArg) noexcept
+			: trace(traceArg), position(0), time(0) {};
+		/** The next chunk and the time of its first byte in us since
+		 * the start, false at the end.  'data' points into the trace.
+		 */
+		bool Next(uint64_t &now, const uint8_t *&data, size_t &len);
+		void Rewind() {
+			position = 0;
+			time = 0;
+		};
+
+	private:
+		bool Number(uint64_t &value);
+
+		const MidiTrace &trace;
+		size_t position;
+		uint64_t time;
+	};
+
+	/** Until the last byte has come in, us.
+	 */
+	uint64_t Duration() const;
+	size_t Size() const {
+		return records.size();
+	};
+
+private:
+	void Number(uint64_t value);
+
+	std::vector<uint8_t> records;
+	uint64_t time;		// Of the last chunk added.
+};
+
+
+#endif /* MidiTrace_hpp */
@@ -0,0 +1,214 @@
+/** @file SimPath.cpp
+ *
+ * The firmware's MIDI path on a host.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <time.h>
+#include <unistd.h>
+#include "SimPath.hpp"
+#include "HeapProbe.hpp"
+#include "MidiEncoder.hpp"
+
+
+SimPath *SimPath::current = nullptr;
+
+
+uint64_t host_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+uint32_t LatencyHistogram::Percentile(unsigned int pct) const {
+	uint64_t rank = (count * pct + 99) / 100;
+	uint64_t seen = 0;
+	for (uint32_t value = 0; value <= range; value++) {
+		seen += counts[value];
+		if (seen >= rank && seen != 0) {
+			return value;
+		}
+	}
+	return max;
+}
+
+
+void LatencyHistogram::Print(const char *name, const char *unit) const {
+	if (count == 0) {
+		printf("%-10s none\n", name);
+		return;
+	}
+	printf("%-10s %9llu  p50 %6lu  p90 %6lu  p99 %6lu  max %7lu %s\n",
+		   name, (unsigned long long)count,
+		   (unsigned long)Percentile(50), (unsigned long)Percentile(90),
+		   (unsigned long)Percentile(99), (unsigned long)max, unit);
+}
+
+
+SimPath::SimPath(bool harmonies, int outputFdArg) noexcept
+: voiceLeader(voiceLowest, voiceHighest), quantize(nullptr),
+  harmonizer(nullptr, harmonyIntervals),
+  transform(&TransformOut, quantize, harmonizer, voiceLeader,
+			harmonies ? MidiTransform::HARMONIES : MidiTransform::CHORDS),
+  scheduler(wireBytesPerSecond, wireBurstBytes),
+  parser(&NoteOn, &Realtime, &NoteOff, &ControlChange, &Pitchwheel)
+{
+	current = this;
+	inputBytes = 0;
+	inputEvents = 0;
+	outputBytes = 0;
+	outputFd = outputFdArg;
+	now = 0;
+
+	// Same scale and controllers as control_thread.
+	quantize.SetScale(StartScale::PitchClasses(0));
+	harmonizer.SetScale(StartScale::PitchClasses(0));
+	for (auto &control: analogControls) {
+		controls.push_back(ControllerInput(control.status, control.controller,
+										   adcFilterParameters));
+	}
+}
+
+
+SimPath::~SimPath() {
+	current = nullptr;
+}
+
+
+void SimPath::Input(const uint8_t *buf, size_t len, uint32_t nowArg) {
+	now = nowArg;
+	inputBytes += len;
+	parser.Parse(buf, len);
+}
+
+
+void SimPath::Control(const uint16_t raw[numOfControls], uint32_t nowArg) {
+	UmpEvent event;
+
+	now = nowArg;
+	for (unsigned int i = 0; i < numOfControls; i++) {
+		if (controls[i].Update(raw[i], controlPeriod, event)) {
+			scheduler.Post(event, now);
+		}
+	}
+}
+
+
+void SimPath::Run(uint32_t nowArg) {
+	UmpEvent event;
+	uint32_t stamp;
+
+	now = nowArg;
+	transform.Release(now);
+	// The latency of an event is counted up to its last byte.
+	while (scheduler.Next(now, event, stamp)) {
+		wire.bytes.clear();
+		MidiEncoder::Send(wire, event);
+		size_t len = wire.bytes.size();
+		uint32_t latency = now - stamp + len * wireByteTime;
+		if (event.Opcode() == 0x80 || event.Opcode() == 0x90) {
+			noteLatency.Add(latency);
+		}
+		else if (event.MessageType() != UmpEvent::SYSTEM) {
+			controlLatency.Add(latency);
+		}
+		outputBytes += len;
+		if (outputFd >= 0 && len > 0 &&
+			write(outputFd, wire.bytes.data(), len) != (ssize_t)len) {
+			perror("output");
+			outputFd = -1;
+		}
+	}
+}
+
+
+uint32_t SimPath::Wait(uint32_t nowArg) {
+	uint32_t wait = scheduler.Wait(nowArg);
+	if (transform.Pending()) {
+		int32_t due = (int32_t)(transform.NextReleaseTime() - nowArg);
+		uint32_t release = due > 0 ? (uint32_t)due : 0;
+		if (release < wait) {
+			wait = release;
+		}
+	}
+	return wait;
+}
+
+
+void SimPath::Report(double simSeconds, double hostSeconds) {
+	const MidiParser::Statistics &ps = parser.Stats();
+	const MidiTransform::Statistics &ts = transform.Stats();
+	const TxScheduler::Statistics &tx = scheduler.Stats();
+
+	printf("simulated %.1f s in %.2f s (x%.0f)\n", simSeconds, hostSeconds,
+		   hostSeconds > 0 ? simSeconds / hostSeconds : 0);
+	printf("input     %9llu bytes %9llu events %8.0f events/s %10.0f host events/s\n",
+		   (unsigned long long)inputBytes, (unsigned long long)inputEvents,
+		   simSeconds > 0 ? inputEvents / simSeconds : 0,
+		   hostSeconds > 0 ? inputEvents / hostSeconds : 0);
+	printf("parser    %9lu messages %6lu realtime %8lu sysex bytes %4lu truncated\n",
+		   (unsigned long)ps.messages, (unsigned long)ps.realtime,
+		   (unsigned long)ps.sysexBytes, (unsigned long)ps.truncated);
+	printf("transform %9lu events %9lu voices %6lu early\n",
+		   (unsigned long)ts.events, (unsigned long)ts.voices,
+		   (unsigned long)ts.early);
+	printf("wire      %9lu sent %9llu bytes %9lu coalesced %6lu dropped "
+		   "(%.0f%% busy)\n",
+		   (unsigned long)tx.sent, (unsigned long long)outputBytes,
+		   (unsigned long)tx.coalesced, (unsigned long)tx.dropped,
+		   simSeconds > 0 ? outputBytes * wireByteTime / (simSeconds * 1e4) : 0);
+	noteLatency.Print("notes", "us");
+	controlLatency.Print("control", "us");
+	handlerTime.Print("handler", "ns");
+}
+
+
+void SimPath::InputEvent(const UmpEvent &event) {
+#if HEAP_PROBE
+	HeapProbe::Scope heapProbeScope(HeapProbe::SiteOf(event.Status()));
+#endif
+	uint64_t start = host_ns();
+	current->inputEvents++;
+	current->transform.Process(event, current->now);
+	current->handlerTime.Add((uint32_t)(host_ns() - start));
+}
+
+
+void SimPath::NoteOn(uint8_t note, uint8_t velocity) {
+	InputEvent(UmpEvent::Midi1(0x90, note, velocity));
+}
+
+
+void SimPath::NoteOff(uint8_t note, uint8_t velocity) {
+	InputEvent(UmpEvent::Midi1(0x80, note, velocity));
+}
+
+
+void SimPath::ControlChange(uint8_t controller, uint8_t value) {
+	InputEvent(UmpEvent::Midi1(0xB0, controller, value));
+}
+
+
+void SimPath::Pitchwheel(uint8_t valueLSB, uint8_t valueMSB) {
+	InputEvent(UmpEvent::Midi1(0xE0, valueLSB, valueMSB));
+}
+
+
+void SimPath::Realtime(uint8_t /* msg */) {
+	// Goes to the clock thread, which only follows the tempo.
+	HEAP_PROBE_SCOPE(REALTIME);
+	current->inputEvents++;
+}
+
+
+void SimPath::TransformOut(const UmpEvent &event) {
+	current->scheduler.Post(event, current->now);
+}
+
+
+/* EOF */
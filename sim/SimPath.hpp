@@ -0,0 +1,128 @@
+/** @file SimPath.hpp
+ *
+ * The firmware's MIDI path on a host, shared by the simulator tools:
+ *
+ *   bytes -> MidiParser -> MidiTransform -> TxScheduler -> bytes
+ *   ADC readings -> ControllerInput ---------^
+ *
+ * set up like main.cpp does (MidiSetup.hpp), except that the board
+ * parses with SerialMidi instead of MidiParser.  Time is whatever the
+ * caller says it is (us), the output wire is modelled by the
+ * scheduler at 31250 baud and gets the bytes MidiEncoder makes of the
+ * events.  Only one SimPath can exist at a time, the parser calls back
+ * into it through plain function pointers like SerialMidi does.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef SimPath_hpp
+#define SimPath_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Ump.hpp"
+#include "MidiParser.hpp"
+#include "MidiTransform.hpp"
+#include "TxScheduler.hpp"
+#include "ControllerInput.hpp"
+#include "Harmony.hpp"
+#include "Random.hpp"
+#include "MidiSetup.hpp"
+#include "SimWire.hpp"
+
+
+/** Host clock in ns.
+ */
+uint64_t host_ns();
+
+
+/** Latencies (or durations), 1 unit resolution up to 'range'.
+ */
+class LatencyHistogram {
+public:
+	static const uint32_t range = 1000000;
+
+	LatencyHistogram() : counts(range + 1, 0), count(0), max(0) {};
+	void Add(uint32_t value) {
+		counts[value < range ? value : range]++;
+		count++;
+		if (value > max) {
+			max = value;
+		}
+	};
+	uint64_t Count() const {
+		return count;
+	};
+	uint32_t Percentile(unsigned int pct) const;
+	void Print(const char *name, const char *unit) const;
+
+private:
+	std::vector<uint32_t> counts;
+	uint64_t count;
+	uint32_t max;
+};
+
+
+class SimPath {
+public:
+	static const uint32_t wireByteTime = 1000000 / wireBytesPerSecond;	// us
+	static const uint32_t controlPeriod = ::controlPeriod;	// us, control_thread
+	static const unsigned int numOfControls = numOfAnalogControls;
+
+	SimPath(bool harmonies, int outputFdArg = -1) noexcept;
+	~SimPath();
+
+	/** Bytes that arrived at the input at 'now'.
+	 */
+	void Input(const uint8_t *buf, size_t len, uint32_t now);
+	/** One reading of the analog inputs (b2in, b3in, ribbon).
+	 */
+	void Control(const uint16_t raw[numOfControls], uint32_t now);
+	/** Releases and whatever the wire can take at 'now'.
+	 */
+	void Run(uint32_t now);
+	/** us until Run() has something to do, TxScheduler::forever when
+	 * nothing is waiting.
+	 */
+	uint32_t Wait(uint32_t now);
+
+	/** Lines with the counters and the latency percentiles.
+	 */
+	void Report(double simSeconds, double hostSeconds);
+
+	/** Input message to output latency, us. */
+	LatencyHistogram noteLatency;
+	LatencyHistogram controlLatency;
+	/** Host time the transform took per message, ns. */
+	LatencyHistogram handlerTime;
+	uint64_t inputBytes;
+	uint64_t inputEvents;
+	uint64_t outputBytes;
+
+private:
+	static void InputEvent(const UmpEvent &event);
+	static void NoteOn(uint8_t note, uint8_t velocity);
+	static void NoteOff(uint8_t note, uint8_t velocity);
+	static void ControlChange(uint8_t controller, uint8_t value);
+	static void Pitchwheel(uint8_t valueLSB, uint8_t valueMSB);
+	static void Realtime(uint8_t msg);
+	static void TransformOut(const UmpEvent &event);
+
+	static SimPath *current;
+
+	VoiceLeader voiceLeader;
+	ScaleQuantize quantize;
+	Harmonizer harmonizer;
+	MidiTransform transform;
+	TxScheduler scheduler;
+	MidiParser parser;
+	std::vector<ControllerInput> controls;
+	SimWire wire;
+	int outputFd;
+	uint32_t now;
+};
+
+
+#endif /* SimPath_hpp */
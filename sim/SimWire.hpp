@@ -0,0 +1,34 @@
+/** @file SimWire.hpp
+ *
+ * The serial MIDI port on a host: write() appends to 'bytes', which
+ * is all MidiEncoder uses of SerialMidi.
+ * The simulator tools clear it, encode an event and take the bytes
+ * from here, so what they put on the modelled wire is what the
+ * firmware would send.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef SimWire_hpp
+#define SimWire_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+
+
+class SimWire {
+public:
+	ssize_t write(const void *buf, size_t len) {
+		const uint8_t *p = (const uint8_t *)buf;
+		bytes.insert(bytes.end(), p, p + len);
+		return (ssize_t)len;
+	};
+
+	std::vector<uint8_t> bytes;
+};
+
+
+#endif /* SimWire_hpp */
@@ -0,0 +1,411 @@
+/** @file clockdrift.cpp
+ *
+ * Hours of MidiClock playback on a simulated clock, set up like the
+ * CLOCK_MASTER clock thread in main.cpp: a Timeout wakes the thread
+ * some us after the next clock is due, Run() sends what is due into
+ * the TxScheduler and the TX thread puts it on the wire through
+ * MidiEncoder (SimWire.hpp) next to other traffic.
+ *
+ *   - Drift: the due time of every clock against the exact time,
+ *     n * 60 / (BPM * 24) s after the start or after the last tempo
+ *     change.  Both are rounded down to the us so they have to be
+ *     equal, however long it plays.  Once at a steady 123.456 BPM,
+ *     once with a new tempo every 10 to 60 s (it has to take effect
+ *     on the next beat).
+ *   - Swing: every swung 16th within the wake up delay of its time.
+ *   - Jitter: when the clocks start on the wire against their exact
+ *     time, and the time between two clocks against the period.
+ *   - Transport: the bytes of start, stop, song position and continue
+ *     on the wire, and the 16th note the steps continue from.
+ *
+ *   -t hours	playback per run, default 4.
+ *   -l load	other traffic, % of the wire, default 50.
+ *   -s seed	seed of the delays and the traffic, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o clockdrift clockdrift.cpp \
+ *       ../MidiClock.cpp ../TxScheduler.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "MidiClock.hpp"
+#include "TxScheduler.hpp"
+#include "MidiEncoder.hpp"
+#include "Random.hpp"
+#include "SimWire.hpp"
+#include "MidiSetup.hpp"
+
+
+const uint64_t second = 1000000;		// us
+const uint32_t wireByteTime = 1000000 / wireBytesPerSecond;
+// One clock at 1/1000 BPM lasts this / milliBpm us.
+const uint64_t clockMicrosMilliBpm = 2500000000u;
+// Timeout interrupt to clock thread: mostly a few us, now and then a
+// higher priority thread or interrupt is in the way.
+const uint32_t wakeMin = 5;
+const uint32_t wakeMax = 300;
+
+
+/** One run of the clock thread, the TX thread and the wire.
+ */
+struct Playback {
+	MidiClock *clock;
+	TxScheduler scheduler;
+	SimWire wire;
+	Random random;
+	uint64_t now;
+	uint64_t wireFree;		// The UART is done with the bytes before.
+
+	// Exact times of the clocks since the start or the tempo change.
+	uint64_t refDue;
+	uint32_t refPosition;
+	uint32_t refMilliBpm;
+	uint32_t pendingMilliBpm;
+	uint64_t pairDue;		// Of the last even 16th.
+	uint8_t swing;
+
+	uint32_t clocks;
+	uint32_t steps;
+	uint32_t tempoChanges;
+	uint64_t maxDrift;
+	uint32_t wrongBeats;	// Tempo changed off the beat.
+	uint32_t lateSteps;
+	std::vector<uint64_t> clockDue;		// Per clock not yet on the wire.
+	std::vector<uint32_t> late;			// Wire start after the due time.
+	std::vector<uint32_t> interval;		// |wire interval - due interval|
+	uint64_t lastWire, lastDue;
+
+	// Transport: every byte on the wire and the steps.
+	std::vector<uint8_t> bytes;
+	std::vector<uint32_t> stepLog;
+
+	Playback(uint32_t seed)
+		: clock(nullptr), scheduler(wireBytesPerSecond, wireBurstBytes), random(seed), now(0),
+		  wireFree(0), refDue(0), refPosition(0), refMilliBpm(0),
+		  pendingMilliBpm(0), pairDue(0), swing(50), clocks(0), steps(0),
+		  tempoChanges(0), maxDrift(0), wrongBeats(0), lateSteps(0),
+		  lastWire(0), lastDue(0) {};
+
+	uint64_t Exact(uint32_t position) const {
+		return refDue + (position - refPosition) * clockMicrosMilliBpm / refMilliBpm;
+	};
+};
+
+Playback *playbackGlob;
+
+
+/** The clock's sink: what main.cpp's clock_master_out() does with
+ * midi_send().
+ */
+void clock_out(const UmpEvent &event)
+{
+	Playback &p = *playbackGlob;
+
+	if (event.Status() == 0xF8) {
+		uint32_t position = p.clock->Position();
+		// Only the clock is due when it is sent.
+		uint64_t due = p.clock->NextEventTime();
+		uint64_t exact = p.Exact(position);
+		uint64_t drift = due > exact ? due - exact : exact - due;
+		p.maxDrift = std::max(p.maxDrift, drift);
+		if (position % MidiClock::clocksPerBeat == 0 && p.pendingMilliBpm) {
+			p.refDue = due;
+			p.refPosition = position;
+			p.refMilliBpm = p.pendingMilliBpm;
+			p.pendingMilliBpm = 0;
+		}
+		if (p.clock->Tempo() != p.refMilliBpm) {
+			p.wrongBeats++;
+		}
+		if (position % (2 * MidiClock::clocksPerStep) == 0) {
+			p.pairDue = due;
+		}
+		p.clockDue.push_back(due);
+		p.clocks++;
+	}
+	p.scheduler.Post(event, (uint32_t)p.now);
+}
+
+
+/** The swung 16th is due 'swing' % into the pair, it is handled
+ * within the wake up delay of that.
+ */
+void clock_step(uint32_t step)
+{
+	Playback &p = *playbackGlob;
+
+	p.steps++;
+	p.stepLog.push_back(step);
+	if (step % 2 == 0) {
+		return;
+	}
+	double due = p.pairDue + (double)clockMicrosMilliBpm * 2 *
+		MidiClock::clocksPerStep * p.swing / (100.0 * p.clock->Tempo());
+	double late = p.now - due;
+	if (late < -1 || late > wakeMax + 1) {
+		p.lateSteps++;
+	}
+}
+
+
+/** What the TX thread sends at p.now, on the wire after what the UART
+ * still has.
+ */
+void tx(Playback &p)
+{
+	UmpEvent event;
+
+	while (p.scheduler.Next((uint32_t)p.now, event)) {
+		p.wire.bytes.clear();
+		MidiEncoder::Send(p.wire, event);
+		uint64_t start = std::max(p.now, p.wireFree);
+		for (uint8_t byte: p.wire.bytes) {
+			p.bytes.push_back(byte);
+			if (byte == 0xF8 && !p.clockDue.empty()) {
+				uint64_t due = p.clockDue.front();
+				p.clockDue.erase(p.clockDue.begin());
+				p.late.push_back((uint32_t)(start - due));
+				if (p.lastWire) {
+					int64_t d = (int64_t)(start - p.lastWire) - (int64_t)(due - p.lastDue);
+					p.interval.push_back((uint32_t)(d < 0 ? -d : d));
+				}
+				p.lastWire = start;
+				p.lastDue = due;
+			}
+			start += wireByteTime;
+		}
+		p.wireFree = start;
+	}
+}
+
+
+uint32_t wake_delay(Random &random)
+{
+	if (random.Chance(100)) {
+		return wakeMin + random.Below(wakeMax - wakeMin + 1);
+	}
+	return wakeMin + random.Below(20);
+}
+
+
+uint32_t percentile(std::vector<uint32_t> values, unsigned int pct)
+{
+	if (values.empty()) {
+		return 0;
+	}
+	size_t rank = (values.size() * pct + 99) / 100;
+	std::nth_element(values.begin(), values.begin() + rank - 1, values.end());
+	return values[rank - 1];
+}
+
+
+/** Plays 'hours' at 'milliBpm', with 'changes' a new tempo every 10 to
+ * 60 s, and other traffic at 'load' % of the wire.
+ */
+bool run(const char *name, uint32_t hours, uint32_t milliBpm, bool changes,
+		 uint32_t load, uint32_t seed)
+{
+	Playback p(seed);
+	MidiClock clock(&clock_out, &clock_step);
+	std::exponential_distribution<double> gap(1.0 * wireBytesPerSecond * load /
+											  100 / 3 / second);
+	const uint64_t end = hours * 3600 * second;
+
+	playbackGlob = &p;
+	p.clock = &clock;
+	p.swing = 50 + p.random.Below(26);
+	clock.SetSwing(p.swing);
+	clock.SetTempo(milliBpm);
+	p.refMilliBpm = milliBpm;
+	clock.Start(0);
+
+	uint64_t wake = clock.NextEventTime() + wake_delay(p.random);
+	uint64_t traffic = load ? (uint64_t)gap(p.random) : UINT64_MAX;
+	uint64_t change = changes ? 10 * second : UINT64_MAX;
+	uint8_t note = 0;
+	while (p.now < end) {
+		uint32_t wait = p.scheduler.Wait((uint32_t)p.now);
+		uint64_t next = std::min(std::min(wake, traffic), change);
+		if (wait != TxScheduler::forever) {
+			next = std::min(next, p.now + wait);
+		}
+		p.now = std::max(next, p.now);
+
+		if (p.now >= change) {
+			// Thousandths of a BPM too.
+			uint32_t tempo = 40000 + p.random.Below(200000);
+			clock.SetTempo(tempo);
+			p.pendingMilliBpm = tempo;
+			p.tempoChanges++;
+			change = p.now + (10 + p.random.Below(51)) * second;
+		}
+		if (p.now >= traffic) {
+			// Note on and off in turn, a controller now and then.
+			UmpEvent event = p.random.Chance(4) ?
+				UmpEvent::Midi1(0xB0, 1, p.random.Below(128)) :
+				UmpEvent::Midi1(note & 1 ? 0x80 : 0x90, 60 + note / 2 % 12, 100);
+			note++;
+			p.scheduler.Post(event, (uint32_t)p.now);
+			traffic = p.now + 1 + (uint64_t)gap(p.random);
+		}
+		if (p.now >= wake) {
+			clock.Run(p.now);
+			wake = clock.NextEventTime() + wake_delay(p.random);
+		}
+		tx(p);
+		p.bytes.clear();
+		p.stepLog.clear();
+	}
+
+	// Every clock made it to the wire, and as many as fit in the time.
+	uint64_t expected = end * milliBpm / clockMicrosMilliBpm + 1;
+	bool counted = p.clocks == clock.Position() && p.clockDue.size() < 2 &&
+		(changes || (p.clocks + 1 >= expected && p.clocks <= expected + 1));
+	uint32_t maxLate = percentile(p.late, 100);
+	uint32_t maxInterval = percentile(p.interval, 100);
+	// Realtime goes first but waits for what the UART already has.
+	uint32_t lateBound = wakeMax + (wireBurstBytes + 1) * wireByteTime;
+	bool ok = p.maxDrift == 0 && p.wrongBeats == 0 && p.lateSteps == 0 &&
+		counted && maxLate <= lateBound &&
+		maxInterval <= lateBound;
+
+	printf("%s: %lu clocks %lu steps in %lu h, %lu tempo changes, swing %u%%\n",
+		   name, (unsigned long)p.clocks, (unsigned long)p.steps,
+		   (unsigned long)hours, (unsigned long)p.tempoChanges, p.swing);
+	printf("  drift max %llu us, %lu clocks off the beat tempo, "
+		   "%lu steps late\n", (unsigned long long)p.maxDrift,
+		   (unsigned long)p.wrongBeats, (unsigned long)p.lateSteps);
+	if (!changes) {
+		// What a whole us period (the fraction dropped) would be off.
+		uint64_t whole = clockMicrosMilliBpm / milliBpm * p.clocks;
+		printf("  without the fraction the last clock would be %.1f ms early\n",
+			   (p.Exact(p.clocks) - whole) / 1000.0);
+	}
+	printf("  on the wire after the due time p50 %lu p99 %lu max %lu us, "
+		   "interval error p50 %lu p99 %lu max %lu us %s\n",
+		   (unsigned long)percentile(p.late, 50), (unsigned long)percentile(p.late, 99),
+		   (unsigned long)maxLate, (unsigned long)percentile(p.interval, 50),
+		   (unsigned long)percentile(p.interval, 99), (unsigned long)maxInterval,
+		   ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+/** Runs the clock until 'until' and sends what is due.
+ */
+void play(Playback &p, MidiClock &clock, uint64_t until)
+{
+	while (clock.Running() && clock.NextEventTime() <= until) {
+		p.now = clock.NextEventTime();
+		clock.Run(p.now);
+		tx(p);
+	}
+	p.now = until;
+	tx(p);
+}
+
+bool test_transport()
+{
+	Playback p(1);
+	MidiClock clock(&clock_out, &clock_step);
+	// 120 BPM: a clock every 20833 us, 100 in 2.08 s.
+	const uint64_t hundred = 99 * clockMicrosMilliBpm / 120000 + 1;
+	bool ok = true;
+
+	playbackGlob = &p;
+	p.clock = &clock;
+	p.refMilliBpm = 120000;
+	clock.Start(0);
+	play(p, clock, hundred - 1);
+	ok = ok && p.bytes.size() == 101 && p.bytes[0] == 0xFA && p.clocks == 100 &&
+		std::count(p.bytes.begin(), p.bytes.end(), 0xF8) == 100;
+
+	p.bytes.clear();
+	clock.Stop();
+	clock.SetPosition(37);
+	play(p, clock, 10 * second);
+	const uint8_t stopped[] = {0xFC, 0xF2, 37, 0};
+	ok = ok && p.bytes.size() == sizeof(stopped) &&
+		std::equal(p.bytes.begin(), p.bytes.end(), stopped) &&
+		clock.Position() == 37 * MidiClock::clocksPerStep;
+
+	// Picked up on an odd 16th: that step first, then the clock.
+	p.bytes.clear();
+	p.stepLog.clear();
+	clock.Continue(10 * second);
+	play(p, clock, 10 * second);
+	ok = ok && p.bytes.size() == 2 && p.bytes[0] == 0xFB && p.bytes[1] == 0xF8 &&
+		p.stepLog.size() == 1 && p.stepLog[0] == 37;
+
+	// Only while stopped.
+	p.bytes.clear();
+	clock.SetPosition(200);
+	play(p, clock, 10 * second + 1);
+	ok = ok && p.bytes.empty();
+
+	// Start while running: stop first, then from the beginning.
+	p.stepLog.clear();
+	clock.Start(11 * second);
+	play(p, clock, 11 * second);
+	const uint8_t restart[] = {0xFC, 0xFA, 0xF8};
+	ok = ok && p.bytes.size() == sizeof(restart) &&
+		std::equal(p.bytes.begin(), p.bytes.end(), restart) &&
+		p.stepLog.size() == 1 && p.stepLog[0] == 0;
+
+	clock.Stop();
+	p.bytes.clear();
+	clock.SetPosition(200);
+	tx(p);
+	const uint8_t position[] = {0xFC, 0xF2, 200 & 0x7F, 200 >> 7};
+	ok = ok && p.bytes.size() == sizeof(position) &&
+		std::equal(p.bytes.begin(), p.bytes.end(), position);
+
+	printf("transport: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: clockdrift [-t hours] [-l load] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t hours = 4;
+	uint32_t load = 50;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:l:s:")) != -1) {
+		switch (opt) {
+			case 't': hours = strtoul(optarg, nullptr, 0); break;
+			case 'l': load = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (hours == 0 || load > 90) {
+		usage();
+	}
+
+	bool ok = test_transport();
+	ok = run("steady", hours, 123456, false, load, seed) && ok;
+	ok = run("tempo changes", hours, 120000, true, load, seed + 1) && ok;
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
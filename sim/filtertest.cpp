@@ -0,0 +1,386 @@
+/** @file filtertest.cpp
+ *
+ * Lag against noise of OneEuroFilter on controller gestures.
+ *
+ * Every gesture is played through the filter twice, clean and with
+ * normal noise added to the readings.  The difference between the two
+ * outputs is the noise that gets through, the difference between the
+ * clean output and the gesture itself is what the filter costs in lag.
+ * For the moves the delay of the output at half way is printed, and
+ * how many control changes ControllerInput would send.  Three filters:
+ * none, a fixed 1 Hz low pass (beta 0) and the one euro filter with
+ * the parameters of MidiSetup.hpp.
+ *
+ * Two sources: the ADC inputs (16 bit, read every 30 ms by
+ * control_thread, with noise) and the pitch wheel (14 bit, a message
+ * every 2 to 20 ms, no noise).
+ *
+ * The fixed point filter is also held against the filter in double
+ * precision, changing the parameters while it runs must never take
+ * the output past the input, and a reading at the same time as the
+ * previous one (dt 0) must replace it.
+ *
+ *   -a noise	rms noise on the ADC readings in counts, default 100.
+ *   -s seed	seed of the noise, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o filtertest filtertest.cpp \
+ *       ../OneEuroFilter.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "OneEuroFilter.hpp"
+#include "ControllerInput.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// As in MidiSetup.hpp, and for a pitch wheel a larger beta.
+const OneEuroFilter::Parameters adcParameters = {1000, 3000, 1000};
+const OneEuroFilter::Parameters pitchwheelParameters = {1000, 12000, 1000};
+
+
+/** Position 0..1 at t seconds.
+ */
+struct Gesture {
+	const char *name;
+	double seconds;
+	double (*position)(double t);
+	double halfway;		// s, when a move is half way, 0 for none.
+};
+
+const Gesture gestures[] = {
+	{"rest", 4, [](double) { return 0.4; }, 0},
+	{"slow sweep", 4, [](double t) { return t < 1 ? 0.0 : t < 3 ? (t - 1) / 2 : 1.0; }, 2},
+	{"fast flick", 2, [](double t) { return t < 1 ? 0.0 : t < 1.1 ? (t - 1) * 10 : 1.0; }, 1.05},
+	{"vibrato", 4, [](double t) { return 0.5 + 0.05 * sin(2 * M_PI * 5 * t); }, 0},
+	{"breath", 3, [](double t) {
+		return t < 0.5 ? 0.0 : t < 0.7 ? (t - 0.5) * 4 : t < 2 ? 0.8 :
+			t < 2.5 ? 0.8 - (t - 2) * 1.6 : 0.0; }, 0.6},
+};
+
+
+struct Source {
+	const char *name;
+	int32_t range;
+	uint32_t minDt, maxDt;		// us
+	bool noise;
+	const OneEuroFilter::Parameters &parameters;
+};
+
+const Source sources[] = {
+	{"adc", 65535, 30000, 30000, true, adcParameters},
+	{"pitch wheel", 16383, 2000, 20000, false, pitchwheelParameters},
+};
+
+
+/** The readings of one gesture.
+ */
+struct Take {
+	std::vector<double> time;		// s
+	std::vector<double> truth;		// counts
+	std::vector<int32_t> clean, noisy;
+	std::vector<uint32_t> dt;
+};
+
+Take take(const Gesture &gesture, const Source &source, double noise,
+		  Random &random)
+{
+	std::normal_distribution<double> normal(0, noise);
+	Take t;
+	double time = 0;
+	uint32_t dt = 0;
+	while (time < gesture.seconds) {
+		double x = gesture.position(time) * source.range;
+		auto clamp = [&](double v) -> int32_t {
+			return (int32_t)fmin(fmax(lround(v), 0), source.range);
+		};
+		t.time.push_back(time);
+		t.truth.push_back(x);
+		t.clean.push_back(clamp(x));
+		t.noisy.push_back(clamp(x + (source.noise ? normal(random) : 0)));
+		t.dt.push_back(dt);
+		dt = source.minDt + random.Below(source.maxDt - source.minDt + 1);
+		time += dt * 1e-6;
+	}
+	return t;
+}
+
+
+enum Kind {
+	NONE,
+	LOW_PASS,
+	ONE_EURO
+};
+const char *kindNames[] = {"none", "low pass 1 Hz", "one euro"};
+
+std::vector<int32_t> run(Kind kind, const Source &source,
+						 const std::vector<int32_t> &in, const std::vector<uint32_t> &dt)
+{
+	OneEuroFilter::Parameters parameters = source.parameters;
+	if (kind == LOW_PASS) {
+		parameters.beta = 0;
+	}
+	OneEuroFilter filter(parameters);
+	std::vector<int32_t> out;
+	for (size_t i = 0; i < in.size(); i++) {
+		out.push_back(kind == NONE ? in[i] : filter.Filter(in[i], dt[i]));
+	}
+	return out;
+}
+
+
+/** Control changes ControllerInput sends for ADC readings.
+ */
+uint32_t messages(Kind kind, const std::vector<int32_t> &in,
+				  const std::vector<uint32_t> &dt)
+{
+	OneEuroFilter::Parameters parameters = adcParameters;
+	if (kind == LOW_PASS) {
+		parameters.beta = 0;
+	}
+	ControllerInput control(0xB0, 2, parameters);
+	UmpEvent event;
+	uint32_t count = 0;
+	int32_t sent = -1;
+	for (size_t i = 0; i < in.size(); i++) {
+		if (kind == NONE) {
+			// Every reading straight to 7 bits.
+			count += (in[i] >> 9) != sent ? 1 : 0;
+			sent = in[i] >> 9;
+		}
+		else {
+			count += control.Update((uint16_t)in[i], dt[i], event) ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+
+struct Result {
+	double noise;		// rms counts
+	double lag;			// rms counts
+	double delay;		// ms at half way, < 0 when not a move.
+	uint32_t messages;
+};
+
+Result measure(Kind kind, const Gesture &gesture, const Source &source,
+			   const Take &t)
+{
+	std::vector<int32_t> clean = run(kind, source, t.clean, t.dt);
+	std::vector<int32_t> noisy = run(kind, source, t.noisy, t.dt);
+	Result r = Result();
+	double noise = 0, lag = 0;
+	for (size_t i = 0; i < clean.size(); i++) {
+		noise += pow(noisy[i] - clean[i], 2);
+		lag += pow(clean[i] - t.truth[i], 2);
+	}
+	r.noise = sqrt(noise / clean.size());
+	r.lag = sqrt(lag / clean.size());
+	r.delay = -1;
+	if (gesture.halfway > 0) {
+		double half = gesture.position(gesture.halfway) * source.range;
+		for (size_t i = 0; i < clean.size(); i++) {
+			if (t.time[i] >= gesture.halfway && clean[i] >= half) {
+				r.delay = (t.time[i] - gesture.halfway) * 1000;
+				break;
+			}
+		}
+	}
+	r.messages = source.range == 65535 ? messages(kind, t.noisy, t.dt) : 0;
+	return r;
+}
+
+
+/** The same filter in double precision, the largest difference in
+ * counts.
+ */
+double against_reference(const Source &source, const Take &t)
+{
+	const OneEuroFilter::Parameters &p = source.parameters;
+	auto alpha = [](double fc, double dt) {
+		double r = 2 * M_PI * fc * dt;
+		return r / (1 + r);
+	};
+	OneEuroFilter filter(p);
+	double value = 0, speed = 0, maxDiff = 0;
+	for (size_t i = 0; i < t.noisy.size(); i++) {
+		int32_t out = filter.Filter(t.noisy[i], t.dt[i]);
+		double x = t.noisy[i];
+		double dt = t.dt[i] * 1e-6;
+		if (i == 0) {
+			value = x;
+			speed = 0;
+		}
+		else {
+			speed += alpha(p.derivativeCutoff * 1e-3, dt) * ((x - value) / dt - speed);
+			double fc = p.minCutoff * 1e-3 + fabs(speed) * p.beta / 65536 * 1e-3;
+			value += alpha(fmin(fc, 1000), dt) * (x - value);
+		}
+		maxDiff = fmax(maxDiff, fabs(out - value));
+	}
+	return maxDiff;
+}
+
+
+/** New parameters every quarter of a gesture: the output may move
+ * faster or slower but never past the input.
+ */
+bool test_retune(const Source &source, const Take &t)
+{
+	OneEuroFilter filter(source.parameters);
+	OneEuroFilter::Parameters parameters = source.parameters;
+	int32_t last = 0;
+	bool ok = true;
+	for (size_t i = 0; i < t.noisy.size(); i++) {
+		size_t quarter = t.noisy.size() / 4;
+		if (i % quarter == 0) {
+			parameters.minCutoff = (i / quarter) % 2 ? 250 : 4000;
+			parameters.beta = (i / quarter) == 2 ? 0 : 4 * source.parameters.beta;
+			filter.SetParameters(parameters);
+		}
+		int32_t in = t.noisy[i];
+		int32_t out = filter.Filter(in, t.dt[i]);
+		if (i > 0) {
+			int32_t low = last < in ? last : in;
+			int32_t high = last < in ? in : last;
+			ok = ok && out >= low - 1 && out <= high + 1;
+		}
+		last = out;
+	}
+	return ok && filter.GetParameters().minCutoff == parameters.minCutoff;
+}
+
+
+/** Every reading is preceded by another one at the same time, the
+ * output must be the same as without them.
+ */
+bool test_same_time(const Source &source, const Take &t)
+{
+	OneEuroFilter filter(source.parameters);
+	OneEuroFilter twice(source.parameters);
+	bool ok = true;
+	for (size_t i = 0; i < t.noisy.size(); i++) {
+		int32_t out = filter.Filter(t.noisy[i], t.dt[i]);
+		twice.Filter(source.range - t.noisy[i], t.dt[i]);
+		ok = ok && twice.Filter(t.noisy[i], 0) == out;
+	}
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: filtertest [-a noise] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	double noise = 100;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:s:")) != -1) {
+		switch (opt) {
+			case 'a': noise = strtod(optarg, nullptr); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (noise < 0) {
+		usage();
+	}
+
+	Random random(seed);
+	bool ok = true;
+	printf("%-12s %-12s %-14s %8s %8s %9s %5s\n", "source", "gesture",
+		   "filter", "noise", "lag", "delay ms", "CCs");
+	for (auto &source: sources) {
+		double maxDiff = 0;
+		bool retuned = true;
+		bool sameTime = true;
+		for (auto &gesture: gestures) {
+			Take t = take(gesture, source, noise, random);
+			Result results[3];
+			for (int kind = NONE; kind <= ONE_EURO; kind++) {
+				Result &r = results[kind];
+				r = measure((Kind)kind, gesture, source, t);
+				printf("%-12s %-12s %-14s %8.1f %8.1f ", source.name,
+					   gesture.name, kindNames[kind], r.noise, r.lag);
+				if (r.delay >= 0) {
+					printf("%9.0f ", r.delay);
+				}
+				else {
+					printf("%9s ", "-");
+				}
+				printf("%5lu\n", (unsigned long)r.messages);
+			}
+			// At rest it smooths like the low pass and keeps the CC
+			// from flickering, when it moves there is a good deal less
+			// lag.
+			const Result &none = results[NONE];
+			const Result &lowPass = results[LOW_PASS];
+			const Result &oneEuro = results[ONE_EURO];
+			bool good = oneEuro.lag <= lowPass.lag + 1;
+			if (&gesture == &gestures[0] && source.noise) {
+				good = good && oneEuro.noise <= lowPass.noise * 1.1 &&
+					oneEuro.noise <= none.noise / 2 &&
+					oneEuro.messages <= none.messages / 4;
+			}
+			if (gesture.halfway > 0) {
+				good = good && oneEuro.delay >= 0 &&
+					oneEuro.delay <= lowPass.delay / 2;
+			}
+			if (!good) {
+				printf("%s %s: FAIL\n", source.name, gesture.name);
+			}
+			ok = ok && good;
+			maxDiff = fmax(maxDiff, against_reference(source, t));
+			retuned = retuned && test_retune(source, t);
+			sameTime = sameTime && test_same_time(source, t);
+		}
+		bool good = maxDiff <= source.range / 1000.0 && retuned && sameTime;
+		printf("%s: max difference from double precision %.1f counts, "
+			   "retune %s, dt 0 %s %s\n", source.name, maxDiff,
+			   retuned ? "ok" : "jumps", sameTime ? "replaces" : "differs",
+			   good ? "ok" : "FAIL");
+		ok = ok && good;
+	}
+
+	// Cost of one update.
+	OneEuroFilter filter(adcParameters);
+	int32_t sink = 0;
+	const uint32_t updates = 1000000;
+	uint64_t start = now_ns();
+	for (uint32_t i = 0; i < updates; i++) {
+		sink += filter.Filter((int32_t)(random.Next() & 0xFFFF), 30000);
+	}
+	uint64_t ns = now_ns() - start;
+	printf("%.1f ns per Filter() on this host\n", (double)ns / updates);
+	// Keeps the calls from being optimized away.
+	if (sink == 1) {
+		printf("\n");
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
@@ -0,0 +1,337 @@
+/** @file fusiontest.cpp
+ *
+ * Accuracy, noise and latency of MotionFusion on sensor samples made
+ * from known orientations.
+ *
+ * The samples are what the FXOS8700CQ would read (NXP AN4248 axes):
+ * gravity at 4096 LSB/g and the earth field of the Netherlands, 49 uT
+ * at 67 degrees inclination, at 0.1 uT/LSB, rounded to whole LSBs.
+ * Noise is normal, 5 LSB on the accelerometer and 4 on the
+ * magnetometer, about what the part gives at 200 Hz.
+ *
+ *   - Accuracy: pitch, roll and heading on a grid of orientations
+ *     without noise against the exact angles.
+ *   - Noise: one orientation with noise, the spread of the angles
+ *     unfiltered and filtered, and how often the pitch bend and the
+ *     modulation wheel main.cpp makes of them change while the board
+ *     lies still.
+ *   - Latency: a 30 degree step in pitch, the time until the output
+ *     is 63% and 90% of the way.
+ *   - Wrap around: heading through north and roll through 180 degrees
+ *     while turning, the output has to follow without a jump.
+ *   - MotionCurve: every curve from 0 to 16383 without going back,
+ *     inverted and not, across 90 and 180 degrees.
+ *
+ *   -n samples	samples for the noise measurement, default 20000.
+ *   -s seed	seed of the noise, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o fusiontest fusiontest.cpp \
+ *       ../MotionFusion.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <unistd.h>
+#include "MotionFusion.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+const double degree = M_PI / 180;
+const double oneG = 4096;				// LSB
+const double earthField = 490;			// LSB, 49 uT
+const double inclination = 67 * degree;
+const uint32_t samplePeriod = 5;		// ms, 200 Hz
+
+
+/** Sensor readings at pitch, roll and heading (radians), AN4248
+ * equation 1 and 2: G = Rx(roll) Ry(pitch) Rz(heading) (0, 0, 1 g).
+ */
+struct Reading {
+	int16_t accel[3];
+	int16_t magnet[3];
+};
+
+Reading reading(double pitch, double roll, double heading, double accelNoise,
+				double magnetNoise, std::normal_distribution<double> &normal,
+				Random &random)
+{
+	double sp = sin(pitch), cp = cos(pitch);
+	double sr = sin(roll), cr = cos(roll);
+	double sh = sin(heading), ch = cos(heading);
+	const double g[3] = {-sp, cp * sr, cp * cr};
+	// Earth frame field (B cos(incl), 0, B sin(incl)) rotated the same.
+	double bx = earthField * cos(inclination);
+	double bz = earthField * sin(inclination);
+	double x = ch * bx;
+	double y = -sh * bx;
+	double z = bz;
+	const double b[3] = {cp * x - sp * z, cr * y + sr * (sp * x + cp * z),
+		-sr * y + cr * (sp * x + cp * z)};
+
+	Reading r;
+	for (int i = 0; i < 3; i++) {
+		r.accel[i] = (int16_t)lround(g[i] * oneG + accelNoise * normal(random));
+		r.magnet[i] = (int16_t)lround(b[i] + magnetNoise * normal(random));
+	}
+	return r;
+}
+
+
+/** Binary angle to degrees, and the difference of two angles.
+ */
+double degrees(int16_t angle)
+{
+	return angle * 360.0 / 65536;
+}
+
+double error(int16_t angle, double radians)
+{
+	double d = degrees(angle) - radians / degree;
+	return fabs(remainder(d, 360));
+}
+
+
+bool test_accuracy(Random &random)
+{
+	std::normal_distribution<double> normal;
+	MotionFusion fusion;
+	double maxPitch = 0, maxRoll = 0, maxHeading = 0;
+	uint32_t count = 0;
+	uint64_t ns = 0;
+	// The heading is undefined straight up, stop at 80 degrees.
+	for (int pitch = -80; pitch <= 80; pitch += 5) {
+		for (int roll = -175; roll <= 180; roll += 5) {
+			for (int heading = 0; heading < 360; heading += 5) {
+				Reading r = reading(pitch * degree, roll * degree,
+									heading * degree, 0, 0, normal, random);
+				fusion.Reset();
+				uint64_t start = now_ns();
+				const MotionFusion::Orientation &o = fusion.Update(r.accel, r.magnet);
+				ns += now_ns() - start;
+				maxPitch = fmax(maxPitch, error(o.pitch, pitch * degree));
+				maxRoll = fmax(maxRoll, error(o.roll, roll * degree));
+				maxHeading = fmax(maxHeading, error((int16_t)o.heading,
+													heading * degree));
+				count++;
+			}
+		}
+	}
+	// Whole LSBs of gravity and field limit it, not the CORDIC.
+	bool ok = maxPitch < 0.1 && maxRoll < 0.1 && maxHeading < 1;
+	printf("accuracy: %lu orientations, max error pitch %.3f roll %.3f "
+		   "heading %.3f degrees %s\n", (unsigned long)count, maxPitch,
+		   maxRoll, maxHeading, ok ? "ok" : "FAIL");
+	printf("%.0f ns per Update() on this host\n", (double)ns / count);
+	return ok;
+}
+
+
+/** Spread of the angles in degrees and the MIDI changes while still.
+ */
+struct Spread {
+	double pitch, roll, heading;
+	uint32_t bendChanges, modChanges;
+	uint16_t mod;			// Mod wheel at the end.
+};
+
+Spread spread(uint8_t shift, uint32_t samples, Random &random)
+{
+	std::normal_distribution<double> normal;
+	MotionFusion fusion(shift);
+	MotionCurve bendCurve(-MotionFusion::degrees90 / 2,
+						  MotionFusion::degrees90 / 2, MotionCurve::S_CURVE);
+	MotionCurve modCurve(-MotionFusion::degrees90, MotionFusion::degrees90,
+						 MotionCurve::LINEAR);
+	const double pitch = 10 * degree, roll = -20 * degree, heading = 30 * degree;
+	double sum[3] = {0, 0, 0};
+	Spread s = Spread();
+	uint16_t bend = 0, mod = 0;
+	// Let the filter settle first.
+	for (uint32_t i = 0; i < samples + 100; i++) {
+		Reading r = reading(pitch, roll, heading, 5, 4, normal, random);
+		const MotionFusion::Orientation &o = fusion.Update(r.accel, r.magnet);
+		if (i < 100) {
+			continue;
+		}
+		sum[0] += pow(error(o.pitch, pitch), 2);
+		sum[1] += pow(error(o.roll, roll), 2);
+		sum[2] += pow(error((int16_t)o.heading, heading), 2);
+		uint16_t b = bendCurve.Map(o.pitch);
+		uint16_t m = modCurve.Map(o.roll) >> 7;
+		s.bendChanges += (i > 100 && b != bend) ? 1 : 0;
+		s.modChanges += (i > 100 && m != mod) ? 1 : 0;
+		bend = b;
+		mod = m;
+	}
+	s.pitch = sqrt(sum[0] / samples);
+	s.roll = sqrt(sum[1] / samples);
+	s.heading = sqrt(sum[2] / samples);
+	s.mod = mod;
+	return s;
+}
+
+bool test_noise(uint32_t samples, Random &random)
+{
+	Spread raw = spread(0, samples, random);
+	Spread filtered = spread(3, samples, random);
+	for (const Spread *s: {&raw, &filtered}) {
+		printf("noise %s: rms pitch %.3f roll %.3f heading %.3f degrees, "
+			   "pitch bend changes %.0f%% mod wheel changes %.1f%% "
+			   "of the samples, mod wheel at %u\n",
+			   s == &raw ? "unfiltered" : "filtered", s->pitch, s->roll,
+			   s->heading, 100.0 * s->bendChanges / samples,
+			   100.0 * s->modChanges / samples, s->mod);
+	}
+	// A stuck output does not change either: unfiltered the pitch bend
+	// has to follow the noise, and -20 degrees roll is 70/180 of the
+	// mod wheel.
+	bool ok = filtered.pitch < raw.pitch / 2 && filtered.roll < raw.roll / 2 &&
+		filtered.heading < raw.heading / 2 && filtered.heading < 1 &&
+		filtered.modChanges < samples / 100 && raw.bendChanges > samples / 10 &&
+		abs(raw.mod - 127 * 70 / 180) <= 1 && abs(filtered.mod - 127 * 70 / 180) <= 1;
+	printf("noise: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+bool test_latency(Random &random)
+{
+	std::normal_distribution<double> normal;
+	MotionFusion fusion;
+	const double step = 30 * degree;
+	int at63 = -1, at90 = -1;
+	double last = 0;
+	for (int i = 0; i < 200; i++) {
+		double pitch = i == 0 ? 0 : step;
+		Reading r = reading(pitch, 0, 0, 0, 0, normal, random);
+		const MotionFusion::Orientation &o = fusion.Update(r.accel, r.magnet);
+		last = degrees(o.pitch);
+		if (at63 < 0 && last >= 0.63 * 30) {
+			at63 = i;
+		}
+		if (at90 < 0 && last >= 0.9 * 30) {
+			at90 = i;
+		}
+	}
+	bool ok = at63 > 0 && at63 * samplePeriod <= 50 && at90 > 0 &&
+		at90 * samplePeriod <= 100 && fabs(last - 30) < 0.1;
+	printf("latency: 30 degree step, 63%% after %d ms, 90%% after %d ms, "
+		   "settles at %.3f %s\n", at63 * (int)samplePeriod,
+		   at90 * (int)samplePeriod, last, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+bool test_wrap(Random &random)
+{
+	std::normal_distribution<double> normal;
+	MotionFusion fusion;
+	double maxHeading = 0, maxRoll = 0;
+	// Two turns in 4 s, both through north and through 180 degrees.
+	for (int i = 0; i < 800; i++) {
+		double angle = i * 4 * M_PI / 800;
+		Reading r = reading(0, angle, angle, 0, 0, normal, random);
+		const MotionFusion::Orientation &o = fusion.Update(r.accel, r.magnet);
+		if (i > 50) {
+			maxHeading = fmax(maxHeading, error((int16_t)o.heading, angle));
+			maxRoll = fmax(maxRoll, error(o.roll, angle));
+		}
+	}
+	// The filter lags about 7 samples of 0.9 degrees.
+	bool ok = maxHeading < 10 && maxRoll < 10;
+	printf("wrap around: max error while turning heading %.2f roll %.2f "
+		   "degrees %s\n", maxHeading, maxRoll, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+bool test_curves()
+{
+	bool ok = true;
+	for (auto curve: {MotionCurve::LINEAR, MotionCurve::SOFT,
+			MotionCurve::HARD, MotionCurve::S_CURVE}) {
+		// Across 180 degrees, and inverted.
+		MotionCurve up(MotionFusion::degrees90, -MotionFusion::degrees90, curve);
+		MotionCurve down(MotionFusion::degrees90, 0, curve);
+		// Not inverted across 180 degrees, like the mod wheel in main.cpp.
+		MotionCurve roll(-MotionFusion::degrees90, MotionFusion::degrees90, curve);
+		ok = ok && up.Map(MotionFusion::degrees90) == 0 &&
+			up.Map(-MotionFusion::degrees90) == MotionCurve::maxValue &&
+			down.Map(MotionFusion::degrees90) == 0 &&
+			down.Map(0) == MotionCurve::maxValue &&
+			down.Map(-MotionFusion::degrees90) == MotionCurve::maxValue &&
+			roll.Map(-MotionFusion::degrees90) == 0 &&
+			roll.Map(MotionFusion::degrees90) == MotionCurve::maxValue &&
+			roll.Map(-2 * MotionFusion::degrees90 + 1) == 0 &&
+			roll.Map(2 * MotionFusion::degrees90 - 1) == MotionCurve::maxValue;
+		uint16_t last = 0;
+		for (int32_t a = MotionFusion::degrees90; a <= 3 * MotionFusion::degrees90;
+			 a += 16) {
+			uint16_t value = up.Map((int16_t)a);
+			ok = ok && value >= last;
+			last = value;
+		}
+		last = 0;
+		for (int32_t a = -MotionFusion::degrees90; a <= MotionFusion::degrees90; a++) {
+			uint16_t value = roll.Map((int16_t)a);
+			ok = ok && value >= last && (a < -MotionFusion::degrees90 / 2 || value > 0);
+			last = value;
+		}
+		ok = ok && (curve == MotionCurve::SOFT || curve == MotionCurve::HARD ||
+					abs(roll.Map(0) - MotionCurve::maxValue / 2) <= 1);
+	}
+	printf("curves: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: fusiontest [-n samples] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t samples = 20000;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': samples = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (samples == 0) {
+		usage();
+	}
+
+	Random random(seed);
+	bool ok = test_accuracy(random);
+	ok = test_noise(samples, random) && ok;
+	ok = test_latency(random) && ok;
+	ok = test_wrap(random) && ok;
+	ok = test_curves() && ok;
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
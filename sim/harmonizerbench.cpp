@@ -0,0 +1,153 @@
+/** @file harmonizerbench.cpp
+ *
+ * Shows that Harmonizer::Harmonize() costs the same for every note
+ * and every scale.
+ *
+ * For every implemented type of scale (mode 1, root C) and three
+ * interval settings (a third above; third and fifth above; all four
+ * intervals above and below) every note 0..127 is harmonized many
+ * times, the best of three runs counts.  Per scale and setting the
+ * mean time per note is printed with the fastest and slowest note,
+ * the spread between them is what has to stay small.  A few results
+ * in C major are checked.
+ *
+ *   -n reps	harmonizations of every note, default 20000.
+ *
+ * Exits with 1 when a checked result is wrong.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o harmonizerbench harmonizerbench.cpp \
+ *       ../TransformMIDI.cpp ../Chord.cpp ../Scale.cpp ../Mode.cpp \
+ *       ../Note.cpp ../VoiceLeading.cpp ../Harmony.cpp ../HeapProbe.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <unistd.h>
+#include "TransformMIDI.h"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+struct Setting {
+	const char *name;
+	uint8_t intervals;
+	bool above;
+	bool below;
+};
+
+const Setting settings[] = {
+	{"3rd", Harmonizer::THIRD, true, false},
+	{"3rd+5th", Harmonizer::THIRD | Harmonizer::FIFTH, true, false},
+	{"all up+down", Harmonizer::THIRD | Harmonizer::FIFTH
+		| Harmonizer::SIXTH | Harmonizer::OCTAVE, true, true},
+};
+
+
+bool check(Harmonizer &harmonizer)
+{
+	struct Expect {
+		uint8_t note;
+		uint8_t count;
+		uint8_t out[2];
+	};
+	// C major, third and fifth above.
+	static const Expect expected[] = {
+		{60, 2, {64, 67}},	// C: E G
+		{62, 2, {65, 69}},	// D: F A
+		{71, 2, {74, 77}},	// B: D F
+		{61, 2, {65, 68}},	// C#: keeps its distance to C
+		{127, 0, {0, 0}},	// G9: nothing fits above
+	};
+	Scale scl(Scale::TypeOfScale::MAJOR, 0);
+	harmonizer.SetScale(scl, 0);
+	harmonizer.SetIntervals(Harmonizer::THIRD | Harmonizer::FIFTH, true, false);
+	bool ok = true;
+	for (auto &e: expected) {
+		uint8_t out[Harmonizer::maxVoices];
+		unsigned int n = harmonizer.Harmonize(e.note, out);
+		if (n != e.count || memcmp(out, e.out, n) != 0) {
+			printf("note %u: %u notes, expected %u\n", e.note, n, e.count);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: harmonizerbench [-n reps]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t reps = 20000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+			case 'n': reps = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (reps == 0) {
+		usage();
+	}
+
+	static Harmonizer harmonizer(nullptr);
+	bool ok = check(harmonizer);
+	uint32_t sink = 0;
+
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		Scale scl(typeOfScale, 0);
+		if (scl.modes.empty()) {
+			continue;
+		}
+		harmonizer.SetScale(scl, 0);
+		printf("%-40s", scl.Text().c_str());
+		for (auto &setting: settings) {
+			harmonizer.SetIntervals(setting.intervals, setting.above,
+									setting.below);
+			double fastest = 1e9, slowest = 0, total = 0;
+			for (unsigned int note = 0; note < 128; note++) {
+				// Best of three, the rest is the host scheduler.
+				double ns = 1e9;
+				for (unsigned int pass = 0; pass < 3; pass++) {
+					uint8_t out[Harmonizer::maxVoices];
+					uint64_t start = now_ns();
+					for (uint32_t i = 0; i < reps; i++) {
+						sink += harmonizer.Harmonize(note, out);
+					}
+					double passNs = (double)(now_ns() - start) / reps;
+					ns = passNs < ns ? passNs : ns;
+				}
+				total += ns;
+				fastest = ns < fastest ? ns : fastest;
+				slowest = ns > slowest ? ns : slowest;
+			}
+			printf("  %s %5.1f ns (%4.1f..%4.1f)", setting.name,
+				   total / 128, fastest, slowest);
+		}
+		printf("\n");
+	}
+	// Keeps the calls from being optimized away.
+	if (sink == 0) {
+		printf("no notes\n");
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
@@ -0,0 +1,141 @@
+/** @file heapfree.cpp
+ *
+ * Fails when what the MIDI handlers call into touches the heap.
+ *
+ * midireplay -z checks the handlers on recorded traces, which only
+ * reach the scales and chords that were played.  This goes through
+ * all of them, counting operator new (HostHeap.cpp) around every
+ * group of calls:
+ *
+ *   chords		every type of chord on every root,
+ *   scales		every type of scale on every root, all its modes,
+ *   progressions	every type on every mode of every scale, voiced,
+ *   transforms	ScaleQuantize and Harmonizer set to every mode and
+ *				given every note.
+ *
+ * The diatonic cache is filled first, as main() does at boot.
+ *
+ * Exits with 1 when a group allocated.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -DHEAP_PROBE=1 -I.. -o heapfree \
+ *       heapfree.cpp HostHeap.cpp ../HeapProbe.cpp ../TransformMIDI.cpp \
+ *       ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include "Harmony.hpp"
+#include "TransformMIDI.h"
+#include "HeapProbe.hpp"
+
+
+static const ChordProgression::Type allProgressions[] = {
+	ChordProgression::Type::II_V_I,
+	ChordProgression::Type::V_of_V,
+	ChordProgression::Type::I_VI_II_V,
+	ChordProgression::Type::III_VI_II_V,
+	ChordProgression::Type::I_II_III_IV
+};
+
+// Set up before counting, like the objects main.cpp makes at boot.
+static VoiceLeader voiceLeaderGlob;
+static ScaleQuantize quantizeGlob(nullptr);
+static Harmonizer harmonizerGlob(nullptr);
+static uint32_t sinkGlob;
+
+
+void chords()
+{
+	for (auto chordType: Chord::allChordTypes) {
+		for (unsigned int root = 0; root < 128; root++) {
+			Chord chord(chordType, root, root);
+			sinkGlob += chord.notes.size() + chord.PitchClasses().bits;
+		}
+	}
+}
+
+
+void scales()
+{
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		for (unsigned int root = 0; root < 12; root++) {
+			Scale scl(typeOfScale, root);
+			for (unsigned int m = 0; m < scl.modes.size(); m++) {
+				sinkGlob += scl.modes[m].NumOfNotes() + scl.PitchClasses(m).bits;
+			}
+		}
+	}
+}
+
+
+void progressions()
+{
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		Scale scl(typeOfScale, 0);
+		for (unsigned int m = 0; m < scl.modes.size(); m++) {
+			for (auto progType: allProgressions) {
+				ChordProgression progression(scl, m, progType);
+				// Chords() is const, the voice leader wants its own copy.
+				for (auto chord: progression.Chords()) {
+					voiceLeaderGlob.Voice(chord);
+					sinkGlob += chord.voicing.size();
+				}
+			}
+		}
+	}
+}
+
+
+void transforms()
+{
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		Scale scl(typeOfScale, 0);
+		for (unsigned int m = 0; m < scl.modes.size(); m++) {
+			quantizeGlob.SetScale(scl, m);
+			harmonizerGlob.SetScale(scl, m);
+			for (unsigned int note = 0; note < 128; note++) {
+				uint8_t out[Harmonizer::maxVoices];
+				sinkGlob += quantizeGlob.NoteOn(note);
+				sinkGlob += quantizeGlob.NoteOff(note);
+				sinkGlob += harmonizerGlob.Harmonize(note, out);
+			}
+		}
+	}
+}
+
+
+/** Runs 'group' and prints how many allocations it made.
+ */
+bool count(const char *name, void (*group)())
+{
+	HeapCounters start, end;
+	heap_counters(start);
+	group();
+	heap_counters(end);
+	uint32_t allocs = end.allocs - start.allocs;
+	printf("%-14s %6lu allocations %8lu bytes\n", name,
+		   (unsigned long)allocs, (unsigned long)(end.bytes - start.bytes));
+	return allocs == 0;
+}
+
+int main()
+{
+	ChordProgression::Precompute();
+
+	bool ok = count("chords", chords);
+	ok = count("scales", scales) && ok;
+	ok = count("progressions", progressions) && ok;
+	ok = count("transforms", transforms) && ok;
+	// Keeps the calls from being optimized away.
+	if (sinkGlob == 0) {
+		printf("nothing made\n");
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
@@ -0,0 +1,213 @@
+/** @file mbed.h
+ *
+ * The parts of mbed OS that MotionSensor uses, on a host, so the
+ * driver can be tested against a model of the part (sensortest.cpp).
+ *
+ * I2C transfers go to i2c_host_write() and i2c_host_read() and Timer
+ * counts host_us(), the test provides all three.  InterruptIn::Fall()
+ * calls the fall handler of a pin like the interrupt would.  Threads
+ * are std::threads that are never joined, like firmware threads.
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#ifndef mbed_h
+#define mbed_h
+
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+
+enum PinName {
+	PTC6,
+	PTE24,
+	PTE25,
+	numOfPins
+};
+
+enum osPriority {
+	osPriorityNormal = 24,
+	osPriorityAboveNormal = 32
+};
+
+static const uint32_t osFlagsError = 0x80000000U;
+static const uint32_t osFlagsErrorTimeout = 0xFFFFFFFEU;
+
+
+/** Provided by the test: the bus (0 is ACK) and the clock in us.
+ */
+int i2c_host_write(int address, const char *data, int length, bool repeated);
+int i2c_host_read(int address, char *data, int length);
+uint64_t host_us();
+
+
+template<class T>
+std::function<void()> callback(T *object, void (T::*method)())
+{
+	return [object, method]() { (object->*method)(); };
+}
+
+
+namespace Kernel {
+	struct Clock {
+		typedef std::chrono::duration<uint32_t, std::milli> duration_u32;
+	};
+}
+
+
+class I2C {
+public:
+	I2C(PinName, PinName) {};
+	void frequency(int) {};
+	int write(int address, const char *data, int length, bool repeated = false) {
+		return i2c_host_write(address, data, length, repeated);
+	};
+	int read(int address, char *data, int length, bool = false) {
+		return i2c_host_read(address, data, length);
+	};
+};
+
+
+class InterruptIn {
+public:
+	InterruptIn(PinName pinArg) : pin(pinArg) {
+		Pins()[pin] = this;
+	};
+	void fall(std::function<void()> handler) {
+		std::lock_guard<std::mutex> lock(Mutex());
+		onFall = handler;
+	};
+	/** The falling edge on 'pin'.
+	 */
+	static void Fall(PinName pin) {
+		std::lock_guard<std::mutex> lock(Mutex());
+		InterruptIn *in = Pins()[pin];
+		if (in && in->onFall) {
+			in->onFall();
+		}
+	};
+
+private:
+	static InterruptIn **Pins() {
+		static InterruptIn *pins[numOfPins];
+		return pins;
+	};
+	static std::mutex &Mutex() {
+		static std::mutex mutex;
+		return mutex;
+	};
+
+	PinName pin;
+	std::function<void()> onFall;
+};
+
+
+class Timer {
+public:
+	Timer() : begin(0) {};
+	void start() {
+		begin = host_us();
+	};
+	std::chrono::microseconds elapsed_time() const {
+		return std::chrono::microseconds(host_us() - begin);
+	};
+
+private:
+	uint64_t begin;
+};
+
+
+class Thread {
+public:
+	Thread(osPriority = osPriorityNormal, uint32_t = 0) {};
+	void start(std::function<void()> task) {
+		std::thread(task).detach();
+	};
+};
+
+
+class EventFlags {
+public:
+	EventFlags() : flags(0) {};
+	uint32_t set(uint32_t set) {
+		std::lock_guard<std::mutex> lock(mutex);
+		flags |= set;
+		changed.notify_all();
+		return flags;
+	};
+	/** Waits in host time, 'timeout' is not host_us().
+	 */
+	uint32_t wait_any_for(uint32_t wanted, Kernel::Clock::duration_u32 timeout) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!changed.wait_for(lock, timeout, [&]() { return flags & wanted; })) {
+			return osFlagsErrorTimeout;
+		}
+		uint32_t result = flags & wanted;
+		flags &= ~wanted;
+		return result;
+	};
+
+private:
+	std::mutex mutex;
+	std::condition_variable changed;
+	uint32_t flags;
+};
+
+
+template<class T, unsigned int N>
+class Mail {
+public:
+	Mail() : used() {};
+	T *try_alloc() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (unsigned int i = 0; i < N; i++) {
+			if (!used[i]) {
+				used[i] = true;
+				return &pool[i];
+			}
+		}
+		return nullptr;
+	};
+	int put(T *item) {
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(item);
+		changed.notify_all();
+		return 0;
+	};
+	T *try_get() {
+		return try_get_for(Kernel::Clock::duration_u32(0));
+	};
+	T *try_get_for(Kernel::Clock::duration_u32 timeout) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!changed.wait_for(lock, timeout, [&]() { return !queue.empty(); })) {
+			return nullptr;
+		}
+		T *item = queue.front();
+		queue.pop_front();
+		return item;
+	};
+	int free(T *item) {
+		std::lock_guard<std::mutex> lock(mutex);
+		used[item - pool] = false;
+		return 0;
+	};
+
+private:
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<T *> queue;
+	T pool[N];
+	bool used[N];
+};
+
+
+#endif /* mbed_h */
@@ -0,0 +1,225 @@
+/** @file lcdtest.cpp
+ *
+ * LcdFrameBuffer against a model of the HD44780 it drives.
+ *
+ * The model keeps the DDRAM and the address counter like the
+ * controller does (set DDRAM address, putchar moves the address on)
+ * and shows the first 16 characters of each line.  A seeded workload
+ * writes what main.cpp writes: chord names on the first line, the
+ * tempo, controller values and the looper state on the second, all at
+ * their own rates, and now and then a menu over the whole display.  The frame buffer is flushed every 50 ms with at
+ * most 8 characters, like lcd_thread does.  Every simulated second
+ * the writers pause, the buffer is flushed until nothing is left and
+ * the display has to show exactly the text in the buffer.  Now and
+ * then the LCD is cleared behind its back and Invalidate() has to
+ * bring it back.
+ *
+ * The I2C transactions are counted against redrawing everything and
+ * redrawing the lines that changed on every flush.
+ *
+ *   -t sec		simulated time, default 600.
+ *   -s seed	seed of the workload, default 1.
+ *
+ * Exits with 1 when the display did not show the buffer.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o lcdtest lcdtest.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "LcdFrameBuffer.hpp"
+#include "Random.hpp"
+
+
+/** HD44780 in two line mode, only what Flush() uses.
+ */
+class ModelLcd {
+public:
+	ModelLcd() {
+		Clear();
+	};
+	void write(uint8_t command) {
+		transactions++;
+		if (command & 0x80) {
+			address = command & 0x7F;
+		}
+	};
+	void putchar(char c) {
+		transactions++;
+		ddram[address] = c;
+		// Line 1 is 0x00..0x27, line 2 0x40..0x67, one follows the other.
+		if (address == 0x27) {
+			address = 0x40;
+		}
+		else if (address == 0x67) {
+			address = 0x00;
+		}
+		else {
+			address++;
+		}
+	};
+	void Clear() {
+		memset(ddram, ' ', sizeof(ddram));
+		address = 0;
+	};
+	/** What a 16x2 display shows.
+	 */
+	char Shown(unsigned int row, unsigned int column) const {
+		return ddram[(row ? 0x40 : 0x00) + column];
+	};
+
+	uint32_t transactions = 0;
+
+private:
+	char ddram[0x80];
+	uint8_t address;
+};
+
+
+/** Copy of what the frame buffer should say.
+ */
+struct Screen {
+	char text[LcdFrameBuffer::rows][LcdFrameBuffer::columns];
+
+	void Print(LcdFrameBuffer &lcd, unsigned int row, unsigned int column,
+			   const char *str, bool fill = true) {
+		lcd.Print(row, column, str, fill);
+		while (column < LcdFrameBuffer::columns && *str) {
+			text[row][column++] = *str++;
+		}
+		while (fill && column < LcdFrameBuffer::columns) {
+			text[row][column++] = ' ';
+		}
+	};
+};
+
+
+bool same(const ModelLcd &model, const Screen &screen)
+{
+	for (unsigned int row = 0; row < LcdFrameBuffer::rows; row++) {
+		for (unsigned int column = 0; column < LcdFrameBuffer::columns; column++) {
+			if (model.Shown(row, column) != screen.text[row][column]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: lcdtest [-t seconds] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *chords[] = {"C", "Dm7", "G7", "Cmaj7", "F#m7b5",
+		"B7", "Em", "Am9", "Dbmaj7#11", "Gsus4"};
+	static const char *looper[] = {"empty", "rec", "play", "dub"};
+	uint32_t seconds = 600;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:s:")) != -1) {
+		switch (opt) {
+			case 't': seconds = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (seconds == 0) {
+		usage();
+	}
+
+	LcdFrameBuffer lcd;
+	ModelLcd model;
+	Screen screen;
+	memset(screen.text, ' ', sizeof(screen.text));
+	Random random(seed);
+	uint32_t checks = 0;
+	uint32_t wrong = 0;
+	uint32_t flushes = 0;
+	uint32_t changedLines = 0;	// Lines that differ at a flush.
+	Screen flushed = screen;
+
+	for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+		char text[LcdFrameBuffer::columns + 1];
+		bool pause = ms % 1000 >= 900;
+
+		// Chords come with the notes, the rest at its own rate.
+		if (!pause && random.Below(250) == 0) {
+			screen.Print(lcd, 0, 0, chords[random.Below(10)]);
+		}
+		if (!pause && ms % 500 == 0) {
+			snprintf(text, sizeof(text), "%3u BPM", 60 + random.Below(120));
+			screen.Print(lcd, 1, 8, text);
+		}
+		if (!pause && random.Below(30) == 0) {
+			snprintf(text, sizeof(text), "CC%-3u%3u", random.Below(128),
+					 random.Below(128));
+			screen.Print(lcd, 1, 0, text, false);
+		}
+		if (!pause && random.Below(5000) == 0) {
+			screen.Print(lcd, 0, 11, looper[random.Below(4)]);
+		}
+		if (!pause && random.Below(2000) == 0) {
+			for (unsigned int row = 0; row < LcdFrameBuffer::rows; row++) {
+				for (unsigned int i = 0; i < LcdFrameBuffer::columns; i++) {
+					text[i] = ' ' + random.Below(95);
+				}
+				text[LcdFrameBuffer::columns] = 0;
+				screen.Print(lcd, row, 0, text);
+			}
+		}
+		if (random.Below(60000) == 0) {
+			model.Clear();
+			lcd.Invalidate();
+		}
+
+		if (ms % 50 == 0) {
+			for (unsigned int row = 0; row < LcdFrameBuffer::rows; row++) {
+				if (memcmp(flushed.text[row], screen.text[row],
+						   LcdFrameBuffer::columns)) {
+					changedLines++;
+				}
+			}
+			flushed = screen;
+			lcd.Flush(model, 8);
+			flushes++;
+		}
+		if (ms % 1000 == 999) {
+			while (lcd.Flush(model, 8)) {
+			}
+			checks++;
+			if (!same(model, screen)) {
+				wrong++;
+			}
+		}
+	}
+
+	const LcdFrameBuffer::Statistics &stats = lcd.Stats();
+	uint32_t full = flushes * (LcdFrameBuffer::cells + LcdFrameBuffer::rows);
+	uint32_t lines = changedLines * (LcdFrameBuffer::columns + 1);
+	printf("%lu flushes %lu characters %lu addresses %lu unchanged\n",
+		   (unsigned long)stats.flushes, (unsigned long)stats.characters,
+		   (unsigned long)stats.addresses, (unsigned long)stats.unchanged);
+	printf("transactions: %lu diffed, %lu changed lines (%.1fx), "
+		   "%lu full redraws (%.1fx)\n",
+		   (unsigned long)model.transactions, (unsigned long)lines,
+		   (double)lines / model.transactions, (unsigned long)full,
+		   (double)full / model.transactions);
+	printf("%lu checks %lu wrong\n", (unsigned long)checks,
+		   (unsigned long)wrong);
+	return wrong ? 1 : 0;
+}
+
+
+/* EOF */
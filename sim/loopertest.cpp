@@ -0,0 +1,394 @@
+/** @file loopertest.cpp
+ *
+ * Memory use and round trips of the recorder and looper.
+ *
+ * A seeded stream of played channel messages (notes and chords,
+ * controllers, pitch bend, pressure and program changes, a few
+ * channels) is recorded in four ways:
+ *
+ *   ring		into a large EventRing, read back it has to be the same
+ *				messages at the same ticks.  The bytes per event are
+ *				reported.
+ *   smf		the ring written out with WriteSmf() and played by
+ *				SmfPlayer has to give the same messages at the same
+ *				times.  Recorded again into a new ring and written out
+ *				it has to be the same file, byte for byte.
+ *   board		into a ring as big as main.cpp gives the looper, the
+ *				newest events that fit have to read back the same and
+ *				make a valid SMF the same way.
+ *   looper		as the first layer of a MidiLooper under a 120 BPM
+ *				MIDI clock, after a count-in of one beat.  After the
+ *				loop is closed one pass has to play every message
+ *				again in order, one loop length later, within a tick.
+ *
+ *   -n events	messages in the stream, default 100000.
+ *   -s seed	seed of the stream, default 1.
+ *
+ * Exits with 1 when a round trip was not exact.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o loopertest loopertest.cpp \
+ *       ../MidiLooper.cpp ../MidiFile.cpp ../MidiParser.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "MidiLooper.hpp"
+#include "MidiFile.hpp"
+#include "Random.hpp"
+
+
+struct Event {
+	uint64_t time;		// us
+	uint8_t len;
+	uint8_t msg[3];
+};
+
+bool same(const Event &a, const Event &b)
+{
+	return a.time == b.time && a.len == b.len &&
+		memcmp(a.msg, b.msg, a.len) == 0;
+}
+
+
+// Ticks of 1 ms for the rings and the SMF: division 500 at 120 BPM.
+static const uint64_t usPerTick = 1000;
+static const uint16_t division = 500;
+static const uint32_t tempo = 500000;
+
+// Storage of the looper in main.cpp.
+static const size_t boardRing = 16 * 1024;
+
+
+static std::vector<uint8_t> fileGlob;
+static std::vector<Event> sentGlob;
+static uint64_t nowGlob;
+
+void file_output(const uint8_t *data, size_t len)
+{
+	fileGlob.insert(fileGlob.end(), data, data + len);
+}
+
+void sink(const UmpEvent &event)
+{
+	Event sent;
+	sent.time = nowGlob;
+	sent.len = event.ToBytes(sent.msg);
+	sentGlob.push_back(sent);
+}
+
+
+/** Played messages, every note is released before the end.
+ */
+std::vector<Event> make_stream(uint32_t count, uint32_t seed)
+{
+	static const uint8_t controllers[] = {1, 7, 10, 11, 64, 71, 74};
+	std::vector<Event> stream;
+	std::vector<uint16_t> held;		// channel << 8 | note
+	Random random(seed);
+	uint64_t time = 0;
+
+	while (stream.size() < count) {
+		// Chords and runs, now and then a rest.
+		if (random.Below(3)) {
+			time += random.Below(random.Below(50) ? 60000 : 2000000);
+		}
+		Event event;
+		event.time = time;
+		uint8_t channel = random.Below(8) ? 0 : random.Below(3);
+		unsigned int kind = random.Below(100);
+		// The last messages release what is still held.
+		bool last = stream.size() + held.size() >= count;
+		if (!held.empty() &&
+			(last || (kind < 70 && (held.size() > 10 || random.Below(2))))) {
+			unsigned int i = random.Below(held.size());
+			event.msg[0] = 0x80 | (held[i] >> 8);
+			event.msg[1] = held[i] & 0x7F;
+			event.msg[2] = random.Below(128);
+			event.len = 3;
+			held.erase(held.begin() + i);
+		}
+		else if (kind < 70) {
+			// Room for its note off too.
+			if (stream.size() + held.size() + 1 >= count) {
+				continue;
+			}
+			uint8_t note = 24 + random.Below(80);
+			event.msg[0] = 0x90 | channel;
+			event.msg[1] = note;
+			event.msg[2] = 1 + random.Below(127);
+			event.len = 3;
+			for (auto h: held) {
+				if (h == (channel << 8 | note)) {
+					event.msg[0] = 0xA0 | channel;	// Poly pressure then.
+				}
+			}
+			if ((event.msg[0] & 0xF0) == 0x90) {
+				held.push_back(channel << 8 | note);
+			}
+		}
+		else if (kind < 90) {
+			event.msg[0] = 0xB0 | channel;
+			event.msg[1] = controllers[random.Below(sizeof(controllers))];
+			event.msg[2] = random.Below(128);
+			event.len = 3;
+		}
+		else if (kind < 96) {
+			event.msg[0] = 0xE0 | channel;
+			event.msg[1] = random.Below(128);
+			event.msg[2] = random.Below(128);
+			event.len = 3;
+		}
+		else {
+			event.msg[0] = (kind < 98 ? 0xD0 : 0xC0) | channel;
+			event.msg[1] = random.Below(128);
+			event.msg[2] = 0;
+			event.len = 2;
+		}
+		stream.push_back(event);
+	}
+	return stream;
+}
+
+
+/** Everything in the ring, with ticks as times.
+ */
+std::vector<Event> read_ring(const EventRing &ring)
+{
+	std::vector<Event> events;
+	EventRing::Reader reader = ring.Read();
+	Event event;
+	uint32_t tick;
+	while ((event.len = reader.Next(tick, event.msg)) != 0) {
+		event.time = tick * usPerTick;
+		events.push_back(event);
+	}
+	return events;
+}
+
+
+bool record(EventRing &ring, const std::vector<Event> &stream)
+{
+	ring.Clear();
+	for (auto &event: stream) {
+		if (!ring.Append(event.time / usPerTick, event.msg, event.len)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/** Writes the ring as SMF and plays it back, it has to be 'expected'
+ * with the times from 'origin', the tick before the oldest event.
+ * Recorded again and written out it has to give the same file.
+ */
+bool smf_round_trip(const EventRing &ring, const std::vector<Event> &expected,
+					uint64_t origin, size_t size)
+{
+	fileGlob.clear();
+	size_t written = ring.WriteSmf(&file_output, division, tempo);
+	std::vector<uint8_t> file = fileGlob;
+
+	SmfPlayer player(&sink);
+	sentGlob.clear();
+	if (written != file.size() || !player.Open(file.data(), file.size())) {
+		return false;
+	}
+	while (!player.Finished()) {
+		nowGlob = player.NextEventTime();
+		player.Play(nowGlob);
+	}
+	if (sentGlob.size() != expected.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < expected.size(); i++) {
+		Event event = expected[i];
+		event.time -= origin;
+		if (!same(sentGlob[i], event)) {
+			return false;
+		}
+	}
+
+	std::vector<uint8_t> storage(size);
+	EventRing again(storage.data(), size);
+	if (!record(again, sentGlob)) {
+		return false;
+	}
+	fileGlob.clear();
+	again.WriteSmf(&file_output, division, tempo);
+	return fileGlob == file;
+}
+
+
+bool test_rings(const std::vector<Event> &stream)
+{
+	// Large enough for all of it.
+	size_t size = 1;
+	while (size < stream.size() * EventRing::maxEncoded) {
+		size <<= 1;
+	}
+	std::vector<uint8_t> storage(size);
+	EventRing ring(storage.data(), size);
+	bool ok = record(ring, stream);
+
+	std::vector<Event> expected;
+	for (auto event: stream) {
+		event.time = event.time / usPerTick * usPerTick;
+		expected.push_back(event);
+	}
+	std::vector<Event> events = read_ring(ring);
+	bool ringOk = ok && ring.Dropped() == 0 && events.size() == expected.size();
+	for (size_t i = 0; ringOk && i < events.size(); i++) {
+		ringOk = same(events[i], expected[i]);
+	}
+	printf("ring    %7lu events %8lu bytes %5.2f bytes/event %s\n",
+		   (unsigned long)ring.Events(), (unsigned long)ring.Bytes(),
+		   (double)ring.Bytes() / ring.Events(), ringOk ? "ok" : "FAIL");
+
+	bool smfOk = ok && smf_round_trip(ring, expected, 0, size);
+	printf("smf     %7lu events %8lu bytes %s\n",
+		   (unsigned long)sentGlob.size(), (unsigned long)fileGlob.size(),
+		   smfOk ? "ok" : "FAIL");
+
+	// Only the newest events fit, the rest is dropped.
+	std::vector<uint8_t> boardStorage(boardRing);
+	EventRing board(boardStorage.data(), boardRing);
+	ok = record(board, stream);
+	std::vector<Event> newest(expected.end() - board.Events(), expected.end());
+	events = read_ring(board);
+	bool boardOk = ok && board.Events() + board.Dropped() == stream.size() &&
+		events.size() == newest.size();
+	for (size_t i = 0; boardOk && i < events.size(); i++) {
+		boardOk = same(events[i], newest[i]);
+	}
+	// The SMF starts at the last event that was dropped.
+	uint64_t origin = board.Dropped() ?
+		expected[board.Dropped() - 1].time : 0;
+	boardOk = boardOk && smf_round_trip(board, newest, origin, boardRing);
+	printf("board   %7lu events %8lu bytes %7lu dropped %s\n",
+		   (unsigned long)board.Events(), (unsigned long)board.Bytes(),
+		   (unsigned long)board.Dropped(), boardOk ? "ok" : "FAIL");
+	return ringOk && smfOk && boardOk;
+}
+
+
+bool test_looper(const std::vector<Event> &stream)
+{
+	// 120 BPM, 24 clocks a beat, the looper interpolates to 4 ticks.
+	const double clockUs = 500000.0 / 24;
+	const double tickUs = clockUs / MidiLooper::ticksPerClock;
+	const uint64_t pollUs = 1000;
+
+	size_t size = 1;
+	while (size < stream.size() * EventRing::maxEncoded) {
+		size <<= 1;
+	}
+	std::vector<uint8_t> storage(size);
+	MidiLooper looper(storage.data(), size, &sink);
+	sentGlob.clear();
+
+	// Start and the first clock at t0, recording starts right there.
+	// Until the second clock there is no tempo to place events with,
+	// the playing starts after a count-in of one beat.
+	uint64_t t0 = 1000;
+	uint64_t countIn = 500000;
+	uint64_t clock = 0;
+	auto clock_time = [&](uint64_t n) {
+		return t0 + (uint64_t)(n * clockUs + 0.5);
+	};
+	auto clocks_until = [&](uint64_t time) {
+		while (clock_time(clock) <= time) {
+			nowGlob = clock_time(clock);
+			looper.Realtime(0xF8, nowGlob);
+			looper.Play(nowGlob);
+			clock++;
+		}
+	};
+	looper.Realtime(0xFA, t0);
+	clocks_until(t0);
+	looper.Record(t0);
+
+	for (auto &event: stream) {
+		uint64_t time = t0 + countIn + event.time;
+		clocks_until(time);
+		UmpEvent ump;
+		UmpEvent::FromBytes(event.msg, event.len, ump);
+		looper.Input(ump, time);
+	}
+	// Closed on the next beat after a beat of silence.
+	uint64_t beats = (clock + 24) / 24 + 1;
+	clocks_until(clock_time(beats * 24));
+	looper.Record(clock_time(beats * 24));
+	uint64_t loopUs = clock_time(beats * 24) - t0;
+	size_t bytes = looper.Bytes();
+
+	// One pass, polled every ms like the looper thread.
+	sentGlob.clear();
+	uint64_t end = clock_time(2 * beats * 24) - 1;
+	for (uint64_t now = clock_time(beats * 24); now < end; now += pollUs) {
+		clocks_until(now);
+		nowGlob = now;
+		looper.Play(now);
+	}
+
+	bool ok = looper.GetState() == MidiLooper::PLAYING &&
+		looper.Dropped() == 0 && sentGlob.size() == stream.size();
+	double worst = 0;
+	for (size_t i = 0; ok && i < stream.size(); i++) {
+		const Event &in = stream[i];
+		const Event &out = sentGlob[i];
+		double late = (double)out.time -
+			(double)(t0 + countIn + in.time + loopUs);
+		ok = out.len == in.len && memcmp(out.msg, in.msg, in.len) == 0 &&
+			late > -tickUs - 1 && late < tickUs + pollUs + 1;
+		worst = late > worst ? late : -late > worst ? -late : worst;
+	}
+	printf("looper  %7lu events %8lu bytes %5.2f bytes/event "
+		   "%4lu beats, worst %.0f us off %s\n",
+		   (unsigned long)sentGlob.size(), (unsigned long)bytes,
+		   (double)bytes / stream.size(), (unsigned long)beats, worst,
+		   ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: loopertest [-n events] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = 100000;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': count = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (count < 2) {
+		usage();
+	}
+
+	std::vector<Event> stream = make_stream(count, seed);
+	printf("%lu messages over %.0f s of playing\n",
+		   (unsigned long)stream.size(), stream.back().time / 1e6);
+	bool ok = test_rings(stream);
+	ok = test_looper(stream) && ok;
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
@@ -0,0 +1,147 @@
+/** @file melodybench.cpp
+ *
+ * Checks and times the MelodyEngine on a host.
+ *
+ * For every seed the engine plays the steps twice in HARMONIC_MINOR
+ * (as main.cpp sets it up) and the notes of both runs have to be the
+ * same, a checksum of them is printed so runs on other machines or
+ * after a change can be compared.  Then the steps are timed, the sink
+ * only adds up the notes so it is the engine that is measured.  No
+ * step may touch the heap.
+ *
+ *   -n steps	16th notes per run, default 1000000.
+ *   -s seed	first seed, default 1.
+ *   -c count	number of seeds, default 8.
+ *   -d pct		density of the rhythm, default the engine's.
+ *
+ * Exits with 1 when a seed did not repeat or the heap was used.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=gnu++14 -O2 -Wall -DHEAP_PROBE=1 -I.. -o melodybench \
+ *       melodybench.cpp HostHeap.cpp ../HeapProbe.cpp ../MelodyEngine.cpp \
+ *       ../Ump.cpp ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+#include "MelodyEngine.hpp"
+#include "StaticScale.hpp"
+#include "HeapProbe.hpp"
+
+
+// FNV-1a over the notes, and how many there were.
+static uint32_t checksumGlob;
+static uint32_t notesGlob;
+
+void melody_sink(const UmpEvent &event)
+{
+	uint8_t msg[3];
+	size_t len = event.ToBytes(msg);
+	for (size_t i = 0; i < len; i++) {
+		checksumGlob = (checksumGlob ^ msg[i]) * 16777619u;
+	}
+	if ((msg[0] & 0xF0) == 0x90) {
+		notesGlob++;
+	}
+}
+
+
+struct Run {
+	uint32_t checksum;
+	uint32_t notes;
+	uint64_t ns;
+};
+
+Run run(const MelodyEngine::Parameters &parameters, uint32_t seed,
+		uint32_t steps)
+{
+	MelodyEngine melody(&melody_sink, 1);
+	melody.SetParameters(parameters);
+	melody.SetScale(StaticScale<Scale::TypeOfScale::HARMONIC_MINOR, 0>::PitchClasses(0));
+	melody.Seed(seed);
+	checksumGlob = 2166136261u;
+	notesGlob = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t step = 0; step < steps; step++) {
+		melody.Step(step);
+	}
+	melody.Stop();
+	auto end = std::chrono::steady_clock::now();
+
+	Run result;
+	result.checksum = checksumGlob;
+	result.notes = notesGlob;
+	result.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			end - start).count();
+	return result;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: melodybench [-n steps] [-s seed] [-c count] "
+			"[-d density%%]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t steps = 1000000;
+	uint32_t firstSeed = 1;
+	uint32_t count = 8;
+	MelodyEngine::Parameters parameters = MelodyEngine::defaults;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:c:d:")) != -1) {
+		switch (opt) {
+			case 'n': steps = strtoul(optarg, nullptr, 0); break;
+			case 's': firstSeed = strtoul(optarg, nullptr, 0); break;
+			case 'c': count = strtoul(optarg, nullptr, 0); break;
+			case 'd': parameters.density = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	if (steps == 0 || count == 0) {
+		usage();
+	}
+
+	bool ok = true;
+	uint64_t totalNs = 0;
+	uint64_t totalSteps = 0;
+	HeapCounters start, end;
+	heap_counters(start);
+	for (uint32_t seed = firstSeed; seed < firstSeed + count; seed++) {
+		Run first = run(parameters, seed, steps);
+		Run again = run(parameters, seed, steps);
+		bool same = first.checksum == again.checksum
+			&& first.notes == again.notes;
+		ok = ok && same;
+		uint64_t ns = first.ns < again.ns ? first.ns : again.ns;
+		totalNs += ns;
+		totalSteps += steps;
+		printf("seed %10lu notes %9lu checksum %08lx %6.1f ns/step%s\n",
+			   (unsigned long)seed, (unsigned long)first.notes,
+			   (unsigned long)first.checksum, (double)ns / steps,
+			   same ? "" : "  NOT REPEATABLE");
+	}
+	heap_counters(end);
+
+	printf("%llu steps, %.1f ns/step, %lu allocations\n",
+		   (unsigned long long)totalSteps, (double)totalNs / totalSteps,
+		   (unsigned long)(end.allocs - start.allocs));
+	if (end.allocs != start.allocs) {
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
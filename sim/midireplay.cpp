@@ -0,0 +1,510 @@
+/** @file midireplay.cpp
+ *
+ * Records MIDI sessions to traces (MidiTrace.hpp) and replays them
+ * through the firmware's MIDI path (SimPath.hpp) as a benchmark:
+ * parser, transform (the chords of midi_note_on_handler) and the
+ * transmit scheduler and encoder.
+ *
+ *   midireplay -R out.mtr -i device	record from a MIDI device, fifo
+ *   midireplay -R out.mtr -p			or from a new pseudo terminal,
+ *										until end of input or ^C.
+ *   midireplay -G kind -o out.mtr		write one of the generated
+ *										traces of the corpus (below).
+ *   midireplay [-x speed] [-n times] [-H] [-z] [-o output] trace...
+ *
+ * A replay runs at 'speed' times real time (-x 1, -x 10), or as fast
+ * as possible without -x.  The input latency figures are in trace
+ * time with the wire modelled and do not depend on the speed, which
+ * only decides how the replay is paced on the host (e.g. to feed a
+ * real device with -o); when paced it also reports how late the host
+ * got to the events.  For every trace it reports the throughput, the
+ * latency percentiles, the time the transform took per message and
+ * the heap allocations made during the replay, which should be none,
+ * per handler and Harmony constructor (HeapProbe.hpp).  With -z it
+ * fails (exit status 3) when any of them allocated, as a regression
+ * gate.
+ *
+ * The corpus in traces/ is made with -G and is the yardstick for
+ * performance work on this path:
+ *   chords		dense 6 note chords on every 16th at 120 BPM with
+ *				sustain pedal, running status, 10 s.
+ *   clockcc	MIDI clock at 120 BPM in a flood of modulation,
+ *				brightness and pitch bend at the full wire rate, the
+ *				clock bytes cut into the messages, 10 s.
+ *   sysex		a 2 KB SysEx dump every second with a melody and
+ *				active sensing in between, 10 s.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -DHEAP_PROBE=1 -I.. -o midireplay \
+ *       midireplay.cpp SimPath.cpp MidiTrace.cpp HostHeap.cpp ../HeapProbe.cpp \
+ *       ../Ump.cpp ../MidiParser.cpp ../MidiTransform.cpp \
+ *       ../TxScheduler.cpp ../OneEuroFilter.cpp ../TransformMIDI.cpp \
+ *       ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SimPath.hpp"
+#include "MidiTrace.hpp"
+#include "HeapProbe.hpp"
+
+
+const uint32_t byteTime = MidiTrace::byteTime;
+
+
+/////////////////////////////////////////////////////////////////
+//  Recording
+/////////////////////////////////////////////////////////////////
+static volatile sig_atomic_t stopGlob;
+
+void stop_handler(int)
+{
+	stopGlob = 1;
+}
+
+int record(const char *path, int inputFd)
+{
+	MidiTrace trace;
+	uint64_t start = host_ns() / 1000;
+	uint64_t end = 0;		// Of the previous chunk.
+	uint64_t bytes = 0;
+
+	signal(SIGINT, stop_handler);
+	signal(SIGTERM, stop_handler);
+	while (!stopGlob) {
+		struct pollfd pfd = {inputFd, POLLIN, 0};
+		if (poll(&pfd, 1, 100) <= 0) {
+			continue;
+		}
+		uint8_t buf[256];
+		ssize_t n = read(inputFd, buf, sizeof(buf));
+		if (n <= 0) {
+			break;
+		}
+		// The bytes read came in back to back up to now.
+		uint64_t now = host_ns() / 1000 - start;
+		uint64_t back = (uint64_t)(n - 1) * byteTime;
+		uint64_t first = now > back ? now - back : 0;
+		if (first < end) {
+			first = end;
+		}
+		trace.Add(first, buf, n);
+		end = first + n * byteTime;
+		bytes += n;
+	}
+	if (!trace.Save(path)) {
+		perror(path);
+		return 1;
+	}
+	printf("%s: %llu bytes in %.1f s, trace of %lu bytes\n", path,
+		   (unsigned long long)bytes, trace.Duration() / 1e6,
+		   (unsigned long)trace.Size() + 5);
+	return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////
+//  The corpus
+/////////////////////////////////////////////////////////////////
+
+/** Puts messages on a modelled wire: bytes go out one every 320 us
+ * in the order of their messages, realtime bytes go first and may cut
+ * into a message like they do on a real cable.
+ */
+class WireBuilder {
+public:
+	void Message(uint64_t time, const uint8_t *data, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			normal.push_back(Timed{time, data[i]});
+		}
+	};
+	void Realtime(uint64_t time, uint8_t byte) {
+		realtime.push_back(Timed{time, byte});
+	};
+	/** Both must have been added in time order.
+	 */
+	void Build(MidiTrace &trace) {
+		size_t i = 0, j = 0;
+		uint64_t slot = 0;
+		uint64_t chunkStart = 0;
+		std::vector<uint8_t> chunk;
+
+		while (i < normal.size() || j < realtime.size()) {
+			const Timed *next = nullptr;
+			if (j < realtime.size() && realtime[j].time <= slot) {
+				next = &realtime[j++];
+			}
+			else if (i < normal.size() && normal[i].time <= slot) {
+				next = &normal[i++];
+			}
+			if (next == nullptr) {
+				// Idle wire until the next byte is due.
+				uint64_t due = ~(uint64_t)0;
+				if (i < normal.size()) {
+					due = normal[i].time;
+				}
+				if (j < realtime.size() && realtime[j].time < due) {
+					due = realtime[j].time;
+				}
+				slot = due;
+				continue;
+			}
+			if (!chunk.empty() && slot != chunkStart + chunk.size() * byteTime) {
+				trace.Add(chunkStart, chunk.data(), chunk.size());
+				chunk.clear();
+			}
+			if (chunk.empty()) {
+				chunkStart = slot;
+			}
+			chunk.push_back(next->byte);
+			slot += byteTime;
+		}
+		if (!chunk.empty()) {
+			trace.Add(chunkStart, chunk.data(), chunk.size());
+		}
+	};
+
+private:
+	struct Timed {
+		uint64_t time;
+		uint8_t byte;
+	};
+	std::vector<Timed> normal;
+	std::vector<Timed> realtime;
+};
+
+
+const uint64_t corpusLength = 10000000;		// us
+const uint64_t sixteenth = 125000;			// us at 120 BPM
+const uint64_t clockTick = 20833;			// us, 24 per beat at 120 BPM
+
+void generate_chords(WireBuilder &wire, Random &random)
+{
+	static const uint8_t shapes[4][6] = {
+		{0, 4, 7, 12, 16, 19},
+		{0, 3, 7, 12, 15, 19},
+		{0, 4, 7, 10, 14, 17},
+		{0, 3, 6, 10, 12, 15}
+	};
+	uint8_t msg[3];
+	bool sustain = false;
+
+	for (uint64_t t = 0; t < corpusLength; t += sixteenth) {
+		if (t % 2000000 == 0) {
+			sustain = !sustain;
+			msg[0] = 0xB0;
+			msg[1] = 64;
+			msg[2] = sustain ? 127 : 0;
+			wire.Message(t, msg, 3);
+		}
+		const uint8_t *shape = shapes[random.Below(4)];
+		uint8_t root = 36 + random.Below(24);
+		// Running status: one status byte for the whole chord.
+		msg[0] = 0x90;
+		wire.Message(t, msg, 1);
+		for (unsigned int i = 0; i < 6; i++) {
+			msg[0] = root + shape[i];
+			msg[1] = 40 + random.Below(80);
+			wire.Message(t, msg, 2);
+		}
+		for (unsigned int i = 0; i < 6; i++) {
+			msg[0] = root + shape[i];
+			msg[1] = 0;
+			wire.Message(t + 100000, msg, 2);
+		}
+	}
+}
+
+void generate_clockcc(WireBuilder &wire, Random &random)
+{
+	static const uint8_t controllers[2] = {1, 74};
+	uint8_t msg[3];
+	uint16_t bend = 0x2000;
+
+	wire.Realtime(0, 0xFA);
+	for (uint64_t t = clockTick; t < corpusLength; t += clockTick) {
+		wire.Realtime(t, 0xF8);
+	}
+	// Three bytes every 960 us fill the wire.
+	for (uint64_t t = 0; t < corpusLength; t += 3 * byteTime) {
+		uint32_t r = random.Below(3);
+		if (r < 2) {
+			msg[0] = 0xB0;
+			msg[1] = controllers[r];
+			msg[2] = (t / 10000 + r * 40) & 0x7F;
+		}
+		else {
+			bend = (bend + random.Below(256) - 128) & 0x3FFF;
+			msg[0] = 0xE0;
+			msg[1] = bend & 0x7F;
+			msg[2] = bend >> 7;
+		}
+		wire.Message(t, msg, 3);
+	}
+}
+
+void generate_sysex(WireBuilder &wire, Random &random)
+{
+	uint8_t msg[3];
+	std::vector<uint8_t> dump(2048);
+
+	for (uint64_t t = 0; t < corpusLength; t += 300000) {
+		wire.Realtime(t, 0xFE);
+	}
+	for (uint64_t t = 0; t < corpusLength; t += 1000000) {
+		// Universal non realtime, a sample dump header and data.
+		dump[0] = 0xF0;
+		dump[1] = 0x7E;
+		for (size_t i = 2; i < dump.size() - 1; i++) {
+			dump[i] = random.Below(128);
+		}
+		dump[dump.size() - 1] = 0xF7;
+		wire.Message(t, dump.data(), dump.size());
+		// A melody in the rest of the second.
+		for (uint64_t n = t + 700000; n < t + 1000000; n += 100000) {
+			msg[0] = 0x90;
+			msg[1] = 60 + random.Below(12);
+			msg[2] = 100;
+			wire.Message(n, msg, 3);
+			msg[0] = 0x80;
+			msg[2] = 64;
+			wire.Message(n + 80000, msg, 3);
+		}
+	}
+}
+
+int generate(const char *kind, const char *path)
+{
+	WireBuilder wire;
+	Random random(1);
+	MidiTrace trace;
+
+	if (strcmp(kind, "chords") == 0) {
+		generate_chords(wire, random);
+	}
+	else if (strcmp(kind, "clockcc") == 0) {
+		generate_clockcc(wire, random);
+	}
+	else if (strcmp(kind, "sysex") == 0) {
+		generate_sysex(wire, random);
+	}
+	else {
+		fprintf(stderr, "%s: not chords, clockcc or sysex\n", kind);
+		return 2;
+	}
+	wire.Build(trace);
+	if (!trace.Save(path)) {
+		perror(path);
+		return 1;
+	}
+	return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////
+//  Replay
+/////////////////////////////////////////////////////////////////
+uint32_t heap_allocs()
+{
+	HeapCounters counters;
+	heap_counters(counters);
+	return counters.allocs;
+}
+
+int replay(const char *tracePath, uint32_t speed, unsigned int times,
+		   bool harmonies, bool heapGate, int outputFd)
+{
+	MidiTrace trace;
+	if (!trace.Load(tracePath)) {
+		fprintf(stderr, "%s: not a trace\n", tracePath);
+		return 1;
+	}
+	// Repeats are played one after the other with a beat in between.
+	uint64_t length = trace.Duration() + 500000;
+	printf("%s: %.1f s x %u", tracePath, trace.Duration() / 1e6, times);
+	if (speed) {
+		printf(" at x%lu\n", (unsigned long)speed);
+	}
+	else {
+		printf(" as fast as possible\n");
+	}
+
+	SimPath path(harmonies, outputFd);
+	LatencyHistogram late;
+	MidiTrace::Reader reader(trace);
+	uint64_t offset = 0;
+	uint64_t chunkTime = 0;
+	const uint8_t *chunk = nullptr;
+	size_t chunkLength = 0;
+	size_t chunkPosition = 0;
+	unsigned int round = 1;
+	uint64_t now = 0;
+	uint32_t heapAllocs = heap_allocs();
+	HeapProbe::Clear();
+	uint64_t hostStart = host_ns();
+
+	bool have = reader.Next(chunkTime, chunk, chunkLength);
+	while (true) {
+		if (!have && round < times) {
+			reader.Rewind();
+			offset += length;
+			round++;
+			have = reader.Next(chunkTime, chunk, chunkLength);
+		}
+		// Whatever happens first: the next input byte or the path.
+		uint64_t next = ~(uint64_t)0;
+		if (have) {
+			next = offset + chunkTime + chunkPosition * byteTime;
+		}
+		uint32_t wait = path.Wait((uint32_t)now);
+		if (wait != TxScheduler::forever && now + wait < next) {
+			next = now + wait;
+		}
+		if (next == ~(uint64_t)0) {
+			break;
+		}
+		if (next > now) {
+			now = next;
+		}
+		if (speed) {
+			uint64_t due = hostStart + now * 1000 / speed;
+			uint64_t host = host_ns();
+			if (due > host) {
+				struct timespec ts = {(time_t)((due - host) / 1000000000),
+									  (long)((due - host) % 1000000000)};
+				nanosleep(&ts, nullptr);
+				host = host_ns();
+			}
+			late.Add((uint32_t)((host - due) / 1000));
+		}
+		if (have && offset + chunkTime + chunkPosition * byteTime <= now) {
+			path.Input(chunk + chunkPosition, 1, (uint32_t)now);
+			if (++chunkPosition == chunkLength) {
+				chunkPosition = 0;
+				have = reader.Next(chunkTime, chunk, chunkLength);
+			}
+		}
+		path.Run((uint32_t)now);
+	}
+
+	heapAllocs = heap_allocs() - heapAllocs;
+	path.Report(now / 1e6, (host_ns() - hostStart) / 1e9);
+	if (speed) {
+		late.Print("host late", "us");
+	}
+	printf("heap      %9lu allocations (%.2f per 1000 events)\n",
+		   (unsigned long)heapAllocs,
+		   path.inputEvents ? heapAllocs * 1000.0 / path.inputEvents : 0);
+	HeapProbe::Print();
+	printf("\n");
+	if (heapGate && HeapProbe::Allocs() != 0) {
+		fprintf(stderr, "%s: handlers allocated\n", tracePath);
+		return 3;
+	}
+	return 0;
+}
+
+
+void usage()
+{
+	fprintf(stderr,
+			"usage: midireplay -R trace (-i input | -p)\n"
+			"       midireplay -G chords|clockcc|sysex -o trace\n"
+			"       midireplay [-x speed] [-n times] [-H] [-z] [-o output] trace...\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *recordPath = nullptr;
+	const char *inputPath = nullptr;
+	const char *outputPath = nullptr;
+	const char *kind = nullptr;
+	bool pty = false;
+	bool harmonies = false;
+	bool heapGate = false;
+	uint32_t speed = 0;
+	unsigned int times = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "R:i:pG:o:x:n:Hz")) != -1) {
+		switch (opt) {
+			case 'R': recordPath = optarg; break;
+			case 'i': inputPath = optarg; break;
+			case 'p': pty = true; break;
+			case 'G': kind = optarg; break;
+			case 'o': outputPath = optarg; break;
+			case 'x': speed = strtoul(optarg, nullptr, 0); break;
+			case 'n': times = strtoul(optarg, nullptr, 0); break;
+			case 'H': harmonies = true; break;
+			case 'z': heapGate = true; break;
+			default: usage();
+		}
+	}
+
+	if (kind) {
+		if (outputPath == nullptr) {
+			usage();
+		}
+		return generate(kind, outputPath);
+	}
+
+	if (recordPath) {
+		int inputFd;
+		if (pty) {
+			inputFd = posix_openpt(O_RDWR | O_NOCTTY);
+			if (inputFd < 0 || grantpt(inputFd) || unlockpt(inputFd)) {
+				perror("pty");
+				return 1;
+			}
+			printf("MIDI port: %s\n", ptsname(inputFd));
+		}
+		else if (inputPath) {
+			inputFd = open(inputPath, O_RDONLY);
+			if (inputFd < 0) {
+				perror(inputPath);
+				return 1;
+			}
+		}
+		else {
+			usage();
+		}
+		return record(recordPath, inputFd);
+	}
+
+	if (optind == argc || times == 0) {
+		usage();
+	}
+	int outputFd = -1;
+	if (outputPath) {
+		outputFd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (outputFd < 0) {
+			perror(outputPath);
+			return 1;
+		}
+	}
+	int result = 0;
+	for (int i = optind; i < argc; i++) {
+		int r = replay(argv[i], speed, times, harmonies, heapGate, outputFd);
+		if (r > result) {
+			result = r;
+		}
+	}
+	return result;
+}
+
+
+/* EOF */
@@ -0,0 +1,373 @@
+/** @file midisim.cpp
+ *
+ * Host simulator of the firmware's MIDI path for load and soak tests
+ * on Linux, set up with the board's settings (MidiSetup.hpp):
+ *
+ *   bytes -> MidiParser -> MidiTransform -> TxScheduler -> bytes
+ *   ADC readings -> ControllerInput ---------^
+ *
+ * The modules after the parser are the ones the board runs.  The
+ * board parses with SerialMidi::ReceiveParser(), which is not in this
+ * tree, the simulator with MidiParser: it makes the same callbacks for
+ * channel and realtime messages but also streams SysEx, which the
+ * board drops.
+ *
+ * Only the hardware is simulated: the MIDI input arrives at the DIN
+ * wire rate (320 us a byte), the three analog inputs are read every
+ * 30 ms like control_thread does, and the output is paced by the
+ * scheduler's model of the wire.  Time is virtual, the simulation
+ * jumps from one event to the next so an hour of playing takes
+ * seconds.  The mbed threads and queues are not part of it, every
+ * stage runs as soon as its input is there.
+ *
+ * Input, one of:
+ *   -i file	raw MIDI bytes (e.g. a capture from a DIN interface),
+ *				played back to back at the wire rate and looped.
+ *   -i fifo	or a character device: read live, in real time.
+ *   -p			opens a pseudo terminal and prints its name, what is
+ *				written to it is the MIDI input and the output can be
+ *				read back from it (e.g. with ttymidi to an ALSA port).
+ *   (none)		a generated stream of notes, controllers and pitch
+ *				bend that keeps the input wire -l percent busy.
+ *
+ * Other options:
+ *   -o file	write the output bytes to a file.
+ *   -a file	ADC trace, one line every 30 ms with the three raw
+ *				readings (0..65535) of b2in, b3in and the ribbon,
+ *				looped.  Without it the inputs are slow sine waves
+ *				with noise.
+ *   -t sec		simulated time, default 60 (not used when live).
+ *   -l pct		load of the generated stream, default 100.
+ *   -s seed	seed of the generated stream and the ADC noise.
+ *   -H			harmonies instead of chords (like HARMONIZER).
+ *
+ * At the end it reports the events per simulated and per host second,
+ * the scheduler counters and the latency distribution (p50, p90, p99,
+ * max) from the moment a message was complete at the input, or an
+ * ADC was read, until its last byte left on the wire.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -DHEAP_PROBE=1 -I.. -o midisim \
+ *       midisim.cpp SimPath.cpp HostHeap.cpp ../HeapProbe.cpp \
+ *       ../Ump.cpp ../MidiParser.cpp ../MidiTransform.cpp \
+ *       ../TxScheduler.cpp ../OneEuroFilter.cpp ../TransformMIDI.cpp \
+ *       ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "SimPath.hpp"
+
+
+const uint32_t wireByteTime = SimPath::wireByteTime;
+
+/////////////////////////////////////////////////////////////////
+//  Inputs
+/////////////////////////////////////////////////////////////////
+
+/** A random but musically shaped stream: notes with a note off for
+ * every note on, controllers and pitch bend sweeps, using running
+ * status the way most keyboards do.
+ */
+class StreamGenerator {
+public:
+	StreamGenerator(uint32_t seed) noexcept
+		: random(seed), length(0), position(0), status(0), numOfHeld(0),
+		  wheel(0x2000) {};
+	uint8_t NextByte() {
+		if (position == length) {
+			Message();
+		}
+		return buf[position++];
+	};
+
+private:
+	void Add(uint8_t st, uint8_t d1, uint8_t d2) {
+		length = 0;
+		position = 0;
+		if (st != status) {
+			buf[length++] = st;
+			status = st;
+		}
+		buf[length++] = d1;
+		buf[length++] = d2;
+	};
+	void Message() {
+		uint32_t r = random.Below(100);
+		if (r < 30 && numOfHeld < maxHeld) {
+			uint8_t note = 36 + random.Below(48);
+			held[numOfHeld++] = note;
+			Add(0x90, note, 1 + random.Below(127));
+		}
+		else if (r < 60 && numOfHeld) {
+			unsigned int i = random.Below(numOfHeld);
+			uint8_t note = held[i];
+			held[i] = held[--numOfHeld];
+			// Half of the keyboards send note on with velocity 0.
+			if (random.Below(2)) {
+				Add(0x90, note, 0);
+			}
+			else {
+				Add(0x80, note, 64);
+			}
+		}
+		else if (r < 85) {
+			static const uint8_t controllers[4] = {1, 2, 11, 74};
+			Add(0xB0, controllers[random.Below(4)], random.Below(128));
+		}
+		else {
+			wheel = (wheel + random.Below(1024) - 512) & 0x3FFF;
+			Add(0xE0, wheel & 0x7F, wheel >> 7);
+		}
+	};
+
+	static const unsigned int maxHeld = 10;
+	Random random;
+	uint8_t buf[3];
+	unsigned int length;
+	unsigned int position;
+	uint8_t status;
+	uint8_t held[maxHeld];
+	unsigned int numOfHeld;
+	uint16_t wheel;
+};
+
+
+/** The three analog inputs, from a trace or made up.
+ */
+class AdcSource {
+public:
+	AdcSource(uint32_t seed) noexcept : random(seed), line(0) {};
+	bool Load(const char *path) {
+		FILE *file = fopen(path, "r");
+		if (file == nullptr) {
+			return false;
+		}
+		unsigned int a, b, c;
+		char text[128];
+		while (fgets(text, sizeof(text), file)) {
+			if (sscanf(text, "%u %u %u", &a, &b, &c) == 3) {
+				trace.push_back((uint16_t)a);
+				trace.push_back((uint16_t)b);
+				trace.push_back((uint16_t)c);
+			}
+		}
+		fclose(file);
+		return !trace.empty();
+	};
+	void Read(uint32_t now, uint16_t raw[3]) {
+		if (!trace.empty()) {
+			for (unsigned int i = 0; i < 3; i++) {
+				raw[i] = trace[line * 3 + i];
+			}
+			line = (line + 1) % (trace.size() / 3);
+			return;
+		}
+		// Periods of 7, 11 and 3 s, the ribbon jumps (a finger).
+		double t = now / 1e6;
+		raw[0] = Wave(t / 7.0);
+		raw[1] = Wave(t / 11.0);
+		raw[2] = (uint32_t)(t / 3.0) % 2 ? Wave(t / 0.5) : 0;
+	};
+
+private:
+	uint16_t Wave(double cycles) {
+		double v = 32768 + 30000 * sin(2 * M_PI * cycles)
+			+ (int32_t)random.Below(512) - 256;
+		return (uint16_t)v;
+	};
+
+	Random random;
+	std::vector<uint16_t> trace;
+	size_t line;
+};
+
+
+uint64_t host_time()
+{
+	return host_ns() / 1000;
+}
+
+
+/////////////////////////////////////////////////////////////////
+//  Main loop
+/////////////////////////////////////////////////////////////////
+void usage()
+{
+	fprintf(stderr, "usage: midisim [-i input | -p] [-o output] [-a adc-trace] "
+			"[-t seconds] [-l load%%] [-s seed] [-H]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *inputPath = nullptr;
+	const char *outputPath = nullptr;
+	const char *adcPath = nullptr;
+	bool pty = false;
+	bool harmonies = false;
+	uint32_t seconds = 60;
+	uint32_t load = 100;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:o:a:pt:l:s:H")) != -1) {
+		switch (opt) {
+			case 'i': inputPath = optarg; break;
+			case 'o': outputPath = optarg; break;
+			case 'a': adcPath = optarg; break;
+			case 'p': pty = true; break;
+			case 't': seconds = strtoul(optarg, nullptr, 0); break;
+			case 'l': load = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			case 'H': harmonies = true; break;
+			default: usage();
+		}
+	}
+	if (load == 0 || load > 100 || (pty && inputPath)) {
+		usage();
+	}
+
+	AdcSource adc(seed);
+	if (adcPath && !adc.Load(adcPath)) {
+		fprintf(stderr, "%s: no readings\n", adcPath);
+		return 1;
+	}
+
+	// Where the input comes from.
+	int inputFd = -1;
+	int outputFd = -1;
+	bool live = false;
+	std::vector<uint8_t> recorded;
+	StreamGenerator generator(seed);
+	if (pty) {
+		inputFd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (inputFd < 0 || grantpt(inputFd) || unlockpt(inputFd)) {
+			perror("pty");
+			return 1;
+		}
+		printf("MIDI port: %s\n", ptsname(inputFd));
+		outputFd = inputFd;
+		live = true;
+	}
+	else if (inputPath) {
+		struct stat st;
+		inputFd = open(inputPath, O_RDONLY);
+		if (inputFd < 0 || fstat(inputFd, &st)) {
+			perror(inputPath);
+			return 1;
+		}
+		if (S_ISREG(st.st_mode)) {
+			uint8_t buf[4096];
+			ssize_t n;
+			while ((n = read(inputFd, buf, sizeof(buf))) > 0) {
+				recorded.insert(recorded.end(), buf, buf + n);
+			}
+			close(inputFd);
+			inputFd = -1;
+			if (recorded.empty()) {
+				fprintf(stderr, "%s: empty\n", inputPath);
+				return 1;
+			}
+		}
+		else {
+			live = true;
+		}
+	}
+	if (outputPath) {
+		outputFd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (outputFd < 0) {
+			perror(outputPath);
+			return 1;
+		}
+	}
+
+	// Virtual time starts at 0 and is 64 bit here, the modules see
+	// the lower 32 bits and wrap like on the board.
+	uint64_t now = 0;
+	uint64_t end = (uint64_t)seconds * 1000000;
+	uint64_t nextByte = 0;
+	uint64_t nextControl = 0;
+	uint64_t hostStart = host_time();
+	size_t recordedPosition = 0;
+	// A gap after every byte brings the generated stream to 'load'.
+	uint32_t byteGap = wireByteTime * 100 / load;
+
+	SimPath path(harmonies, outputFd);
+	while (live || now < end) {
+		uint32_t now32 = (uint32_t)now;
+
+		if (!live && now >= nextByte) {
+			uint8_t byte;
+			if (!recorded.empty()) {
+				byte = recorded[recordedPosition];
+				recordedPosition = (recordedPosition + 1) % recorded.size();
+				nextByte += wireByteTime;
+			}
+			else {
+				byte = generator.NextByte();
+				nextByte += byteGap;
+			}
+			path.Input(&byte, 1, now32);
+		}
+		if (now >= nextControl) {
+			uint16_t raw[SimPath::numOfControls];
+			adc.Read(now32, raw);
+			path.Control(raw, now32);
+			nextControl += controlPeriod;
+		}
+		path.Run(now32);
+
+		// On to whatever happens first.
+		uint64_t next = nextControl;
+		if (!live && nextByte < next) {
+			next = nextByte;
+		}
+		uint32_t wait = path.Wait(now32);
+		if (wait != TxScheduler::forever && now + wait < next) {
+			next = now + wait;
+		}
+		if (next <= now) {
+			next = now + 1;
+		}
+
+		if (!live) {
+			now = next;
+			continue;
+		}
+		// Live: sleep in poll() until then or until bytes come in.
+		struct pollfd pfd = {inputFd, POLLIN, 0};
+		uint64_t host = host_time() - hostStart;
+		int timeout = next > host ? (int)((next - host + 999) / 1000) : 0;
+		if (poll(&pfd, 1, timeout) > 0) {
+			uint8_t buf[256];
+			ssize_t n = read(inputFd, buf, sizeof(buf));
+			if (n <= 0) {
+				break;
+			}
+			now = host_time() - hostStart;
+			path.Input(buf, n, (uint32_t)now);
+		}
+		now = host_time() - hostStart;
+	}
+
+	path.Report(now / 1e6, (host_time() - hostStart) / 1e6);
+	return 0;
+}
+
+
+/* EOF */
@@ -0,0 +1,381 @@
+/** @file mpebench.cpp
+ *
+ * MpeAllocator: the channels it hands out, how fair that is and what
+ * it costs per event.
+ *
+ * A seeded stream of note ons and offs (chords, repeated notes, held
+ * notes, more notes than channels now and then) goes through the
+ * allocator and through a reference that scans time stamps: the
+ * channel that has been free the longest, else the channel of the
+ * oldest note.  Every event both have to give the same channel and the
+ * same stolen note, and the active channels have to be the sounding
+ * notes, oldest first.  This is done with 1, 4 and 15 member channels.
+ *
+ * Fairness with 15 channels against "lowest free channel first": how
+ * evenly the channels are used and how long a channel stays free
+ * before it is used again (the time the release has to ring out),
+ * counted in events.
+ *
+ *   -n events	events per run, default 1000000.
+ *   -s seed	seed of the stream, default 1.
+ *
+ * Exits with 1 when the allocator and the reference differ.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o mpebench mpebench.cpp \
+ *       ../MpeAllocator.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+#include "MpeAllocator.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** One note on or off.
+ */
+struct NoteEvent {
+	bool on;
+	uint8_t note;
+};
+
+/** Mostly chords of 3 or 4 notes that are held a while, and now and
+ * then a note that is already sounding or a pile of notes that does
+ * not fit.
+ */
+std::vector<NoteEvent> make_stream(uint32_t events, Random &random)
+{
+	std::vector<NoteEvent> stream;
+	std::vector<uint8_t> sounding;
+	while (stream.size() < events) {
+		unsigned int what = random.Below(100);
+		if (what < 40 && !sounding.empty()) {
+			size_t i = random.Below(sounding.size());
+			stream.push_back({false, sounding[i]});
+			sounding.erase(sounding.begin() + i);
+		}
+		else if (what < 45 && !sounding.empty()) {
+			stream.push_back({true, sounding[random.Below(sounding.size())]});
+		}
+		else if (what < 47) {
+			// Off for a note that does not sound.
+			stream.push_back({false, (uint8_t)random.Below(128)});
+		}
+		else {
+			uint8_t root = 36 + random.Below(48);
+			bool pile = what < 49;
+			unsigned int notes = pile ? 12 : 3 + random.Below(2);
+			for (unsigned int i = 0; i < notes; i++) {
+				uint8_t note = (root + i * 4) & 0x7F;
+				stream.push_back({true, note});
+				sounding.push_back(note);
+			}
+			// Two hands' worth, the oldest are released.
+			while (sounding.size() > (pile ? 24u : 10u)) {
+				stream.push_back({false, sounding.front()});
+				sounding.erase(sounding.begin());
+			}
+		}
+	}
+	stream.resize(events);
+	return stream;
+}
+
+
+/** The allocator written out the slow way with time stamps.
+ */
+class ReferenceAllocator {
+public:
+	ReferenceAllocator(unsigned int numOfMembersArg)
+	: numOfMembers(numOfMembersArg), time(0) {
+		for (unsigned int i = 0; i < numOfMembers; i++) {
+			note[i] = MpeAllocator::none;
+			since[i] = i;	// Free in channel order.
+		}
+		time = numOfMembers;
+	};
+	uint8_t NoteOn(uint8_t n, uint8_t &stolen) {
+		int pick = -1;
+		for (unsigned int i = 0; i < numOfMembers; i++) {
+			if (note[i] == n) {
+				pick = i;
+			}
+		}
+		if (pick < 0) {
+			// Free the longest, else the oldest note.
+			bool anyFree = false;
+			for (unsigned int i = 0; i < numOfMembers; i++) {
+				anyFree = anyFree || note[i] == MpeAllocator::none;
+			}
+			for (unsigned int i = 0; i < numOfMembers; i++) {
+				if ((note[i] == MpeAllocator::none) == anyFree &&
+					(pick < 0 || since[i] < since[pick])) {
+					pick = i;
+				}
+			}
+		}
+		stolen = note[pick];
+		note[pick] = n;
+		since[pick] = time++;
+		return pick + 1;
+	};
+	uint8_t NoteOff(uint8_t n) {
+		for (unsigned int i = 0; i < numOfMembers; i++) {
+			if (note[i] == n) {
+				note[i] = MpeAllocator::none;
+				since[i] = time++;
+				return i + 1;
+			}
+		}
+		return MpeAllocator::none;
+	};
+	/** Sounding channels, oldest first.
+	 */
+	unsigned int ActiveChannels(uint8_t *channels) const {
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < numOfMembers; i++) {
+			if (note[i] == MpeAllocator::none) {
+				continue;
+			}
+			// Insertion sort on the time of the note on.
+			unsigned int j = n++;
+			while (j > 0 && since[channels[j - 1] - 1] > since[i]) {
+				channels[j] = channels[j - 1];
+				j--;
+			}
+			channels[j] = i + 1;
+		}
+		return n;
+	};
+
+private:
+	unsigned int numOfMembers;
+	uint8_t note[MpeAllocator::maxMembers];
+	uint64_t since[MpeAllocator::maxMembers];	// Note on, or free since.
+	uint64_t time;
+};
+
+
+bool test_reference(const std::vector<NoteEvent> &stream, uint8_t members)
+{
+	MpeAllocator allocator(members);
+	ReferenceAllocator reference(members);
+	uint32_t wrong = 0;
+	for (size_t i = 0; i < stream.size(); i++) {
+		const NoteEvent &e = stream[i];
+		if (e.on) {
+			uint8_t stolen, refStolen;
+			uint8_t channel = allocator.NoteOn(e.note, stolen);
+			uint8_t refChannel = reference.NoteOn(e.note, refStolen);
+			wrong += (channel != refChannel || stolen != refStolen ||
+					  allocator.Channel(e.note) != channel) ? 1 : 0;
+		}
+		else {
+			wrong += allocator.NoteOff(e.note) != reference.NoteOff(e.note) ? 1 : 0;
+		}
+		uint8_t a[MpeAllocator::maxMembers], b[MpeAllocator::maxMembers];
+		unsigned int n = allocator.ActiveChannels(a);
+		bool same = n == reference.ActiveChannels(b);
+		for (unsigned int j = 0; same && j < n; j++) {
+			same = a[j] == b[j];
+		}
+		wrong += same ? 0 : 1;
+	}
+	printf("%2u members: %lu allocations %lu steals, %lu differences %s\n",
+		   members, (unsigned long)allocator.Stats().allocations,
+		   (unsigned long)allocator.Stats().steals, (unsigned long)wrong,
+		   wrong == 0 ? "ok" : "FAIL");
+	return wrong == 0;
+}
+
+
+/** Lowest free channel first, for comparison.
+ */
+class LowestFreeAllocator {
+public:
+	LowestFreeAllocator() {
+		for (auto &n: note) {
+			n = MpeAllocator::none;
+		}
+	};
+	uint8_t NoteOn(uint8_t n) {
+		for (unsigned int i = 0; i < MpeAllocator::maxMembers; i++) {
+			if (note[i] == MpeAllocator::none || note[i] == n) {
+				note[i] = n;
+				return i + 1;
+			}
+		}
+		note[0] = n;
+		return 1;
+	};
+	uint8_t NoteOff(uint8_t n) {
+		for (unsigned int i = 0; i < MpeAllocator::maxMembers; i++) {
+			if (note[i] == n) {
+				note[i] = MpeAllocator::none;
+				return i + 1;
+			}
+		}
+		return MpeAllocator::none;
+	};
+
+private:
+	uint8_t note[MpeAllocator::maxMembers];
+};
+
+
+/** Use of the channels and the events between a note off and the
+ * next note on on the same channel.
+ */
+struct Fairness {
+	uint64_t uses[MpeAllocator::maxMembers + 1];
+	uint64_t freedAt[MpeAllocator::maxMembers + 1];
+	uint64_t gaps, gapSum, shortGaps;
+
+	Fairness() : uses(), freedAt(), gaps(0), gapSum(0), shortGaps(0) {};
+	void On(uint8_t channel, uint64_t time, bool wasFree) {
+		uses[channel]++;
+		if (wasFree && freedAt[channel]) {
+			uint64_t gap = time - freedAt[channel];
+			gaps++;
+			gapSum += gap;
+			shortGaps += gap < 4 ? 1 : 0;
+		}
+	};
+	void Off(uint8_t channel, uint64_t time) {
+		if (channel != MpeAllocator::none) {
+			freedAt[channel] = time;
+		}
+	};
+	/** Difference between the most and least used channel relative
+	 * to the average use.
+	 */
+	double Spread() const {
+		uint64_t least = UINT64_MAX, most = 0, total = 0;
+		for (unsigned int c = 1; c <= MpeAllocator::maxMembers; c++) {
+			least = uses[c] < least ? uses[c] : least;
+			most = uses[c] > most ? uses[c] : most;
+			total += uses[c];
+		}
+		return (double)(most - least) * MpeAllocator::maxMembers / total;
+	};
+	void Print(const char *name) const {
+		printf("%-20s channel use %.1f%% apart, free for %.1f events on "
+			   "average, %.2f%% reused within 4 events\n", name,
+			   100 * Spread(), gaps ? (double)gapSum / gaps : 0.0,
+			   gaps ? 100.0 * shortGaps / gaps : 0.0);
+	};
+};
+
+bool test_fairness(const std::vector<NoteEvent> &stream)
+{
+	MpeAllocator allocator;
+	LowestFreeAllocator lowest;
+	Fairness lru, low;
+	for (size_t i = 0; i < stream.size(); i++) {
+		const NoteEvent &e = stream[i];
+		uint64_t time = i + 1;
+		if (e.on) {
+			uint8_t stolen;
+			uint8_t channel = allocator.NoteOn(e.note, stolen);
+			lru.On(channel, time, stolen == MpeAllocator::none);
+			bool sounding = false;
+			uint8_t c = lowest.NoteOff(e.note);
+			if (c != MpeAllocator::none) {
+				sounding = true;
+				low.Off(c, time);
+			}
+			c = lowest.NoteOn(e.note);
+			low.On(c, time, !sounding);
+		}
+		else {
+			lru.Off(allocator.NoteOff(e.note), time);
+			low.Off(lowest.NoteOff(e.note), time);
+		}
+	}
+	lru.Print("free the longest");
+	low.Print("lowest free first");
+	// Every channel gets its share and a channel is never taken
+	// straight back while others have been free longer.
+	bool ok = lru.Spread() < 0.05 && lru.shortGaps * 10 < low.shortGaps;
+	printf("fairness: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+void test_cost(const std::vector<NoteEvent> &stream)
+{
+	for (uint8_t members: {(uint8_t)4, (uint8_t)15}) {
+		MpeAllocator allocator(members);
+		ReferenceAllocator reference(members);
+		uint32_t sink = 0;
+		uint64_t start = now_ns();
+		for (auto &e: stream) {
+			uint8_t stolen;
+			sink += e.on ? allocator.NoteOn(e.note, stolen) : allocator.NoteOff(e.note);
+		}
+		uint64_t ns = now_ns() - start;
+		start = now_ns();
+		for (auto &e: stream) {
+			uint8_t stolen;
+			sink += e.on ? reference.NoteOn(e.note, stolen) : reference.NoteOff(e.note);
+		}
+		uint64_t refNs = now_ns() - start;
+		printf("%2u members: %.1f ns per event, scanning %.1f ns\n", members,
+			   (double)ns / stream.size(), (double)refNs / stream.size());
+		// Keeps the calls from being optimized away.
+		if (sink == 1) {
+			printf("\n");
+		}
+	}
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: mpebench [-n events] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t events = 1000000;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': events = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (events == 0) {
+		usage();
+	}
+
+	Random random(seed);
+	std::vector<NoteEvent> stream = make_stream(events, random);
+	bool ok = true;
+	for (uint8_t members: {(uint8_t)1, (uint8_t)4, (uint8_t)15}) {
+		ok = test_reference(stream, members) && ok;
+	}
+	ok = test_fairness(stream) && ok;
+	test_cost(stream);
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
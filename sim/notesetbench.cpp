@@ -0,0 +1,261 @@
+/** @file notesetbench.cpp
+ *
+ * PitchClassSet and NoteSet against the loops over std::vector<Note>
+ * they replaced.
+ *
+ * A seeded set of random chords (3 to 6 notes) and modes (every mode
+ * of every implemented scale, on a random root) is made once, both
+ * as vectors of notes and as bitsets.  Then three questions are
+ * timed both ways:
+ *
+ *   fits		are all pitch classes of the chord in the mode,
+ *   transpose	the chord moved by -12..12 semitones,
+ *   common		notes two voicings have in common.
+ *
+ * Both ways have to give the same answers, the program exits with 1
+ * when they do not.
+ *
+ *   -n count	chord and mode pairs, default 4096.
+ *   -r reps	passes over the pairs, default 200.
+ *   -s seed	seed, default 1.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o notesetbench notesetbench.cpp \
+ *       ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp ../HeapProbe.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+#include "Harmony.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+struct Pair {
+	std::vector<Note> chord;
+	std::vector<Note> mode;
+	std::vector<Note> voicing;
+	PitchClassSet chordPcs;
+	PitchClassSet modePcs;
+	NoteSet chordNotes;
+	NoteSet voicingNotes;
+};
+
+
+/** The old way: every chord note looked up in the mode.
+ */
+bool fits(const std::vector<Note> &chord, const std::vector<Note> &mode)
+{
+	for (auto &c: chord) {
+		bool found = false;
+		for (auto &m: mode) {
+			if (c.number % 12 == m.number % 12) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+std::vector<Note> transpose(const std::vector<Note> &chord, int semitones)
+{
+	std::vector<Note> result;
+	for (auto &c: chord) {
+		int note = c.number + semitones;
+		if (note >= 0 && note < 128) {
+			result.push_back(Note(note));
+		}
+	}
+	return result;
+}
+
+
+unsigned int common(const std::vector<Note> &a, const std::vector<Note> &b)
+{
+	unsigned int n = 0;
+	for (auto &x: a) {
+		for (auto &y: b) {
+			if (x.number == y.number) {
+				n++;
+				break;
+			}
+		}
+	}
+	return n;
+}
+
+
+/** Notes stacked in thirds and fourths from 'root'.
+ */
+std::vector<Note> make_chord(uint8_t root, unsigned int size, Random &random)
+{
+	std::vector<Note> chord;
+	uint8_t note = root;
+	for (unsigned int i = 0; i < size; i++) {
+		chord.push_back(Note(note));
+		note += 3 + random.Below(2);
+	}
+	return chord;
+}
+
+
+std::vector<Pair> make_pairs(uint32_t count, uint32_t seed)
+{
+	std::vector<PitchClassSet> modes;
+	for (auto typeOfScale: Scale::allScaleKinds) {
+		Scale scl(typeOfScale, 0);
+		for (unsigned int m = 0; m < scl.modes.size(); m++) {
+			modes.push_back(scl.PitchClasses(m));
+		}
+	}
+
+	Random random(seed);
+	std::vector<Pair> pairs(count);
+	for (auto &pair: pairs) {
+		pair.chord = make_chord(36 + random.Below(48), 3 + random.Below(4), random);
+		pair.voicing = make_chord(36 + random.Below(48), 3 + random.Below(4), random);
+		pair.modePcs = modes[random.Below(modes.size())].Transpose(random.Below(12));
+		for (unsigned int note = 60; note < 72; note++) {
+			if (pair.modePcs.Contains(note)) {
+				pair.mode.push_back(Note((uint8_t)note));
+			}
+		}
+		for (auto &note: pair.chord) {
+			pair.chordPcs.Add(note.number);
+			pair.chordNotes.Add(note.number);
+		}
+		for (auto &note: pair.voicing) {
+			pair.voicingNotes.Add(note.number);
+		}
+	}
+	return pairs;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: notesetbench [-n count] [-r reps] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = 4096;
+	uint32_t reps = 200;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:s:")) != -1) {
+		switch (opt) {
+			case 'n': count = strtoul(optarg, nullptr, 0); break;
+			case 'r': reps = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (count == 0 || reps == 0) {
+		usage();
+	}
+
+	std::vector<Pair> pairs = make_pairs(count, seed);
+	double ops = (double)count * reps;
+	uint32_t mismatches = 0;
+
+	// Same answers both ways.
+	for (auto &pair: pairs) {
+		for (int semitones = -12; semitones <= 12; semitones++) {
+			NoteSet expected;
+			for (auto &note: transpose(pair.chord, semitones)) {
+				expected.Add(note.number);
+			}
+			if (!(pair.chordNotes.Transpose(semitones) == expected)) {
+				mismatches++;
+			}
+		}
+		if (fits(pair.chord, pair.mode) != pair.modePcs.Contains(pair.chordPcs)
+			|| common(pair.chord, pair.voicing)
+				!= (pair.chordNotes & pair.voicingNotes).Count()) {
+			mismatches++;
+		}
+	}
+
+	uint32_t sink = 0;
+	uint64_t start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		for (auto &pair: pairs) {
+			sink += fits(pair.chord, pair.mode);
+		}
+	}
+	double fitsVector = (now_ns() - start) / ops;
+	start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		for (auto &pair: pairs) {
+			sink += pair.modePcs.Contains(pair.chordPcs);
+		}
+	}
+	double fitsBits = (now_ns() - start) / ops;
+
+	start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		int semitones = (int)(r % 25) - 12;
+		for (auto &pair: pairs) {
+			sink += transpose(pair.chord, semitones).size();
+		}
+	}
+	double transposeVector = (now_ns() - start) / ops;
+	start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		int semitones = (int)(r % 25) - 12;
+		for (auto &pair: pairs) {
+			sink += pair.chordNotes.Transpose(semitones).words[1];
+		}
+	}
+	double transposeBits = (now_ns() - start) / ops;
+
+	start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		for (auto &pair: pairs) {
+			sink += common(pair.chord, pair.voicing);
+		}
+	}
+	double commonVector = (now_ns() - start) / ops;
+	start = now_ns();
+	for (uint32_t r = 0; r < reps; r++) {
+		for (auto &pair: pairs) {
+			sink += (pair.chordNotes & pair.voicingNotes).Count();
+		}
+	}
+	double commonBits = (now_ns() - start) / ops;
+
+	printf("%-10s %10s %10s\n", "", "vector", "bitset");
+	printf("%-10s %7.1f ns %7.1f ns\n", "fits", fitsVector, fitsBits);
+	printf("%-10s %7.1f ns %7.1f ns\n", "transpose", transposeVector, transposeBits);
+	printf("%-10s %7.1f ns %7.1f ns\n", "common", commonVector, commonBits);
+	printf("%lu mismatches\n", (unsigned long)mismatches);
+	// Keeps the loops from being optimized away.
+	if (sink == 0) {
+		printf("nothing counted\n");
+	}
+	return mismatches ? 1 : 0;
+}
+
+
+/* EOF */
@@ -0,0 +1,273 @@
+/** @file parsertest.cpp
+ *
+ * Checks the table driven MidiParser against MidiReferenceParser, the
+ * byte at a time parser it replaced, and measures both.
+ *
+ * Recorded streams (running status, realtime inside messages, cut
+ * short messages, SysEx, garbage) must give the callbacks listed with
+ * them.  Then a seeded random stream, mostly data bytes with status
+ * and realtime bytes mixed in, goes through both parsers: byte by
+ * byte and as a block they must make the same callbacks with the same
+ * arguments in the same order, and count the same statistics.
+ *
+ * SysEx streaming is tested in sysextest.cpp, the UMP translation in
+ * umptest.cpp.
+ *
+ *   -n passes	passes over the random stream, default 256.
+ *   -s seed	seed of the random stream, default 0x2545F491.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -DMIDI_PARSER_SELFTEST=1 -I.. \
+ *       -o parsertest parsertest.cpp ../MidiParser.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+#include "MidiParser.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+struct Counts {
+	uint32_t noteOn, noteOff, controlChange, pitchwheel, realtime, errors;
+	uint32_t hash;	// Of every callback and its arguments in order.
+};
+static Counts countsGlob;
+
+void hash(uint8_t type, uint8_t a, uint8_t b)
+{
+	// FNV-1a
+	countsGlob.hash = (countsGlob.hash ^ type) * 16777619u;
+	countsGlob.hash = (countsGlob.hash ^ a) * 16777619u;
+	countsGlob.hash = (countsGlob.hash ^ b) * 16777619u;
+}
+
+void note_on(uint8_t note, uint8_t velocity)
+{
+	countsGlob.noteOn++;
+	hash(1, note, velocity);
+	if ((note | velocity) & 0x80 || velocity == 0) {
+		countsGlob.errors++;
+	}
+}
+
+void note_off(uint8_t note, uint8_t velocity)
+{
+	countsGlob.noteOff++;
+	hash(2, note, velocity);
+	if ((note | velocity) & 0x80) {
+		countsGlob.errors++;
+	}
+}
+
+void control_change(uint8_t controller, uint8_t value)
+{
+	countsGlob.controlChange++;
+	hash(3, controller, value);
+	if ((controller | value) & 0x80) {
+		countsGlob.errors++;
+	}
+}
+
+void pitchwheel(uint8_t valueLSB, uint8_t valueMSB)
+{
+	countsGlob.pitchwheel++;
+	hash(4, valueLSB, valueMSB);
+	if ((valueLSB | valueMSB) & 0x80) {
+		countsGlob.errors++;
+	}
+}
+
+void realtime(uint8_t msg)
+{
+	countsGlob.realtime++;
+	hash(5, msg, 0);
+	if (msg < 0xF8) {
+		countsGlob.errors++;
+	}
+}
+
+
+/** Recorded streams with the callbacks they must produce
+ * {note on, note off, control change, pitch wheel, realtime}
+ */
+struct Corpus {
+	const char *name;
+	const uint8_t *bytes;
+	size_t len;
+	Counts expected;
+};
+// Running status with note on velocity 0 as note off.
+const uint8_t corpusRunningStatus[] = {
+	0x90, 60, 100, 64, 100, 67, 100, 60, 0, 64, 0, 67, 0
+};
+// Clock bytes in the middle of every message.
+const uint8_t corpusRealtime[] = {
+	0xF8, 0x90, 0xF8, 60, 0xF8, 100, 0xFA, 0xB0, 1, 0xFE, 64, 0xF8,
+	2, 0xFC, 65, 0xE0, 0xF8, 0, 0xFF, 64
+};
+// Messages cut short by the next status byte.
+const uint8_t corpusTruncated[] = {
+	0x90, 60, 0x80, 60, 0xB0, 0x90, 62, 0xE0, 1, 0x80, 62, 0
+};
+// SysEx with realtime inside, ended by F7 and by a status byte.
+const uint8_t corpusSysex[] = {
+	0xF0, 0x7E, 0x7F, 0xF8, 0x09, 0x01, 0xF7,
+	0xF0, 0x43, 0x10, 0x90, 60, 100, 0xF7, 0xF7
+};
+// System common, stray data and undefined bytes.
+const uint8_t corpusGarbage[] = {
+	10, 20, 0xF2, 0, 8, 30, 0xF1, 0x20, 40, 0xF4, 50, 0xF9, 0xFD,
+	0xC0, 5, 6, 0xB0, 7, 100, 8
+};
+const Corpus corpora[] = {
+	{"running status", corpusRunningStatus, sizeof(corpusRunningStatus),
+		{3, 3, 0, 0, 0, 0, 0}},
+	{"realtime", corpusRealtime, sizeof(corpusRealtime),
+		{1, 0, 2, 1, 9, 0, 0}},
+	{"truncated", corpusTruncated, sizeof(corpusTruncated),
+		{0, 1, 0, 0, 0, 0, 0}},
+	{"sysex", corpusSysex, sizeof(corpusSysex),
+		{1, 0, 0, 0, 1, 0, 0}},
+	{"garbage", corpusGarbage, sizeof(corpusGarbage),
+		{0, 0, 1, 0, 2, 0, 0}},
+};
+
+
+/** Feeds the stream 'passes' times into the parser, returns the time
+ * it took in ns, the callbacks end up in countsGlob.
+ */
+template<class Parser>
+uint64_t run(Parser &parser, const uint8_t *bytes, size_t len,
+			 uint32_t passes, bool bytewise)
+{
+	countsGlob = Counts();
+	countsGlob.hash = 2166136261u;
+	parser.Reset();
+	parser.ClearStats();
+	uint64_t start = now_ns();
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		if (bytewise) {
+			for (size_t i = 0; i < len; i++) {
+				parser.Parse(bytes[i]);
+			}
+		}
+		else {
+			parser.Parse(bytes, len);
+		}
+	}
+	return now_ns() - start;
+}
+
+
+bool same(const Counts &a, const Counts &b)
+{
+	return a.noteOn == b.noteOn && a.noteOff == b.noteOff &&
+		a.controlChange == b.controlChange &&
+		a.pitchwheel == b.pitchwheel && a.realtime == b.realtime &&
+		a.errors == 0 && b.errors == 0;
+}
+
+bool same(const MidiParser::Statistics &a, const MidiParser::Statistics &b)
+{
+	return a.bytes == b.bytes && a.messages == b.messages &&
+		a.realtime == b.realtime && a.sysexBytes == b.sysexBytes &&
+		a.truncated == b.truncated && a.stray == b.stray;
+}
+
+void report(const char *name, uint64_t ns, uint32_t bytes)
+{
+	uint32_t callbacks = countsGlob.noteOn + countsGlob.noteOff +
+		countsGlob.controlChange + countsGlob.pitchwheel + countsGlob.realtime;
+	if (ns > 0) {
+		printf("%-24s %6.1f ns/byte %10.0f callbacks/s\n", name,
+			   (double)ns / bytes, callbacks * 1e9 / ns);
+	}
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: parsertest [-n passes] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t passes = 256;
+	uint32_t seed = 0x2545F491;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': passes = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (passes == 0) {
+		usage();
+	}
+
+	MidiParser parser(&note_on, &realtime, &note_off, &control_change,
+					  &pitchwheel);
+	MidiReferenceParser reference(&note_on, &realtime, &note_off,
+								  &control_change, &pitchwheel);
+	unsigned int failures = 0;
+
+	for (auto &corpus: corpora) {
+		run(reference, corpus.bytes, corpus.len, 1, true);
+		Counts ref = countsGlob;
+		bool ok = same(ref, corpus.expected);
+		run(parser, corpus.bytes, corpus.len, 1, true);
+		ok = ok && same(countsGlob, ref) && countsGlob.hash == ref.hash &&
+			same(parser.Stats(), reference.Stats());
+		run(parser, corpus.bytes, corpus.len, 1, false);
+		ok = ok && same(countsGlob, ref) && countsGlob.hash == ref.hash;
+		printf("%-24s %s\n", corpus.name, ok ? "ok" : "FAIL");
+		failures += ok ? 0 : 1;
+	}
+
+	// Mostly data bytes with status bytes and realtime mixed in.
+	static uint8_t stream[4096];
+	Random random(seed);
+	for (auto &byte: stream) {
+		uint32_t r = random.Next();
+		byte = (r & 0x300) ? (r & 0x7F) : (r & 0xFF);
+	}
+	uint64_t ns = run(reference, stream, sizeof(stream), passes, true);
+	Counts ref = countsGlob;
+	report("reference parser", ns, reference.Stats().bytes);
+	ns = run(parser, stream, sizeof(stream), passes, true);
+	bool ok = same(countsGlob, ref) && countsGlob.hash == ref.hash &&
+		same(parser.Stats(), reference.Stats());
+	report("table parser (bytes)", ns, parser.Stats().bytes);
+	ns = run(parser, stream, sizeof(stream), passes, false);
+	ok = ok && same(countsGlob, ref) && countsGlob.hash == ref.hash &&
+		same(parser.Stats(), reference.Stats());
+	report("table parser (block)", ns, parser.Stats().bytes);
+	printf("random: %lu bytes %lu truncated %lu stray %s\n",
+		   (unsigned long)parser.Stats().bytes,
+		   (unsigned long)parser.Stats().truncated,
+		   (unsigned long)parser.Stats().stray, ok ? "ok" : "FAIL");
+	failures += ok ? 0 : 1;
+
+	printf("%u failures\n", failures);
+	return failures ? 1 : 0;
+}
+
+
+/* EOF */
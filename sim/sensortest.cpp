@@ -0,0 +1,394 @@
+/** @file sensortest.cpp
+ *
+ * MotionSensor against a register level model of the FXOS8700CQ, with
+ * the mbed parts it uses from hostmbed/mbed.h.
+ *
+ * The model answers on the I2C address of the FRDM-K64F, has the
+ * registers Start() writes, the burst auto increment from the
+ * accelerometer into the magnetometer data (hyb_autoinc_mode) and
+ * pulls INT1 low on new data until it has been read, so an edge that
+ * is lost stays lost until the driver reads on its timeout.
+ *
+ *   - Start() without a part on the bus fails, with one: the
+ *     configuration registers.
+ *   - A seeded stream of samples, every one has to come out of the
+ *     Mail queue once, in order, with the values put in the registers
+ *     and the time of its interrupt.
+ *   - A lost edge and a NACK: the sample still comes on the timeout.
+ *   - Nobody taking samples: the queue fills and the rest is dropped.
+ *   - No new data: nothing comes out.
+ *
+ * The I2C bytes per sample and the bus load at 400 kHz are printed.
+ * Time is simulated, only the driver's timeouts wait on the host.
+ *
+ *   -n samples	samples in the stream, default 2000.
+ *   -s seed	seed of the samples, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -pthread -Ihostmbed -I.. -o sensortest \
+ *       sensortest.cpp ../MotionSensor.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <unistd.h>
+#include "MotionSensor.hpp"
+#include "Random.hpp"
+
+
+/** FXOS8700CQ, the registers MotionSensor uses.
+ */
+class Fxos8700Model {
+public:
+	static const int address = 0x1D << 1;
+
+	enum Register: uint8_t {
+		STATUS = 0x00,
+		OUT_X_MSB = 0x01,
+		OUT_Z_MSB = 0x05,
+		OUT_Z_LSB = 0x06,
+		WHO_AM_I = 0x0D,
+		CTRL_REG1 = 0x2A,
+		CTRL_REG3 = 0x2C,
+		CTRL_REG4 = 0x2D,
+		CTRL_REG5 = 0x2E,
+		M_OUT_X_MSB = 0x33,
+		M_CTRL_REG1 = 0x5B,
+		M_CTRL_REG2 = 0x5C
+	};
+
+	Fxos8700Model() : present(false), nacks(0), pointer(0), asserted(false),
+		busBytes(0), bursts(0) {
+		memset(registers, 0, sizeof(registers));
+		registers[WHO_AM_I] = 0xC7;
+	};
+
+	int Write(int addr, const char *data, int length) {
+		std::lock_guard<std::mutex> lock(mutex);
+		busBytes += 1 + length;
+		if (!Ack(addr) || length < 1) {
+			return 1;
+		}
+		pointer = (uint8_t)data[0];
+		for (int i = 1; i < length; i++) {
+			registers[pointer++ & 0x7F] = (uint8_t)data[i];
+		}
+		return 0;
+	};
+
+	int Read(int addr, char *data, int length) {
+		std::lock_guard<std::mutex> lock(mutex);
+		busBytes += 1 + length;
+		if (!Ack(addr + 1)) {
+			return 1;
+		}
+		for (int i = 0; i < length; i++) {
+			data[i] = (char)registers[pointer];
+			if (pointer == OUT_Z_MSB) {
+				// Reading the data clears ZYXDR and releases INT1.
+				registers[STATUS] = 0;
+				asserted = false;
+				bursts++;
+			}
+			if (pointer == OUT_Z_LSB && (registers[M_CTRL_REG2] & 0x20)) {
+				pointer = M_OUT_X_MSB;
+			}
+			else {
+				pointer = (pointer + 1) & 0x7F;
+			}
+		}
+		return 0;
+	};
+
+	/** New data from the part, 'edge' false loses the interrupt.
+	 */
+	void Sample(const int16_t accel[3], const int16_t magnet[3], bool edge) {
+		bool fall;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (int i = 0; i < 3; i++) {
+				uint16_t a = (uint16_t)(accel[i] << 2);	// 14 bit left aligned.
+				registers[OUT_X_MSB + 2 * i] = a >> 8;
+				registers[OUT_X_MSB + 2 * i + 1] = a & 0xFF;
+				registers[M_OUT_X_MSB + 2 * i] = (uint16_t)magnet[i] >> 8;
+				registers[M_OUT_X_MSB + 2 * i + 1] = magnet[i] & 0xFF;
+			}
+			registers[STATUS] = 0x0F;
+			// Data ready routed to INT1, active low, part active.
+			bool enabled = (registers[CTRL_REG1] & 0x01) &&
+				(registers[CTRL_REG4] & 0x01) && (registers[CTRL_REG5] & 0x01) &&
+				(registers[CTRL_REG3] & 0x02) == 0;
+			fall = enabled && !asserted && edge;
+			asserted = enabled;
+		}
+		if (fall) {
+			InterruptIn::Fall(PTC6);
+		}
+	};
+
+	uint8_t Register(uint8_t reg) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return registers[reg];
+	};
+	uint32_t Bursts() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return bursts;
+	};
+	uint64_t BusBytes() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return busBytes;
+	};
+
+	bool present;
+	unsigned int nacks;		// Transactions to NACK.
+
+private:
+	bool Ack(int addr) {
+		if (!present || (addr & ~1) != address) {
+			return false;
+		}
+		if (nacks) {
+			nacks--;
+			return false;
+		}
+		return true;
+	};
+
+	std::mutex mutex;
+	uint8_t registers[0x80];
+	uint8_t pointer;
+	bool asserted;			// INT1 low.
+	uint64_t busBytes;		// Including the address bytes.
+	uint32_t bursts;
+};
+
+static Fxos8700Model modelGlob;
+static std::atomic<uint64_t> hostUsGlob(0);
+
+
+int i2c_host_write(int address, const char *data, int length, bool)
+{
+	return modelGlob.Write(address, data, length);
+}
+
+int i2c_host_read(int address, char *data, int length)
+{
+	return modelGlob.Read(address, data, length);
+}
+
+uint64_t host_us()
+{
+	return hostUsGlob;
+}
+
+
+struct Values {
+	int16_t accel[3];
+	int16_t magnet[3];
+};
+
+Values random_values(Random &random)
+{
+	Values values;
+	for (int i = 0; i < 3; i++) {
+		values.accel[i] = (int16_t)random.Below(1 << 14) - (1 << 13);
+		values.magnet[i] = (int16_t)random.Next();
+	}
+	return values;
+}
+
+bool same(const MotionSample &sample, const Values &values)
+{
+	return memcmp(sample.accel, values.accel, sizeof(values.accel)) == 0 &&
+		memcmp(sample.magnet, values.magnet, sizeof(values.magnet)) == 0;
+}
+
+
+/** Waits (host time) until 'done' or a second has passed.
+ */
+template<class Done>
+bool wait_until(Done done)
+{
+	for (int i = 0; i < 10000; i++) {
+		if (done()) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	return false;
+}
+
+
+const uint32_t period = 5000;	// us, 200 Hz
+
+
+bool test_start(MotionSensor &sensor)
+{
+	bool absent = !sensor.Start(MotionSensor::HZ_200) &&
+		sensor.Stats().busErrors == 1;
+	modelGlob.present = true;
+	bool started = sensor.Start(MotionSensor::HZ_200);
+	bool config = modelGlob.Register(Fxos8700Model::CTRL_REG1) == 0x0D &&
+		(modelGlob.Register(Fxos8700Model::M_CTRL_REG1) & 0x03) == 0x03 &&
+		(modelGlob.Register(Fxos8700Model::M_CTRL_REG2) & 0x20) &&
+		modelGlob.Register(Fxos8700Model::CTRL_REG4) == 0x01 &&
+		modelGlob.Register(Fxos8700Model::CTRL_REG5) == 0x01;
+	printf("no part %s, start %s, configuration %s\n", absent ? "ok" : "FAIL",
+		   started ? "ok" : "FAIL", config ? "ok" : "FAIL");
+	return absent && started && config;
+}
+
+
+bool test_stream(MotionSensor &sensor, uint32_t samples, Random &random)
+{
+	uint32_t wrong = 0;
+	uint32_t onTimeout = 0;
+	uint32_t firstBurst = modelGlob.Bursts();
+	uint64_t firstBytes = modelGlob.BusBytes();
+	for (uint32_t i = 0; i < samples; i++) {
+		hostUsGlob += period;
+		Values values = random_values(random);
+		uint32_t missed = sensor.Stats().missed;
+		modelGlob.Sample(values.accel, values.magnet, true);
+		MotionSample *sample = sensor.mail.try_get_for(1000ms);
+		if (sample == nullptr) {
+			wrong++;
+			continue;
+		}
+		// The driver's timeout can come just before the edge, the
+		// sample is then read on the timeout.
+		bool timeout = sensor.Stats().missed != missed;
+		onTimeout += timeout ? 1 : 0;
+		if (!same(*sample, values) || (sample->time != hostUsGlob && !timeout)) {
+			wrong++;
+		}
+		sensor.mail.free(sample);
+	}
+	uint32_t bursts = modelGlob.Bursts() - firstBurst;
+	double bytes = (double)(modelGlob.BusBytes() - firstBytes) / bursts;
+	// 9 bits a byte and start/stop at 400 kHz.
+	double us = (bytes * 9 + 4) / 0.4;
+	printf("stream: %lu samples %lu read on the timeout %lu wrong %s\n",
+		   (unsigned long)samples, (unsigned long)onTimeout,
+		   (unsigned long)wrong, wrong == 0 ? "ok" : "FAIL");
+	printf("%.1f bus bytes per sample, %.0f us at 400 kHz, %.1f%% of the bus "
+		   "at 200 Hz\n", bytes, us, us * 100 / period);
+	return wrong == 0 && bursts == samples;
+}
+
+
+/** A lost edge or a NACK: the sample comes on the timeout.
+ */
+bool test_recovery(MotionSensor &sensor, Random &random)
+{
+	bool ok = true;
+	for (int nack = 0; nack < 2; nack++) {
+		hostUsGlob += period;
+		Values values = random_values(random);
+		uint32_t missed = sensor.Stats().missed;
+		uint32_t busErrors = sensor.Stats().busErrors;
+		modelGlob.nacks = nack;
+		modelGlob.Sample(values.accel, values.magnet, nack);
+		MotionSample *sample = sensor.mail.try_get_for(1000ms);
+		bool good = sample && same(*sample, values) &&
+			sample->time == hostUsGlob && sensor.Stats().missed == missed + 1 &&
+			sensor.Stats().busErrors == busErrors + nack;
+		if (sample) {
+			sensor.mail.free(sample);
+		}
+		printf("%s: %s\n", nack ? "nack" : "lost edge", good ? "ok" : "FAIL");
+		ok = ok && good;
+	}
+	return ok;
+}
+
+
+bool test_full(MotionSensor &sensor, Random &random)
+{
+	const unsigned int extra = 4;
+	Values values[MotionSensor::queueLength + extra];
+	uint32_t dropped = sensor.Stats().dropped;
+	uint32_t samples = sensor.Stats().samples;
+	bool ok = true;
+	for (auto &v: values) {
+		hostUsGlob += period;
+		v = random_values(random);
+		uint32_t bursts = modelGlob.Bursts();
+		modelGlob.Sample(v.accel, v.magnet, true);
+		ok = ok && wait_until([&]() {
+			return sensor.Stats().samples + sensor.Stats().dropped ==
+				samples + dropped + 1 && modelGlob.Bursts() == bursts + 1;
+		});
+		samples = sensor.Stats().samples;
+		dropped = sensor.Stats().dropped;
+	}
+	for (unsigned int i = 0; i < MotionSensor::queueLength; i++) {
+		MotionSample *sample = sensor.mail.try_get();
+		ok = ok && sample && same(*sample, values[i]);
+		if (sample) {
+			sensor.mail.free(sample);
+		}
+	}
+	ok = ok && sensor.mail.try_get() == nullptr;
+	printf("queue full: %lu dropped %s\n", (unsigned long)dropped,
+		   ok && dropped == extra ? "ok" : "FAIL");
+	return ok && dropped == extra;
+}
+
+
+bool test_idle(MotionSensor &sensor)
+{
+	// A few timeouts without new data.
+	uint32_t missed = sensor.Stats().missed;
+	MotionSample *sample = sensor.mail.try_get_for(100ms);
+	bool ok = sample == nullptr && sensor.Stats().missed == missed;
+	printf("idle: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: sensortest [-n samples] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t samples = 2000;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': samples = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (samples == 0) {
+		usage();
+	}
+
+	// Its thread never stops, like on the board.
+	MotionSensor *sensor = new MotionSensor(PTE25, PTE24, PTC6);
+	Random random(seed);
+	bool ok = test_start(*sensor);
+	ok = ok && test_stream(*sensor, samples, random);
+	ok = ok && test_recovery(*sensor, random);
+	ok = ok && test_full(*sensor, random);
+	ok = ok && test_idle(*sensor);
+	// Leave with the sensor thread still waiting.
+	fflush(stdout);
+	_exit(ok ? 0 : 1);
+}
+
+
+/* EOF */
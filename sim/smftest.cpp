@@ -0,0 +1,360 @@
+/** @file smftest.cpp
+ *
+ * Round trip of seeded random songs through a Standard MIDI File and
+ * SmfPlayer.
+ *
+ * Every song is a list of timed channel messages on up to 16 tracks
+ * with tempo changes, SysEx and text events in between.  It is
+ * written as a type 0 or type 1 SMF (running status where it can be
+ * used, metrical or SMPTE division) and played back by calling
+ * Play() at every NextEventTime().  Every message has to come out
+ * once, in the order of the file, at the time the tempo map gives it
+ * to the microsecond, and the SysEx events have to be skipped.  The
+ * files are also played cut short, which must not send more than the
+ * whole file.
+ *
+ *   -n events	channel messages per song, default 20000.
+ *   -c count	number of songs, default 32.
+ *   -s seed	first seed, default 1.
+ *
+ * Exits with 1 when a song did not come back the same.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o smftest smftest.cpp \
+ *       ../MidiFile.cpp ../MidiParser.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include "MidiFile.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** One event of a song.
+ */
+struct SongEvent {
+	enum Kind: uint8_t {MESSAGE, TEMPO, SYSEX, TEXT};
+	uint32_t tick;
+	unsigned int track;
+	unsigned int index;	// In the track, keeps the order of equal ticks.
+	Kind kind;
+	uint8_t len;
+	uint8_t msg[3];
+	uint32_t tempo;
+};
+
+struct Played {
+	uint64_t time;
+	uint8_t len;
+	uint8_t msg[3];
+};
+
+
+// What the player sent, at the time Play() was called.
+static std::vector<Played> playedGlob;
+static uint64_t playTimeGlob;
+
+void sink(const UmpEvent &event)
+{
+	Played played;
+	played.time = playTimeGlob;
+	played.len = event.ToBytes(played.msg);
+	playedGlob.push_back(played);
+}
+
+
+void put_vlq(std::vector<uint8_t> &out, uint32_t value)
+{
+	uint8_t bytes[4];
+	unsigned int n = 0;
+	do {
+		bytes[n++] = value & 0x7F;
+		value >>= 7;
+	} while (value && n < 4);
+	while (n-- > 0) {
+		out.push_back(bytes[n] | (n ? 0x80 : 0));
+	}
+}
+
+void put_be(std::vector<uint8_t> &out, uint32_t value, unsigned int bytes)
+{
+	while (bytes-- > 0) {
+		out.push_back((value >> (8 * bytes)) & 0xFF);
+	}
+}
+
+
+void random_message(SongEvent &event, Random &random)
+{
+	static const uint8_t opcodes[] = {0x80, 0x90, 0xA0, 0xB0, 0xC0, 0xD0, 0xE0};
+	uint8_t opcode = opcodes[random.Below(sizeof(opcodes))];
+	// Few channels so running status comes up often.
+	event.msg[0] = opcode | random.Below(3);
+	event.msg[1] = random.Below(128);
+	// Velocity 0 would come back as a note off.
+	event.msg[2] = opcode == 0x90 ? 1 + random.Below(127) : random.Below(128);
+	event.len = (opcode == 0xC0 || opcode == 0xD0) ? 2 : 3;
+}
+
+
+/** Random song, tempo changes only in the first track like most
+ * sequencers write them.
+ */
+std::vector<SongEvent> make_song(uint32_t messages, unsigned int numOfTracks,
+								 Random &random)
+{
+	std::vector<SongEvent> song;
+	std::vector<uint32_t> ticks(numOfTracks, 0);
+	std::vector<unsigned int> counts(numOfTracks, 0);
+	for (uint32_t i = 0; i < messages; i++) {
+		SongEvent event = SongEvent();
+		event.track = random.Below(numOfTracks);
+		// Chords (delta 0) and now and then a long rest.
+		uint32_t delta = random.Below(3) == 0 ? 0 : random.Below(200);
+		if (random.Below(500) == 0) {
+			delta = random.Below(1 << 20);
+		}
+		ticks[event.track] += delta;
+		event.tick = ticks[event.track];
+		unsigned int kind = random.Below(100);
+		if (kind == 0 && event.track == 0) {
+			event.kind = SongEvent::TEMPO;
+			event.tempo = 250000 + random.Below(1000000);
+		}
+		else if (kind == 1) {
+			event.kind = SongEvent::SYSEX;
+		}
+		else if (kind == 2) {
+			event.kind = SongEvent::TEXT;
+		}
+		else {
+			event.kind = SongEvent::MESSAGE;
+			random_message(event, random);
+		}
+		event.index = counts[event.track]++;
+		song.push_back(event);
+	}
+	return song;
+}
+
+
+std::vector<uint8_t> write_smf(const std::vector<SongEvent> &song,
+							   unsigned int numOfTracks, uint16_t division)
+{
+	std::vector<uint8_t> file = {'M', 'T', 'h', 'd'};
+	put_be(file, 6, 4);
+	put_be(file, numOfTracks > 1 ? 1 : 0, 2);
+	put_be(file, numOfTracks, 2);
+	put_be(file, division, 2);
+
+	for (unsigned int track = 0; track < numOfTracks; track++) {
+		std::vector<uint8_t> data;
+		uint32_t tick = 0;
+		uint8_t status = 0;
+		for (auto &event: song) {
+			if (event.track != track) {
+				continue;
+			}
+			put_vlq(data, event.tick - tick);
+			tick = event.tick;
+			switch (event.kind) {
+				case SongEvent::TEMPO:
+					data.insert(data.end(), {0xFF, 0x51, 3});
+					put_be(data, event.tempo, 3);
+					break;
+				case SongEvent::SYSEX:
+					data.insert(data.end(), {0xF0, 4, 0x7E, 0x7F, 0x09, 0xF7});
+					break;
+				case SongEvent::TEXT:
+					data.insert(data.end(), {0xFF, 0x01, 2, 'h', 'i'});
+					break;
+				case SongEvent::MESSAGE:
+					if (event.msg[0] != status) {
+						data.push_back(event.msg[0]);
+					}
+					data.insert(data.end(), event.msg + 1, event.msg + event.len);
+					break;
+			}
+			// Meta and SysEx events cancel running status.
+			status = event.kind == SongEvent::MESSAGE ? event.msg[0] : 0;
+		}
+		data.insert(data.end(), {0, 0xFF, 0x2F, 0});
+		file.insert(file.end(), {'M', 'T', 'r', 'k'});
+		put_be(file, data.size(), 4);
+		file.insert(file.end(), data.begin(), data.end());
+	}
+	return file;
+}
+
+
+/** The messages in the order and at the time the song should play,
+ * and how many SysEx events there are.
+ */
+std::vector<Played> expected_play(std::vector<SongEvent> song,
+								  uint16_t division, uint32_t &sysex)
+{
+	std::stable_sort(song.begin(), song.end(),
+		[](const SongEvent &a, const SongEvent &b) {
+			if (a.tick != b.tick) {
+				return a.tick < b.tick;
+			}
+			if (a.track != b.track) {
+				return a.track < b.track;
+			}
+			return a.index < b.index;
+		});
+
+	uint32_t usPerTick = 0;
+	if (division & 0x8000) {
+		usPerTick = 1000000 / (-(int8_t)(division >> 8) * (division & 0xFF));
+	}
+	uint32_t tempo = 500000;
+	uint32_t tempoTick = 0;
+	uint64_t tempoTime = 0;
+	auto time = [&](uint32_t tick) -> uint64_t {
+		if (usPerTick) {
+			return (uint64_t)tick * usPerTick;
+		}
+		return tempoTime + (uint64_t)(tick - tempoTick) * tempo / division;
+	};
+
+	std::vector<Played> expected;
+	sysex = 0;
+	for (auto &event: song) {
+		if (event.kind == SongEvent::TEMPO) {
+			tempoTime = time(event.tick);
+			tempoTick = event.tick;
+			tempo = event.tempo;
+		}
+		else if (event.kind == SongEvent::SYSEX) {
+			sysex++;
+		}
+		else if (event.kind == SongEvent::MESSAGE) {
+			Played played;
+			played.time = time(event.tick);
+			played.len = event.len;
+			memcpy(played.msg, event.msg, sizeof(played.msg));
+			expected.push_back(played);
+		}
+	}
+	return expected;
+}
+
+
+/** Plays the file the way the playback thread does, returns the ns
+ * Play() took.
+ */
+uint64_t play(SmfPlayer &player, const uint8_t *file, size_t len)
+{
+	playedGlob.clear();
+	if (!player.Open(file, len)) {
+		return 0;
+	}
+	uint64_t ns = 0;
+	while (!player.Finished()) {
+		playTimeGlob = player.NextEventTime();
+		uint64_t start = now_ns();
+		player.Play(playTimeGlob);
+		ns += now_ns() - start;
+	}
+	return ns;
+}
+
+
+bool same(const std::vector<Played> &a, const std::vector<Played> &b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].time != b[i].time || a[i].len != b[i].len ||
+			memcmp(a[i].msg, b[i].msg, a[i].len) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: smftest [-n events] [-c count] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t messages = 20000;
+	uint32_t count = 32;
+	uint32_t firstSeed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:s:")) != -1) {
+		switch (opt) {
+			case 'n': messages = strtoul(optarg, nullptr, 0); break;
+			case 'c': count = strtoul(optarg, nullptr, 0); break;
+			case 's': firstSeed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (messages == 0 || count == 0) {
+		usage();
+	}
+
+	static SmfPlayer player(&sink);
+	bool ok = true;
+	uint64_t totalNs = 0;
+	uint64_t totalEvents = 0;
+	for (uint32_t seed = firstSeed; seed < firstSeed + count; seed++) {
+		Random random(seed);
+		// Every fourth song is type 0, another fourth in SMPTE (25 fps
+		// with 40 ticks a frame).
+		unsigned int numOfTracks = seed % 4 == 1 ? 1
+			: 2 + random.Below(SmfPlayer::maxTracks - 1);
+		uint16_t division = seed % 4 == 0 ? 0xE728 : 24 + random.Below(960);
+		std::vector<SongEvent> song = make_song(messages, numOfTracks, random);
+		std::vector<uint8_t> file = write_smf(song, numOfTracks, division);
+		uint32_t sysex;
+		std::vector<Played> expected = expected_play(song, division, sysex);
+
+		uint64_t ns = play(player, file.data(), file.size());
+		bool good = same(playedGlob, expected) &&
+			player.Stats().skipped == sysex && player.Stats().maxLate == 0;
+		totalNs += ns;
+		totalEvents += playedGlob.size();
+
+		// Cut short, anywhere.
+		size_t cut = random.Below(file.size());
+		play(player, file.data(), cut);
+		good = good && playedGlob.size() <= expected.size();
+
+		printf("seed %4lu type %u %2u tracks %7lu bytes %7lu events %s\n",
+			   (unsigned long)seed, numOfTracks > 1 ? 1 : 0, numOfTracks,
+			   (unsigned long)file.size(), (unsigned long)expected.size(),
+			   good ? "ok" : "FAIL");
+		ok = ok && good;
+	}
+	if (totalEvents) {
+		printf("%llu events, %.1f ns per event in Play()\n",
+			   (unsigned long long)totalEvents, (double)totalNs / totalEvents);
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
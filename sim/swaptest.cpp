@@ -0,0 +1,150 @@
+/** @file swaptest.cpp
+ *
+ * Stress test of SwapTables, the table swap behind ScaleQuantize and
+ * Harmonizer, on a multi-core host where reader and writer really run
+ * at the same time (on the board they only interleave).
+ *
+ * The writer fills tables with one value in every entry and publishes
+ * them as fast as it can.  The reader takes a table, reads all of it
+ * twice and checks that every entry is the same value both times: a
+ * table that is written while it is read shows up as a mix.  Then
+ * ScaleQuantize itself: notes go through NoteOn() while the scale is
+ * changed, every note that comes out must be in one of the scales.
+ *
+ *   -t sec		run time per test, default 2.
+ *
+ * Exits with 1 when a torn table or a note outside the scales was
+ * seen.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -pthread -I.. -o swaptest swaptest.cpp \
+ *       ../TransformMIDI.cpp ../Chord.cpp ../Scale.cpp ../Mode.cpp \
+ *       ../Note.cpp ../VoiceLeading.cpp ../Harmony.cpp ../HeapProbe.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include "TransformMIDI.h"
+
+
+static std::atomic<bool> runningGlob;
+
+
+void run_for(unsigned int seconds)
+{
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	runningGlob = false;
+}
+
+
+bool test_tables(unsigned int seconds)
+{
+	static SwapTables<1024> tables;
+	uint32_t published = 0;
+	uint32_t reads = 0;
+	uint32_t torn = 0;
+
+	runningGlob = true;
+	std::thread writer([&]() {
+		uint8_t value = 0;
+		while (runningGlob) {
+			uint8_t *spare = tables.Spare();
+			memset(spare, ++value, 1024);
+			tables.Publish(spare);
+			published++;
+		}
+	});
+	std::thread timer(run_for, seconds);
+	while (runningGlob) {
+		const uint8_t *table = tables.Acquire();
+		uint8_t value = table[0];
+		for (unsigned int pass = 0; pass < 2; pass++) {
+			for (unsigned int i = 0; i < 1024; i++) {
+				if (table[i] != value) {
+					torn++;
+					break;
+				}
+			}
+		}
+		tables.Release();
+		reads++;
+	}
+	writer.join();
+	timer.join();
+	printf("tables: %lu published %lu read %lu torn\n",
+		   (unsigned long)published, (unsigned long)reads,
+		   (unsigned long)torn);
+	return torn == 0;
+}
+
+
+bool test_quantize(unsigned int seconds)
+{
+	static ScaleQuantize quantize(nullptr);
+	typedef StaticScale<Scale::TypeOfScale::MAJOR, 0> CMajor;
+	typedef StaticScale<Scale::TypeOfScale::PENTATONIC, 1> DbPentatonic;
+	PitchClassSet both = CMajor::PitchClasses(0) | DbPentatonic::PitchClasses(0);
+	uint32_t changes = 0;
+	uint32_t notes = 0;
+	uint32_t wrong = 0;
+
+	// Chromatic until the first scale is set.
+	quantize.SetScale(CMajor::PitchClasses(0));
+	runningGlob = true;
+	std::thread writer([&]() {
+		while (runningGlob) {
+			quantize.SetScale(changes & 1 ? CMajor::PitchClasses(0)
+							  : DbPentatonic::PitchClasses(0));
+			changes++;
+		}
+	});
+	std::thread timer(run_for, seconds);
+	while (runningGlob) {
+		uint8_t note = notes & 0x7F;
+		uint8_t out = quantize.NoteOn(note);
+		if (!both.Contains(out) || quantize.NoteOff(note) != out) {
+			wrong++;
+		}
+		notes++;
+	}
+	writer.join();
+	timer.join();
+	printf("quantize: %lu scale changes %lu notes %lu wrong\n",
+		   (unsigned long)changes, (unsigned long)notes,
+		   (unsigned long)wrong);
+	return wrong == 0;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: swaptest [-t seconds]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int seconds = 2;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:")) != -1) {
+		switch (opt) {
+			case 't': seconds = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	bool ok = test_tables(seconds);
+	ok = test_quantize(seconds) && ok;
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
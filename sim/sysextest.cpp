@@ -0,0 +1,230 @@
+/** @file sysextest.cpp
+ *
+ * SysEx streaming through MidiParser: correctness and throughput.
+ *
+ * A seeded 64 kB dump is fed to the parser in pieces of 1 byte (the
+ * byte at a time path), 16, 256 and 4096 bytes, without realtime and
+ * with a clock byte every 100 and every 10 data bytes.  Every time
+ * all data has to arrive once, hashed in order, between one START
+ * and one END, with every clock dispatched.  Parsed a piece at a time
+ * the chunks have to point into the piece (nothing is copied).  The time per data byte
+ * is printed with how many times faster that is than the DIN wire
+ * (3125 bytes/s).
+ *
+ * Then the ends of a dump: F7, a status byte in the middle (END and
+ * ABORTED, the message after it still comes out) and Reset() in the
+ * middle (END and ABORTED).
+ *
+ *   -n passes	dumps per piece size, default 16.
+ *   -s seed	seed of the dump, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o sysextest sysextest.cpp \
+ *       ../MidiParser.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+#include "MidiParser.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** What the handlers saw.
+ */
+struct Seen {
+	const uint8_t *pieceBegin, *pieceEnd;	// Being parsed.
+	uint32_t bytes, chunks, starts, ends, aborted, copied;
+	uint32_t hash;
+	uint32_t realtime;
+	uint32_t noteOn;
+};
+static Seen seenGlob;
+
+void sysex(const uint8_t *data, size_t len, uint8_t flags)
+{
+	Seen &seen = seenGlob;
+	seen.chunks++;
+	seen.starts += (flags & MidiParser::SYSEX_START) ? 1 : 0;
+	seen.ends += (flags & MidiParser::SYSEX_END) ? 1 : 0;
+	seen.aborted += (flags & MidiParser::SYSEX_ABORTED) ? 1 : 0;
+	if (len && (data < seen.pieceBegin || data + len > seen.pieceEnd)) {
+		seen.copied++;
+	}
+	seen.bytes += len;
+	for (size_t i = 0; i < len; i++) {
+		seen.hash = (seen.hash ^ data[i]) * 16777619u;
+	}
+}
+
+void realtime(uint8_t)
+{
+	seenGlob.realtime++;
+}
+
+void note_on(uint8_t, uint8_t)
+{
+	seenGlob.noteOn++;
+}
+
+
+void clear(MidiParser &parser)
+{
+	parser.Reset();
+	parser.ClearStats();
+	seenGlob = Seen();
+	seenGlob.hash = 2166136261u;
+}
+
+
+/** Parses 'stream' in pieces, returns the ns it took.
+ */
+uint64_t parse(MidiParser &parser, const std::vector<uint8_t> &stream,
+			   size_t piece)
+{
+	uint64_t start = now_ns();
+	for (size_t at = 0; at < stream.size(); at += piece) {
+		size_t n = stream.size() - at < piece ? stream.size() - at : piece;
+		seenGlob.pieceBegin = stream.data() + at;
+		seenGlob.pieceEnd = stream.data() + at + n;
+		if (piece == 1) {
+			parser.Parse(stream[at]);
+		}
+		else {
+			parser.Parse(stream.data() + at, n);
+		}
+	}
+	return now_ns() - start;
+}
+
+
+bool test_throughput(MidiParser &parser, uint32_t passes, uint32_t seed)
+{
+	static const size_t pieces[] = {1, 16, 256, 4096};
+	static const uint32_t clockEvery[] = {0, 100, 10};
+	const uint32_t dumpLen = 64 * 1024;
+	bool ok = true;
+
+	for (auto every: clockEvery) {
+		// F0, the data with clocks in between, F7.
+		std::vector<uint8_t> stream = {0xF0};
+		Random random(seed);
+		uint32_t hash = 2166136261u;
+		uint32_t clocks = 0;
+		for (uint32_t i = 0; i < dumpLen; i++) {
+			if (every && i % every == 0) {
+				stream.push_back(0xF8);
+				clocks++;
+			}
+			uint8_t byte = random.Next() & 0x7F;
+			hash = (hash ^ byte) * 16777619u;
+			stream.push_back(byte);
+		}
+		stream.push_back(0xF7);
+
+		for (auto piece: pieces) {
+			uint64_t ns = 0;
+			bool good = true;
+			for (uint32_t pass = 0; pass < passes; pass++) {
+				clear(parser);
+				ns += parse(parser, stream, piece);
+				const Seen &seen = seenGlob;
+				// One byte at a time is passed by value, not in place.
+				good = good && seen.bytes == dumpLen && seen.hash == hash &&
+					(seen.copied == 0 || piece == 1) &&
+					seen.starts == 1 && seen.ends == 1 &&
+					seen.aborted == 0 && seen.realtime == clocks &&
+					parser.Stats().sysexBytes == dumpLen;
+			}
+			double perByte = (double)ns / passes / dumpLen;
+			printf("clock every %3u piece %4zu %6.2f ns/byte %8.0fx the wire "
+				   "%5lu chunks %s\n", every, piece, perByte,
+				   1e9 / 3125 / perByte, (unsigned long)seenGlob.chunks,
+				   good ? "ok" : "FAIL");
+			ok = ok && good;
+		}
+	}
+	return ok;
+}
+
+
+bool test_ends(MidiParser &parser)
+{
+	struct End {
+		const char *name;
+		std::vector<uint8_t> stream;
+		bool reset;		// Reset() after the stream.
+		uint32_t bytes, ends, aborted, noteOn;
+	};
+	const End ends[] = {
+		{"F7", {0xF0, 1, 2, 3, 0xF7}, false, 3, 1, 0, 0},
+		{"status byte", {0xF0, 1, 2, 0x90, 60, 100}, false, 2, 1, 1, 1},
+		{"reset", {0xF0, 1, 2, 3}, true, 3, 1, 1, 0},
+	};
+	bool ok = true;
+	for (auto &end: ends) {
+		for (size_t piece: {(size_t)1, end.stream.size()}) {
+			clear(parser);
+			parse(parser, end.stream, piece);
+			if (end.reset) {
+				parser.Reset();
+			}
+			const Seen &seen = seenGlob;
+			bool good = seen.bytes == end.bytes && seen.starts == 1 &&
+				seen.ends == end.ends && seen.aborted == end.aborted &&
+				seen.noteOn == end.noteOn;
+			printf("ended by %-12s piece %zu %s\n", end.name, piece,
+				   good ? "ok" : "FAIL");
+			ok = ok && good;
+		}
+	}
+	return ok;
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: sysextest [-n passes] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t passes = 16;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': passes = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (passes == 0) {
+		usage();
+	}
+
+	MidiParser parser(&note_on, &realtime, nullptr, nullptr, nullptr);
+	parser.SetSysexHandler(&sysex);
+	bool ok = test_throughput(parser, passes, seed);
+	ok = test_ends(parser) && ok;
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
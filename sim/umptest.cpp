@@ -0,0 +1,316 @@
+/** @file umptest.cpp
+ *
+ * Universal MIDI Packet translation in both directions, and what it
+ * costs.
+ *
+ *   - MIDI 1.0 to MIDI 2.0: every channel message on every channel
+ *     must come back unchanged from bytes -> MIDI 1.0 UMP -> MIDI 2.0
+ *     UMP -> bytes, a note on with velocity 0 comes back as a note
+ *     off.  The group and channel stay what they were.
+ *   - System messages: realtime and system common come back byte for
+ *     byte as type 1 packets; SysEx, data bytes and messages cut short
+ *     are refused.
+ *   - MIDI 2.0 to MIDI 1.0: seeded random velocities and controller,
+ *     pressure and pitch bend values come out as their top bits, a
+ *     note on never with velocity 0, messages without a MIDI 1.0
+ *     counterpart as nothing.
+ *   - Scaling: every 7 and 14 bit value scaled up keeps 0, the centre
+ *     and the maximum, goes up with the value and scales back down to
+ *     itself.
+ *
+ * Then the time per message of every step.
+ *
+ *   -n passes	passes over the messages for the timing, default 64.
+ *   -s seed	seed of the MIDI 2.0 values, default 1.
+ *
+ * Exits with 1 when a check failed.
+ *
+ * Build (from this directory):
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o umptest umptest.cpp ../Ump.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+#include "Ump.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** Every MIDI 1.0 channel message: all opcodes, channels and data.
+ */
+struct Message {
+	uint8_t bytes[3];
+	uint8_t len;
+};
+
+std::vector<Message> channel_messages()
+{
+	std::vector<Message> messages;
+	for (unsigned int opcode = 0x80; opcode < 0xF0; opcode += 0x10) {
+		uint8_t len = (opcode == 0xC0 || opcode == 0xD0) ? 2 : 3;
+		for (unsigned int channel = 0; channel < 16; channel++) {
+			for (unsigned int data = 0; data < (len == 3 ? 0x4000u : 0x80u); data++) {
+				Message m = {{(uint8_t)(opcode | channel), (uint8_t)(data & 0x7F),
+					(uint8_t)(data >> 7)}, len};
+				messages.push_back(m);
+			}
+		}
+	}
+	return messages;
+}
+
+
+bool test_midi1(const std::vector<Message> &messages)
+{
+	uint32_t errors = 0;
+	for (auto &m: messages) {
+		uint8_t group = m.bytes[1] & 0x0F;
+		UmpEvent event;
+		uint8_t out[3];
+		if (!UmpEvent::FromBytes(m.bytes, m.len, event, group) ||
+			event.MessageType() != UmpEvent::MIDI1) {
+			errors++;
+			continue;
+		}
+		UmpEvent midi2 = event.ToMidi2();
+		if (midi2.MessageType() != UmpEvent::MIDI2 || midi2.Group() != group ||
+			midi2.Channel() != (m.bytes[0] & 0x0F) ||
+			midi2.ToBytes(out) != m.len) {
+			errors++;
+			continue;
+		}
+		uint8_t status = (m.bytes[0] & 0xF0) == 0x90 && m.bytes[2] == 0 ?
+			(m.bytes[0] & 0x0F) | 0x80 : m.bytes[0];
+		if (out[0] != status || out[1] != m.bytes[1] ||
+			(m.len == 3 && out[2] != m.bytes[2])) {
+			errors++;
+		}
+		// The MIDI 1.0 packet itself gives the bytes back as well.
+		if (event.ToBytes(out) != m.len || out[0] != m.bytes[0] ||
+			out[1] != m.bytes[1] || (m.len == 3 && out[2] != m.bytes[2])) {
+			errors++;
+		}
+	}
+	printf("midi 1.0 -> 2.0 -> 1.0: %lu messages %s\n",
+		   (unsigned long)messages.size(), errors == 0 ? "ok" : "FAIL");
+	return errors == 0;
+}
+
+
+bool test_system()
+{
+	struct System {
+		std::vector<uint8_t> bytes;
+		bool valid;
+	};
+	const System systems[] = {
+		{{0xF1, 0x35}, true},		// MTC quarter frame
+		{{0xF2, 0x10, 0x7F}, true},	// Song position
+		{{0xF3, 5}, true},			// Song select
+		{{0xF6}, true},				// Tune request
+		{{0xF8}, true},
+		{{0xFA}, true},
+		{{0xFB}, true},
+		{{0xFC}, true},
+		{{0xFE}, true},
+		{{0xFF}, true},
+		{{0xF0, 0x7E, 0xF7}, false},
+		{{0xF7}, false},
+		{{0x40, 0x40}, false},		// Data without a status.
+		{{0xF2, 0x10}, false},		// Cut short.
+		{{0x90, 60}, false},
+		{{}, false},
+	};
+	bool ok = true;
+	for (auto &s: systems) {
+		UmpEvent event;
+		uint8_t out[3];
+		bool valid = UmpEvent::FromBytes(s.bytes.data(), s.bytes.size(), event);
+		bool good = valid == s.valid;
+		if (valid && good) {
+			size_t len = event.ToBytes(out);
+			good = event.MessageType() == (s.bytes[0] >= 0xF0 ?
+										   UmpEvent::SYSTEM : UmpEvent::MIDI1) &&
+				event.ToMidi2() == event && len == s.bytes.size();
+			for (size_t i = 0; good && i < len; i++) {
+				good = out[i] == s.bytes[i];
+			}
+		}
+		if (!good) {
+			printf("system message %02X length %zu: FAIL\n",
+				   s.bytes.empty() ? 0 : s.bytes[0], s.bytes.size());
+		}
+		ok = ok && good;
+	}
+	printf("system messages: %s\n", ok ? "ok" : "FAIL");
+	return ok;
+}
+
+
+bool test_midi2(uint32_t seed)
+{
+	Random random(seed);
+	uint32_t errors = 0;
+	const uint32_t count = 100000;
+	for (uint32_t i = 0; i < count; i++) {
+		uint8_t channel = random.Below(16);
+		uint8_t index = random.Below(128);
+		uint16_t velocity = (uint16_t)random.Next();
+		uint32_t value = random.Next();
+		uint8_t out[3];
+
+		UmpEvent on = UmpEvent::NoteOn(channel, index, velocity);
+		uint8_t v = velocity >> 9;
+		errors += (on.ToBytes(out) != 3 || out[0] != (0x90 | channel) ||
+				   out[1] != index || out[2] != (v ? v : 1)) ? 1 : 0;
+		UmpEvent off = UmpEvent::NoteOff(channel, index, velocity);
+		errors += (off.ToBytes(out) != 3 || out[0] != (0x80 | channel) ||
+				   out[2] != v) ? 1 : 0;
+		UmpEvent cc = UmpEvent::ControlChange(channel, index, value);
+		errors += (cc.ToBytes(out) != 3 || out[1] != index ||
+				   out[2] != value >> 25) ? 1 : 0;
+		UmpEvent pressure = UmpEvent::ChannelPressure(channel, value);
+		errors += (pressure.ToBytes(out) != 2 || out[1] != value >> 25) ? 1 : 0;
+		UmpEvent bend = UmpEvent::PitchBend(channel, value);
+		errors += (bend.ToBytes(out) != 3 || out[1] != ((value >> 18) & 0x7F) ||
+				   out[2] != value >> 25) ? 1 : 0;
+		// A MIDI 1.0 value up and down again is the same value.
+		UmpEvent midi1 = UmpEvent::Midi1(0xB0 | channel, index, value & 0x7F);
+		errors += (midi1.ToMidi2().ToBytes(out) != 3 || out[2] != (value & 0x7F)) ? 1 : 0;
+	}
+	// Per note management (opcode F) and registered per note
+	// controllers (opcode 0).
+	for (uint32_t opcode: {0xFu, 0x0u}) {
+		UmpEvent perNote = UmpEvent::NoteOn(0, 60, 1000);
+		perNote.word[0] = (perNote.word[0] & ~0x00F00000u) | opcode << 20;
+		uint8_t out[3];
+		errors += perNote.ToBytes(out) != 0 ? 1 : 0;
+	}
+	printf("midi 2.0 -> 1.0: %lu random values %s\n", (unsigned long)count,
+		   errors == 0 ? "ok" : "FAIL");
+	return errors == 0;
+}
+
+
+bool test_scaling()
+{
+	struct Scale {
+		unsigned int src, dst;
+	};
+	const Scale scales[] = {{7, 16}, {7, 32}, {14, 32}};
+	bool ok = true;
+	for (auto &s: scales) {
+		uint32_t max = (1u << s.src) - 1;
+		uint32_t dstMax = s.dst == 32 ? UINT32_MAX : (1u << s.dst) - 1;
+		bool good = UmpEvent::ScaleUp(0, s.src, s.dst) == 0 &&
+			UmpEvent::ScaleUp(max, s.src, s.dst) == dstMax &&
+			UmpEvent::ScaleUp(1u << (s.src - 1), s.src, s.dst) == 1u << (s.dst - 1);
+		uint32_t last = 0;
+		for (uint32_t v = 0; good && v <= max; v++) {
+			uint32_t up = UmpEvent::ScaleUp(v, s.src, s.dst);
+			good = (v == 0 || up > last) &&
+				UmpEvent::ScaleDown(up, s.dst, s.src) == v;
+			last = up;
+		}
+		printf("scale %2u -> %2u bits: %s\n", s.src, s.dst, good ? "ok" : "FAIL");
+		ok = ok && good;
+	}
+	return ok;
+}
+
+
+/** ns per message of each step.
+ */
+void timing(const std::vector<Message> &messages, uint32_t passes)
+{
+	std::vector<UmpEvent> midi1(messages.size());
+	std::vector<UmpEvent> midi2(messages.size());
+	uint32_t sink = 0;
+	uint8_t out[3];
+
+	uint64_t start = now_ns();
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < messages.size(); i++) {
+			sink += UmpEvent::FromBytes(messages[i].bytes, messages[i].len, midi1[i]);
+		}
+	}
+	uint64_t fromBytes = now_ns() - start;
+	start = now_ns();
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < messages.size(); i++) {
+			midi2[i] = midi1[i].ToMidi2();
+		}
+	}
+	uint64_t toMidi2 = now_ns() - start;
+	start = now_ns();
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		for (auto &event: midi1) {
+			sink += event.ToBytes(out) + out[2];
+		}
+	}
+	uint64_t midi1ToBytes = now_ns() - start;
+	start = now_ns();
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		for (auto &event: midi2) {
+			sink += event.ToBytes(out) + out[2];
+		}
+	}
+	uint64_t midi2ToBytes = now_ns() - start;
+
+	double n = (double)messages.size() * passes;
+	printf("bytes -> midi 1.0 %.2f ns, midi 1.0 -> 2.0 %.2f ns, "
+		   "midi 1.0 -> bytes %.2f ns, midi 2.0 -> bytes %.2f ns per message\n",
+		   fromBytes / n, toMidi2 / n, midi1ToBytes / n, midi2ToBytes / n);
+	// Keeps the calls from being optimized away.
+	if (sink == 1 || midi2[0].word[1] == 1) {
+		printf("\n");
+	}
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: umptest [-n passes] [-s seed]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t passes = 64;
+	uint32_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': passes = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			default: usage();
+		}
+	}
+	if (passes == 0) {
+		usage();
+	}
+
+	std::vector<Message> messages = channel_messages();
+	bool ok = test_midi1(messages);
+	ok = test_system() && ok;
+	ok = test_midi2(seed) && ok;
+	ok = test_scaling() && ok;
+	timing(messages, passes);
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */
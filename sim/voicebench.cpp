@@ -0,0 +1,125 @@
+/** @file voicebench.cpp
+ *
+ * Times VoiceLeader::Voice() against the number of chord notes.
+ *
+ * For every chord size from 1 to VoiceLeader::maxVoices a seeded
+ * progression of chords (random roots, notes stacked in thirds and
+ * fourths) is voiced one after the other as the note-on handler
+ * does, the time per chord is reported as mean and 99th percentile
+ * (the max is mostly the host scheduler).  Every voicing has to stay
+ * inside the register, the program exits with 1 when one does not.
+ * Chords that do not fit the register at all are counted.
+ *
+ *   -n chords	chords per size, default 100000.
+ *   -s seed	seed of the progression, default 1.
+ *   -l note	low end of the register, default 36.
+ *   -h note	high end of the register, default 84.
+ *
+ * Build from this directory:
+ *
+ *   g++ -std=gnu++14 -O2 -Wall -I.. -o voicebench voicebench.cpp \
+ *       ../Chord.cpp ../Scale.cpp ../Mode.cpp ../Note.cpp \
+ *       ../VoiceLeading.cpp ../Harmony.cpp ../HeapProbe.cpp
+ *
+ * @author Jan-Willem Smaal <usenet@gispen.org>
+ * @date 18/10/2026
+ * @copyright APACHE-2.0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include "Harmony.hpp"
+#include "Random.hpp"
+
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/** Chord of 'size' notes from 'root' up, 3 or 4 semitones apart.
+ */
+void make_chord(Chord &chord, unsigned int size, uint8_t root, Random &random)
+{
+	chord.notes.clear();
+	uint8_t note = root;
+	for (unsigned int i = 0; i < size; i++) {
+		chord.notes.push_back(Note(note));
+		note += 3 + random.Below(2);
+	}
+}
+
+
+void usage()
+{
+	fprintf(stderr, "usage: voicebench [-n chords] [-s seed] "
+			"[-l low] [-h high]\n");
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t chords = 100000;
+	uint32_t seed = 1;
+	unsigned int low = 36;
+	unsigned int high = 84;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:l:h:")) != -1) {
+		switch (opt) {
+			case 'n': chords = strtoul(optarg, nullptr, 0); break;
+			case 's': seed = strtoul(optarg, nullptr, 0); break;
+			case 'l': low = atoi(optarg); break;
+			case 'h': high = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	if (chords == 0 || low > 127 || high > 127) {
+		usage();
+	}
+
+	bool ok = true;
+	Chord chord(Chord::Type::MAJOR, 60, 60);
+	std::vector<uint32_t> times(chords);
+	for (unsigned int size = 1; size <= VoiceLeader::maxVoices; size++) {
+		VoiceLeader voiceLeader(low, high);
+		Random random(seed);
+		uint64_t total = 0;
+		uint32_t outside = 0;
+		uint32_t unvoiced = 0;
+
+		for (uint32_t n = 0; n < chords; n++) {
+			make_chord(chord, size, 36 + random.Below(36), random);
+			chord.voicing.clear();
+			uint64_t start = now_ns();
+			voiceLeader.Voice(chord);
+			times[n] = now_ns() - start;
+			total += times[n];
+			if (chord.voicing.empty()) {
+				unvoiced++;
+			}
+			for (auto note: chord.voicing) {
+				if (note.number < voiceLeader.lowNote
+					|| note.number > voiceLeader.highNote) {
+					outside++;
+				}
+			}
+		}
+		std::sort(times.begin(), times.end());
+		printf("%u notes %8.1f ns mean %8lu ns p99 %8lu did not fit%s\n",
+			   size, (double)total / chords,
+			   (unsigned long)times[chords * 99 / 100],
+			   (unsigned long)unvoiced,
+			   outside ? "  OUTSIDE THE REGISTER" : "");
+		ok = ok && outside == 0;
+	}
+	return ok ? 0 : 1;
+}
+
+
+/* EOF */